@@ -0,0 +1,682 @@
+/*
+ * jitbench.c - Benchmark suite for libjit.
+ *
+ * Copyright (C) 2026  Southern Storm Software, Pty Ltd.
+ *
+ * This file is part of the libjit library.
+ *
+ * The libjit library is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation, either version 2.1 of
+ * the License, or (at your option) any later version.
+ *
+ * The libjit library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the libjit library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+
+The benchmarks measure how fast libjit compiles functions and how fast
+the generated code runs.  The results are written to stdout with one
+tab-separated line per measurement:
+
+	backend	benchmark	metric	value	unit
+
+The backend is "native" or "interpreter", so results of a native build
+and of a build configured with --enable-interpreter can be concatenated
+and compared.  Lines starting with '#' are comments.
+
+Usage: jitbench [-s scale] [-r repeat] [-O level] [benchmark ...]
+
+	-s scale	multiply the amount of work by "scale" (default 1)
+	-r repeat	run each benchmark "repeat" times and report the
+			fastest run (default 3)
+	-O level	optimization level of the compiled functions
+
+If benchmark names are given, only the benchmarks whose names start
+with one of them are run.
+
+*/
+
+#include <jit/jit.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+static int scale = 1;
+static int repeat = 3;
+static int opt_level = -1;
+static const char *backend;
+
+/*
+ * Get the current time in microseconds.
+ */
+static double
+now_usec(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return (double)tv.tv_sec * 1000000.0 + (double)tv.tv_usec;
+}
+
+/*
+ * Print a measurement.
+ */
+static void
+report(const char *benchmark, const char *metric, double value, const char *unit)
+{
+	printf("%s\t%s\t%s\t%.3f\t%s\n", backend, benchmark, metric, value, unit);
+	fflush(stdout);
+}
+
+/*
+ * Check and report the result of a kernel so that the work cannot be
+ * optimized away and wrong code is noticed.
+ */
+static void
+report_check(const char *benchmark, jit_long result, jit_long expected)
+{
+	if(result != expected)
+	{
+		fprintf(stderr, "jitbench: %s: wrong result %ld, expected %ld\n",
+			benchmark, (long)result, (long)expected);
+		exit(1);
+	}
+}
+
+/*
+ * Create a function and apply the optimization level.
+ */
+static jit_function_t
+create_function(jit_context_t context, jit_type_t signature)
+{
+	jit_function_t function;
+
+	function = jit_function_create(context, signature);
+	if(opt_level >= 0)
+	{
+		jit_function_set_optimization_level(function, (unsigned int)opt_level);
+	}
+	return function;
+}
+
+/*
+ * Compile-time throughput: build and compile functions made of
+ * "num_insns" arithmetic instructions with a forward branch after
+ * every 16 of them.
+ */
+static void
+build_straight_line(jit_function_t function, int num_insns)
+{
+	jit_value_t a, b, v, w;
+	jit_label_t label;
+	int index;
+
+	a = jit_value_get_param(function, 0);
+	b = jit_value_get_param(function, 1);
+	v = jit_value_create(function, jit_type_int);
+	w = jit_value_create(function, jit_type_int);
+	jit_insn_store(function, v, a);
+	jit_insn_store(function, w, b);
+	label = jit_label_undefined;
+	for(index = 0; index < num_insns; ++index)
+	{
+		switch(index % 4)
+		{
+		case 0:
+			jit_insn_store(function, v, jit_insn_add(function, v, w));
+			break;
+
+		case 1:
+			jit_insn_store(function, w, jit_insn_xor(function, w, v));
+			break;
+
+		case 2:
+			jit_insn_store(function, v, jit_insn_sub(function, v, a));
+			break;
+
+		default:
+			jit_insn_store(function, w, jit_insn_mul(function, w, b));
+			break;
+		}
+		if((index % 16) == 15)
+		{
+			jit_insn_branch_if(function, jit_insn_lt(function, v, w), &label);
+			jit_insn_store(function, v, jit_insn_add(function, v, b));
+			jit_insn_label(function, &label);
+			label = jit_label_undefined;
+		}
+	}
+	jit_insn_return(function, jit_insn_add(function, v, w));
+}
+
+static void
+bench_compile(int num_insns)
+{
+	jit_context_t context;
+	jit_type_t params[2];
+	jit_type_t signature;
+	jit_function_t function;
+	double start, elapsed, best;
+	int count, index, run;
+	char name[64];
+
+	params[0] = jit_type_int;
+	params[1] = jit_type_int;
+	signature = jit_type_create_signature
+		(jit_abi_cdecl, jit_type_int, params, 2, 1);
+
+	count = (200000 / num_insns) * scale;
+	if(count < 1)
+	{
+		count = 1;
+	}
+
+	best = 0;
+	for(run = 0; run < repeat; ++run)
+	{
+		context = jit_context_create();
+		start = now_usec();
+		for(index = 0; index < count; ++index)
+		{
+			jit_context_build_start(context);
+			function = create_function(context, signature);
+			build_straight_line(function, num_insns);
+			if(!jit_function_compile(function))
+			{
+				fprintf(stderr, "jitbench: compile failed\n");
+				exit(1);
+			}
+			jit_context_build_end(context);
+		}
+		elapsed = now_usec() - start;
+		jit_context_destroy(context);
+		if(run == 0 || elapsed < best)
+		{
+			best = elapsed;
+		}
+	}
+
+	sprintf(name, "compile.insns_%d", num_insns);
+	report(name, "time_per_function", best / count, "us");
+	report(name, "throughput", (double)num_insns * count / best, "insns/us");
+	jit_type_free(signature);
+}
+
+/*
+ * Build the integer kernel:
+ *
+ *	long int_kernel(int n)
+ *	{
+ *		uint x = 1, h = 0;
+ *		for(int i = 0; i < n; ++i)
+ *		{
+ *			x = x * 1103515245 + 12345;
+ *			h = (h ^ (x >> 16)) + (uint)i;
+ *		}
+ *		return h;
+ *	}
+ */
+static jit_function_t
+build_int_kernel(jit_context_t context)
+{
+	jit_type_t params[1];
+	jit_type_t signature;
+	jit_function_t function;
+	jit_value_t n, i, x, h, t;
+	jit_label_t top = jit_label_undefined;
+	jit_label_t done = jit_label_undefined;
+
+	params[0] = jit_type_int;
+	signature = jit_type_create_signature
+		(jit_abi_cdecl, jit_type_long, params, 1, 1);
+	function = create_function(context, signature);
+	jit_type_free(signature);
+
+	n = jit_value_get_param(function, 0);
+	i = jit_value_create(function, jit_type_int);
+	x = jit_value_create(function, jit_type_uint);
+	h = jit_value_create(function, jit_type_uint);
+	jit_insn_store(function, i, jit_value_create_nint_constant(function, jit_type_int, 0));
+	jit_insn_store(function, x, jit_value_create_nint_constant(function, jit_type_uint, 1));
+	jit_insn_store(function, h, jit_value_create_nint_constant(function, jit_type_uint, 0));
+
+	jit_insn_label(function, &top);
+	jit_insn_branch_if_not(function, jit_insn_lt(function, i, n), &done);
+	t = jit_insn_mul(function, x, jit_value_create_nint_constant(function, jit_type_uint, 1103515245));
+	jit_insn_store(function, x, jit_insn_add(function, t, jit_value_create_nint_constant(function, jit_type_uint, 12345)));
+	t = jit_insn_ushr(function, x, jit_value_create_nint_constant(function, jit_type_uint, 16));
+	t = jit_insn_xor(function, h, t);
+	jit_insn_store(function, h, jit_insn_add(function, t, jit_insn_convert(function, i, jit_type_uint, 0)));
+	jit_insn_store(function, i, jit_insn_add(function, i, jit_value_create_nint_constant(function, jit_type_int, 1)));
+	jit_insn_branch(function, &top);
+
+	jit_insn_label(function, &done);
+	jit_insn_return(function, jit_insn_convert(function, h, jit_type_long, 0));
+	return function;
+}
+
+static jit_long
+int_kernel(jit_int n)
+{
+	jit_uint x = 1, h = 0;
+	jit_int i;
+	for(i = 0; i < n; ++i)
+	{
+		x = x * 1103515245 + 12345;
+		h = (h ^ (x >> 16)) + (jit_uint)i;
+	}
+	return (jit_long)h;
+}
+
+/*
+ * Build the floating point kernel:
+ *
+ *	long float_kernel(int n)
+ *	{
+ *		double x = 0.5, s = 0;
+ *		for(int i = 0; i < n; ++i)
+ *		{
+ *			x = x * 0.999 + 0.25;
+ *			s = s + x * x / (x + 1.0);
+ *		}
+ *		return (long)(s * 1000.0);
+ *	}
+ *
+ * The sum is scaled and truncated to an integer inside the function
+ * so that the result can be compared exactly with the C version.
+ */
+static jit_function_t
+build_float_kernel(jit_context_t context)
+{
+	jit_type_t params[1];
+	jit_type_t signature;
+	jit_function_t function;
+	jit_value_t n, i, x, s, t;
+	jit_label_t top = jit_label_undefined;
+	jit_label_t done = jit_label_undefined;
+
+	params[0] = jit_type_int;
+	signature = jit_type_create_signature
+		(jit_abi_cdecl, jit_type_long, params, 1, 1);
+	function = create_function(context, signature);
+	jit_type_free(signature);
+
+	n = jit_value_get_param(function, 0);
+	i = jit_value_create(function, jit_type_int);
+	x = jit_value_create(function, jit_type_float64);
+	s = jit_value_create(function, jit_type_float64);
+	jit_insn_store(function, i, jit_value_create_nint_constant(function, jit_type_int, 0));
+	jit_insn_store(function, x, jit_value_create_float64_constant(function, jit_type_float64, 0.5));
+	jit_insn_store(function, s, jit_value_create_float64_constant(function, jit_type_float64, 0.0));
+
+	jit_insn_label(function, &top);
+	jit_insn_branch_if_not(function, jit_insn_lt(function, i, n), &done);
+	t = jit_insn_mul(function, x, jit_value_create_float64_constant(function, jit_type_float64, 0.999));
+	jit_insn_store(function, x, jit_insn_add(function, t, jit_value_create_float64_constant(function, jit_type_float64, 0.25)));
+	t = jit_insn_div(function, jit_insn_mul(function, x, x),
+			 jit_insn_add(function, x, jit_value_create_float64_constant(function, jit_type_float64, 1.0)));
+	jit_insn_store(function, s, jit_insn_add(function, s, t));
+	jit_insn_store(function, i, jit_insn_add(function, i, jit_value_create_nint_constant(function, jit_type_int, 1)));
+	jit_insn_branch(function, &top);
+
+	jit_insn_label(function, &done);
+	t = jit_insn_mul(function, s, jit_value_create_float64_constant(function, jit_type_float64, 1000.0));
+	jit_insn_return(function, jit_insn_convert(function, t, jit_type_long, 0));
+	return function;
+}
+
+static jit_long
+float_kernel(jit_int n)
+{
+	jit_float64 x = 0.5, s = 0;
+	jit_int i;
+	for(i = 0; i < n; ++i)
+	{
+		x = x * 0.999 + 0.25;
+		s = s + x * x / (x + 1.0);
+	}
+	return (jit_long)(s * 1000.0);
+}
+
+/*
+ * Build the memory kernel, a running sum over an array that is
+ * stored back into the array:
+ *
+ *	long memory_kernel(int *a, int n)
+ *	{
+ *		int s = 0;
+ *		for(int i = 0; i < n; ++i)
+ *		{
+ *			s += a[i];
+ *			a[i] = s;
+ *		}
+ *		return s;
+ *	}
+ */
+static jit_function_t
+build_memory_kernel(jit_context_t context)
+{
+	jit_type_t params[2];
+	jit_type_t signature;
+	jit_function_t function;
+	jit_value_t a, n, i, s;
+	jit_label_t top = jit_label_undefined;
+	jit_label_t done = jit_label_undefined;
+
+	params[0] = jit_type_void_ptr;
+	params[1] = jit_type_int;
+	signature = jit_type_create_signature
+		(jit_abi_cdecl, jit_type_long, params, 2, 1);
+	function = create_function(context, signature);
+	jit_type_free(signature);
+
+	a = jit_value_get_param(function, 0);
+	n = jit_value_get_param(function, 1);
+	i = jit_value_create(function, jit_type_int);
+	s = jit_value_create(function, jit_type_int);
+	jit_insn_store(function, i, jit_value_create_nint_constant(function, jit_type_int, 0));
+	jit_insn_store(function, s, jit_value_create_nint_constant(function, jit_type_int, 0));
+
+	jit_insn_label(function, &top);
+	jit_insn_branch_if_not(function, jit_insn_lt(function, i, n), &done);
+	jit_insn_store(function, s, jit_insn_add(function, s, jit_insn_load_elem(function, a, i, jit_type_int)));
+	jit_insn_store_elem(function, a, i, s);
+	jit_insn_store(function, i, jit_insn_add(function, i, jit_value_create_nint_constant(function, jit_type_int, 1)));
+	jit_insn_branch(function, &top);
+
+	jit_insn_label(function, &done);
+	jit_insn_return(function, jit_insn_convert(function, s, jit_type_long, 0));
+	return function;
+}
+
+static jit_long
+memory_kernel(jit_int *a, jit_int n)
+{
+	jit_int s = 0;
+	jit_int i;
+	for(i = 0; i < n; ++i)
+	{
+		s += a[i];
+		a[i] = s;
+	}
+	return s;
+}
+
+/*
+ * Build the call kernel, the recursive Fibonacci function:
+ *
+ *	int fib(int n)
+ *	{
+ *		if(n < 2)
+ *			return n;
+ *		return fib(n - 1) + fib(n - 2);
+ *	}
+ */
+static jit_function_t
+build_call_kernel(jit_context_t context)
+{
+	jit_type_t params[1];
+	jit_type_t signature;
+	jit_function_t function;
+	jit_value_t n, args[1], r1, r2;
+	jit_label_t recurse = jit_label_undefined;
+
+	params[0] = jit_type_int;
+	signature = jit_type_create_signature
+		(jit_abi_cdecl, jit_type_int, params, 1, 1);
+	function = create_function(context, signature);
+
+	n = jit_value_get_param(function, 0);
+	jit_insn_branch_if_not(function,
+			       jit_insn_lt(function, n, jit_value_create_nint_constant(function, jit_type_int, 2)),
+			       &recurse);
+	jit_insn_return(function, n);
+
+	jit_insn_label(function, &recurse);
+	args[0] = jit_insn_sub(function, n, jit_value_create_nint_constant(function, jit_type_int, 1));
+	r1 = jit_insn_call(function, "fib", function, signature, args, 1, 0);
+	args[0] = jit_insn_sub(function, n, jit_value_create_nint_constant(function, jit_type_int, 2));
+	r2 = jit_insn_call(function, "fib", function, signature, args, 1, 0);
+	jit_insn_return(function, jit_insn_add(function, r1, r2));
+
+	jit_type_free(signature);
+	return function;
+}
+
+static jit_int
+call_kernel(jit_int n)
+{
+	if(n < 2)
+	{
+		return n;
+	}
+	return call_kernel(n - 1) + call_kernel(n - 2);
+}
+
+/*
+ * Compile a kernel and time its execution.
+ */
+static void
+bench_kernel(const char *name, jit_function_t (*build)(jit_context_t),
+	     void **args, void *result, jit_long (*get_result)(void *),
+	     jit_long expected, void (*reset)(void), double work, const char *unit)
+{
+	jit_context_t context;
+	jit_function_t function;
+	double start, elapsed, best;
+	int run;
+
+	context = jit_context_create();
+	jit_context_build_start(context);
+	start = now_usec();
+	function = (*build)(context);
+	if(!jit_function_compile(function))
+	{
+		fprintf(stderr, "jitbench: %s: compile failed\n", name);
+		exit(1);
+	}
+	elapsed = now_usec() - start;
+	jit_context_build_end(context);
+	report(name, "compile_time", elapsed, "us");
+
+	best = 0;
+	for(run = 0; run < repeat; ++run)
+	{
+		if(reset)
+		{
+			(*reset)();
+		}
+		start = now_usec();
+		jit_function_apply(function, args, result);
+		elapsed = now_usec() - start;
+		report_check(name, (*get_result)(result), expected);
+		if(run == 0 || elapsed < best)
+		{
+			best = elapsed;
+		}
+	}
+	report(name, "run_time", best / 1000.0, "ms");
+	report(name, "throughput", work / best, unit);
+
+	jit_context_destroy(context);
+}
+
+static jit_long
+get_long(void *result)
+{
+	return *((jit_long *)result);
+}
+
+static jit_long
+get_int(void *result)
+{
+	return *((jit_int *)result);
+}
+
+static jit_int *memory_array;
+static jit_int memory_size;
+
+static void
+reset_memory(void)
+{
+	jit_int i;
+	for(i = 0; i < memory_size; ++i)
+	{
+		memory_array[i] = (i & 7) - 3;
+	}
+}
+
+/*
+ * Determine if a benchmark should be run.
+ */
+static int
+selected(const char *name, char **names, int num_names)
+{
+	int index;
+
+	if(num_names == 0)
+	{
+		return 1;
+	}
+	for(index = 0; index < num_names; ++index)
+	{
+		if(!strncmp(name, names[index], strlen(names[index])))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void
+usage(void)
+{
+	fprintf(stderr, "Usage: jitbench [-s scale] [-r repeat] [-O level] [benchmark ...]\n");
+	exit(1);
+}
+
+int
+main(int argc, char **argv)
+{
+	static int const compile_sizes[] = {100, 1000, 10000};
+	char **names;
+	int num_names;
+	int index;
+	char name[64];
+	jit_int n;
+	void *args[2];
+	jit_long long_result;
+	jit_int int_result;
+	jit_long expected;
+
+	/* Parse the command line */
+	names = (char **)malloc(sizeof(char *) * argc);
+	num_names = 0;
+	for(index = 1; index < argc; ++index)
+	{
+		if(argv[index][0] == '-' && argv[index][1] != '\0' && argv[index][2] == '\0')
+		{
+			if(index + 1 >= argc)
+			{
+				usage();
+			}
+			switch(argv[index][1])
+			{
+			case 's':
+				scale = atoi(argv[++index]);
+				break;
+
+			case 'r':
+				repeat = atoi(argv[++index]);
+				break;
+
+			case 'O':
+				opt_level = atoi(argv[++index]);
+				break;
+
+			default:
+				usage();
+			}
+		}
+		else
+		{
+			names[num_names++] = argv[index];
+		}
+	}
+	if(scale < 1 || repeat < 1)
+	{
+		usage();
+	}
+
+	jit_init();
+	backend = jit_uses_interpreter() ? "interpreter" : "native";
+
+	printf("# libjit benchmark: scale %d, repeat %d, optimization level %d\n",
+	       scale, repeat, opt_level);
+	printf("backend\tbenchmark\tmetric\tvalue\tunit\n");
+
+	for(index = 0; index < (int)(sizeof(compile_sizes) / sizeof(int)); ++index)
+	{
+		sprintf(name, "compile.insns_%d", compile_sizes[index]);
+		if(selected(name, names, num_names))
+		{
+			bench_compile(compile_sizes[index]);
+		}
+	}
+
+	if(selected("kernel.int", names, num_names))
+	{
+		n = 20000000 * scale;
+		args[0] = &n;
+		bench_kernel("kernel.int", build_int_kernel, args, &long_result,
+			     get_long, int_kernel(n), 0, n, "iterations/us");
+	}
+
+	if(selected("kernel.float", names, num_names))
+	{
+		n = 10000000 * scale;
+		args[0] = &n;
+		bench_kernel("kernel.float", build_float_kernel, args, &long_result,
+			     get_long, float_kernel(n), 0, n, "iterations/us");
+	}
+
+	if(selected("kernel.memory", names, num_names))
+	{
+		memory_size = 4000000;
+		memory_array = (jit_int *)malloc(sizeof(jit_int) * memory_size);
+		if(!memory_array)
+		{
+			fprintf(stderr, "jitbench: out of memory\n");
+			return 1;
+		}
+		reset_memory();
+		expected = memory_kernel(memory_array, memory_size);
+		n = memory_size;
+		args[0] = &memory_array;
+		args[1] = &n;
+		bench_kernel("kernel.memory", build_memory_kernel, args, &long_result,
+			     get_long, expected, reset_memory,
+			     (double)memory_size * sizeof(jit_int), "bytes/us");
+		free(memory_array);
+	}
+
+	if(selected("kernel.call", names, num_names))
+	{
+		n = 27 + (scale > 1 ? 2 : 0);
+		args[0] = &n;
+		bench_kernel("kernel.call", build_call_kernel, args, &int_result,
+			     get_int, call_kernel(n), 0,
+			     (double)(2 * call_kernel(n + 1) - 1), "calls/us");
+	}
+
+	free(names);
+	return 0;
+}
@@ -34,6 +34,10 @@ void jit_context_destroy(jit_context_t context) JIT_NOTHROW;
 void jit_context_build_start(jit_context_t context) JIT_NOTHROW;
 void jit_context_build_end(jit_context_t context) JIT_NOTHROW;
 
+int jit_context_run_compile_queue
+	(jit_context_t context, int wait) JIT_NOTHROW;
+void jit_context_stop_compile_queue(jit_context_t context) JIT_NOTHROW;
+
 void jit_context_set_on_demand_driver(
 	jit_context_t context,
 	jit_on_demand_driver_func driver) JIT_NOTHROW;
@@ -61,6 +65,7 @@ void jit_context_free_meta(jit_context_t context, int type) JIT_NOTHROW;
 #define	JIT_OPTION_DONT_FOLD		10003
 #define JIT_OPTION_POSITION_INDEPENDENT	10004
 #define JIT_OPTION_CACHE_MAX_PAGE_FACTOR	10005
+#define JIT_OPTION_CONCURRENT_BUILD	10006
 
 #ifdef	__cplusplus
 };
@@ -211,6 +211,8 @@ int jit_insn_branch_if
 	(jit_function_t func, jit_value_t value, jit_label_t *label) JIT_NOTHROW;
 int jit_insn_branch_if_not
 	(jit_function_t func, jit_value_t value, jit_label_t *label) JIT_NOTHROW;
+int jit_insn_set_branch_weights
+	(jit_function_t func, jit_uint taken, jit_uint not_taken) JIT_NOTHROW;
 int jit_insn_jump_table
 	(jit_function_t func, jit_value_t value,
 	 jit_label_t *labels, unsigned int num_labels) JIT_NOTHROW;
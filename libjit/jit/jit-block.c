@@ -900,6 +900,433 @@ _jit_block_clean_cfg(jit_function_t func)
 	}
 }
 
+/* A branch edge is unlikely if it is taken less than once in this
+   many executions of the branch */
+#define	UNLIKELY_RATIO		16
+
+/* Determine if the block ends with a conditional branch */
+static int
+ends_in_cond_branch(jit_block_t block)
+{
+	jit_insn_t insn;
+
+	insn = _jit_block_get_last(block);
+	return (insn && insn->opcode > JIT_OP_BR && insn->opcode <= JIT_OP_BR_NFGE_INV);
+}
+
+/* Get the opcode that branches on the opposite condition */
+static int
+invert_branch(int opcode)
+{
+	switch(opcode)
+	{
+	case JIT_OP_BR_IFALSE:		return JIT_OP_BR_ITRUE;
+	case JIT_OP_BR_ITRUE:		return JIT_OP_BR_IFALSE;
+	case JIT_OP_BR_IEQ:		return JIT_OP_BR_INE;
+	case JIT_OP_BR_INE:		return JIT_OP_BR_IEQ;
+	case JIT_OP_BR_ILT:		return JIT_OP_BR_IGE;
+	case JIT_OP_BR_ILT_UN:		return JIT_OP_BR_IGE_UN;
+	case JIT_OP_BR_ILE:		return JIT_OP_BR_IGT;
+	case JIT_OP_BR_ILE_UN:		return JIT_OP_BR_IGT_UN;
+	case JIT_OP_BR_IGT:		return JIT_OP_BR_ILE;
+	case JIT_OP_BR_IGT_UN:		return JIT_OP_BR_ILE_UN;
+	case JIT_OP_BR_IGE:		return JIT_OP_BR_ILT;
+	case JIT_OP_BR_IGE_UN:		return JIT_OP_BR_ILT_UN;
+	case JIT_OP_BR_LFALSE:		return JIT_OP_BR_LTRUE;
+	case JIT_OP_BR_LTRUE:		return JIT_OP_BR_LFALSE;
+	case JIT_OP_BR_LEQ:		return JIT_OP_BR_LNE;
+	case JIT_OP_BR_LNE:		return JIT_OP_BR_LEQ;
+	case JIT_OP_BR_LLT:		return JIT_OP_BR_LGE;
+	case JIT_OP_BR_LLT_UN:		return JIT_OP_BR_LGE_UN;
+	case JIT_OP_BR_LLE:		return JIT_OP_BR_LGT;
+	case JIT_OP_BR_LLE_UN:		return JIT_OP_BR_LGT_UN;
+	case JIT_OP_BR_LGT:		return JIT_OP_BR_LLE;
+	case JIT_OP_BR_LGT_UN:		return JIT_OP_BR_LLE_UN;
+	case JIT_OP_BR_LGE:		return JIT_OP_BR_LLT;
+	case JIT_OP_BR_LGE_UN:		return JIT_OP_BR_LLT_UN;
+	case JIT_OP_BR_FEQ:		return JIT_OP_BR_FNE;
+	case JIT_OP_BR_FNE:		return JIT_OP_BR_FEQ;
+	case JIT_OP_BR_FLT:		return JIT_OP_BR_FGE_INV;
+	case JIT_OP_BR_FLE:		return JIT_OP_BR_FGT_INV;
+	case JIT_OP_BR_FGT:		return JIT_OP_BR_FLE_INV;
+	case JIT_OP_BR_FGE:		return JIT_OP_BR_FLT_INV;
+	case JIT_OP_BR_FLT_INV:		return JIT_OP_BR_FGE;
+	case JIT_OP_BR_FLE_INV:		return JIT_OP_BR_FGT;
+	case JIT_OP_BR_FGT_INV:		return JIT_OP_BR_FLE;
+	case JIT_OP_BR_FGE_INV:		return JIT_OP_BR_FLT;
+	case JIT_OP_BR_DEQ:		return JIT_OP_BR_DNE;
+	case JIT_OP_BR_DNE:		return JIT_OP_BR_DEQ;
+	case JIT_OP_BR_DLT:		return JIT_OP_BR_DGE_INV;
+	case JIT_OP_BR_DLE:		return JIT_OP_BR_DGT_INV;
+	case JIT_OP_BR_DGT:		return JIT_OP_BR_DLE_INV;
+	case JIT_OP_BR_DGE:		return JIT_OP_BR_DLT_INV;
+	case JIT_OP_BR_DLT_INV:		return JIT_OP_BR_DGE;
+	case JIT_OP_BR_DLE_INV:		return JIT_OP_BR_DGT;
+	case JIT_OP_BR_DGT_INV:		return JIT_OP_BR_DLE;
+	case JIT_OP_BR_DGE_INV:		return JIT_OP_BR_DLT;
+	case JIT_OP_BR_NFEQ:		return JIT_OP_BR_NFNE;
+	case JIT_OP_BR_NFNE:		return JIT_OP_BR_NFEQ;
+	case JIT_OP_BR_NFLT:		return JIT_OP_BR_NFGE_INV;
+	case JIT_OP_BR_NFLE:		return JIT_OP_BR_NFGT_INV;
+	case JIT_OP_BR_NFGT:		return JIT_OP_BR_NFLE_INV;
+	case JIT_OP_BR_NFGE:		return JIT_OP_BR_NFLT_INV;
+	case JIT_OP_BR_NFLT_INV:	return JIT_OP_BR_NFGE;
+	case JIT_OP_BR_NFLE_INV:	return JIT_OP_BR_NFGT;
+	case JIT_OP_BR_NFGT_INV:	return JIT_OP_BR_NFLE;
+	case JIT_OP_BR_NFGE_INV:	return JIT_OP_BR_NFLT;
+	}
+	return JIT_OP_NOP;
+}
+
+/* Create a new label for the block so that it can be branched to */
+static jit_label_t
+new_block_label(jit_function_t func, jit_block_t block)
+{
+	jit_label_t label;
+
+	label = (func->builder->next_label)++;
+	if(!_jit_block_record_label(block, label))
+	{
+		jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
+	}
+	return label;
+}
+
+/* Find the successor edge of the block that has the given flags */
+static _jit_edge_t
+find_succ_edge(jit_block_t block, int flags)
+{
+	int index;
+
+	for(index = 0; index < block->num_succs; index++)
+	{
+		if(block->succs[index]->flags == flags)
+		{
+			return block->succs[index];
+		}
+	}
+	return 0;
+}
+
+/* Determine if an edge is unlikely to be taken according to the weights
+   recorded with "jit_insn_set_branch_weights" */
+static int
+is_unlikely_edge(_jit_edge_t edge)
+{
+	jit_block_t block;
+	jit_ulong weight;
+	jit_ulong total;
+
+	block = edge->src;
+	if(block->num_succs != 2 || !ends_in_cond_branch(block))
+	{
+		return 0;
+	}
+	if(edge->flags == _JIT_EDGE_BRANCH)
+	{
+		weight = block->taken_weight;
+	}
+	else if(edge->flags == _JIT_EDGE_FALLTHRU)
+	{
+		weight = block->not_taken_weight;
+	}
+	else
+	{
+		return 0;
+	}
+	total = (jit_ulong)(block->taken_weight) + (jit_ulong)(block->not_taken_weight);
+	return (total != 0 && weight * UNLIKELY_RATIO < total);
+}
+
+/* Determine if the block ends by throwing an exception or by calling
+   a function that does not return */
+static int
+ends_in_throw(jit_block_t block)
+{
+	int index, opcode;
+
+	if(!block->ends_in_dead)
+	{
+		return 0;
+	}
+	for(index = block->num_insns - 1; index >= 0; index--)
+	{
+		opcode = block->insns[index].opcode;
+		switch(opcode)
+		{
+		case JIT_OP_THROW:
+		case JIT_OP_RETHROW:
+		case JIT_OP_CALL:
+		case JIT_OP_CALL_INDIRECT:
+		case JIT_OP_CALL_VTABLE_PTR:
+		case JIT_OP_CALL_EXTERNAL:
+			return 1;
+
+		case JIT_OP_CALL_TAIL:
+		case JIT_OP_CALL_INDIRECT_TAIL:
+		case JIT_OP_CALL_VTABLE_PTR_TAIL:
+		case JIT_OP_CALL_EXTERNAL_TAIL:
+		case JIT_OP_JUMP_TABLE:
+		case JIT_OP_LEAVE_FINALLY:
+		case JIT_OP_LEAVE_FILTER:
+		case JIT_OP_CALL_FINALLY:
+		case JIT_OP_CALL_FILTER:
+			return 0;
+		}
+		if(opcode >= JIT_OP_BR && opcode <= JIT_OP_BR_NFGE_INV)
+		{
+			return 0;
+		}
+		if(opcode >= JIT_OP_RETURN && opcode <= JIT_OP_RETURN_SMALL_STRUCT)
+		{
+			return 0;
+		}
+	}
+	return 0;
+}
+
+/* Find the blocks that are unlikely to be executed.  These are the blocks
+   that end by throwing an exception, the blocks that are only entered
+   from cold blocks or through unlikely edges, and the blocks that only
+   lead to cold blocks */
+static void
+mark_cold_blocks(jit_function_t func)
+{
+	jit_block_t block;
+	_jit_edge_t edge;
+	int index, count, cold, changed;
+
+	func->builder->entry_block->cold = 0;
+	for(block = func->builder->entry_block->next;
+	    block != func->builder->exit_block;
+	    block = block->next)
+	{
+		block->cold = ends_in_throw(block);
+	}
+
+	do
+	{
+		changed = 0;
+		for(block = func->builder->entry_block->next;
+		    block != func->builder->exit_block;
+		    block = block->next)
+		{
+			if(block->cold)
+			{
+				continue;
+			}
+
+			cold = (block->num_preds > 0);
+			for(index = 0; cold && index < block->num_preds; index++)
+			{
+				edge = block->preds[index];
+				if(!edge->src->cold && !is_unlikely_edge(edge))
+				{
+					cold = 0;
+				}
+			}
+
+			if(!cold)
+			{
+				cold = 1;
+				count = 0;
+				for(index = 0; cold && index < block->num_succs; index++)
+				{
+					edge = block->succs[index];
+					if(edge->flags == _JIT_EDGE_EXCEPT)
+					{
+						continue;
+					}
+					if(!edge->dst->cold)
+					{
+						cold = 0;
+					}
+					++count;
+				}
+				cold = (cold && count > 0);
+			}
+
+			if(cold)
+			{
+				block->cold = 1;
+				changed = 1;
+			}
+		}
+	}
+	while(changed);
+}
+
+/* Move the run of cold blocks from "first" to "last" in front of the exit
+   block.  Returns zero if the run cannot be moved */
+static int
+move_cold_blocks(jit_function_t func, jit_block_t first, jit_block_t last)
+{
+	jit_block_t prev, next;
+	jit_insn_t insn;
+	_jit_edge_t edge, fallthru;
+	jit_uint weight;
+
+	prev = first->prev;
+	next = last->next;
+	if(!last->ends_in_dead && ends_in_cond_branch(last))
+	{
+		return 0;
+	}
+
+	/* If the previous block falls through into the run then it must
+	   branch over it to the next block, which can be done by inverting
+	   its conditional branch */
+	if(!prev->ends_in_dead)
+	{
+		if(!ends_in_cond_branch(prev))
+		{
+			return 0;
+		}
+		edge = find_succ_edge(prev, _JIT_EDGE_BRANCH);
+		fallthru = find_succ_edge(prev, _JIT_EDGE_FALLTHRU);
+		if(!edge || !fallthru || edge->dst != next)
+		{
+			return 0;
+		}
+
+		insn = _jit_block_get_last(prev);
+		insn->opcode = (short)invert_branch(insn->opcode);
+		insn->dest = (jit_value_t)new_block_label(func, first);
+		edge->flags = _JIT_EDGE_FALLTHRU;
+		fallthru->flags = _JIT_EDGE_BRANCH;
+		prev->succs[0] = fallthru;
+		prev->succs[1] = edge;
+		weight = prev->taken_weight;
+		prev->taken_weight = prev->not_taken_weight;
+		prev->not_taken_weight = weight;
+	}
+
+	/* If the last block of the run falls through then it now needs
+	   an explicit branch to its successor */
+	if(!last->ends_in_dead)
+	{
+		edge = find_succ_edge(last, _JIT_EDGE_FALLTHRU);
+		insn = _jit_block_add_insn(last);
+		if(!insn)
+		{
+			jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
+		}
+		insn->opcode = JIT_OP_BR;
+		insn->flags = JIT_INSN_DEST_IS_LABEL;
+		insn->dest = (jit_value_t)new_block_label(func, next);
+		last->ends_in_dead = 1;
+		if(edge)
+		{
+			edge->flags = _JIT_EDGE_BRANCH;
+		}
+	}
+
+	_jit_block_detach(first, last);
+	_jit_block_attach_before(func->builder->exit_block, first, last);
+
+	/* The previous block might have branched over the run */
+	insn = _jit_block_get_last(prev);
+	if(insn && insn->opcode == JIT_OP_BR
+	   && jit_block_from_label(func, (jit_label_t)insn->dest) == next)
+	{
+		insn->opcode = JIT_OP_NOP;
+		prev->ends_in_dead = 0;
+		edge = find_succ_edge(prev, _JIT_EDGE_BRANCH);
+		if(edge)
+		{
+			edge->flags = _JIT_EDGE_FALLTHRU;
+		}
+	}
+
+	return 1;
+}
+
+/* Mark the blocks that are targets of backward branches */
+static void
+mark_loop_headers(jit_function_t func)
+{
+	jit_block_t block;
+	_jit_edge_t edge;
+	int index;
+
+	clear_visited(func);
+	for(block = func->builder->entry_block;
+	    block != func->builder->exit_block;
+	    block = block->next)
+	{
+		block->visited = 1;
+		if(block->cold)
+		{
+			continue;
+		}
+		for(index = 0; index < block->num_succs; index++)
+		{
+			edge = block->succs[index];
+			if(edge->flags == _JIT_EDGE_BRANCH
+			   && edge->dst->visited && !edge->dst->cold)
+			{
+				edge->dst->loop_header = 1;
+			}
+		}
+	}
+	clear_visited(func);
+}
+
+void
+_jit_block_layout(jit_function_t func)
+{
+	jit_block_t block, first, last, moved;
+
+	/* The blocks of the try regions are found by the address range
+	   so these functions are left alone */
+	if(!func->has_try)
+	{
+		mark_cold_blocks(func);
+
+		/* The last hot block must not fall through into the cold code */
+		if(func->builder->exit_block->prev->ends_in_dead)
+		{
+			moved = func->builder->exit_block;
+			block = func->builder->entry_block->next;
+			while(block != moved && block != func->builder->exit_block)
+			{
+				if(!block->cold || block->address_of)
+				{
+					block = block->next;
+					continue;
+				}
+
+				/* Find the longest run of cold blocks that
+				   fall through into each other */
+				first = block;
+				last = block;
+				while(!last->ends_in_dead
+				      && last->next != moved
+				      && last->next != func->builder->exit_block
+				      && last->next->cold
+				      && !last->next->address_of)
+				{
+					last = last->next;
+				}
+				if(last->next == moved || last->next == func->builder->exit_block)
+				{
+					/* The run is already at the end */
+					break;
+				}
+
+				block = last->next;
+				if(move_cold_blocks(func, first, last)
+				   && moved == func->builder->exit_block)
+				{
+					moved = first;
+				}
+			}
+		}
+	}
+
+	mark_loop_headers(func);
+}
+
 int
 _jit_block_compute_postorder(jit_function_t func)
 {
@@ -76,6 +76,9 @@ optimize(jit_function_t func)
 	/* Eliminate useless control flow */
 	_jit_block_clean_cfg(func);
 
+	/* Move cold code out of the way of the hot paths */
+	_jit_block_layout(func);
+
 	/* Optimization is done */
 	func->is_optimized = 1;
 }
@@ -377,19 +380,31 @@ cleanup_on_restart(jit_gencode_t gen, jit_function_t func)
 }
 
 /*
- * Acquire the memory context.
+ * Lock the memory context unless it is already locked.
  */
 static void
-memory_acquire(_jit_compile_t *state)
+memory_lock(_jit_compile_t *state)
 {
 	/* Store the function's context as codegen context */
 	state->gen.context = state->func->context;
 
-	/* Acquire the memory context lock */
-	_jit_memory_lock(state->gen.context);
+	if(!state->memory_locked)
+	{
+		/* Acquire the memory context lock */
+		_jit_memory_lock(state->gen.context);
 
-	/* Remember that the lock is acquired */
-	state->memory_locked = 1;
+		/* Remember that the lock is acquired */
+		state->memory_locked = 1;
+	}
+}
+
+/*
+ * Acquire the memory context.
+ */
+static void
+memory_acquire(_jit_compile_t *state)
+{
+	memory_lock(state);
 
 	if(!_jit_memory_ensure(state->gen.context))
 	{
@@ -411,6 +426,20 @@ memory_release(_jit_compile_t *state)
 	}
 }
 
+/*
+ * Let other threads use the memory context while the code is being
+ * generated, if the memory manager keeps a started function apart
+ * for each thread.
+ */
+static void
+memory_detach(_jit_compile_t *state)
+{
+	if(_jit_memory_is_concurrent(state->gen.context))
+	{
+		memory_release(state);
+	}
+}
+
 /*
  * Align the method code on a particular boundary if the
  * difference between the current position and the aligned
@@ -670,6 +699,14 @@ codegen(_jit_compile_t *state)
 	gen->code_start = _jit_gen_prolog(gen, func, gen->code_start);
 #endif
 
+#ifdef JIT_USE_UNWIND_TABLES
+	/* Record how exceptions get to the catcher of the function */
+	if(func->has_try)
+	{
+		func->unwind_table = _jit_gen_unwind_table(gen, func);
+	}
+#endif
+
 #if !defined(JIT_BACKEND_INTERP) && (!defined(jit_redirector_size) || !defined(jit_indirector_size))
 	/* If the function is recompilable, then we need an extra entry
 	   point to properly redirect previous references to the function */
@@ -717,6 +754,7 @@ compile(_jit_compile_t *state, jit_function_t func)
 		}
 
 		/* Release allocated code space and exit */
+		memory_lock(state);
 		memory_abort(state);
 		goto exit;
 	}
@@ -743,9 +781,13 @@ compile(_jit_compile_t *state, jit_function_t func)
 		cleanup_on_restart(&state->gen, state->func);
 
 		/* Allocate more space */
+		memory_lock(state);
 		memory_realloc(state);
 	}
 
+	/* The allocated space is ours until the function is ended */
+	memory_detach(state);
+
 #ifdef _JIT_COMPILE_DEBUG
 	if(state->restart == 0)
 	{
@@ -774,8 +816,16 @@ compile(_jit_compile_t *state, jit_function_t func)
 #endif
 
 	/* End the function's output process */
+	memory_lock(state);
 	memory_flush(state);
 
+	/* Let exceptions find the catcher now that the code is final */
+	if(func->unwind_table &&
+	   !_jit_unwind_add_table(func->context, func->unwind_table))
+	{
+		jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
+	}
+
 	/* Compilation done, no exceptions occurred */
 	result = JIT_RESULT_OK;
 
@@ -971,13 +1021,13 @@ _jit_function_compile_on_demand(jit_function_t func)
 	_jit_compile_t state;
 	int result;
 
-	/* Lock down the context */
-	jit_context_build_start(func->context);
+	/* Lock down the function */
+	jit_function_build_start(func);
 
 	/* Fast return if we are already compiled */
 	if(func->is_compiled)
 	{
-		jit_context_build_end(func->context);
+		jit_function_build_end(func);
 		return func->entry_point;
 	}
 
@@ -1004,8 +1054,8 @@ _jit_function_compile_on_demand(jit_function_t func)
 		_jit_function_free_builder(func);
 	}
 
-	/* Unlock the context and report the result */
-	jit_context_build_end(func->context);
+	/* Unlock the function and report the result */
+	jit_function_build_end(func);
 	if(result != JIT_RESULT_OK)
 	{
 		jit_exception_builtin(result);
@@ -1016,6 +1066,39 @@ _jit_function_compile_on_demand(jit_function_t func)
 	return func->entry_point;
 }
 
+int
+_jit_function_compile_queued(jit_function_t func)
+{
+	jit_exception_func handler;
+	jit_jmp_buf jbuf;
+
+	/* Bail out if we got here too late */
+	if(func->is_compiled)
+	{
+		return JIT_RESULT_OK;
+	}
+
+	/* Override user's exception handler */
+	handler = jit_exception_set_handler(internal_exception_handler);
+
+	/* The driver reports errors by throwing, so catch them here */
+	_jit_unwind_push_setjmp(&jbuf);
+	if(setjmp(jbuf.buf))
+	{
+		_jit_unwind_pop_setjmp();
+		jit_exception_set_handler(handler);
+		return _JIT_RESULT_FROM_OBJECT(jit_exception_get_last_and_clear());
+	}
+
+	/* Compile the function as though it was called */
+	(func->context->on_demand_driver)(func);
+
+	/* Restore the "setjmp" contexts and exit */
+	_jit_unwind_pop_setjmp();
+	jit_exception_set_handler(handler);
+	return JIT_RESULT_OK;
+}
+
 #define	JIT_CACHE_NO_OFFSET		(~((unsigned long)0))
 
 unsigned long
@@ -50,6 +50,20 @@ once the function has been fully compiled.
 You can compile multiple functions during the one build process
 if you wish, which is the normal case when compiling a class.
 
+If the front end can build several functions at once safely, it
+may set the @code{JIT_OPTION_CONCURRENT_BUILD} option and use
+@code{jit_function_build_start} and @code{jit_function_build_end}
+instead.  These lock only the function that is being built, so that
+independent functions are built and compiled in parallel.  Code for
+each function is written into a region of the code cache that its
+thread has to itself, so the cache is locked only briefly at the
+start and the end of the compilation.
+
+Functions may also be compiled ahead of their first call.  The front
+end queues them with @code{jit_function_queue_compile}, and threads
+of its own choosing compile them by calling
+@code{jit_context_run_compile_queue}.
+
 It is usually a good idea to suspend the finalization of
 garbage-collected objects while function building is in progress.
 Otherwise you may get a deadlock when the finalizer thread tries
@@ -88,6 +102,7 @@ jit_context_create(void)
 	/* Initialize the context and return it */
 	jit_mutex_create(&context->memory_lock);
 	jit_mutex_create(&context->builder_lock);
+	jit_monitor_create(&context->compile_queue_lock);
 	context->functions = 0;
 	context->last_function = 0;
 	context->on_demand_driver = _jit_function_compile_on_demand;
@@ -123,10 +138,12 @@ jit_context_destroy(jit_context_t context)
 		_jit_function_destroy(context->functions);
 	}
 
+	_jit_unwind_remove_context(context);
 	_jit_memory_destroy(context);
 
 	jit_mutex_destroy(&context->memory_lock);
 	jit_mutex_destroy(&context->builder_lock);
+	jit_monitor_destroy(&context->compile_queue_lock);
 
 	jit_free(context);
 }
@@ -168,11 +185,11 @@ jit_context_build_end(jit_context_t context)
  *
  * @enumerate
  * @item
- * The context is locked by calling @code{jit_context_build_start}.
+ * The function is locked by calling @code{jit_function_build_start}.
  *
  * @item
  * If the function has already been compiled, @code{libjit} unlocks
- * the context and returns immediately.  This can happen because of race
+ * the function and returns immediately.  This can happen because of race
  * conditions between threads: some other thread may have beaten us
  * to the on-demand compiler.
  *
@@ -187,7 +204,7 @@ jit_context_build_end(jit_context_t context)
  * will call @code{jit_function_compile} to compile the function.
  *
  * @item
- * The context is unlocked by calling @code{jit_context_build_end} and
+ * The function is unlocked by calling @code{jit_function_build_end} and
  * @code{libjit} jumps to the newly-compiled entry point.  If an error
  * occurs, a built-in exception of type @code{JIT_RESULT_COMPILE_ERROR}
  * or @code{JIT_RESULT_OUT_OF_MEMORY} will be thrown.
@@ -214,6 +231,85 @@ jit_context_set_on_demand_driver(jit_context_t context, jit_on_demand_driver_fun
 	}
 }
 
+/*@
+ * @deftypefun int jit_context_run_compile_queue (jit_context_t @var{context}, int @var{wait})
+ * Compile the functions that were queued with
+ * @code{jit_function_queue_compile}, in the order that they were
+ * queued.  Several threads may run the queue at the same time; with
+ * the @code{JIT_OPTION_CONCURRENT_BUILD} option set they will compile
+ * functions in parallel.
+ *
+ * If @var{wait} is zero, then this returns once the queue is empty.
+ * Otherwise it waits for more functions to be queued, and returns
+ * only after @code{jit_context_stop_compile_queue} is called.  This
+ * makes it suitable as the body of a background compiler thread.
+ *
+ * Errors in compiling a queued function are ignored; the function
+ * will be compiled again, and the error reported, on its first call.
+ * Returns the number of functions compiled.
+ * @end deftypefun
+@*/
+int
+jit_context_run_compile_queue(jit_context_t context, int wait)
+{
+	jit_function_t func;
+	int count = 0;
+
+	jit_monitor_lock(&context->compile_queue_lock);
+	for(;;)
+	{
+		func = context->compile_queue;
+		if(func)
+		{
+			/* Take the function off the queue and compile it */
+			context->compile_queue = func->next_queued;
+			if(!context->compile_queue)
+			{
+				context->last_compile_queue = 0;
+			}
+			func->is_queued = 0;
+			func->is_queue_compiling = 1;
+			jit_monitor_unlock(&context->compile_queue_lock);
+			if(_jit_function_compile_queued(func) == JIT_RESULT_OK)
+			{
+				++count;
+			}
+			jit_monitor_lock(&context->compile_queue_lock);
+
+			/* Let a thread that is destroying the function go on */
+			func->is_queue_compiling = 0;
+			jit_monitor_signal_all(&context->compile_queue_lock);
+		}
+		else if(!wait || context->compile_queue_stop)
+		{
+			break;
+		}
+		else if(!jit_monitor_wait(&context->compile_queue_lock, -1))
+		{
+			/* Waiting is not supported without thread support */
+			break;
+		}
+	}
+	jit_monitor_unlock(&context->compile_queue_lock);
+	return count;
+}
+
+/*@
+ * @deftypefun void jit_context_stop_compile_queue (jit_context_t @var{context})
+ * Make the threads that are waiting in @code{jit_context_run_compile_queue}
+ * return once the queue is empty.  This should be called before the
+ * context is destroyed if any background compiler threads are running.
+ * @end deftypefun
+@*/
+void
+jit_context_stop_compile_queue(jit_context_t context)
+{
+	jit_monitor_lock(&context->compile_queue_lock);
+	context->compile_queue_stop = 1;
+	jit_monitor_signal_all(&context->compile_queue_lock);
+	jit_monitor_unlock(&context->compile_queue_lock);
+}
+
 /*@
  * @deftypefun void jit_context_set_memory_manager (jit_context_t @var{context}, jit_memory_manager_t @var{manager})
  * Specify the memory manager plug-in.
@@ -299,6 +395,13 @@ jit_context_set_meta(jit_context_t context, int type, void *data, jit_meta_free_
  * A numeric option that forces generation of position-independent code (PIC)
  * if it is set to a non-zero value. This may be mainly useful for pre-compiled
  * contexts.
+ *
+ * @vindex JIT_OPTION_CONCURRENT_BUILD
+ * @item JIT_OPTION_CONCURRENT_BUILD
+ * A numeric option that makes @code{jit_function_build_start} lock
+ * only the function being built, rather than the whole context, if it
+ * is set to a non-zero value.  This also applies to the default
+ * on-demand driver.  It should be set before any function is built.
  * @end table
  *
  * Metadata type values of 10000 or greater are reserved for internal use.
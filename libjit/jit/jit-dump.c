@@ -582,6 +582,33 @@ static void dump_interp_code(FILE *stream, void **pc, void **end)
 			}
 			break;
 
+			case JIT_OPCODE_NINT_ARG_THREE:
+			{
+				fprintf(stream, " %ld, %ld, %ld",
+						(long)(jit_nint)(pc[0]), (long)(jit_nint)(pc[1]),
+						(long)(jit_nint)(pc[2]));
+				pc += 3;
+			}
+			break;
+
+			case JIT_OPCODE_BRANCH_NINT_ARG:
+			{
+				fprintf(stream, " %08lX, %ld",
+						(long)(jit_nint)((pc - 1) + (jit_nint)(pc[0])),
+						(long)(jit_nint)(pc[1]));
+				pc += 2;
+			}
+			break;
+
+			case JIT_OPCODE_BRANCH_NINT_ARG_TWO:
+			{
+				fprintf(stream, " %08lX, %ld, %ld",
+						(long)(jit_nint)((pc - 1) + (jit_nint)(pc[0])),
+						(long)(jit_nint)(pc[1]), (long)(jit_nint)(pc[2]));
+				pc += 3;
+			}
+			break;
+
 			case JIT_OPCODE_CONST_LONG:
 			{
 				jit_ulong value;
@@ -887,10 +914,16 @@ void jit_dump_function(FILE *stream, jit_function_t func, const char *name)
 	}
 	else if(func->is_compiled)
 	{
-		void *end  = _jit_memory_get_function_end(func->context, func);
+		void *func_info;
+		void *end;
 #if defined(JIT_BACKEND_INTERP)
-		/* Dump the interpreter's bytecode representation */
 		jit_function_interp_t interp;
+#endif
+		func_info = _jit_memory_find_function_info
+			(func->context, func->entry_point);
+		end = _jit_memory_get_function_end(func->context, func_info);
+#if defined(JIT_BACKEND_INTERP)
+		/* Dump the interpreter's bytecode representation */
 		interp = (jit_function_interp_t)(func->entry_point);
 		fprintf(stream, "\t%08lX: prolog(0x%lX, %d, %d, %d)\n",
 				(long)(jit_nint)interp, (long)(jit_nint)func,
@@ -129,6 +129,9 @@ void jit_exception_throw(void *object)
 	if(control)
 	{
 		control->last_exception = object;
+#ifdef JIT_USE_UNWIND_TABLES
+		_jit_unwind_to_catcher(control, jit_get_current_frame());
+#endif
 		if(control->setjmp_head)
 		{
 			control->backtrace_head = control->setjmp_head->trace;
@@ -545,3 +548,34 @@ void _jit_unwind_pop_and_rethrow(void)
 	_jit_unwind_pop_setjmp();
 	jit_exception_throw(jit_exception_get_last());
 }
+
+void *_jit_unwind_get_thrown_pc(void)
+{
+	jit_thread_control_t control = _jit_thread_get_control();
+	if(control)
+	{
+		return control->thrown_pc;
+	}
+	else
+	{
+		return 0;
+	}
+}
+
+void _jit_unwind_rethrow(void *object)
+{
+	jit_thread_control_t control = _jit_thread_get_control();
+	if(control)
+	{
+		control->last_exception = object;
+#ifdef JIT_USE_UNWIND_TABLES
+		_jit_unwind_to_catcher(control, jit_get_next_frame_address
+									(jit_get_current_frame()));
+#endif
+		if(control->setjmp_head)
+		{
+			control->backtrace_head = control->setjmp_head->trace;
+			longjmp(control->setjmp_head->buf, 1);
+		}
+	}
+}
@@ -84,6 +84,19 @@ jit_function_create(jit_context_t context, jit_type_t signature)
 # endif
 #endif /* !defined(JIT_BACKEND_INTERP) && (defined(jit_redirector_size) || defined(jit_indirector_size)) */
 
+	/* Add the function to the context list */
+	func->next = 0;
+	func->prev = context->last_function;
+	if(context->last_function)
+	{
+		context->last_function->next = func;
+	}
+	else
+	{
+		context->functions = func;
+	}
+	context->last_function = func;
+
 	/* Release the memory context */
 	_jit_memory_unlock(context);
 
@@ -91,6 +104,7 @@ jit_function_create(jit_context_t context, jit_type_t signature)
 	func->context = context;
 	func->signature = jit_type_copy(signature);
 	func->optimization_level = JIT_OPTLEVEL_NORMAL;
+	jit_mutex_create(&func->build_lock);
 
 #if !defined(JIT_BACKEND_INTERP) && defined(jit_redirector_size)
 	/* If we aren't using interpretation, then point the function's
@@ -106,19 +120,6 @@ jit_function_create(jit_context_t context, jit_type_t signature)
 	_jit_flush_exec(func->indirector, jit_indirector_size);
 #endif
 
-	/* Add the function to the context list */
-	func->next = 0;
-	func->prev = context->last_function;
-	if(context->last_function)
-	{
-		context->last_function->next = func;
-	}
-	else
-	{
-		context->functions = func;
-	}
-	context->last_function = func;
-
 	/* Return the function to the caller */
 	return func;
 }
@@ -235,6 +236,50 @@ _jit_function_destroy(jit_function_t func)
 	}
 
 	context = func->context;
+
+	/* Wait for a thread that is compiling the function from the queue,
+	   and then take the function off the queue */
+	jit_monitor_lock(&context->compile_queue_lock);
+	while(func->is_queue_compiling)
+	{
+		if(!jit_monitor_wait(&context->compile_queue_lock, -1))
+		{
+			break;
+		}
+	}
+	if(func->is_queued)
+	{
+		jit_function_t prev = 0;
+		jit_function_t queued = context->compile_queue;
+		while(queued != func)
+		{
+			prev = queued;
+			queued = queued->next_queued;
+		}
+		if(prev)
+		{
+			prev->next_queued = func->next_queued;
+		}
+		else
+		{
+			context->compile_queue = func->next_queued;
+		}
+		if(context->last_compile_queue == func)
+		{
+			context->last_compile_queue = prev;
+		}
+		func->is_queued = 0;
+	}
+	jit_monitor_unlock(&context->compile_queue_lock);
+
+	_jit_function_free_builder(func);
+	_jit_varint_free_data(func->bytecode_offset);
+	jit_meta_destroy(&func->meta);
+	jit_type_free(func->signature);
+	jit_mutex_destroy(&func->build_lock);
+
+	_jit_memory_lock(context);
+
 	if(func->next)
 	{
 		func->next->prev = func->prev;
@@ -252,13 +297,6 @@ _jit_function_destroy(jit_function_t func)
 		context->functions = func->next;
 	}
 
-	_jit_function_free_builder(func);
-	_jit_varint_free_data(func->bytecode_offset);
-	jit_meta_destroy(&func->meta);
-	jit_type_free(func->signature);
-
-	_jit_memory_lock(context);
-
 #if !defined(JIT_BACKEND_INTERP) && (defined(jit_redirector_size) || defined(jit_indirector_size))
 # if defined(jit_redirector_size)
 	_jit_memory_free_trampoline(context, func->redirector);
@@ -528,6 +566,99 @@ int jit_function_is_compiled(jit_function_t func)
 	}
 }
 
+/*@
+ * @deftypefun void jit_function_build_start (jit_function_t @var{func})
+ * This routine should be called before you start building or compiling
+ * the function @var{func}.  Normally it is the same as calling
+ * @code{jit_context_build_start} on the function's context.
+ *
+ * If the context's @code{JIT_OPTION_CONCURRENT_BUILD} option is set,
+ * then only @var{func} is locked, and other threads may build and
+ * compile other functions in the same context at the same time.
+ * Concurrent building is safe only if the front end's own data
+ * structures, and any types that are shared between functions,
+ * are not modified without suitable locking.
+ * @end deftypefun
+@*/
+void jit_function_build_start(jit_function_t func)
+{
+	if(jit_context_get_meta_numeric(func->context, JIT_OPTION_CONCURRENT_BUILD))
+	{
+		jit_mutex_lock(&func->build_lock);
+	}
+	else
+	{
+		jit_context_build_start(func->context);
+	}
+}
+
+/*@
+ * @deftypefun void jit_function_build_end (jit_function_t @var{func})
+ * This routine should be called once you have finished building
+ * and compiling the function @var{func}.  It releases the lock
+ * acquired by @code{jit_function_build_start}.
+ * @end deftypefun
+@*/
+void jit_function_build_end(jit_function_t func)
+{
+	if(jit_context_get_meta_numeric(func->context, JIT_OPTION_CONCURRENT_BUILD))
+	{
+		jit_mutex_unlock(&func->build_lock);
+	}
+	else
+	{
+		jit_context_build_end(func->context);
+	}
+}
+
+/*@
+ * @deftypefun int jit_function_queue_compile (jit_function_t @var{func})
+ * Request that @var{func} be compiled ahead of its first call.  The
+ * function is placed on its context's compile queue, and will be
+ * compiled by the next thread that calls
+ * @code{jit_context_run_compile_queue}.  The function is compiled
+ * with the context's on-demand driver, exactly as it would have been
+ * on its first call, so it must have an on-demand compiler.
+ *
+ * Returns zero if @var{func} is already compiled or has no on-demand
+ * compiler.  Queueing a function that is already on the queue, or
+ * that is being compiled from the queue, is harmless.
+ *
+ * A queued function may be destroyed, with its context or with
+ * @code{jit_function_abandon}.  This takes it off the queue, and
+ * waits for the thread that is compiling it from the queue, if any.
+ * @end deftypefun
+@*/
+int jit_function_queue_compile(jit_function_t func)
+{
+	jit_context_t context;
+
+	if(!func || func->is_compiled || !func->on_demand)
+	{
+		return 0;
+	}
+	context = func->context;
+
+	jit_monitor_lock(&context->compile_queue_lock);
+	if(!func->is_queued && !func->is_queue_compiling)
+	{
+		func->is_queued = 1;
+		func->next_queued = 0;
+		if(context->last_compile_queue)
+		{
+			context->last_compile_queue->next_queued = func;
+		}
+		else
+		{
+			context->compile_queue = func;
+		}
+		context->last_compile_queue = func;
+		jit_monitor_signal(&context->compile_queue_lock);
+	}
+	jit_monitor_unlock(&context->compile_queue_lock);
+	return 1;
+}
+
 /*@
  * @deftypefun int jit_function_set_recompilable (jit_function_t @var{func})
  * Mark this function as a candidate for recompilation.  That is,
@@ -798,7 +929,7 @@ jit_function_from_vtable_pointer(jit_context_t context, void *vtable_pointer)
  *
  * @enumerate
  * @item
- * The context is locked by calling @code{jit_context_build_start}.
+ * The function is locked by calling @code{jit_function_build_start}.
  *
  * @item
  * If the function has already been compiled, @code{libjit} unlocks
@@ -817,7 +948,7 @@ jit_function_from_vtable_pointer(jit_context_t context, void *vtable_pointer)
  * will call @code{jit_function_compile} to compile the function.
  *
  * @item
- * The context is unlocked by calling @code{jit_context_build_end} and
+ * The function is unlocked by calling @code{jit_function_build_end} and
  * @code{libjit} jumps to the newly-compiled entry point.  If an error
  * occurs, a built-in exception of type @code{JIT_RESULT_COMPILE_ERROR}
  * or @code{JIT_RESULT_OUT_OF_MEMORY} will be thrown.
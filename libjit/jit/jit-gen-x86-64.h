@@ -5630,6 +5630,86 @@ typedef union
 		x86_64_membase_emit ((inst), 5, (basereg), (disp)); \
 	} while(0)
 
+/*
+ * Emit a single nop instruction of 1 to 9 bytes.
+ * These are the multi-byte forms recommended by the vendors and are
+ * safe to execute, so they can be used to align branch targets.
+ */
+#define x86_64_nop_size(inst, size) \
+	do { \
+		switch((size)) \
+		{ \
+			case 1: \
+				*(inst)++ = (unsigned char)0x90; \
+				break; \
+			case 2: \
+				*(inst)++ = (unsigned char)0x66; \
+				*(inst)++ = (unsigned char)0x90; \
+				break; \
+			case 3: \
+				*(inst)++ = (unsigned char)0x0f; \
+				*(inst)++ = (unsigned char)0x1f; \
+				*(inst)++ = (unsigned char)0x00; \
+				break; \
+			case 4: \
+				*(inst)++ = (unsigned char)0x0f; \
+				*(inst)++ = (unsigned char)0x1f; \
+				*(inst)++ = (unsigned char)0x40; \
+				*(inst)++ = (unsigned char)0x00; \
+				break; \
+			case 5: \
+				*(inst)++ = (unsigned char)0x0f; \
+				*(inst)++ = (unsigned char)0x1f; \
+				*(inst)++ = (unsigned char)0x44; \
+				*(inst)++ = (unsigned char)0x00; \
+				*(inst)++ = (unsigned char)0x00; \
+				break; \
+			case 6: \
+				*(inst)++ = (unsigned char)0x66; \
+				*(inst)++ = (unsigned char)0x0f; \
+				*(inst)++ = (unsigned char)0x1f; \
+				*(inst)++ = (unsigned char)0x44; \
+				*(inst)++ = (unsigned char)0x00; \
+				*(inst)++ = (unsigned char)0x00; \
+				break; \
+			case 7: \
+				*(inst)++ = (unsigned char)0x0f; \
+				*(inst)++ = (unsigned char)0x1f; \
+				*(inst)++ = (unsigned char)0x80; \
+				x86_imm_emit32((inst), 0); \
+				break; \
+			case 8: \
+				*(inst)++ = (unsigned char)0x0f; \
+				*(inst)++ = (unsigned char)0x1f; \
+				*(inst)++ = (unsigned char)0x84; \
+				*(inst)++ = (unsigned char)0x00; \
+				x86_imm_emit32((inst), 0); \
+				break; \
+			case 9: \
+				*(inst)++ = (unsigned char)0x66; \
+				*(inst)++ = (unsigned char)0x0f; \
+				*(inst)++ = (unsigned char)0x1f; \
+				*(inst)++ = (unsigned char)0x84; \
+				*(inst)++ = (unsigned char)0x00; \
+				x86_imm_emit32((inst), 0); \
+				break; \
+		} \
+	} while(0)
+
+/*
+ * Pad the code with nops up to the given number of bytes.
+ */
+#define x86_64_padding(inst, size) \
+	do { \
+		int __pad = (size); \
+		while(__pad > 9) \
+		{ \
+			x86_64_nop_size((inst), 9); \
+			__pad -= 9; \
+		} \
+		x86_64_nop_size((inst), __pad); \
+	} while(0)
+
 #ifdef	__cplusplus
 };
 #endif
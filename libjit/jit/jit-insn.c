@@ -3622,6 +3622,7 @@ int jit_insn_branch_if
 	{
 		return 0;
 	}
+	func->builder->last_branch_block = 0;
 
 	/* Flush any stack pops that were deferred previously */
 	if(!jit_insn_flush_defer_pop(func, 0))
@@ -3797,6 +3798,9 @@ int jit_insn_branch_if
 	insn->value2 = value2;
 
 add_block:
+	/* Remember the branch for "jit_insn_set_branch_weights" */
+	func->builder->last_branch_block = func->builder->current_block;
+
 	/* Add a new block for the fall-through case */
 	return jit_insn_new_block(func);
 }
@@ -3834,6 +3838,7 @@ int jit_insn_branch_if_not
 	{
 		return 0;
 	}
+	func->builder->last_branch_block = 0;
 
 	/* Flush any stack pops that were deferred previously */
 	if(!jit_insn_flush_defer_pop(func, 0))
@@ -4010,10 +4015,46 @@ int jit_insn_branch_if_not
 	insn->value2 = value2;
 
 add_block:
+	/* Remember the branch for "jit_insn_set_branch_weights" */
+	func->builder->last_branch_block = func->builder->current_block;
+
 	/* Add a new block for the fall-through case */
 	return jit_insn_new_block(func);
 }
 
+/*@
+ * @deftypefun int jit_insn_set_branch_weights (jit_function_t @var{func}, jit_uint @var{taken}, jit_uint @var{not_taken})
+ * Record the relative weights of the two outcomes of the conditional
+ * branch that was most recently output by @code{jit_insn_branch_if} or
+ * @code{jit_insn_branch_if_not}.  The weights may be execution counts
+ * gathered during a profiling run, or simple hints such as 0 and 1
+ * for a branch to an error path that is almost never taken.
+ *
+ * When the function is compiled, blocks that are unlikely to be reached
+ * are moved to the end of the function so that they do not separate the
+ * frequently executed blocks.  Blocks that throw an exception or call
+ * a function marked with @code{JIT_CALL_NORETURN} are always considered
+ * unlikely, so they do not need weights.
+ *
+ * Returns zero if there is no conditional branch to annotate, which
+ * happens when the condition of the last branch was a constant.
+ * @end deftypefun
+@*/
+int jit_insn_set_branch_weights
+		(jit_function_t func, jit_uint taken, jit_uint not_taken)
+{
+	jit_block_t block;
+	if(!func || !(func->builder) || !(func->builder->last_branch_block))
+	{
+		return 0;
+	}
+	block = func->builder->last_branch_block;
+	block->taken_weight = taken;
+	block->not_taken_weight = not_taken;
+	func->builder->last_branch_block = 0;
+	return 1;
+}
+
 /*@
  * @deftypefun int jit_insn_jump_table (jit_function_t @var{func}, jit_value_t @var{value}, jit_label_t *@var{labels}, unsigned int @var{num_labels})
  * Branch to a label from the @var{labels} table. The @var{value} is the
@@ -5128,10 +5169,13 @@ static int convert_call_parameters
 static int setup_eh_frame_for_call(jit_function_t func, int flags)
 {
 #if !defined(JIT_BACKEND_INTERP)
+#if !defined(JIT_USE_UNWIND_TABLES) || JIT_APPLY_BROKEN_FRAME_BUILTINS != 0
 	jit_type_t type;
+#endif
 	jit_value_t args[2];
 	jit_insn_t insn;
 
+#if !defined(JIT_USE_UNWIND_TABLES)
 	/* If "tail" is set, then we need to pop the "setjmp" context */
 	if((flags & JIT_CALL_TAIL) != 0 && func->has_try)
 	{
@@ -5146,6 +5190,7 @@ static int setup_eh_frame_for_call(jit_function_t func, int flags)
 			 (void *)_jit_unwind_pop_setjmp, type, 0, 0, JIT_CALL_NOTHROW);
 		jit_type_free(type);
 	}
+#endif
 
 	/* If "nothrow" or "tail" is set, then there is no more to do */
 	if((flags & (JIT_CALL_NOTHROW | JIT_CALL_TAIL)) != 0)
@@ -6758,7 +6803,7 @@ int jit_insn_return(jit_function_t func, jit_value_t value)
 		return 0;
 	}
 
-#if !defined(JIT_BACKEND_INTERP)
+#if !defined(JIT_BACKEND_INTERP) && !defined(JIT_USE_UNWIND_TABLES)
 	/* We need to pop the "setjmp" context */
 	if(func->has_try)
 	{
@@ -6928,7 +6973,7 @@ int jit_insn_return_ptr
 		return 0;
 	}
 
-#if !defined(JIT_BACKEND_INTERP)
+#if !defined(JIT_BACKEND_INTERP) && !defined(JIT_USE_UNWIND_TABLES)
 	/* We need to pop the "setjmp" context */
 	if(func->has_try)
 	{
@@ -7147,10 +7192,21 @@ jit_value_t jit_insn_thrown_exception(jit_function_t func)
  * Native back ends are responsible for outputting a call to the function
  * "_jit_unwind_pop_setjmp()" just before "return" instructions if the
  * "has_try" flag is set on the function.
+ *
+ * Back ends that catch exceptions with unwind tables don't need the
+ * block.  The stack is unwound straight to the catcher when an exception
+ * is thrown, and the catcher fetches the location of the exception.
  */
 static int initialize_setjmp_block(jit_function_t func)
 {
-#if !defined(JIT_BACKEND_INTERP)
+#if defined(JIT_USE_UNWIND_TABLES)
+	func->builder->catcher_label = jit_label_undefined;
+	if(!func->builder->thrown_pc)
+	{
+		func->builder->thrown_pc = jit_value_create(func, jit_type_void_ptr);
+	}
+	return (func->builder->thrown_pc != 0);
+#elif !defined(JIT_BACKEND_INTERP)
 	jit_label_t start_label = jit_label_undefined;
 	jit_label_t end_label = jit_label_undefined;
 	jit_label_t code_label = jit_label_undefined;
@@ -7415,6 +7471,13 @@ jit_value_t jit_insn_start_catcher(jit_function_t func)
 		func, "jit_exception_get_last",
 		(void *)jit_exception_get_last, type, 0, 0, JIT_CALL_NOTHROW);
 	jit_insn_store(func, value, last_exception);
+#if defined(JIT_USE_UNWIND_TABLES)
+	/* The unwinder records where the exception occurred */
+	last_exception = jit_insn_call_native(
+		func, "_jit_unwind_get_thrown_pc",
+		(void *)_jit_unwind_get_thrown_pc, type, 0, 0, JIT_CALL_NOTHROW);
+	jit_insn_store(func, func->builder->thrown_pc, last_exception);
+#endif
 	jit_type_free(type);
 #endif
 	return value;
@@ -7524,6 +7587,22 @@ int jit_insn_rethrow_unhandled(jit_function_t func)
 		return 0;
 	}
 
+#elif defined(JIT_USE_UNWIND_TABLES)
+
+	/* Call "_jit_unwind_rethrow", which skips the current function */
+	type = jit_type_void_ptr;
+	type = jit_type_create_signature
+		(jit_abi_cdecl, jit_type_void, &type, 1, 1);
+	if(!type)
+	{
+		return 0;
+	}
+	jit_insn_call_native
+		(func, "_jit_unwind_rethrow",
+		 (void *)_jit_unwind_rethrow, type, &value, 1,
+		 JIT_CALL_NOTHROW | JIT_CALL_NORETURN);
+	jit_type_free(type);
+
 #else /* !JIT_BACKEND_INTERP */
 
 	/* Call "_jit_unwind_pop_setjmp" to remove the current exception catcher */
@@ -253,6 +253,15 @@ struct _jit_block
 	unsigned		ends_in_dead : 1;
 	unsigned		address_of : 1;
 
+	/* Block layout flags */
+	unsigned		cold : 1;
+	unsigned		loop_header : 1;
+
+	/* Relative weights of the taken and fall-through edges of the
+	   conditional branch at the end of this block, zero if unknown */
+	jit_uint		taken_weight;
+	jit_uint		not_taken_weight;
+
 	/* Metadata */
 	jit_meta_t		meta;
 
@@ -386,6 +395,9 @@ struct _jit_builder
 	/* The list of deleted blocks */
 	jit_block_t		deleted_blocks;
 
+	/* The block that ends in the most recent conditional branch */
+	jit_block_t		last_branch_block;
+
 	/* Blocks sorted in order required by an optimization pass */
 	jit_block_t		*block_order;
 	int			num_block_order;
@@ -451,6 +463,22 @@ struct _jit_builder
 #endif
 };
 
+/*
+ * Table that describes how exceptions reach the catcher of a function
+ * when the back end catches them by unwinding the stack rather than
+ * with "setjmp".  The table is stored in the code cache next to the
+ * function's code.
+ */
+typedef struct _jit_unwind_table *_jit_unwind_table_t;
+struct _jit_unwind_table
+{
+	void			*start;		/* Start of the code that is covered */
+	void			*end;		/* End of the code that is covered */
+	void			*catcher;	/* Address of the catcher block */
+	jit_nint		frame_size;	/* Distance from the frame pointer
+						   to the stack top on entry */
+};
+
 /*
  * Internal structure of a function.
  */
@@ -487,12 +515,26 @@ struct _jit_function
 	unsigned		has_try : 1;
 	unsigned		optimization_level : 8;
 
+	/* Lock that protects the build process of this function alone */
+	jit_mutex_t		build_lock;
+
+	/* Compile queue link, protected by the context's queue lock */
+	int			is_queued;
+	jit_function_t		next_queued;
+
+	/* Non-zero while a thread compiles the function from the queue,
+	   which keeps the function from being destroyed under it */
+	int			is_queue_compiling;
+
 	/* Flag set once the function is compiled */
 	int volatile		is_compiled;
 
 	/* The entry point for the function's compiled code */
 	void * volatile		entry_point;
 
+	/* Table that describes how to unwind into the function's catcher */
+	_jit_unwind_table_t	unwind_table;
+
 	/* The function to call to perform on-demand compilation */
 	jit_on_demand_func	on_demand;
 
@@ -536,6 +578,13 @@ void _jit_function_compute_liveness(jit_function_t func);
  */
 void *_jit_function_compile_on_demand(jit_function_t func);
 
+/*
+ * Compile a function that was queued for compilation ahead of its
+ * first call, using the context's on-demand driver.  Exceptions
+ * are not propagated.  Returns a JIT_RESULT_* code.
+ */
+int _jit_function_compile_queued(jit_function_t func);
+
 /*
  * Get the bytecode offset that is associated with a native
  * offset within a method.  Returns JIT_CACHE_NO_OFFSET
@@ -567,6 +616,12 @@ struct _jit_context
 	/* Lock that controls access to the building process */
 	jit_mutex_t		builder_lock;
 
+	/* Queue of functions to compile ahead of their first call */
+	jit_monitor_t		compile_queue_lock;
+	jit_function_t		compile_queue;
+	jit_function_t		last_compile_queue;
+	int			compile_queue_stop;
+
 	/* List of functions that are currently registered with the context */
 	jit_function_t		functions;
 	jit_function_t		last_function;
@@ -587,6 +642,9 @@ struct _jit_context
 
 	/* On-demand compilation driver */
 	jit_on_demand_driver_func	on_demand_driver;
+
+	/* Non-zero if the unwind index contains tables of this context */
+	int			has_unwind_tables;
 };
 
 void *_jit_malloc_exec(unsigned int size);
@@ -595,6 +653,7 @@ void _jit_flush_exec(void *ptr, unsigned int size);
 
 void _jit_memory_lock(jit_context_t context);
 void _jit_memory_unlock(jit_context_t context);
+int _jit_memory_is_concurrent(jit_context_t context);
 
 int _jit_memory_ensure(jit_context_t context);
 void _jit_memory_destroy(jit_context_t context);
@@ -656,8 +715,50 @@ struct jit_thread_control
 	jit_exception_func	exception_handler;
 	jit_backtrace_t		backtrace_head;
 	struct jit_jmp_buf	*setjmp_head;
+	void			*thrown_pc;
+
+	/* Location of the fault that a signal handler is throwing an
+	   exception for, so that unwinding starts at the fault */
+	void			*fault_pc;
+	void			*fault_frame;
+
+	/* Regions of code caches that the thread is outputting functions
+	   into.  This belongs to the default memory manager */
+	void			*started_regions;
 };
 
+/*
+ * Add the unwind table of a function that was compiled in "context"
+ * to the index that is searched when an exception is thrown.  Returns
+ * zero if out of memory.
+ */
+int _jit_unwind_add_table(jit_context_t context, _jit_unwind_table_t table);
+
+/*
+ * Remove the unwind tables of a context from the index.  Returns once
+ * no thread that is throwing an exception can see them any more.
+ */
+void _jit_unwind_remove_context(jit_context_t context);
+
+/*
+ * Unwind the stack above "frame" to the catcher of the nearest function
+ * that has an unwind table, if it is closer than the top-most "setjmp"
+ * buffer.  Returns only if there is no such function.
+ */
+void _jit_unwind_to_catcher(jit_thread_control_t control, void *frame);
+
+/*
+ * Get the location within the current function where the exception
+ * that was just caught using an unwind table occurred.
+ */
+void *_jit_unwind_get_thrown_pc(void);
+
+/*
+ * Rethrow an exception that the catcher of the calling function
+ * could not handle.  The search starts with the caller's caller.
+ */
+void _jit_unwind_rethrow(void *object);
+
 /*
  * Initialize the block list for a function.
  */
@@ -679,6 +780,11 @@ void _jit_block_build_cfg(jit_function_t func);
  */
 void _jit_block_clean_cfg(jit_function_t func);
 
+/*
+ * Move cold blocks to the end of a function and mark loop headers.
+ */
+void _jit_block_layout(jit_function_t func);
+
 /*
  * Compute block postorder for control flow graph depth first traversal.
  */
@@ -192,6 +192,22 @@ straight vanilla ANSI C.
 #define	VM_LOC(type)		\
 			((type *)(((jit_item *)frame) + VM_NINT_ARG))
 
+/*
+ * Get the address of the local variables that are named by the
+ * second and third arguments of a register-form instruction.
+ */
+#define	VM_LOC2(type)		\
+			((type *)(((jit_item *)frame) + VM_NINT_ARG2))
+#define	VM_LOC3(type)		\
+			((type *)(((jit_item *)frame) + VM_NINT_ARG3))
+
+/*
+ * Get the address of a field within the object that is pointed
+ * to by the local variable "loc".
+ */
+#define	VM_FIELD(type,loc)	\
+			((type *)(((unsigned char *)((loc)->ptr_value)) + VM_NINT_ARG3))
+
 /*
  * Handle the return value from a function that reports a builtin exception.
  */
@@ -5008,6 +5024,654 @@ restart_tail:
 		}
 		VMBREAK;
 
+		/******************************************************************
+		 * Register-form instructions that operate on frame slots.
+		 ******************************************************************/
+
+		VMCASE(JIT_INTERP_OP_IADD_LLL):
+		{
+			/* Add signed 32-bit integer locals */
+			*VM_LOC(jit_int) = *VM_LOC2(jit_int) + *VM_LOC3(jit_int);
+			VM_MODIFY_PC(4);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_IADD_LLC):
+		{
+			/* Add a signed 32-bit integer local and a constant */
+			*VM_LOC(jit_int) = *VM_LOC2(jit_int) + (jit_int)VM_NINT_ARG3;
+			VM_MODIFY_PC(4);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_ISUB_LLL):
+		{
+			/* Subtract signed 32-bit integer locals */
+			*VM_LOC(jit_int) = *VM_LOC2(jit_int) - *VM_LOC3(jit_int);
+			VM_MODIFY_PC(4);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_ISUB_LLC):
+		{
+			/* Subtract a signed 32-bit integer local and a constant */
+			*VM_LOC(jit_int) = *VM_LOC2(jit_int) - (jit_int)VM_NINT_ARG3;
+			VM_MODIFY_PC(4);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_IMUL_LLL):
+		{
+			/* Multiply signed 32-bit integer locals */
+			*VM_LOC(jit_int) = *VM_LOC2(jit_int) * *VM_LOC3(jit_int);
+			VM_MODIFY_PC(4);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_IMUL_LLC):
+		{
+			/* Multiply a signed 32-bit integer local and a constant */
+			*VM_LOC(jit_int) = *VM_LOC2(jit_int) * (jit_int)VM_NINT_ARG3;
+			VM_MODIFY_PC(4);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_IAND_LLL):
+		{
+			/* Bitwise AND signed 32-bit integer locals */
+			*VM_LOC(jit_int) = *VM_LOC2(jit_int) & *VM_LOC3(jit_int);
+			VM_MODIFY_PC(4);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_IAND_LLC):
+		{
+			/* Bitwise AND a signed 32-bit integer local and a constant */
+			*VM_LOC(jit_int) = *VM_LOC2(jit_int) & (jit_int)VM_NINT_ARG3;
+			VM_MODIFY_PC(4);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_IOR_LLL):
+		{
+			/* Bitwise OR signed 32-bit integer locals */
+			*VM_LOC(jit_int) = *VM_LOC2(jit_int) | *VM_LOC3(jit_int);
+			VM_MODIFY_PC(4);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_IOR_LLC):
+		{
+			/* Bitwise OR a signed 32-bit integer local and a constant */
+			*VM_LOC(jit_int) = *VM_LOC2(jit_int) | (jit_int)VM_NINT_ARG3;
+			VM_MODIFY_PC(4);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_IXOR_LLL):
+		{
+			/* Bitwise XOR signed 32-bit integer locals */
+			*VM_LOC(jit_int) = *VM_LOC2(jit_int) ^ *VM_LOC3(jit_int);
+			VM_MODIFY_PC(4);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_IXOR_LLC):
+		{
+			/* Bitwise XOR a signed 32-bit integer local and a constant */
+			*VM_LOC(jit_int) = *VM_LOC2(jit_int) ^ (jit_int)VM_NINT_ARG3;
+			VM_MODIFY_PC(4);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_LADD_LLL):
+		{
+			/* Add signed 64-bit integer locals */
+			*VM_LOC(jit_long) = *VM_LOC2(jit_long) + *VM_LOC3(jit_long);
+			VM_MODIFY_PC(4);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_LSUB_LLL):
+		{
+			/* Subtract signed 64-bit integer locals */
+			*VM_LOC(jit_long) = *VM_LOC2(jit_long) - *VM_LOC3(jit_long);
+			VM_MODIFY_PC(4);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_MOV_LL_INT):
+		{
+			/* Copy a 32-bit integer local to another local */
+			*VM_LOC(jit_int) = *VM_LOC2(jit_int);
+			VM_MODIFY_PC(3);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_MOV_LC_INT):
+		{
+			/* Store a 32-bit integer constant into a local */
+			*VM_LOC(jit_int) = (jit_int)VM_NINT_ARG2;
+			VM_MODIFY_PC(3);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_MOV_LL_LONG):
+		{
+			/* Copy a 64-bit integer local to another local */
+			*VM_LOC(jit_long) = *VM_LOC2(jit_long);
+			VM_MODIFY_PC(3);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_IFALSE_L):
+		{
+			/* Branch if a 32-bit integer local is false */
+			if(*VM_LOC2(jit_int) == 0)
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(3);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_ITRUE_L):
+		{
+			/* Branch if a 32-bit integer local is true */
+			if(*VM_LOC2(jit_int) != 0)
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(3);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_IEQ_LL):
+		{
+			/* Branch if signed 32-bit integer locals are equal */
+			if(*VM_LOC2(jit_int) == *VM_LOC3(jit_int))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_INE_LL):
+		{
+			/* Branch if signed 32-bit integer locals are not equal */
+			if(*VM_LOC2(jit_int) != *VM_LOC3(jit_int))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_ILT_LL):
+		{
+			/* Branch if signed 32-bit integer locals are less than */
+			if(*VM_LOC2(jit_int) < *VM_LOC3(jit_int))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_ILT_UN_LL):
+		{
+			/* Branch if unsigned 32-bit integer locals are less than */
+			if(*VM_LOC2(jit_uint) < *VM_LOC3(jit_uint))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_ILE_LL):
+		{
+			/* Branch if signed 32-bit integer locals are less than or equal */
+			if(*VM_LOC2(jit_int) <= *VM_LOC3(jit_int))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_ILE_UN_LL):
+		{
+			/* Branch if unsigned 32-bit integer locals are less than or equal */
+			if(*VM_LOC2(jit_uint) <= *VM_LOC3(jit_uint))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_IGT_LL):
+		{
+			/* Branch if signed 32-bit integer locals are greater than */
+			if(*VM_LOC2(jit_int) > *VM_LOC3(jit_int))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_IGT_UN_LL):
+		{
+			/* Branch if unsigned 32-bit integer locals are greater than */
+			if(*VM_LOC2(jit_uint) > *VM_LOC3(jit_uint))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_IGE_LL):
+		{
+			/* Branch if signed 32-bit integer locals are greater than or equal */
+			if(*VM_LOC2(jit_int) >= *VM_LOC3(jit_int))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_IGE_UN_LL):
+		{
+			/* Branch if unsigned 32-bit integer locals are greater than or equal */
+			if(*VM_LOC2(jit_uint) >= *VM_LOC3(jit_uint))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_LFALSE_L):
+		{
+			/* Branch if a 64-bit integer local is false */
+			if(*VM_LOC2(jit_long) == 0)
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(3);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_LTRUE_L):
+		{
+			/* Branch if a 64-bit integer local is true */
+			if(*VM_LOC2(jit_long) != 0)
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(3);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_LEQ_LL):
+		{
+			/* Branch if signed 64-bit integer locals are equal */
+			if(*VM_LOC2(jit_long) == *VM_LOC3(jit_long))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_LNE_LL):
+		{
+			/* Branch if signed 64-bit integer locals are not equal */
+			if(*VM_LOC2(jit_long) != *VM_LOC3(jit_long))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_LLT_LL):
+		{
+			/* Branch if signed 64-bit integer locals are less than */
+			if(*VM_LOC2(jit_long) < *VM_LOC3(jit_long))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_LLT_UN_LL):
+		{
+			/* Branch if unsigned 64-bit integer locals are less than */
+			if(*VM_LOC2(jit_ulong) < *VM_LOC3(jit_ulong))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_LLE_LL):
+		{
+			/* Branch if signed 64-bit integer locals are less than or equal */
+			if(*VM_LOC2(jit_long) <= *VM_LOC3(jit_long))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_LLE_UN_LL):
+		{
+			/* Branch if unsigned 64-bit integer locals are less than or equal */
+			if(*VM_LOC2(jit_ulong) <= *VM_LOC3(jit_ulong))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_LGT_LL):
+		{
+			/* Branch if signed 64-bit integer locals are greater than */
+			if(*VM_LOC2(jit_long) > *VM_LOC3(jit_long))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_LGT_UN_LL):
+		{
+			/* Branch if unsigned 64-bit integer locals are greater than */
+			if(*VM_LOC2(jit_ulong) > *VM_LOC3(jit_ulong))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_LGE_LL):
+		{
+			/* Branch if signed 64-bit integer locals are greater than or equal */
+			if(*VM_LOC2(jit_long) >= *VM_LOC3(jit_long))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_LGE_UN_LL):
+		{
+			/* Branch if unsigned 64-bit integer locals are greater than or equal */
+			if(*VM_LOC2(jit_ulong) >= *VM_LOC3(jit_ulong))
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_IEQ_LC):
+		{
+			/* Branch if a signed 32-bit local is equal to a constant */
+			if(*VM_LOC2(jit_int) == (jit_int)VM_NINT_ARG3)
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_INE_LC):
+		{
+			/* Branch if a signed 32-bit local is not equal to a constant */
+			if(*VM_LOC2(jit_int) != (jit_int)VM_NINT_ARG3)
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_ILT_LC):
+		{
+			/* Branch if a signed 32-bit local is less than a constant */
+			if(*VM_LOC2(jit_int) < (jit_int)VM_NINT_ARG3)
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_ILT_UN_LC):
+		{
+			/* Branch if an unsigned 32-bit local is less than a constant */
+			if(*VM_LOC2(jit_uint) < (jit_uint)VM_NINT_ARG3)
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_ILE_LC):
+		{
+			/* Branch if a signed 32-bit local is less than or equal to a constant */
+			if(*VM_LOC2(jit_int) <= (jit_int)VM_NINT_ARG3)
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_ILE_UN_LC):
+		{
+			/* Branch if an unsigned 32-bit local is less than or equal to a constant */
+			if(*VM_LOC2(jit_uint) <= (jit_uint)VM_NINT_ARG3)
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_IGT_LC):
+		{
+			/* Branch if a signed 32-bit local is greater than a constant */
+			if(*VM_LOC2(jit_int) > (jit_int)VM_NINT_ARG3)
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_IGT_UN_LC):
+		{
+			/* Branch if an unsigned 32-bit local is greater than a constant */
+			if(*VM_LOC2(jit_uint) > (jit_uint)VM_NINT_ARG3)
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_IGE_LC):
+		{
+			/* Branch if a signed 32-bit local is at least a constant */
+			if(*VM_LOC2(jit_int) >= (jit_int)VM_NINT_ARG3)
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_BR_IGE_UN_LC):
+		{
+			/* Branch if an unsigned 32-bit local is at least a constant */
+			if(*VM_LOC2(jit_uint) >= (jit_uint)VM_NINT_ARG3)
+			{
+				pc = VM_BR_TARGET;
+			}
+			else
+			{
+				VM_MODIFY_PC(4);
+			}
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_LDFLD_L_INT):
+		{
+			/* Load a 32-bit integer field into a local */
+			*VM_LOC(jit_int) = *VM_FIELD(jit_int, VM_LOC2(jit_item));
+			VM_MODIFY_PC(4);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_LDFLD_L_LONG):
+		{
+			/* Load a 64-bit integer field into a local */
+			*VM_LOC(jit_long) = *VM_FIELD(jit_long, VM_LOC2(jit_item));
+			VM_MODIFY_PC(4);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_STFLD_L_INT):
+		{
+			/* Store a 32-bit integer local into a field */
+			*VM_FIELD(jit_int, VM_LOC(jit_item)) = *VM_LOC2(jit_int);
+			VM_MODIFY_PC(4);
+		}
+		VMBREAK;
+
+		VMCASE(JIT_INTERP_OP_STFLD_L_LONG):
+		{
+			/* Store a 64-bit integer local into a field */
+			*VM_FIELD(jit_long, VM_LOC(jit_item)) = *VM_LOC2(jit_long);
+			VM_MODIFY_PC(4);
+		}
+		VMBREAK;
+
 		/******************************************************************
 		 * Opcodes that aren't used by the interpreter.  These are replaced
 		 * by more specific instructions during function compilation.
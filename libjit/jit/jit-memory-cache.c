@@ -75,9 +75,30 @@ struct jit_cache_page
 };
 
 /*
- * Structure of the method cache.
+ * Free region within a cache page.  A thread that outputs a function
+ * takes a region for itself until the function is finished, so that
+ * several threads may output functions at the same time.  The thread
+ * also links the region into a list of its own, so that it can find
+ * the region again without looking at the regions of other threads.
  */
 typedef struct jit_cache *jit_cache_t;
+typedef struct jit_cache_region *jit_cache_region_t;
+struct jit_cache_region
+{
+	jit_cache_t		cache;		/* Cache that contains the region */
+	jit_cache_region_t	next;		/* Next region in the cache */
+	jit_cache_region_t	next_started;	/* Next region of the same thread */
+	void			*owner;		/* Thread that last output code here */
+	unsigned char		*free_start;	/* Current start of the free region */
+	unsigned char		*free_end;	/* Current end of the free region */
+	unsigned char		*prev_start;	/* Previous start of the free region */
+	unsigned char		*prev_end;	/* Previous end of the free region */
+	jit_cache_node_t	node;		/* Information for the current function */
+};
+
+/*
+ * Structure of the method cache.
+ */
 struct jit_cache
 {
 	struct jit_cache_page	*pages;		/* List of pages currently in the cache */
@@ -86,11 +107,8 @@ struct jit_cache
 	unsigned long		pageSize;	/* Default size of a page for allocation */
 	unsigned int		maxPageFactor;	/* Maximum page size factor */
 	long			pagesLeft;	/* Number of pages left to allocate */
-	unsigned char		*free_start;	/* Current start of the free region */
-	unsigned char		*free_end;	/* Current end of the free region */
-	unsigned char		*prev_start;	/* Previous start of the free region */
-	unsigned char		*prev_end;	/* Previous end of the free region */
-	jit_cache_node_t	node;		/* Information for the current function */
+	jit_cache_region_t	regions;	/* Free regions, the first is "region" */
+	struct jit_cache_region	region;		/* Region used when there is no contention */
 	struct jit_cache_node	head;		/* Head of the lookup tree */
 	struct jit_cache_node	nil;		/* Nil pointer for the lookup tree */
 };
@@ -122,10 +140,11 @@ void _jit_cache_destroy(jit_cache_t cache);
 void * _jit_cache_alloc_data(jit_cache_t cache, unsigned long size, unsigned long align);
 
 /*
- * Allocate a cache page and add it to the cache.
+ * Allocate a cache page, add it to the cache and make it
+ * the free space of the given region.
  */
 static void
-AllocCachePage(jit_cache_t cache, int factor)
+AllocCachePage(jit_cache_t cache, jit_cache_region_t region, int factor)
 {
 	long num;
 	unsigned char *ptr;
@@ -182,8 +201,8 @@ AllocCachePage(jit_cache_t cache, int factor)
 		{
 			_jit_free_exec(ptr, cache->pageSize * factor);
 		failAlloc:
-			cache->free_start = 0;
-			cache->free_end = 0;
+			region->free_start = 0;
+			region->free_end = 0;
 			return;
 		}
 
@@ -201,8 +220,157 @@ AllocCachePage(jit_cache_t cache, int factor)
 	}
 
 	/* Set up the working region within the new page */
-	cache->free_start = ptr;
-	cache->free_end = ptr + (int) cache->pageSize * factor;
+	region->free_start = ptr;
+	region->free_end = ptr + (int) cache->pageSize * factor;
+}
+
+/*
+ * Get the identity of the current thread for region ownership.
+ */
+#define	CurrentOwner()	((void *) _jit_thread_get_control())
+
+/*
+ * Find the region where the current thread is outputting a function.
+ * Only the thread's own list is searched, so this is safe whether or
+ * not the cache lock is held.  Returns NULL if the thread has not
+ * started a function.
+ */
+static jit_cache_region_t
+FindStartedRegion(jit_cache_t cache)
+{
+	jit_thread_control_t control = _jit_thread_get_control();
+	jit_cache_region_t region;
+
+	if(!control)
+	{
+		return 0;
+	}
+	region = (jit_cache_region_t) control->started_regions;
+	while(region && region->cache != cache)
+	{
+		region = region->next_started;
+	}
+	return region;
+}
+
+/*
+ * Add a region to the list of the current thread once it has started
+ * a function in it, or remove it once the function has ended.
+ */
+static int
+AddStartedRegion(jit_cache_region_t region)
+{
+	jit_thread_control_t control = _jit_thread_get_control();
+
+	if(!control)
+	{
+		return 0;
+	}
+	region->next_started = (jit_cache_region_t) control->started_regions;
+	control->started_regions = region;
+	return 1;
+}
+
+static void
+RemoveStartedRegion(jit_cache_region_t region)
+{
+	jit_thread_control_t control = _jit_thread_get_control();
+	jit_cache_region_t *prev;
+
+	prev = (jit_cache_region_t *) &(control->started_regions);
+	while(*prev != region)
+	{
+		prev = &((*prev)->next_started);
+	}
+	*prev = region->next_started;
+	region->next_started = 0;
+}
+
+/*
+ * Find a region that no thread is outputting a function into.  The
+ * region last used by the current thread is preferred, so that each
+ * thread keeps writing its code sequentially.  A new region with a
+ * fresh page is created if every region is busy.  Returns NULL if
+ * out of memory.
+ */
+static jit_cache_region_t
+FindIdleRegion(jit_cache_t cache)
+{
+	jit_cache_region_t region;
+	jit_cache_region_t idle = 0;
+	void *owner = CurrentOwner();
+
+	for(region = cache->regions; region; region = region->next)
+	{
+		if(region->node || !region->free_start)
+		{
+			continue;
+		}
+		if(region->owner == owner)
+		{
+			return region;
+		}
+		if(!idle)
+		{
+			idle = region;
+		}
+	}
+	if(idle)
+	{
+		idle->owner = owner;
+		return idle;
+	}
+
+	/* Reuse a region whose page is exhausted, or create a new one */
+	for(region = cache->regions; region; region = region->next)
+	{
+		if(!region->node && !region->free_start)
+		{
+			break;
+		}
+	}
+	if(!region)
+	{
+		region = jit_cnew(struct jit_cache_region);
+		if(!region)
+		{
+			return 0;
+		}
+		region->cache = cache;
+		region->next = cache->regions;
+		cache->regions = region;
+	}
+	region->owner = owner;
+	AllocCachePage(cache, region, 0);
+	if(!region->free_start)
+	{
+		return 0;
+	}
+	return region;
+}
+
+/*
+ * Allocate data from the top of a region.
+ */
+static void *
+AllocRegionData(jit_cache_region_t region, unsigned long size, unsigned long align)
+{
+	unsigned char *ptr;
+
+	/* Get memory from the top of the free region, so that it does not
+	   overlap with the function code possibly being written at the bottom
+	   of the free region */
+	ptr = region->free_end - size;
+	ptr = (unsigned char *) (((jit_nuint) ptr) & ~(align - 1));
+	if(ptr < region->free_start)
+	{
+		/* When we aligned the block, it caused an overflow */
+		return 0;
+	}
+
+	/* Allocate the block and return it */
+	region->free_end = ptr;
+	return ptr;
 }
 
 /*
@@ -410,8 +578,9 @@ _jit_cache_create(jit_context_t context)
 	cache->maxNumPages = 0;
 	cache->pageSize = cache_page_size;
 	cache->maxPageFactor = max_page_factor;
-	cache->free_start = 0;
-	cache->free_end = 0;
+	jit_memzero(&cache->region, sizeof(struct jit_cache_region));
+	cache->region.cache = cache;
+	cache->regions = &cache->region;
 	if(limit > 0)
 	{
 		cache->pagesLeft = limit / cache_page_size;
@@ -424,7 +593,6 @@ _jit_cache_create(jit_context_t context)
 	{
 		cache->pagesLeft = -1;
 	}
-	cache->node = 0;
 	cache->nil.left = &(cache->nil);
 	cache->nil.right = &(cache->nil);
 	cache->nil.func = 0;
@@ -433,8 +601,8 @@ _jit_cache_create(jit_context_t context)
 	cache->head.func = 0;
 
 	/* Allocate the initial cache page */
-	AllocCachePage(cache, 0);
-	if(!cache->free_start)
+	AllocCachePage(cache, &cache->region, 0);
+	if(!cache->region.free_start)
 	{
 		_jit_cache_destroy(cache);
 		return 0;
@@ -448,6 +616,14 @@ void
 _jit_cache_destroy(jit_cache_t cache)
 {
 	unsigned long page;
+	jit_cache_region_t region;
+
+	/* Free the regions created for contending threads */
+	while((region = cache->regions) != &cache->region)
+	{
+		cache->regions = region->next;
+		jit_free(region);
+	}
 
 	/* Free all of the cache pages */
 	for(page = 0; page < cache->numPages; ++page)
@@ -467,20 +643,30 @@ _jit_cache_destroy(jit_cache_t cache)
 void
 _jit_cache_extend(jit_cache_t cache, int count)
 {
+	jit_cache_region_t region;
+	struct jit_cache_page *p;
+
 	/* Compute the page size factor */
 	int factor = 1 << count;
 
 	/* Bail out if there is a started function */
-	if(cache->node)
+	if(FindStartedRegion(cache))
+	{
+		return;
+	}
+
+	/* Find the region the current thread is going to use */
+	region = FindIdleRegion(cache);
+	if(!region)
 	{
 		return;
 	}
 
 	/* If we had a newly allocated page then it has to be freed
 	   to let allocate another new page of appropriate size. */
-	struct jit_cache_page *p = &cache->pages[cache->numPages - 1];
-	if((cache->free_start == ((unsigned char *)p->page))
-	   && (cache->free_end == (cache->free_start + cache->pageSize * p->factor)))
+	p = &cache->pages[cache->numPages - 1];
+	if((region->free_start == ((unsigned char *)p->page))
+	   && (region->free_end == (region->free_start + cache->pageSize * p->factor)))
 	{
 		_jit_free_exec(p->page, cache->pageSize * p->factor);
 
@@ -489,8 +675,8 @@ _jit_cache_extend(jit_cache_t cache, int count)
 		{
 			cache->pagesLeft += p->factor;
 		}
-		cache->free_start = 0;
-		cache->free_end = 0;
+		region->free_start = 0;
+		region->free_end = 0;
 
 		if(factor <= p->factor)
 		{
@@ -499,7 +685,7 @@ _jit_cache_extend(jit_cache_t cache, int count)
 	}
 
 	/* Allocate a new page now */
-	AllocCachePage(cache, factor);
+	AllocCachePage(cache, region, factor);
 }
 
 jit_function_t
@@ -517,36 +703,48 @@ _jit_cache_free_function(jit_cache_t cache, jit_function_t func)
 int
 _jit_cache_start_function(jit_cache_t cache, jit_function_t func)
 {
+	jit_cache_region_t region;
+
 	/* Bail out if there is a started function already */
-	if(cache->node)
+	if(FindStartedRegion(cache))
 	{
 		return JIT_MEMORY_ERROR;
 	}
 
 	/* Bail out if the cache is already full */
-	if(!cache->free_start)
+	region = FindIdleRegion(cache);
+	if(!region)
 	{
 		return JIT_MEMORY_TOO_BIG;
 	}
 
 	/* Save the cache position */
-	cache->prev_start = cache->free_start;
-	cache->prev_end = cache->free_end;
+	region->prev_start = region->free_start;
+	region->prev_end = region->free_end;
 
 	/* Allocate a new cache node */
-	cache->node = _jit_cache_alloc_data(
-		cache, sizeof(struct jit_cache_node), sizeof(void *));
-	if(!cache->node)
+	region->node = AllocRegionData(
+		region, sizeof(struct jit_cache_node), sizeof(void *));
+	if(!region->node)
 	{
 		return JIT_MEMORY_TOO_BIG;
 	}
-	cache->node->func = func;
+	region->node->func = func;
 
 	/* Initialize the function information */
-	cache->node->start = cache->free_start;
-	cache->node->end = 0;
-	cache->node->left = 0;
-	cache->node->right = 0;
+	region->node->start = region->free_start;
+	region->node->end = 0;
+	region->node->left = 0;
+	region->node->right = 0;
+
+	/* Remember the region for the rest of the function's output */
+	if(!AddStartedRegion(region))
+	{
+		region->free_start = region->prev_start;
+		region->free_end = region->prev_end;
+		region->node = 0;
+		return JIT_MEMORY_ERROR;
+	}
 
 	return JIT_MEMORY_OK;
 }
@@ -554,27 +752,33 @@ _jit_cache_start_function(jit_cache_t cache, jit_function_t func)
 int
 _jit_cache_end_function(jit_cache_t cache, int result)
 {
+	jit_cache_region_t region;
+
 	/* Bail out if there is no started function */
-	if(!cache->node)
+	region = FindStartedRegion(cache);
+	if(!region)
 	{
 		return JIT_MEMORY_ERROR;
 	}
 
+	/* The thread is done with the region */
+	RemoveStartedRegion(region);
+
 	/* Determine if we ran out of space while writing the function */
 	if(result != JIT_MEMORY_OK)
 	{
 		/* Restore the saved cache position */
-		cache->free_start = cache->prev_start;
-		cache->free_end = cache->prev_end;
-		cache->node = 0;
+		region->free_start = region->prev_start;
+		region->free_end = region->prev_end;
+		region->node = 0;
 
 		return JIT_MEMORY_RESTART;
 	}
 
 	/* Update the method region block and then add it to the lookup tree */
-	cache->node->end = cache->free_start;
-	AddToLookupTree(cache, cache->node);
-	cache->node = 0;
+	region->node->end = region->free_start;
+	AddToLookupTree(cache, region->node);
+	region->node = 0;
 
 	/* The method is ready to go */
 	return JIT_MEMORY_OK;
@@ -583,90 +787,99 @@ _jit_cache_end_function(jit_cache_t cache, int result)
 void *
 _jit_cache_get_code_break(jit_cache_t cache)
 {
+	jit_cache_region_t region;
+
 	/* Bail out if there is no started function */
-	if(!cache->node)
+	region = FindStartedRegion(cache);
+	if(!region)
 	{
 		return 0;
 	}
 
 	/* Return the address of the available code area */
-	return cache->free_start;
+	return region->free_start;
 }
 
 void
 _jit_cache_set_code_break(jit_cache_t cache, void *ptr)
 {
+	jit_cache_region_t region;
+
 	/* Bail out if there is no started function */
-	if(!cache->node)
+	region = FindStartedRegion(cache);
+	if(!region)
 	{
 		return;
 	}
 	/* Sanity checks */
-	if((unsigned char *) ptr < cache->free_start)
+	if((unsigned char *) ptr < region->free_start)
 	{
 		return;
 	}
-	if((unsigned char *) ptr > cache->free_end)
+	if((unsigned char *) ptr > region->free_end)
 	{
 		return;
 	}
 
 	/* Update the address of the available code area */
-	cache->free_start = ptr;
+	region->free_start = ptr;
 }
 
 void *
 _jit_cache_get_code_limit(jit_cache_t cache)
 {
+	jit_cache_region_t region;
+
 	/* Bail out if there is no started function */
-	if(!cache->node)
+	region = FindStartedRegion(cache);
+	if(!region)
 	{
 		return 0;
 	}
 
 	/* Return the end address of the available code area */
-	return cache->free_end;
+	return region->free_end;
 }
 
 void *
 _jit_cache_alloc_data(jit_cache_t cache, unsigned long size, unsigned long align)
 {
-	unsigned char *ptr;
+	jit_cache_region_t region;
 
-	/* Get memory from the top of the free region, so that it does not
-	   overlap with the function code possibly being written at the bottom
-	   of the free region */
-	ptr = cache->free_end - size;
-	ptr = (unsigned char *) (((jit_nuint) ptr) & ~(align - 1));
-	if(ptr < cache->free_start)
+	/* Data for a started function goes next to its code, anything
+	   else may be put into any region that is not in use */
+	region = FindStartedRegion(cache);
+	if(!region)
 	{
-		/* When we aligned the block, it caused an overflow */
-		return 0;
+		region = FindIdleRegion(cache);
+		if(!region)
+		{
+			return 0;
+		}
 	}
-
-	/* Allocate the block and return it */
-	cache->free_end = ptr;
-	return ptr;
+	return AllocRegionData(region, size, align);
 }
 
 static void *
 alloc_code(jit_cache_t cache, unsigned int size, unsigned int align)
 {
+	jit_cache_region_t region;
 	unsigned char *ptr;
 
 	/* Bail out if there is a started function */
-	if(cache->node)
+	if(FindStartedRegion(cache))
 	{
 		return 0;
 	}
 	/* Bail out if there is no cache available */
-	if(!cache->free_start)
+	region = FindIdleRegion(cache);
+	if(!region)
 	{
 		return 0;
 	}
 
 	/* Allocate aligned memory. */
-	ptr = cache->free_start;
+	ptr = region->free_start;
 	if(align > 1)
 	{
 		jit_nuint p = ((jit_nuint) ptr + align - 1) & ~(align - 1);
@@ -674,19 +887,19 @@ alloc_code(jit_cache_t cache, unsigned int size, unsigned int align)
 	}
 
 	/* Do we need to allocate a new cache page? */
-	if((ptr + size) > cache->free_end)
+	if((ptr + size) > region->free_end)
 	{
 		/* Allocate a new page */
-		AllocCachePage(cache, 0);
+		AllocCachePage(cache, region, 0);
 
 		/* Bail out if the cache is full */
-		if(!cache->free_start)
+		if(!region->free_start)
 		{
 			return 0;
 		}
 
 		/* Allocate memory from the new page */
-		ptr = cache->free_start;
+		ptr = region->free_start;
 		if(align > 1)
 		{
 			jit_nuint p = ((jit_nuint) ptr + align - 1) & ~(align - 1);
@@ -695,7 +908,7 @@ alloc_code(jit_cache_t cache, unsigned int size, unsigned int align)
 	}
 
 	/* Allocate the block and return it */
-	cache->free_start = ptr + size;
+	region->free_start = ptr + size;
 	return (void *) ptr;
 }
 
@@ -1007,6 +1220,18 @@ offset information for a method, are not thread-safe.  The caller should
 arrange for a cache lock to be acquired prior to performing these
 operations.
 
+The lock need not be held while the method code itself is written.
+Each thread that starts a method gets a free region of a cache page
+to itself (struct jit_cache_region) and keeps it until it ends the
+method.  The thread finds the region through a list in its own thread
+control block, so it never has to search the regions of other threads
+while it outputs the method.  When another thread wants to start a method at the same time
+it picks a different region, allocating a new page if all of them are
+in use.  Ending the method merges its information block into the shared
+lookup tree, which requires the lock again.  A thread prefers the region
+it used last, so that with no contention there is only one region and
+the layout of the cache is the same as with a single writer.
+
 Executing methods from the cache is thread-safe, as the method code is
 fixed in place once it has been written.
 
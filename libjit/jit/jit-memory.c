@@ -32,6 +32,15 @@ _jit_memory_unlock(jit_context_t context)
 	jit_mutex_unlock(&context->memory_lock);
 }
 
+int
+_jit_memory_is_concurrent(jit_context_t context)
+{
+	/* Only the default code cache keeps a started function apart for
+	   each thread.  Other memory managers may expect the lock to be
+	   held while code is output, as it was before */
+	return context->memory_manager == jit_default_memory_manager();
+}
+
 int
 _jit_memory_ensure(jit_context_t context)
 {
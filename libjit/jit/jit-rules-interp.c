@@ -1032,6 +1032,337 @@ store_value(jit_gencode_t gen, jit_value_t value)
 	jit_cache_native(gen, offset);
 }
 
+/*
+ * Get the class of a value for the purposes of register-form
+ * instructions: JIT_TYPE_INT, JIT_TYPE_LONG, or -1 if the value
+ * must be accessed through the r0, r1, and r2 registers instead.
+ */
+static int
+frame_class(jit_value_t value)
+{
+	switch(jit_type_normalize(value->type)->kind)
+	{
+	case JIT_TYPE_INT:
+	case JIT_TYPE_UINT:
+		return JIT_TYPE_INT;
+
+	case JIT_TYPE_LONG:
+	case JIT_TYPE_ULONG:
+		return JIT_TYPE_LONG;
+	}
+	return -1;
+}
+
+#ifdef JIT_NATIVE_INT32
+#define	FRAME_PTR_CLASS		JIT_TYPE_INT
+#else
+#define	FRAME_PTR_CLASS		JIT_TYPE_LONG
+#endif
+
+/*
+ * Determine if a value lives in a local frame slot of a particular
+ * class, so that a register-form instruction can address it directly.
+ * Arguments and constants are not frame slots.
+ */
+static int
+is_frame_slot(jit_value_t value, int class)
+{
+	if(!value || value->is_constant || frame_class(value) != class)
+	{
+		return 0;
+	}
+	_jit_gen_fix_value(value);
+	return (value->frame_offset >= 0);
+}
+
+/*
+ * Determine if a value is a 32-bit integer constant.
+ */
+static int
+is_int_constant(jit_value_t value)
+{
+	return (value && value->is_constant &&
+			frame_class(value) == JIT_TYPE_INT);
+}
+
+/*
+ * Output the branch offset for a branch instruction at "pc".
+ */
+static void
+branch_target(jit_gencode_t gen, jit_function_t func, void **pc,
+			  jit_label_t label)
+{
+	jit_block_t block;
+
+	block = jit_block_from_label(func, label);
+	if(!block)
+	{
+		return;
+	}
+	if(block->address)
+	{
+		/* We already know the address of the block */
+		jit_cache_native(gen, ((void **)(block->address)) - pc);
+	}
+	else
+	{
+		/* Record this position on the block's fixup list */
+		jit_cache_native(gen, block->fixup_list);
+		block->fixup_list = (void *)pc;
+	}
+}
+
+/*
+ * Try to output a register-form instruction or superinstruction for
+ * "insn", which works directly on frame slots rather than loading
+ * its operands into registers and storing the result afterwards.
+ * Returns zero if the operands are not suitable, in which case the
+ * caller falls back to the regular stack-register form.
+ */
+static int
+gen_register_form(jit_gencode_t gen, jit_function_t func, jit_insn_t insn)
+{
+	void **pc;
+	int opcode;
+
+	switch(insn->opcode)
+	{
+	case JIT_OP_IADD:
+	case JIT_OP_ISUB:
+	case JIT_OP_IMUL:
+	case JIT_OP_IAND:
+	case JIT_OP_IOR:
+	case JIT_OP_IXOR:
+		if(!is_frame_slot(insn->dest, JIT_TYPE_INT) ||
+		   !is_frame_slot(insn->value1, JIT_TYPE_INT))
+		{
+			return 0;
+		}
+		switch(insn->opcode)
+		{
+		case JIT_OP_IADD:	opcode = JIT_INTERP_OP_IADD_LLL; break;
+		case JIT_OP_ISUB:	opcode = JIT_INTERP_OP_ISUB_LLL; break;
+		case JIT_OP_IMUL:	opcode = JIT_INTERP_OP_IMUL_LLL; break;
+		case JIT_OP_IAND:	opcode = JIT_INTERP_OP_IAND_LLL; break;
+		case JIT_OP_IOR:	opcode = JIT_INTERP_OP_IOR_LLL; break;
+		default:			opcode = JIT_INTERP_OP_IXOR_LLL; break;
+		}
+		if(is_int_constant(insn->value2))
+		{
+			/* The "_llc" form always follows the "_lll" form */
+			jit_cache_opcode(gen, opcode + 1);
+			jit_cache_native(gen, insn->dest->frame_offset);
+			jit_cache_native(gen, insn->value1->frame_offset);
+			jit_cache_native(gen, (jit_nint)(insn->value2->address));
+			return 1;
+		}
+		if(!is_frame_slot(insn->value2, JIT_TYPE_INT))
+		{
+			return 0;
+		}
+		break;
+
+	case JIT_OP_LADD:
+	case JIT_OP_LSUB:
+		if(!is_frame_slot(insn->dest, JIT_TYPE_LONG) ||
+		   !is_frame_slot(insn->value1, JIT_TYPE_LONG) ||
+		   !is_frame_slot(insn->value2, JIT_TYPE_LONG))
+		{
+			return 0;
+		}
+		if(insn->opcode == JIT_OP_LADD)
+		{
+			opcode = JIT_INTERP_OP_LADD_LLL;
+		}
+		else
+		{
+			opcode = JIT_INTERP_OP_LSUB_LLL;
+		}
+		break;
+
+	case JIT_OP_COPY_INT:
+		if(!is_frame_slot(insn->dest, JIT_TYPE_INT))
+		{
+			return 0;
+		}
+		if(is_int_constant(insn->value1))
+		{
+			jit_cache_opcode(gen, JIT_INTERP_OP_MOV_LC_INT);
+			jit_cache_native(gen, insn->dest->frame_offset);
+			jit_cache_native(gen, (jit_nint)(insn->value1->address));
+			return 1;
+		}
+		if(!is_frame_slot(insn->value1, JIT_TYPE_INT))
+		{
+			return 0;
+		}
+		jit_cache_opcode(gen, JIT_INTERP_OP_MOV_LL_INT);
+		jit_cache_native(gen, insn->dest->frame_offset);
+		jit_cache_native(gen, insn->value1->frame_offset);
+		return 1;
+
+	case JIT_OP_COPY_LONG:
+		if(!is_frame_slot(insn->dest, JIT_TYPE_LONG) ||
+		   !is_frame_slot(insn->value1, JIT_TYPE_LONG))
+		{
+			return 0;
+		}
+		jit_cache_opcode(gen, JIT_INTERP_OP_MOV_LL_LONG);
+		jit_cache_native(gen, insn->dest->frame_offset);
+		jit_cache_native(gen, insn->value1->frame_offset);
+		return 1;
+
+	case JIT_OP_BR_IFALSE:
+	case JIT_OP_BR_ITRUE:
+	case JIT_OP_BR_LFALSE:
+	case JIT_OP_BR_LTRUE:
+		if(insn->opcode <= JIT_OP_BR_ITRUE)
+		{
+			if(!is_frame_slot(insn->value1, JIT_TYPE_INT))
+			{
+				return 0;
+			}
+			opcode = JIT_INTERP_OP_BR_IFALSE_L +
+					 (insn->opcode - JIT_OP_BR_IFALSE);
+		}
+		else
+		{
+			if(!is_frame_slot(insn->value1, JIT_TYPE_LONG))
+			{
+				return 0;
+			}
+			opcode = JIT_INTERP_OP_BR_LFALSE_L +
+					 (insn->opcode - JIT_OP_BR_LFALSE);
+		}
+		pc = (void **)(gen->ptr);
+		jit_cache_opcode(gen, opcode);
+		branch_target(gen, func, pc, (jit_label_t)(insn->dest));
+		jit_cache_native(gen, insn->value1->frame_offset);
+		return 1;
+
+	case JIT_OP_BR_IEQ:
+	case JIT_OP_BR_INE:
+	case JIT_OP_BR_ILT:
+	case JIT_OP_BR_ILT_UN:
+	case JIT_OP_BR_ILE:
+	case JIT_OP_BR_ILE_UN:
+	case JIT_OP_BR_IGT:
+	case JIT_OP_BR_IGT_UN:
+	case JIT_OP_BR_IGE:
+	case JIT_OP_BR_IGE_UN:
+		if(!is_frame_slot(insn->value1, JIT_TYPE_INT))
+		{
+			return 0;
+		}
+		if(is_int_constant(insn->value2))
+		{
+			opcode = JIT_INTERP_OP_BR_IEQ_LC + (insn->opcode - JIT_OP_BR_IEQ);
+			pc = (void **)(gen->ptr);
+			jit_cache_opcode(gen, opcode);
+			branch_target(gen, func, pc, (jit_label_t)(insn->dest));
+			jit_cache_native(gen, insn->value1->frame_offset);
+			jit_cache_native(gen, (jit_nint)(insn->value2->address));
+			return 1;
+		}
+		if(!is_frame_slot(insn->value2, JIT_TYPE_INT))
+		{
+			return 0;
+		}
+		opcode = JIT_INTERP_OP_BR_IEQ_LL + (insn->opcode - JIT_OP_BR_IEQ);
+		goto binary_branch;
+
+	case JIT_OP_BR_LEQ:
+	case JIT_OP_BR_LNE:
+	case JIT_OP_BR_LLT:
+	case JIT_OP_BR_LLT_UN:
+	case JIT_OP_BR_LLE:
+	case JIT_OP_BR_LLE_UN:
+	case JIT_OP_BR_LGT:
+	case JIT_OP_BR_LGT_UN:
+	case JIT_OP_BR_LGE:
+	case JIT_OP_BR_LGE_UN:
+		if(!is_frame_slot(insn->value1, JIT_TYPE_LONG) ||
+		   !is_frame_slot(insn->value2, JIT_TYPE_LONG))
+		{
+			return 0;
+		}
+		opcode = JIT_INTERP_OP_BR_LEQ_LL + (insn->opcode - JIT_OP_BR_LEQ);
+	binary_branch:
+		pc = (void **)(gen->ptr);
+		jit_cache_opcode(gen, opcode);
+		branch_target(gen, func, pc, (jit_label_t)(insn->dest));
+		jit_cache_native(gen, insn->value1->frame_offset);
+		jit_cache_native(gen, insn->value2->frame_offset);
+		return 1;
+
+	case JIT_OP_LOAD_RELATIVE_INT:
+	case JIT_OP_LOAD_RELATIVE_LONG:
+		if(!is_frame_slot(insn->value1, FRAME_PTR_CLASS))
+		{
+			return 0;
+		}
+		if(insn->opcode == JIT_OP_LOAD_RELATIVE_INT)
+		{
+			if(!is_frame_slot(insn->dest, JIT_TYPE_INT))
+			{
+				return 0;
+			}
+			opcode = JIT_INTERP_OP_LDFLD_L_INT;
+		}
+		else
+		{
+			if(!is_frame_slot(insn->dest, JIT_TYPE_LONG))
+			{
+				return 0;
+			}
+			opcode = JIT_INTERP_OP_LDFLD_L_LONG;
+		}
+		jit_cache_opcode(gen, opcode);
+		jit_cache_native(gen, insn->dest->frame_offset);
+		jit_cache_native(gen, insn->value1->frame_offset);
+		jit_cache_native(gen, jit_value_get_nint_constant(insn->value2));
+		return 1;
+
+	case JIT_OP_STORE_RELATIVE_INT:
+	case JIT_OP_STORE_RELATIVE_LONG:
+		if(!is_frame_slot(insn->dest, FRAME_PTR_CLASS))
+		{
+			return 0;
+		}
+		if(insn->opcode == JIT_OP_STORE_RELATIVE_INT)
+		{
+			if(!is_frame_slot(insn->value1, JIT_TYPE_INT))
+			{
+				return 0;
+			}
+			opcode = JIT_INTERP_OP_STFLD_L_INT;
+		}
+		else
+		{
+			if(!is_frame_slot(insn->value1, JIT_TYPE_LONG))
+			{
+				return 0;
+			}
+			opcode = JIT_INTERP_OP_STFLD_L_LONG;
+		}
+		jit_cache_opcode(gen, opcode);
+		jit_cache_native(gen, insn->dest->frame_offset);
+		jit_cache_native(gen, insn->value1->frame_offset);
+		jit_cache_native(gen, jit_value_get_nint_constant(insn->value2));
+		return 1;
+
+	default:
+		return 0;
+	}
+
+	/* Output a three-address instruction on frame slots */
+	jit_cache_opcode(gen, opcode);
+	jit_cache_native(gen, insn->dest->frame_offset);
+	jit_cache_native(gen, insn->value1->frame_offset);
+	jit_cache_native(gen, insn->value2->frame_offset);
+	return 1;
+}
+
 /*@
  * @deftypefun void _jit_gen_insn (jit_gencode_t @var{gen}, jit_function_t @var{func}, jit_block_t @var{block}, jit_insn_t @var{insn})
  * Generate native code for the specified @var{insn}.  This function should
@@ -1048,6 +1379,12 @@ void _jit_gen_insn(jit_gencode_t gen, jit_function_t func,
 	jit_nint offset;
 	jit_nint size;
 
+	/* Use a register-form instruction if the operands allow it */
+	if(gen_register_form(gen, func, insn))
+	{
+		return;
+	}
+
 	switch(insn->opcode)
 	{
 	case JIT_OP_BR_IEQ:
@@ -129,6 +129,13 @@ do { \
 #define	jit_cache_end_output()	\
 	gen->ptr = inst
 
+/*
+ * Alignment of the loop header blocks and the maximum number of bytes
+ * of padding that is worth spending to get there.
+ */
+#define JIT_LOOP_ALIGN			16
+#define JIT_LOOP_ALIGN_MAX_PAD		10
+
 /*
  * Set this to 1 for debugging fixups
  */
@@ -2472,9 +2479,13 @@ _jit_gen_prolog(jit_gencode_t gen, jit_function_t func, void *buf)
 	if(func->builder->param_area_size > 0x50 && regs_to_save > 0)
 	{
 		x86_64_sub_reg_imm_size(inst, X86_64_RSP, func->builder->param_area_size, 8);
+		frame_size += func->builder->param_area_size;
 	}
 #endif /* JIT_USE_PARAM_AREA */
 
+	/* Remember where the stack top is for the unwind table */
+	gen->frame_size = frame_size;
+
 	/* Copy the prolog into place and return the adjusted entry position */
 	reg = (int)(inst - prolog);
 	jit_memcpy(((unsigned char *)buf) + JIT_PROLOG_SIZE - reg, prolog, reg);
@@ -2495,6 +2506,20 @@ _jit_gen_epilog(jit_gencode_t gen, jit_function_t func)
 
 	inst = gen->ptr;
 
+	/* The catcher is entered with the callee saved registers left by
+	   the function that threw the exception, so a function with a
+	   catcher has to preserve all of them for its caller */
+	if(func->has_try)
+	{
+		for(reg = 0; reg <= 14; ++reg)
+		{
+			if((_jit_reg_info[reg].flags & JIT_REG_CALL_USED) == 0)
+			{
+				jit_reg_set_used(gen->touched, reg);
+			}
+		}
+	}
+
 	/* Perform fixups on any blocks that jump to the epilog */
 	fixup = (jit_int *)(gen->epilog_fixup);
 	while(fixup != 0)
@@ -2756,6 +2781,18 @@ _jit_gen_start_block(jit_gencode_t gen, jit_block_t block)
 	jit_int *next;
 	void **absolute_fixup;
 	void **absolute_next;
+	int pad;
+
+	/* Align loop headers if it can be done with a few nops */
+	if(block->loop_header)
+	{
+		pad = (int)(-((jit_nint)(gen->ptr)) & (JIT_LOOP_ALIGN - 1));
+		if(pad > 0 && pad <= JIT_LOOP_ALIGN_MAX_PAD)
+		{
+			_jit_gen_check_space(gen, pad);
+			x86_64_padding(gen->ptr, pad);
+		}
+	}
 
 	/* Set the address of this block */
 	block->address = (void *)(gen->ptr);
@@ -2821,6 +2858,49 @@ _jit_gen_is_global_candidate(jit_type_t type)
 	return 0;
 }
 
+#ifdef JIT_USE_UNWIND_TABLES
+
+_jit_unwind_table_t
+_jit_gen_unwind_table(jit_gencode_t gen, jit_function_t func)
+{
+	_jit_unwind_table_t table;
+	jit_block_t block;
+
+	/* Nothing to do if the function never started its catcher */
+	block = jit_block_from_label(func, func->builder->catcher_label);
+	if(!block || !block->address)
+	{
+		return 0;
+	}
+
+	/* The table goes into the code cache next to the function */
+	table = (_jit_unwind_table_t)
+		_jit_gen_alloc(gen, sizeof(struct _jit_unwind_table));
+	table->start = gen->code_start;
+	table->end = gen->code_end;
+	table->catcher = block->address;
+	table->frame_size = gen->frame_size;
+	return table;
+}
+
+void
+_jit_gen_unwind_jump(void *frame, _jit_unwind_table_t table)
+{
+	void *stack = (void *)(((unsigned char *)frame) - table->frame_size);
+
+	/* Restore the frame and stack pointers that the function had on
+	   entry and jump to its catcher.  The callee saved registers need
+	   no restoring as the function saves all of them in its prolog */
+	__asm__ __volatile__ (
+		"movq %%rax, %%rsp\n\t"
+		"movq %%rdx, %%rbp\n\t"
+		"jmpq *%%rcx\n\t"
+		: : "a"(stack), "d"(frame), "c"(table->catcher) : "memory");
+	__builtin_unreachable();
+}
+
+#endif /* JIT_USE_UNWIND_TABLES */
+
 /*
  * Do the stuff usually handled in jit-rules.c for native implementations
  * here too because the common implementation is not enough for x86_64.
@@ -114,11 +114,13 @@ extern	"C" {
  */
 
 #define jit_extra_gen_state	\
-	void *alloca_fixup
+	void *alloca_fixup;	\
+	int frame_size
 
 #define jit_extra_gen_init(gen)	\
 	do {	\
 		(gen)->alloca_fixup = 0;	\
+		(gen)->frame_size = 0;	\
 	} while (0)
 
 #define jit_extra_gen_cleanup(gen)	do { ; } while (0)
@@ -134,6 +136,26 @@ extern	"C" {
  */
 #define JIT_USE_PARAM_AREA
 
+/*
+ * Get the location of a fault from the context that is passed to a
+ * signal handler, so that exceptions for faults can be unwound.
+ */
+#if defined(__linux__)
+#define	JIT_SIGNAL_FAULT_PC(uc)		((void *)((uc)->uc_mcontext.gregs[REG_RIP]))
+#define	JIT_SIGNAL_FAULT_FRAME(uc)	((void *)((uc)->uc_mcontext.gregs[REG_RBP]))
+#endif
+
+/*
+ * Exceptions are caught by unwinding the stack with the help of
+ * per-function unwind tables rather than with "setjmp".  Exceptions
+ * that are thrown for signals keep using "setjmp" if the location of
+ * the fault cannot be found.
+ */
+#if defined(__GNUC__) && \
+	(!defined(JIT_USE_SIGNALS) || defined(JIT_SIGNAL_FAULT_PC))
+#define JIT_USE_UNWIND_TABLES
+#endif
+
 #ifdef	__cplusplus
 };
 #endif
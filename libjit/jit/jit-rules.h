@@ -239,6 +239,10 @@ void _jit_gen_insn(jit_gencode_t gen, jit_function_t func,
 void _jit_gen_start_block(jit_gencode_t gen, jit_block_t block);
 void _jit_gen_end_block(jit_gencode_t gen, jit_block_t block);
 int _jit_gen_is_global_candidate(jit_type_t type);
+#ifdef JIT_USE_UNWIND_TABLES
+_jit_unwind_table_t _jit_gen_unwind_table(jit_gencode_t gen, jit_function_t func);
+void _jit_gen_unwind_jump(void *frame, _jit_unwind_table_t table);
+#endif
 
 #if defined(JIT_NATIVE_INT32) && !defined(JIT_BACKEND_INTERP)
 int _jit_reg_get_pair(jit_type_t type, int reg);
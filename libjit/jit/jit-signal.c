@@ -21,20 +21,55 @@
  * <http://www.gnu.org/licenses/>.
  */
 
+/* The register names in "ucontext_t" are GNU extensions */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include "jit-internal.h"
+#include "jit-rules.h"
 
 #ifdef JIT_USE_SIGNALS
 
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef JIT_USE_UNWIND_TABLES
+#include <ucontext.h>
+#endif
+
+/*
+ * Throw a builtin exception from a signal handler.  The exception leaves
+ * the handler without returning, so the signal has to be unblocked here.
+ * Otherwise the next fault of the same kind would kill the process.
+ */
+static void throw_builtin(int signum, void *uap, int exception_type)
+{
+	sigset_t set;
+#ifdef JIT_USE_UNWIND_TABLES
+	jit_thread_control_t control;
+
+	/* Unwinding starts at the fault, not in the handler */
+	control = _jit_thread_get_control();
+	if(control)
+	{
+		control->fault_pc = JIT_SIGNAL_FAULT_PC((ucontext_t *)uap);
+		control->fault_frame = JIT_SIGNAL_FAULT_FRAME((ucontext_t *)uap);
+	}
+#endif
+
+	sigemptyset(&set);
+	sigaddset(&set, signum);
+	sigprocmask(SIG_UNBLOCK, &set, 0);
+	jit_exception_builtin(exception_type);
+}
 
 /*
  * Use SIGSEGV for builtin libjit exception.
  */
 static void sigsegv_handler(int signum, siginfo_t *info, void *uap)
 {
-	jit_exception_builtin(JIT_RESULT_NULL_REFERENCE);
+	throw_builtin(signum, uap, JIT_RESULT_NULL_REFERENCE);
 }
 
 /*
@@ -45,25 +80,25 @@ static void sigfpe_handler(int signum, siginfo_t *info, void *uap)
 	switch(info->si_code)
 	{
 	case FPE_INTDIV:
-		jit_exception_builtin(JIT_RESULT_DIVISION_BY_ZERO);
+		throw_builtin(signum, uap, JIT_RESULT_DIVISION_BY_ZERO);
 		break;
 	case FPE_INTOVF:
-		jit_exception_builtin(JIT_RESULT_OVERFLOW);
+		throw_builtin(signum, uap, JIT_RESULT_OVERFLOW);
 		break;
 	case FPE_FLTDIV:
-		jit_exception_builtin(JIT_RESULT_DIVISION_BY_ZERO);
+		throw_builtin(signum, uap, JIT_RESULT_DIVISION_BY_ZERO);
 		break;
 	case FPE_FLTOVF:
-		jit_exception_builtin(JIT_RESULT_OVERFLOW);
+		throw_builtin(signum, uap, JIT_RESULT_OVERFLOW);
 		break;
 	case FPE_FLTUND:
-		jit_exception_builtin(JIT_RESULT_ARITHMETIC);
+		throw_builtin(signum, uap, JIT_RESULT_ARITHMETIC);
 		break;
 	case FPE_FLTSUB:
-		jit_exception_builtin(JIT_RESULT_ARITHMETIC);
+		throw_builtin(signum, uap, JIT_RESULT_ARITHMETIC);
 		break;
 	default:
-		jit_exception_builtin(JIT_RESULT_ARITHMETIC);
+		throw_builtin(signum, uap, JIT_RESULT_ARITHMETIC);
 		break;
 	}
 }
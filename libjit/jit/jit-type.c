@@ -316,6 +316,21 @@ DECLARE_TAGGED(sys_long_double, nfloat_def, JIT_TYPETAG_SYS_LONGDOUBLE);
 #define	JIT_LAYOUT_EXPLICIT_SIZE	2
 #define	JIT_LAYOUT_EXPLICIT_ALIGN	4
 
+/*
+ * Adjust the reference count of a type.  Functions that are built at
+ * the same time may share types, so the count is updated atomically
+ * where the compiler can do so.
+ */
+#if defined(__GNUC__)
+#define	JIT_TYPE_ADDREF(type)	\
+	__atomic_add_fetch(&((type)->ref_count), 1, __ATOMIC_RELAXED)
+#define	JIT_TYPE_RELEASE(type)	\
+	__atomic_sub_fetch(&((type)->ref_count), 1, __ATOMIC_ACQ_REL)
+#else
+#define	JIT_TYPE_ADDREF(type)	(++((type)->ref_count))
+#define	JIT_TYPE_RELEASE(type)	(--((type)->ref_count))
+#endif
+
 /*
  * Perform layout on a structure or union type.
  */
@@ -433,7 +448,7 @@ jit_type_t jit_type_copy(jit_type_t type)
 	{
 		return type;
 	}
-	++(type->ref_count);
+	JIT_TYPE_ADDREF(type);
 	return type;
 }
 
@@ -451,7 +466,7 @@ void jit_type_free(jit_type_t type)
 	{
 		return;
 	}
-	if(--(type->ref_count) != 0)
+	if(JIT_TYPE_RELEASE(type) != 0)
 	{
 		return;
 	}
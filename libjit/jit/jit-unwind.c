@@ -202,3 +202,311 @@ jit_unwind_get_offset(jit_unwind_context_t *unwind)
 
 	return _jit_function_get_bytecode(func, unwind->cache, pc, 0);
 }
+
+#ifdef JIT_USE_UNWIND_TABLES
+
+/*
+ * Index of the unwind tables of all contexts, sorted by code address.
+ * Exceptions search the index without taking any locks, because they
+ * may be thrown while the thread holds a lock, or from a signal handler.
+ * So a published index is never changed.  It is copied and replaced
+ * instead, with "_jit_global_lock" held.
+ *
+ * Threads that search the index count themselves in "unwind_readers".
+ * Replaced indexes are freed once that count drops to zero.
+ */
+typedef struct _jit_unwind_entry
+{
+	_jit_unwind_table_t	table;
+	jit_context_t		context;
+
+} _jit_unwind_entry_t;
+typedef struct _jit_unwind_index *_jit_unwind_index_t;
+struct _jit_unwind_index
+{
+	_jit_unwind_index_t	next_retired;
+	int			num_entries;
+	_jit_unwind_entry_t	entries[1];
+};
+static _jit_unwind_index_t unwind_index;
+static _jit_unwind_index_t retired_indexes;
+static int unwind_readers;
+
+/*
+ * Allocate an index with room for "num_entries" entries.
+ */
+static _jit_unwind_index_t
+alloc_index(int num_entries)
+{
+	_jit_unwind_index_t index;
+
+	index = (_jit_unwind_index_t)jit_malloc
+		(sizeof(struct _jit_unwind_index) +
+		 (num_entries - 1) * sizeof(_jit_unwind_entry_t));
+	if(index)
+	{
+		index->next_retired = 0;
+		index->num_entries = 0;
+	}
+	return index;
+}
+
+/*
+ * Free the replaced indexes if no thread is searching them.
+ */
+static void
+free_retired_indexes(void)
+{
+	_jit_unwind_index_t index;
+
+	if(__atomic_load_n(&unwind_readers, __ATOMIC_SEQ_CST) != 0)
+	{
+		return;
+	}
+	while(retired_indexes != 0)
+	{
+		index = retired_indexes;
+		retired_indexes = index->next_retired;
+		jit_free(index);
+	}
+}
+
+/*
+ * Wait until no thread is searching an index that was replaced.
+ * Searches are short and never block, so spinning is enough.
+ */
+static void
+wait_for_readers(void)
+{
+	while(__atomic_load_n(&unwind_readers, __ATOMIC_SEQ_CST) != 0)
+	{
+		/* Spin */
+	}
+}
+
+/*
+ * Publish a new index and retire the old one.
+ */
+static void
+replace_index(_jit_unwind_index_t index)
+{
+	_jit_unwind_index_t old = unwind_index;
+
+	__atomic_store_n(&unwind_index, index, __ATOMIC_SEQ_CST);
+	if(old)
+	{
+		old->next_retired = retired_indexes;
+		retired_indexes = old;
+	}
+}
+
+/*
+ * Find the unwind table whose code contains "pc".
+ */
+static _jit_unwind_table_t
+find_unwind_table(_jit_unwind_index_t index, void *pc)
+{
+	_jit_unwind_table_t table;
+	int left = 0;
+	int right = index->num_entries - 1;
+	int middle;
+
+	while(left <= right)
+	{
+		middle = (left + right) / 2;
+		table = index->entries[middle].table;
+		if(pc < table->start)
+		{
+			right = middle - 1;
+		}
+		else if(pc >= table->end)
+		{
+			left = middle + 1;
+		}
+		else
+		{
+			return table;
+		}
+	}
+	return 0;
+}
+
+#endif /* JIT_USE_UNWIND_TABLES */
+
+int
+_jit_unwind_add_table(jit_context_t context, _jit_unwind_table_t table)
+{
+#ifdef JIT_USE_UNWIND_TABLES
+	_jit_unwind_index_t old;
+	_jit_unwind_index_t index;
+	int count, posn;
+
+	jit_mutex_lock(&_jit_global_lock);
+	old = unwind_index;
+	count = (old ? old->num_entries : 0);
+	index = alloc_index(count + 1);
+	if(!index)
+	{
+		jit_mutex_unlock(&_jit_global_lock);
+		return 0;
+	}
+
+	/* Copy the old index and insert the table at its position */
+	posn = 0;
+	while(posn < count && old->entries[posn].table->start < table->start)
+	{
+		index->entries[posn] = old->entries[posn];
+		++posn;
+	}
+	index->entries[posn].table = table;
+	index->entries[posn].context = context;
+	if(posn < count)
+	{
+		jit_memcpy(index->entries + posn + 1, old->entries + posn,
+			   (count - posn) * sizeof(_jit_unwind_entry_t));
+	}
+	index->num_entries = count + 1;
+
+	context->has_unwind_tables = 1;
+	replace_index(index);
+	free_retired_indexes();
+	jit_mutex_unlock(&_jit_global_lock);
+#endif
+	return 1;
+}
+
+void
+_jit_unwind_remove_context(jit_context_t context)
+{
+#ifdef JIT_USE_UNWIND_TABLES
+	_jit_unwind_index_t old;
+	_jit_unwind_index_t index;
+	int posn, count;
+
+	if(!context->has_unwind_tables)
+	{
+		return;
+	}
+	jit_mutex_lock(&_jit_global_lock);
+	old = unwind_index;
+	index = alloc_index(old->num_entries);
+	if(index)
+	{
+		/* Publish a copy of the index without the context's tables */
+		count = 0;
+		for(posn = 0; posn < old->num_entries; ++posn)
+		{
+			if(old->entries[posn].context != context)
+			{
+				index->entries[count++] = old->entries[posn];
+			}
+		}
+		index->num_entries = count;
+		if(!count)
+		{
+			jit_free(index);
+			index = 0;
+		}
+		replace_index(index);
+		wait_for_readers();
+	}
+	else
+	{
+		/* There is no memory for a copy, so hide the index while
+		   the context's tables are removed from it in place */
+		__atomic_store_n(&unwind_index, 0, __ATOMIC_SEQ_CST);
+		wait_for_readers();
+		count = 0;
+		for(posn = 0; posn < old->num_entries; ++posn)
+		{
+			if(old->entries[posn].context != context)
+			{
+				old->entries[count++] = old->entries[posn];
+			}
+		}
+		old->num_entries = count;
+		if(count)
+		{
+			__atomic_store_n(&unwind_index, old, __ATOMIC_SEQ_CST);
+		}
+		else
+		{
+			jit_free(old);
+		}
+	}
+
+	/* The code of the context can be freed once nobody can find it */
+	free_retired_indexes();
+	context->has_unwind_tables = 0;
+	jit_mutex_unlock(&_jit_global_lock);
+#endif
+}
+
+#ifdef JIT_USE_UNWIND_TABLES
+
+void
+_jit_unwind_to_catcher(jit_thread_control_t control, void *frame)
+{
+	_jit_unwind_index_t index;
+	void *limit;
+	void *next;
+	void *pc;
+	_jit_unwind_table_t table;
+
+	/* Frames beyond the top-most "setjmp" buffer are handled by it */
+	limit = (void *)(control->setjmp_head);
+
+	/* An exception that a signal handler throws for a fault starts at
+	   the faulting instruction.  The frame chain of the handler does
+	   not lead to it, because the fault does not push a return address */
+	pc = 0;
+	next = 0;
+	if(control->fault_frame && control->fault_frame > frame &&
+	   (!limit || control->fault_frame < limit))
+	{
+		pc = control->fault_pc;
+		next = control->fault_frame;
+		control->fault_pc = 0;
+		control->fault_frame = 0;
+	}
+
+	/* Don't bother walking the stack if there are no unwind tables */
+	if(!__atomic_load_n(&unwind_index, __ATOMIC_SEQ_CST))
+	{
+		return;
+	}
+
+	__atomic_add_fetch(&unwind_readers, 1, __ATOMIC_SEQ_CST);
+	index = __atomic_load_n(&unwind_index, __ATOMIC_SEQ_CST);
+	table = 0;
+	if(index && next)
+	{
+		table = find_unwind_table(index, pc);
+		frame = next;
+	}
+	while(index && !table && frame != 0)
+	{
+		next = jit_get_next_frame_address(frame);
+		if(!next || next <= frame || (limit && next > limit))
+		{
+			break;
+		}
+
+		/* The return address points just past the call instruction,
+		   which belongs to the function that owns "next" */
+		pc = (void *)(((unsigned char *)jit_get_return_address(frame)) - 1);
+		table = find_unwind_table(index, pc);
+		frame = next;
+	}
+	__atomic_sub_fetch(&unwind_readers, 1, __ATOMIC_SEQ_CST);
+
+	/* The table stays valid after the search because its function
+	   is still running in this thread */
+	if(table)
+	{
+		control->thrown_pc = pc;
+		_jit_gen_unwind_jump(next, table);
+	}
+}
+
+#endif /* JIT_USE_UNWIND_TABLES */
@@ -42,7 +42,7 @@ ILObject *ILExecThreadBoxNoValue(ILExecThread *thread, ILType *type)
 		}
 		classInfo = ILClassResolve(classInfo);
 		typeSize = ILSizeOfType(thread, type);
-		object = (ILObject *)_ILEngineAlloc(thread, classInfo, typeSize);
+		object = (ILObject *)_ILEngineAllocBoxed(thread, classInfo, typeSize);
 		if(!object)
 		{
 			return 0;
@@ -72,7 +72,7 @@ ILObject *ILExecThreadBox(ILExecThread *thread, ILType *type, void *ptr)
 		}
 		classInfo = ILClassResolve(classInfo);
 		typeSize = ILSizeOfType(thread, type);
-		object = (ILObject *)_ILEngineAlloc(thread, classInfo, typeSize);
+		object = (ILObject *)_ILEngineAllocBoxed(thread, classInfo, typeSize);
 		if(object)
 		{
 			ILMemCpy(object, ptr, typeSize);
@@ -106,7 +106,7 @@ ILObject *ILExecThreadBoxFloat(ILExecThread *thread, ILType *type, void *ptr)
 		}
 		classInfo = ILClassResolve(classInfo);
 		typeSize = ILSizeOfType(thread, type);
-		object = (ILObject *)_ILEngineAlloc(thread, classInfo, typeSize);
+		object = (ILObject *)_ILEngineAllocBoxed(thread, classInfo, typeSize);
 		if(object)
 		{
 			if(type == ILType_Float32)
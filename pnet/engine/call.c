@@ -71,9 +71,13 @@ extern	"C" {
 			do { \
 				if((stacktop + (nwords)) > stacklimit) \
 				{ \
-					_ILExecThreadSetException(thread, _ILSystemException \
-						(thread, "System.StackOverflowException")); \
-					return 1; \
+					if(!_ILGrowStack(thread, stacktop, (nwords))) \
+					{ \
+						_ILExecThreadSetException(thread, _ILSystemException \
+							(thread, "System.StackOverflowException")); \
+						return 1; \
+					} \
+					stacklimit = thread->stackLimit; \
 				} \
 			} while (0)
 
@@ -1112,10 +1116,7 @@ int _ILCallMethod(ILExecThread *thread, ILMethod *method,
 			if(!isArrayOrString)
 			{
 				/* We need to allocate the Object. */
-				ILUInt32 alignment;
-				ILUInt32 size = _ILLayoutClassReturn(_ILExecThreadProcess(thread), info, &alignment);
-
-				if(!(_this = _ILEngineAlloc(thread, ILMethod_Owner(method), size)))
+				if(!(_this = _ILEngineAllocObject(thread, info)))
 				{
 					return 1;
 				}
@@ -1232,6 +1233,257 @@ int _ILCallMethod(ILExecThread *thread, ILMethod *method,
 }
 #endif
 
+/*
+ * Arguments for packing the parameters of a call through a call site.
+ */
+typedef struct
+{
+	ILExecCallSite *site;
+	IL_VA_LIST	   *va;
+
+} ILCallSiteArgs;
+
+/*
+ * Pack the parameters for a call site.  This is the same as
+ * "_ILCallPackVaParams", except that the argument layout was
+ * worked out when the call site was resolved.
+ */
+#ifdef IL_USE_JIT
+static int PackSiteParams(ILExecThread *thread, ILType *signature,
+						  int isCtor, void *_this,
+						  void *argBuffer, void **jitArgs, void *userData)
+{
+	ILExecCallSite *site = ((ILCallSiteArgs *)userData)->site;
+	IL_VA_LIST va;
+	ILUInt32 arg;
+
+	/* Copy the incoming "va_list" value */
+	ILMemCpy(&va, ((ILCallSiteArgs *)userData)->va, sizeof(IL_VA_LIST));
+
+	/* Push the "this" argument */
+	if(ILType_HasThis(signature) && !isCtor)
+	{
+		*jitArgs = argBuffer;
+		if(_this)
+		{
+			*((void **)argBuffer) = _this;
+		}
+		else
+		{
+			*((void **)argBuffer) = (void *)(IL_VA_ARG(va, ILObject *));
+		}
+		argBuffer += sizeof(void *);
+		++jitArgs;
+	}
+
+	/* Push the remaining arguments */
+	for(arg = 0; arg < site->numArgs; ++arg)
+	{
+		if((site->args[arg] & IL_CALL_ARG_KIND_MASK) == IL_CALL_ARG_VALUE)
+		{
+			/* Value types are passed as a pointer to a temporary */
+			*jitArgs++ = (void *)(IL_VA_ARG(va, void *));
+			continue;
+		}
+		*jitArgs++ = argBuffer;
+		switch(site->args[arg] & IL_CALL_ARG_KIND_MASK)
+		{
+			case IL_CALL_ARG_I1:
+			{
+				*((ILInt8 *)argBuffer) = (ILInt8)IL_VA_ARG(va, ILVaInt);
+			}
+			break;
+
+			case IL_CALL_ARG_U1:
+			{
+				*((ILUInt8 *)argBuffer) = (ILUInt8)IL_VA_ARG(va, ILVaUInt);
+			}
+			break;
+
+			case IL_CALL_ARG_I2:
+			{
+				*((ILInt16 *)argBuffer) = (ILInt16)IL_VA_ARG(va, ILVaInt);
+			}
+			break;
+
+			case IL_CALL_ARG_U2:
+			{
+				*((ILUInt16 *)argBuffer) = (ILUInt16)IL_VA_ARG(va, ILVaUInt);
+			}
+			break;
+
+			case IL_CALL_ARG_I4:
+			{
+				*((ILInt32 *)argBuffer) = (ILInt32)IL_VA_ARG(va, ILVaInt);
+			}
+			break;
+
+			case IL_CALL_ARG_U4:
+			{
+				*((ILUInt32 *)argBuffer) = (ILUInt32)IL_VA_ARG(va, ILVaUInt);
+			}
+			break;
+
+			case IL_CALL_ARG_I8:
+			{
+				*((ILInt64 *)argBuffer) = IL_VA_ARG(va, ILInt64);
+			}
+			break;
+
+			case IL_CALL_ARG_U8:
+			{
+				*((ILUInt64 *)argBuffer) = IL_VA_ARG(va, ILUInt64);
+			}
+			break;
+
+			case IL_CALL_ARG_R4:
+			{
+				*((ILFloat *)argBuffer) = (ILFloat)IL_VA_ARG(va, ILVaDouble);
+			}
+			break;
+
+			case IL_CALL_ARG_R8:
+			{
+				*((ILDouble *)argBuffer) = (ILDouble)IL_VA_ARG(va, ILVaDouble);
+			}
+			break;
+
+			case IL_CALL_ARG_R:
+			{
+				*((ILNativeFloat *)argBuffer) =
+					(ILNativeFloat)IL_VA_ARG(va, ILVaDouble);
+			}
+			break;
+
+			default:
+			{
+				/* Object references, byrefs and typedref pointers */
+				*((void **)argBuffer) = IL_VA_ARG(va, void *);
+			}
+			break;
+		}
+		argBuffer += sizeof(ILNativeFloat);
+	}
+
+	return 0;
+}
+#else
+static int PackSiteParams(ILExecThread *thread, ILMethod *method,
+						  int isCtor, void *_this, void *userData)
+{
+	ILExecCallSite *site = ((ILCallSiteArgs *)userData)->site;
+	IL_VA_LIST va;
+	CVMWord *stacktop, *stacklimit;
+	ILUInt32 arg, size, sizeInWords;
+	void *ptr;
+	ILInt64 int64Value;
+	ILNativeFloat fValue;
+
+	/* Copy the incoming "va_list" value */
+	ILMemCpy(&va, ((ILCallSiteArgs *)userData)->va, sizeof(IL_VA_LIST));
+
+	/* Get the top and extent of the stack */
+	stacktop = thread->stackTop;
+	stacklimit = thread->stackLimit;
+
+	/* Push the "this" argument */
+	if(ILType_HasThis(ILMethod_Signature(method)) && !isCtor)
+	{
+		CHECK_SPACE(1);
+		if(_this)
+		{
+			stacktop->ptrValue = _this;
+		}
+		else
+		{
+			stacktop->ptrValue = (void *)(IL_VA_ARG(va, ILObject *));
+		}
+		++stacktop;
+	}
+
+	/* Push the remaining arguments */
+	for(arg = 0; arg < site->numArgs; ++arg)
+	{
+		switch(site->args[arg] & IL_CALL_ARG_KIND_MASK)
+		{
+			case IL_CALL_ARG_I1:
+			case IL_CALL_ARG_U1:
+			case IL_CALL_ARG_I2:
+			case IL_CALL_ARG_U2:
+			case IL_CALL_ARG_I4:
+			{
+				CHECK_SPACE(1);
+				stacktop->intValue = (ILInt32)(IL_VA_ARG(va, ILVaInt));
+				++stacktop;
+			}
+			break;
+
+			case IL_CALL_ARG_U4:
+			{
+				CHECK_SPACE(1);
+				stacktop->uintValue = (ILUInt32)(IL_VA_ARG(va, ILVaUInt));
+				++stacktop;
+			}
+			break;
+
+			case IL_CALL_ARG_I8:
+			case IL_CALL_ARG_U8:
+			{
+				CHECK_SPACE(CVM_WORDS_PER_LONG);
+				int64Value = IL_VA_ARG(va, ILInt64);
+				ILMemCpy(stacktop, &int64Value, sizeof(int64Value));
+				stacktop += CVM_WORDS_PER_LONG;
+			}
+			break;
+
+			case IL_CALL_ARG_R4:
+			case IL_CALL_ARG_R8:
+			case IL_CALL_ARG_R:
+			{
+				CHECK_SPACE(CVM_WORDS_PER_NATIVE_FLOAT);
+				fValue = (ILNativeFloat)(IL_VA_ARG(va, ILVaDouble));
+				ILMemCpy(stacktop, &fValue, sizeof(fValue));
+				stacktop += CVM_WORDS_PER_NATIVE_FLOAT;
+			}
+			break;
+
+			case IL_CALL_ARG_TYPEDREF:
+			{
+				CHECK_SPACE(CVM_WORDS_PER_TYPED_REF);
+				ptr = (void *)(IL_VA_ARG(va, void *));
+				ILMemCpy(stacktop, ptr, sizeof(ILTypedRef));
+				stacktop += CVM_WORDS_PER_TYPED_REF;
+			}
+			break;
+
+			case IL_CALL_ARG_VALUE:
+			{
+				ptr = (void *)(IL_VA_ARG(va, void *));
+				size = (site->args[arg] >> IL_CALL_ARG_SIZE_SHIFT);
+				sizeInWords = ((size + sizeof(CVMWord) - 1) / sizeof(CVMWord));
+				CHECK_SPACE(sizeInWords);
+				ILMemCpy(stacktop, ptr, size);
+				stacktop += sizeInWords;
+			}
+			break;
+
+			default:
+			{
+				/* Object references and byrefs */
+				CHECK_SPACE(1);
+				stacktop->ptrValue = (void *)(IL_VA_ARG(va, void *));
+				++stacktop;
+			}
+			break;
+		}
+	}
+
+	/* Update the stack top */
+	thread->stackTop = stacktop;
+	return 0;
+}
+#endif
+
 ILMethod *_ILLookupInterfaceMethod(ILClassPrivate *objectClassPrivate,
 								   ILClass *interfaceClass,
 								   ILUInt32 index)
@@ -1287,7 +1539,8 @@ static void ThrowMethodMissing(ILExecThread *thread)
 }
 
 static int CallVirtualMethod(ILExecThread *thread, ILMethod *method,
-					  		 void *result, void *_this, IL_VA_LIST va)
+					  		 void *result, void *_this,
+							 ILCallPackFunc pack, void *userData)
 {
 	ILClass *classInfo;
 	ILClass *objectClass;
@@ -1308,7 +1561,7 @@ static int CallVirtualMethod(ILExecThread *thread, ILMethod *method,
 		return _ILCallMethod(thread, method,
 							 _ILCallUnpackDirectResult, result,
 							 0, _this,
-							 _ILCallPackVaParams, &va);
+							 pack, userData);
 	}
 	classInfo = method->member.owner;
 	objectClass = GetObjectClass(_this);
@@ -1326,7 +1579,7 @@ static int CallVirtualMethod(ILExecThread *thread, ILMethod *method,
 				return _ILCallMethod(thread, method,
 									 _ILCallUnpackDirectResult, result,
 									 0, _this,
-									 _ILCallPackVaParams, &va);
+									 pack, userData);
 			}
 		}
 	}
@@ -1342,7 +1595,7 @@ static int CallVirtualMethod(ILExecThread *thread, ILMethod *method,
 				return _ILCallMethod(thread, method,
 									 _ILCallUnpackDirectResult, result,
 									 0, _this,
-									 _ILCallPackVaParams, &va);
+									 pack, userData);
 			}
 		}
 	}
@@ -1419,6 +1672,37 @@ static int CallVirtualMethodV(ILExecThread *thread, ILMethod *method,
 	return 1;
 }
 
+/*
+ * Make sure that the class that owns a constructor has been laid out.
+ * Returns zero and throws "TypeLoadException" if it could not be.
+ */
+static int LayoutCtorClass(ILExecThread *thread, ILMethod *ctor,
+						   ILExecCallSite *site)
+{
+	ILClass *classInfo;
+
+	/* The layout only needs to be checked once per call site */
+	if(site && site->classReady)
+	{
+		return 1;
+	}
+	classInfo = ILMethod_Owner(ctor);
+	IL_METADATA_WRLOCK(_ILExecThreadProcess(thread));
+	if(!_ILLayoutClass(_ILExecThreadProcess(thread), classInfo))
+	{
+		IL_METADATA_UNLOCK(_ILExecThreadProcess(thread));
+		ILExecThreadThrowSystem(thread, "System.TypeLoadException",
+								(const char *)0);
+		return 0;
+	}
+	IL_METADATA_UNLOCK(_ILExecThreadProcess(thread));
+	if(site)
+	{
+		site->classReady = 1;
+	}
+	return 1;
+}
+
 int ILExecThreadCall(ILExecThread *thread, ILMethod *method,
 					 void *result, ...)
 {
@@ -1432,9 +1716,74 @@ int ILExecThreadCall(ILExecThread *thread, ILMethod *method,
 	return threwException;
 }
 
+#ifdef IL_USE_JIT
+
+/*
+ * Call a method with ILExecValue arguments through its compiled
+ * invocation stub.  Returns -1 if the method has no stub, in
+ * which case the caller should use "_ILCallMethod" instead.
+ */
+static int CallMethodThunkV(ILExecThread *thread, ILMethod *method,
+							void *result, int isCtor, ILExecValue *args)
+{
+	ILJitInvokeThunk thunk;
+	ILClass *info;
+	ILType *synType;
+	void *_this = 0;
+
+	if(ILType_HasThis(ILMethod_Signature(method)))
+	{
+		if(isCtor)
+		{
+			/* Array and string constructors allocate their own object */
+			info = ILMethod_Owner(method);
+			synType = ILClassGetSynType(info);
+			if((synType && ILType_IsArray(synType)) ||
+			   ILTypeIsStringClass(ILClassToType(info)))
+			{
+				return -1;
+			}
+		}
+		else
+		{
+			/* The "this" argument is the first value */
+			_this = args->objValue;
+			++args;
+		}
+	}
+	if(!(thunk = ILJitGetInvokeThunk(thread, method)))
+	{
+		return -1;
+	}
+	if(isCtor)
+	{
+		if(!(_this = _ILEngineAllocObject(thread, ILMethod_Owner(method))))
+		{
+			return 1;
+		}
+		if((*thunk)(thread, _this, args, 0))
+		{
+			return 1;
+		}
+		*((void **)result) = _this;
+		return 0;
+	}
+	return (*thunk)(thread, _this, args, result);
+}
+
+#endif
+
 int ILExecThreadCallV(ILExecThread *thread, ILMethod *method,
 					  ILExecValue *result, ILExecValue *args)
 {
+#ifdef IL_USE_JIT
+	int threwException;
+	threwException = CallMethodThunkV(thread, method, result, 0, args);
+	if(threwException >= 0)
+	{
+		return threwException;
+	}
+#endif
 	return _ILCallMethod(thread, method,
 						 _ILCallUnpackVResult, result,
 						 0, 0,
@@ -1445,6 +1794,14 @@ ILObject *ILExecThreadCallCtorV(ILExecThread *thread, ILMethod *ctor,
                                 ILExecValue *args)
 {
 	ILObject *result = 0;
+#ifdef IL_USE_JIT
+	int threwException;
+	threwException = CallMethodThunkV(thread, ctor, &result, 1, args);
+	if(threwException >= 0)
+	{
+		return (threwException ? 0 : result);
+	}
+#endif
 	if(_ILCallMethod(thread, ctor,
 					 _ILCallUnpackDirectResult, &result,
 					 1, 0,
@@ -1464,7 +1821,8 @@ int ILExecThreadCallVirtual(ILExecThread *thread, ILMethod *method,
 	int threwException;
 	IL_VA_START(_this);
 	threwException = CallVirtualMethod
-						(thread, method, result, _this, IL_VA_GET_LIST);
+						(thread, method, result, _this,
+						 _ILCallPackVaParams, &IL_VA_GET_LIST);
 	IL_VA_END;
 	return threwException;
 }
@@ -1481,11 +1839,12 @@ int ILExecThreadCallNamed(ILExecThread *thread, const char *typeName,
 						  void *result, ...)
 {
 	int threwException;
-	ILMethod *method;
+	ILExecCallSite *site;
+	ILCallSiteArgs args;
 	IL_VA_START(result);
-	method = ILExecThreadLookupMethod(thread, typeName,
-									  methodName, signature);
-	if(!method)
+	site = ILExecThreadResolveMethod(thread, typeName,
+									 methodName, signature);
+	if(!site)
 	{
 		/* End argument processing */
 		IL_VA_END;
@@ -1496,10 +1855,11 @@ int ILExecThreadCallNamed(ILExecThread *thread, const char *typeName,
 		/* There is a pending exception waiting for the caller */
 		return 1;
 	}
-	threwException = _ILCallMethod(thread, method,
+	args.site = site;
+	args.va = &IL_VA_GET_LIST;
+	threwException = _ILCallMethod(thread, site->method,
 								   _ILCallUnpackDirectResult, result,
-								   0, 0,
-								   _ILCallPackVaParams, &IL_VA_GET_LIST);
+								   0, 0, PackSiteParams, &args);
 	IL_VA_END;
 	return threwException;
 }
@@ -1530,11 +1890,12 @@ int ILExecThreadCallNamedVirtual(ILExecThread *thread, const char *typeName,
 						         void *result, void *_this, ...)
 {
 	int threwException;
-	ILMethod *method;
+	ILExecCallSite *site;
+	ILCallSiteArgs args;
 	IL_VA_START(_this);
-	method = ILExecThreadLookupMethod(thread, typeName,
-									  methodName, signature);
-	if(!method)
+	site = ILExecThreadResolveMethod(thread, typeName,
+									 methodName, signature);
+	if(!site)
 	{
 		/* End argument processing */
 		IL_VA_END;
@@ -1545,8 +1906,11 @@ int ILExecThreadCallNamedVirtual(ILExecThread *thread, const char *typeName,
 		/* There is a pending exception waiting for the caller */
 		return 1;
 	}
+	args.site = site;
+	args.va = &IL_VA_GET_LIST;
 	threwException = CallVirtualMethod
-						(thread, method, result, _this, IL_VA_GET_LIST);
+						(thread, site->method, result, _this,
+						 PackSiteParams, &args);
 	IL_VA_END;
 	return threwException;
 }
@@ -1573,14 +1937,14 @@ int ILExecThreadCallNamedVirtualV(ILExecThread *thread, const char *typeName,
 ILObject *ILExecThreadNew(ILExecThread *thread, const char *typeName,
 						  const char *signature, ...)
 {
-	ILMethod *ctor;
-	ILClass *classInfo;
+	ILExecCallSite *site;
+	ILCallSiteArgs args;
 	ILObject *result;
 	IL_VA_START(signature);
 
 	/* Find the constructor */
-	ctor = ILExecThreadLookupMethod(thread, typeName, ".ctor", signature);
-	if(!ctor)
+	site = ILExecThreadResolveMethod(thread, typeName, ".ctor", signature);
+	if(!site)
 	{
 		/* Throw a "MissingMethodException" */
 		IL_VA_END;
@@ -1589,25 +1953,19 @@ ILObject *ILExecThreadNew(ILExecThread *thread, const char *typeName,
 	}
 
 	/* Make sure that the class has been initialized */
-	classInfo = ILMethod_Owner(ctor);
-	IL_METADATA_WRLOCK(_ILExecThreadProcess(thread));
-	if(!_ILLayoutClass(_ILExecThreadProcess(thread), classInfo))
+	if(!LayoutCtorClass(thread, site->method, site))
 	{
-		/* Throw a "TypeLoadException" */
-		IL_METADATA_UNLOCK(_ILExecThreadProcess(thread));
 		IL_VA_END;
-		ILExecThreadThrowSystem(thread, "System.TypeLoadException",
-								(const char *)0);
 		return 0;
 	}
-	IL_METADATA_UNLOCK(_ILExecThreadProcess(thread));
 
 	/* Call the constructor */
 	result = 0;
-	if(_ILCallMethod(thread, ctor,
+	args.site = site;
+	args.va = &IL_VA_GET_LIST;
+	if(_ILCallMethod(thread, site->method,
 					 _ILCallUnpackDirectResult, &result,
-					 1, 0,
-					 _ILCallPackVaParams, &IL_VA_GET_LIST))
+					 1, 0, PackSiteParams, &args))
 	{
 		/* The constructor threw an exception */
 		IL_VA_END;
@@ -1620,31 +1978,25 @@ ILObject *ILExecThreadNew(ILExecThread *thread, const char *typeName,
 ILObject *ILExecThreadNewV(ILExecThread *thread, const char *typeName,
 						   const char *signature, ILExecValue *args)
 {
+	ILExecCallSite *site;
 	ILMethod *ctor;
-	ILClass *classInfo;
 	ILObject *result;
 
 	/* Find the constructor */
-	ctor = ILExecThreadLookupMethod(thread, typeName, ".ctor", signature);
-	if(!ctor)
+	site = ILExecThreadResolveMethod(thread, typeName, ".ctor", signature);
+	if(!site)
 	{
 		/* Throw a "MissingMethodException" */
 		ThrowMethodMissing(thread);
 		return 0;
 	}
+	ctor = site->method;
 
 	/* Make sure that the class has been initialized */
-	classInfo = ILMethod_Owner(ctor);
-	IL_METADATA_WRLOCK(_ILExecThreadProcess(thread));
-	if(!_ILLayoutClass(_ILExecThreadProcess(thread), classInfo))
+	if(!LayoutCtorClass(thread, ctor, site))
 	{
-		/* Throw a "TypeLoadException" */
-		IL_METADATA_UNLOCK(_ILExecThreadProcess(thread));
-		ILExecThreadThrowSystem(thread, "System.TypeLoadException",
-								(const char *)0);
 		return 0;
 	}
-	IL_METADATA_UNLOCK(_ILExecThreadProcess(thread));
 
 	/* Call the constructor */
 	result = 0;
@@ -1659,6 +2011,81 @@ ILObject *ILExecThreadNewV(ILExecThread *thread, const char *typeName,
 	return result;
 }
 
+int ILExecThreadCallSite(ILExecThread *thread, ILExecCallSite *site,
+						 void *result, ...)
+{
+	int threwException;
+	ILCallSiteArgs args;
+	IL_VA_START(result);
+	if(!site)
+	{
+		IL_VA_END;
+		ThrowMethodMissing(thread);
+		return 1;
+	}
+	args.site = site;
+	args.va = &IL_VA_GET_LIST;
+	threwException = _ILCallMethod(thread, site->method,
+								   _ILCallUnpackDirectResult, result,
+								   0, 0, PackSiteParams, &args);
+	IL_VA_END;
+	return threwException;
+}
+
+int ILExecThreadCallSiteVirtual(ILExecThread *thread, ILExecCallSite *site,
+								void *result, void *_this, ...)
+{
+	int threwException;
+	ILCallSiteArgs args;
+	IL_VA_START(_this);
+	if(!site)
+	{
+		IL_VA_END;
+		ThrowMethodMissing(thread);
+		return 1;
+	}
+	args.site = site;
+	args.va = &IL_VA_GET_LIST;
+	threwException = CallVirtualMethod(thread, site->method, result, _this,
+									   PackSiteParams, &args);
+	IL_VA_END;
+	return threwException;
+}
+
+ILObject *ILExecThreadNewSite(ILExecThread *thread, ILExecCallSite *site, ...)
+{
+	ILCallSiteArgs args;
+	ILObject *result;
+	IL_VA_START(site);
+	if(!site)
+	{
+		IL_VA_END;
+		ThrowMethodMissing(thread);
+		return 0;
+	}
+
+	/* Make sure that the class has been initialized */
+	if(!LayoutCtorClass(thread, site->method, site))
+	{
+		IL_VA_END;
+		return 0;
+	}
+
+	/* Call the constructor */
+	result = 0;
+	args.site = site;
+	args.va = &IL_VA_GET_LIST;
+	if(_ILCallMethod(thread, site->method,
+					 _ILCallUnpackDirectResult, &result,
+					 1, 0, PackSiteParams, &args))
+	{
+		IL_VA_END;
+		return 0;
+	}
+	IL_VA_END;
+	return result;
+}
+
 #ifdef	__cplusplus
 };
 #endif
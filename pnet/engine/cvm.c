@@ -379,6 +379,20 @@ extern	"C" {
 				goto throwStackOverflowException; \
 			} while (0)
 
+/*
+ * Grow the stack so that more than "words" words are available, or
+ * throw a stack overflow exception if it cannot grow any further.
+ * The current instruction is executed again afterwards.
+ */
+#define	GROW_STACK(words)	\
+			do { \
+				if(!_ILGrowStack(thread, stacktop, (words))) \
+				{ \
+					goto throwStackOverflowException; \
+				} \
+				stackmax = thread->stackLimit; \
+			} while (0)
+
 /*
  * Throw a missing method exception.
  */
@@ -95,6 +95,56 @@ ILCallFrame *_ILAllocCallFrame(ILExecThread *thread)
 #endif
 }
 
+/*
+ * Grow the operand stack so that more than "words" words are available.
+ */
+int _ILGrowStack(ILExecThread *thread, CVMWord *stacktop, ILUInt32 words)
+{
+#ifdef IL_CONFIG_GROW_STACK
+	ILUInt32 pageWords;
+	ILUInt32 size;
+	CVMWord *limit;
+
+	/* Bail out if the request doesn't fit within the reserved space */
+	if(((ILUInt32)(thread->stackMax - stacktop)) <= words)
+	{
+		return 0;
+	}
+
+	/* Double the usable size of the stack, rounded up to whole pages */
+	pageWords = (ILUInt32)(ILPageAllocSize() / sizeof(CVMWord));
+	size = (ILUInt32)(thread->stackLimit - thread->stackBase) * 2;
+	if(size <= (ILUInt32)(stacktop - thread->stackBase) + words)
+	{
+		size = (ILUInt32)(stacktop - thread->stackBase) + words + 1;
+	}
+	size = ((size + pageWords - 1) / pageWords) * pageWords;
+	if(size > (ILUInt32)(thread->stackMax - thread->stackBase))
+	{
+		size = (ILUInt32)(thread->stackMax - thread->stackBase);
+	}
+	limit = thread->stackBase + size;
+
+	/* Commit the pages above the high-water mark, and then extend
+	   the root region so that the garbage collector scans them */
+	if(limit > thread->stackCommit)
+	{
+		if(!ILPageCommit(thread->stackCommit,
+						 (limit - thread->stackCommit) * sizeof(CVMWord)))
+		{
+			return 0;
+		}
+		thread->stackCommit = limit;
+	}
+	thread->stackRoots.end = (void *)limit;
+	thread->stackLimit = limit;
+	return 1;
+#else
+	/* We are not allowed to grow the operand stack */
+	return 0;
+#endif
+}
+
 
 #define CHECK_MANAGED_BARRIER()	\
 	if (IL_EXPECT(thread->managedSafePointFlags, 0))	\
@@ -192,6 +242,7 @@ ILCallFrame *_ILAllocCallFrame(ILExecThread *thread)
 #else
 #define	RESTORE_STATE_FROM_THREAD()	\
 			do { \
+				stackmax = thread->stackLimit; \
 				if(IL_EXPECT(_ILExecThreadGetException(thread) != 0, 0)) \
 				{ \
 					/* An exception occurred, which we now must handle */ \
@@ -199,7 +250,6 @@ ILCallFrame *_ILAllocCallFrame(ILExecThread *thread)
 				} \
 				stacktop = thread->stackTop; \
 				frame = thread->frame; \
-				stackmax = thread->stackLimit; \
 			} while (0)
 #endif
 
@@ -1385,7 +1435,8 @@ VMCASE(COP_PUSHDOWN):
 	}
 	else
 	{
-		STACK_OVERFLOW_EXCEPTION();
+		/* Grow the stack and then try again */
+		GROW_STACK(1);
 	}
 }
 VMBREAK(COP_PUSHDOWN);
@@ -2634,7 +2634,7 @@ VMCASE(COP_NEW):
 	}
 	else
 	{
-		STACK_OVERFLOW_EXCEPTION();
+		GROW_STACK(1);
 	}
 }
 VMBREAK(COP_NEW);
@@ -2777,7 +2777,7 @@ VMCASE(COP_BOX):
 	classInfo = CVM_ARG_WIDE_PTR_SMALL(ILClass *);
 	tempNum = (CVM_ARG_WIDE_SMALL + sizeof(CVMWord) - 1) / sizeof(CVMWord);
 	COPY_STATE_TO_THREAD();
-	tempptr = (void *)_ILEngineAlloc(thread, classInfo, CVM_ARG_WIDE_SMALL);
+	tempptr = (void *)_ILEngineAllocBoxed(thread, classInfo, CVM_ARG_WIDE_SMALL);
 	RESTORE_STATE_FROM_THREAD();
 	IL_MEMCPY(tempptr, stacktop - tempNum, CVM_ARG_WIDE_SMALL);
 	stacktop[-((ILInt32)tempNum)].ptrValue = tempptr;
@@ -2817,7 +2817,7 @@ VMCASE(COP_BOX_PTR):
 	/* Box a managed pointer */
 	classInfo = CVM_ARG_WIDE_PTR_SMALL(ILClass *);
 	COPY_STATE_TO_THREAD();
-	tempptr = (void *)_ILEngineAlloc(thread, classInfo, CVM_ARG_WIDE_SMALL);
+	tempptr = (void *)_ILEngineAllocBoxed(thread, classInfo, CVM_ARG_WIDE_SMALL);
 	RESTORE_STATE_FROM_THREAD();
 	IL_MEMCPY(tempptr, stacktop[-1].ptrValue, CVM_ARG_WIDE_SMALL);
 	stacktop[-1].ptrValue = tempptr;
@@ -3027,7 +3027,7 @@ case COP_BOX:
 	tempSize = CVM_ARG_WIDE_LARGE;
 	tempNum = (tempSize + sizeof(CVMWord) - 1) / sizeof(CVMWord);
 	COPY_STATE_TO_THREAD();
-	tempptr = (void *)_ILEngineAlloc(thread, classInfo, tempSize);
+	tempptr = (void *)_ILEngineAllocBoxed(thread, classInfo, tempSize);
 	RESTORE_STATE_FROM_THREAD();
 	IL_MEMCPY(tempptr, stacktop - tempNum, tempSize);
 	stacktop[-((ILInt32)tempNum)].ptrValue = tempptr;
@@ -3041,7 +3041,7 @@ case COP_BOX_PTR:
 	classInfo = CVM_ARG_WIDE_PTR_LARGE(ILClass *);
 	tempSize = CVM_ARG_WIDE_LARGE;
 	COPY_STATE_TO_THREAD();
-	tempptr = (void *)_ILEngineAlloc(thread, classInfo, tempSize);
+	tempptr = (void *)_ILEngineAllocBoxed(thread, classInfo, tempSize);
 	RESTORE_STATE_FROM_THREAD();
 	IL_MEMCPY(tempptr, stacktop[-1].ptrValue, tempSize);
 	stacktop[-1].ptrValue = tempptr;
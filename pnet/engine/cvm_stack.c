@@ -273,7 +273,7 @@ VMCASE(COP_CKHEIGHT):
 	}
 	else
 	{
-		STACK_OVERFLOW_EXCEPTION();
+		GROW_STACK(8);
 	}
 }
 VMBREAK(COP_CKHEIGHT);
@@ -312,7 +312,7 @@ VMCASE(COP_CKHEIGHT_N):
 	}
 	else
 	{
-		STACK_OVERFLOW_EXCEPTION();
+		GROW_STACK(CVM_ARG_WORD);
 	}
 }
 VMBREAK(COP_CKHEIGHT_N);
@@ -491,6 +491,22 @@ int _ILDumpMethodProfile(FILE *stream, ILExecProcess *process)
 	return haveCounts;
 }
 
+/*
+ * Dump branch profile information.  Not supported by the CVM coder.
+ */
+int _ILDumpBranchProfile(FILE *stream, ILExecProcess *process)
+{
+	return 0;
+}
+
+/*
+ * Load branch profile information.  Not supported by the CVM coder.
+ */
+int _ILLoadBranchProfile(FILE *stream, ILExecProcess *process)
+{
+	return 0;
+}
+
 #endif /* !IL_CONFIG_REDUCE_CODE */
 
 /*
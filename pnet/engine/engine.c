@@ -119,7 +119,7 @@ ILExecEngine *ILExecEngineCreate(void)
 	engine->firstProcess = 0;
 #endif
 #ifdef IL_USE_CVM
-	engine->stackSize = IL_CONFIG_STACK_SIZE;
+	engine->stackSize = IL_CONFIG_STACK_MAX_SIZE;
 	engine->frameStackSize = IL_CONFIG_FRAME_STACK_SIZE;
 #endif
 
@@ -21,6 +21,7 @@
 #ifndef	_ENGINE_ENGINE_H
 #define	_ENGINE_ENGINE_H
 #include "il_thread.h"
+#include "il_sysio.h"
 #include "il_engine.h"
 #include "il_system.h"
 #include "il_program.h"
@@ -101,6 +102,13 @@ extern	"C" {
 #ifndef	IL_CONFIG_FRAME_STACK_SIZE
 #define	IL_CONFIG_FRAME_STACK_SIZE	512
 #endif
+#ifndef	IL_CONFIG_STACK_MAX_SIZE
+#ifdef IL_CONFIG_GROW_STACK
+#define	IL_CONFIG_STACK_MAX_SIZE	(IL_CONFIG_STACK_SIZE * 32)
+#else
+#define	IL_CONFIG_STACK_MAX_SIZE	IL_CONFIG_STACK_SIZE
+#endif
+#endif
 
 /*
  * Determine if we should use interface method tables.
@@ -258,7 +266,8 @@ struct _tagILExecProcess
 	/* List of threads that are active within this process */
 	ILExecThread   *firstThread;
 
-	/* The finalizer thread for the process */
+	/* Finalizer threads for the process that are not running a
+	   finalizer right now.  Protected by "lock" */
 	ILExecThread   *finalizerThread;
 
 	/* Context that holds all images that have been loaded by this process */
@@ -315,6 +324,26 @@ struct _tagILExecProcess
 	/* Hash table that maps program items to reflection objects */
 	void		   *reflectionHash;
 
+	/* Hash table of custom attributes that have been decoded */
+	void		   *attributeHash;
+
+	/* Hash table of methods that have been resolved by name */
+	ILExecCallSite * volatile *callSiteHash;
+
+	/* Cache of "ffi" descriptors for native methods and structures */
+	void * volatile	ffiCache;
+
+	/* Assemblies whose code is trusted to be type safe */
+	char		  **trustedAssemblies;
+	int				numTrustedAssemblies;
+
+	/* The last image whose trust level was checked by the verifier */
+	ILImage		   *verifyImage;
+	int				verifyImageTrusted;
+
+	/* Cache of methods that have been verified on previous runs */
+	void		   *verifyCache;
+
 	/* List of loaded modules for PInvoke methods */
 	ILLoadedModule *loadedModules;
 
@@ -337,6 +366,14 @@ struct _tagILExecProcess
 	/* Size of the global thread-static allocation */
 	ILUInt32			numThreadStaticSlots;
 
+	/* Native thread pools for "System.Threading.ThreadPool" */
+	ILThreadPool * volatile workerPool;
+	ILThreadPool * volatile completionPool;
+	ILMethod * volatile workItemExecute;
+
+	/* Readiness notification for asynchronous socket and pipe I/O */
+	ILSysIOReactor * volatile reactor;
+
 	/* Image loading flags */
 	int					loadFlags;
 
@@ -483,6 +520,9 @@ struct _tagILExecThread
 	/* Finalizer threads are destroyed last */
 	int isFinalizerThread;
 
+	/* Next idle finalizer thread for the process */
+	ILExecThread *nextFinalizerThread;
+
 	/* Free monitors list */
 	ILExecMonitor *freeMonitor;
 
@@ -490,9 +530,16 @@ struct _tagILExecThread
 	int freeMonitorCount;
 
 #ifdef IL_USE_CVM
-	/* Extent of the execution stack */
+	/* Extent of the execution stack.  Address space is reserved up
+	   to "stackMax", but only "stackLimit" is currently usable */
 	CVMWord		   *stackBase;
 	CVMWord		   *stackLimit;
+	CVMWord		   *stackCommit;	/* High-water mark of committed pages */
+	CVMWord		   *stackMax;
+	int				stackReserved;
+
+	/* Root region that the collector scans up to "stackLimit" */
+	ILGCRootRegion	stackRoots;
 
 	/* Current thread state */
 	unsigned char  *pc;				/* Current program position */
@@ -568,6 +615,7 @@ struct _tagILClassPrivate
 	ILUInt32		hasFinalizer : 1;	/* Non-zero if non-trivial finalizer */
 	ILUInt32		managedInstance : 1;/* Non-zero if managed instance field */
 	ILUInt32		managedStatic : 1;	/* Non-zero if managed static field */
+	ILUInt32		blittable : 1;		/* Non-zero if native without conversion */
 	ILUInt32		alignment : 6;		/* Preferred instance alignment */
 	ILUInt32		nativeAlignment : 6;/* Preferred native alignment */
 	ILUInt32		vtableSize : 16;	/* Size of the vtable */
@@ -577,6 +625,7 @@ struct _tagILClassPrivate
 	ILImplPrivate  *implements;			/* Interface implementation records */
 	ILNativeInt		gcTypeDescriptor;	/* Describes the layout of the type for the GC */
 	ILClassPrivate *nextClassPrivate;	/* linked list of ILClassPrivate objects */
+	ILMethod	   *finalizeMethod;		/* Cached "Finalize" method, or NULL */
 	ILExecProcess  *process;			/* Back-pointer to the process this class belongs to */
 #ifdef IL_USE_JIT
 	void		  **jitVtable;			/* table with vtable pointers to the vtable methods. */
@@ -770,6 +819,46 @@ typedef int (*ILCallPackFunc)(ILExecThread *thread, ILMethod *method,
 typedef void (*ILCallUnpackFunc)(ILExecThread *thread, ILMethod *method,
 					             int isCtor, void *result, void *userData);
 
+/*
+ * Kinds of arguments in the layout of a call site.  Value types
+ * also record their size, shifted up by "IL_CALL_ARG_SIZE_SHIFT".
+ */
+#define	IL_CALL_ARG_I1				1
+#define	IL_CALL_ARG_U1				2
+#define	IL_CALL_ARG_I2				3
+#define	IL_CALL_ARG_U2				4
+#define	IL_CALL_ARG_I4				5
+#define	IL_CALL_ARG_U4				6
+#define	IL_CALL_ARG_I8				7
+#define	IL_CALL_ARG_U8				8
+#define	IL_CALL_ARG_R4				9
+#define	IL_CALL_ARG_R8				10
+#define	IL_CALL_ARG_R				11
+#define	IL_CALL_ARG_TYPEDREF		12
+#define	IL_CALL_ARG_PTR				13
+#define	IL_CALL_ARG_VALUE			14
+#define	IL_CALL_ARG_KIND_MASK		0xFF
+#define	IL_CALL_ARG_SIZE_SHIFT		8
+
+/*
+ * A method that was resolved by name, along with the layout of its
+ * arguments.  Call sites are kept in a per-process hash table and
+ * are never changed once they are visible to other threads, except
+ * for "classReady".
+ */
+struct _tagILExecCallSite
+{
+	ILExecCallSite *next;			/* Next call site in the hash bucket */
+	unsigned long	hash;
+	const char	   *typeName;
+	const char	   *methodName;
+	const char	   *signature;
+	ILMethod	   *method;
+	int				classReady;		/* Non-zero once the owner is laid out */
+	ILUInt32		numArgs;
+	ILUInt32		args[1];		/* Layout of the non-void arguments */
+};
+
 /*
  * Call a method using the supplied packing and unpacking rules.
  */
@@ -824,6 +913,11 @@ ILNativeUInt ILGCBuildStaticTypeDescriptor(ILClass *classInfo,
 int _ILVerify(ILCoder *coder, unsigned char **start, ILMethod *method,
 			  ILMethodCode *code, int unsafeAllowed, ILExecThread *thread);
 
+/*
+ * Destroy the verification cache for a process.
+ */
+void _ILVerifyCacheDestroy(ILExecProcess *process);
+
 /*
  * Construct the "ffi_cif" structure that is needed to
  * call a PInvoke or "internalcall" method.  Returns NULL
@@ -841,6 +935,11 @@ void *_ILMakeCifForMethod(ILExecProcess *process, ILMethod *method,
 void *_ILMakeCifForConstructor(ILExecProcess *process, ILMethod *method,
 								int isInternal);
 
+/*
+ * Destroy the cache of "ffi" descriptors for a process.
+ */
+void _ILFFICacheDestroy(ILExecProcess *process);
+
 /*
  * Make a native closure for a particular delegate.  "method"
  * is the method within the delegate object.
@@ -868,6 +967,12 @@ unsigned char *_ILConvertMethod(ILExecThread *thread, ILMethod *method);
  */
 void _ILFinalizeObject(void *block, void *data);
 
+/*
+ * Stop watching a socket or pipe handle for readiness before it is
+ * closed.  Pending asynchronous operations on the handle are queued.
+ */
+void _ILExecProcessUnwatchHandle(ILExecProcess *process, ILNativeInt handle);
+
 /*
  * Allocate a block of memory and associate it with a specific class.
  * This will throw an exception if out of memory, and return zero.
@@ -888,6 +993,14 @@ ILObject *_ILEngineAllocAtomic(ILExecThread *thread, ILClass *classInfo,
  */
 ILObject *_ILEngineAllocObject(ILExecThread *thread, ILClass *classInfo);
 
+/*
+ * Allocate a block of memory to hold a boxed value of a specific
+ * value type.  The class layout is used to avoid scanning boxed
+ * values that do not contain object references.
+ */
+ILObject *_ILEngineAllocBoxed(ILExecThread *thread, ILClass *classInfo,
+							  ILUInt32 size);
+
 /*
  * Find the function for an "internalcall" method.
  * Returns zero if there is no function information.
@@ -912,6 +1025,11 @@ ILClass *_ILLookupClass(ILExecProcess *process,
 						const char *className,
 						int classNameLen);
 
+/*
+ * Free the call sites that were resolved for a process.
+ */
+void _ILExecCallSiteDestroy(ILExecProcess *process);
+
 /*
  * Look up an interface method.  Returns NULL if not found.
  */
@@ -997,6 +1115,19 @@ ILCallFrame *_ILGetNextCallFrame(ILExecThread *thread, ILCallFrame *frame);
  */
 ILCallFrame *_ILAllocCallFrame(ILExecThread *thread);
 
+/*
+ * Grow the operand stack for a given thread so that more than
+ * "words" words are available above "stacktop".  Returns zero
+ * if the stack cannot grow that far.
+ */
+int _ILGrowStack(ILExecThread *thread, CVMWord *stacktop, ILUInt32 words);
+
+/*
+ * Release the operand stack memory that a thread is not using while
+ * it waits.  Does nothing if the engine doesn't use an operand stack.
+ */
+void _ILExecThreadShrinkStack(ILExecThread *thread);
+
 #ifdef IL_DEBUGGER
 /*
  * Reallocate the watches for a given thread in order
@@ -1093,6 +1224,22 @@ void _ILCVMSetFrameOffset(ILCoder *coder, int frameOffset);
  */
 ILUInt32 _ILSizeOfTypeLocked(ILExecProcess *process, ILType *type);
 
+/*
+ * Determine if values of a type may contain object references that
+ * the garbage collector must scan.  Primitive types and value types
+ * without managed fields can be allocated atomically.  The "Locked"
+ * version assumes that the caller has the metadata write lock.
+ */
+int _ILTypeHasManagedFields(ILExecThread *thread, ILType *type);
+int _ILTypeHasManagedFieldsLocked(ILExecProcess *process, ILType *type);
+
+/*
+ * Determine if a value type can be passed to native code without
+ * converting any of its fields.  The caller must have the metadata
+ * write lock.
+ */
+int _ILTypeIsBlittableLocked(ILExecProcess *process, ILType *type);
+
 /*
  * Get the native closure associated with a delegate.  Returns NULL
  * if the closure could not be created for some reason.
@@ -68,6 +68,12 @@ static IL_INLINE ILMethod *FindFinalizeMethod(ILClassPrivate *classPrivate)
 		return 0;
 	}
 
+	/* Use the method that we found for an earlier object of this class */
+	if (classPrivate->finalizeMethod)
+	{
+		return classPrivate->finalizeMethod;
+	}
+
 	classInfo = classPrivate->classInfo;
 
 	while(classInfo != 0)
@@ -85,6 +91,7 @@ static IL_INLINE ILMethod *FindFinalizeMethod(ILClassPrivate *classPrivate)
 				if(ILTypeGetReturn(signature) == ILType_Void &&
 				   ILTypeNumParams(signature) == 0)
 				{
+					classPrivate->finalizeMethod = method;
 					return method;
 				}
 			}
@@ -95,7 +102,47 @@ static IL_INLINE ILMethod *FindFinalizeMethod(ILClassPrivate *classPrivate)
 	return 0;
 }
 
-/* This method assumes there is only one finalizer thread for the entire os process */
+/*
+ * Get an idle finalizer thread for a process, or create a new one.
+ * Several threads may be running finalizers at the same time.
+ */
+static ILExecThread *AcquireFinalizerThread(ILExecProcess *process)
+{
+	ILExecThread *execThread;
+
+	ILMutexLock(process->lock);
+	execThread = process->finalizerThread;
+	if(execThread)
+	{
+		process->finalizerThread = execThread->nextFinalizerThread;
+		execThread->nextFinalizerThread = 0;
+	}
+	ILMutexUnlock(process->lock);
+
+	if(!execThread)
+	{
+		/* Create a new engine thread for the finalizers of this process */
+		execThread = _ILExecThreadCreate(process, 1);
+		if(execThread)
+		{
+			execThread->isFinalizerThread = 1;
+		}
+	}
+	return execThread;
+}
+
+/*
+ * Return a finalizer thread to the idle list of its process.
+ */
+static void ReleaseFinalizerThread(ILExecProcess *process,
+								   ILExecThread *execThread)
+{
+	ILMutexLock(process->lock);
+	execThread->nextFinalizerThread = process->finalizerThread;
+	process->finalizerThread = execThread;
+	ILMutexUnlock(process->lock);
+}
+
 void _ILFinalizeObject(void *block, void *data)
 {
 	ILObject *object;
@@ -130,25 +177,15 @@ void _ILFinalizeObject(void *block, void *data)
 	}
 
 	/* Get the engine thread to execute the finalizer on */
-	execThread = process->finalizerThread;
-
-	/* Get the finalizer thread instance */
-	thread = ILThreadSelf();
-	
+	execThread = AcquireFinalizerThread(process);
 	if (execThread == 0)
 	{
-		/* Create a new engine thread for the finalizers of this process to run on */
-
-		execThread = _ILExecThreadCreate(process, 1);
-
-		if (execThread == 0)
-		{
-			return;
-		}
-
-		process->finalizerThread = execThread;
+		return;
 	}
 
+	/* Get the finalizer thread instance */
+	thread = ILThreadSelf();
+
 	newContext.execThread = execThread;
 
 	/* Make the new thread execute on the finalizer ILExecThread
@@ -183,6 +220,8 @@ void _ILFinalizeObject(void *block, void *data)
 	   is used) so the ILThread needs to be reassociated with the
 	   original ILExecThread rather than the finalizer ILExecThread. */
 	_ILThreadRestoreExecContext(thread, &saveContext);
+
+	ReleaseFinalizerThread(process, execThread);
 }
 
 ILObject *_ILEngineAlloc(ILExecThread *thread, ILClass *classInfo,
@@ -377,6 +416,35 @@ ILObject *_ILEngineAllocObject(ILExecThread *thread, ILClass *classInfo)
 #endif	/* !IL_USE_TYPED_ALLOCATION */
 }
 
+ILObject *_ILEngineAllocBoxed(ILExecThread *thread, ILClass *classInfo,
+							  ILUInt32 size)
+{
+	ILClassPrivate *classPrivate;
+
+	classInfo = ILClassResolve(classInfo);
+	if(!InitializeClass(thread, classInfo))
+	{
+		return 0;
+	}
+	classPrivate = (ILClassPrivate *)(classInfo->userData);
+#ifdef	IL_USE_TYPED_ALLOCATION
+	if(classPrivate->size == size)
+	{
+		/* The class descriptor describes the boxed value exactly */
+		return _ILEngineAllocTyped(thread, classInfo);
+	}
+#endif	/* IL_USE_TYPED_ALLOCATION */
+	if(classPrivate->managedInstance)
+	{
+		return _ILEngineAlloc(thread, classInfo, size);
+	}
+	else
+	{
+		/* The value has no managed fields, so use atomic allocation */
+		return _ILEngineAllocAtomic(thread, classInfo, size);
+	}
+}
+
 #ifdef	__cplusplus
 };
 #endif
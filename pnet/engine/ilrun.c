@@ -41,6 +41,80 @@ extern	"C" {
 int _ILRegisterWithKernel(const char *progname);
 int _ILUnregisterFromKernel(void);
 
+/*
+ * Imports from "verify.c".
+ */
+int _ILLoadVerifyCache(FILE *stream, ILExecProcess *process);
+int _ILDumpVerifyCache(FILE *stream, ILExecProcess *process);
+
+/*
+ * Save the verification cache to "filename".
+ */
+static void SaveVerifyCache(const char *filename, ILExecProcess *process)
+{
+	char *tempName;
+	FILE *stream;
+	int ok;
+
+	/* Other threads may still be verifying methods if we are
+	   being called from "exit" */
+
+	tempName = (char *)ILMalloc(strlen(filename) + 32);
+	if(!tempName)
+	{
+		return;
+	}
+#if defined(HAVE_UNISTD_H) && !defined(_MSC_VER)
+	sprintf(tempName, "%s.%ld.tmp", filename, (long)getpid());
+#else
+	sprintf(tempName, "%s.tmp", filename);
+#endif
+	if((stream = fopen(tempName, "wb")) == NULL)
+	{
+		perror(tempName);
+		ILFree(tempName);
+		return;
+	}
+	IL_METADATA_WRLOCK(process);
+	ok = _ILDumpVerifyCache(stream, process);
+	IL_METADATA_UNLOCK(process);
+	if(fflush(stream) != 0)
+	{
+		ok = 0;
+	}
+	if(fclose(stream) != 0)
+	{
+		ok = 0;
+	}
+	if(!ok || rename(tempName, filename) != 0)
+	{
+		perror(filename);
+		remove(tempName);
+	}
+	ILFree(tempName);
+}
+
+/*
+ * The verification cache that has yet to be saved.
+ */
+static const char *verifyCacheSaveFile;
+static ILExecProcess *verifyCacheSaveProcess;
+
+/*
+ * Save the verification cache if it has not been saved yet.  This is
+ * registered with "atexit" so that the cache is also saved when the
+ * program calls "Environment.Exit".
+ */
+static void SaveVerifyCacheOnExit(void)
+{
+	const char *filename = verifyCacheSaveFile;
+	if(filename)
+	{
+		verifyCacheSaveFile = 0;
+		SaveVerifyCache(filename, verifyCacheSaveProcess);
+	}
+}
+
 #ifndef IL_WITHOUT_TOOLS
 
 /*
@@ -53,6 +127,8 @@ int _ILDumpVarProfile(FILE *stream);
  * Imports from "cvmc.c".
  */
 int _ILDumpMethodProfile(FILE *stream, ILExecProcess *process);
+int _ILDumpBranchProfile(FILE *stream, ILExecProcess *process);
+int _ILLoadBranchProfile(FILE *stream, ILExecProcess *process);
 
 /*
  * Imports from "dumpconfig.c"
@@ -72,7 +148,7 @@ static ILCmdLineOption const options[] = {
 	{"-S", 'S', 1, 0, 0},
 	{"--stack-size", 'S', 1, 
 	        "--stack-size value  or -S value",
-	        "Set the operation stack size to `value' kilobytes."},
+	        "Set the maximum operation stack size to `value' kilobytes."},
 	{"-C", 'C', 1, 0, 0},
 	{"--method-cache-page", 'C', 1, 
 	        "--method-cache-page value  or -C value",
@@ -81,10 +157,31 @@ static ILCmdLineOption const options[] = {
 	{"--library-dir", 'L', 1,
 		"--library-dir dir       or -L dir",
 		"Specify a directory to search for libraries."},
+	{"--trust", 't', 1,
+		"--trust file",
+		"Skip type safety checks on code from the assembly `file'."},
+	{"--verify-cache", 'k', 1,
+		"--verify-cache file",
+		"Remember methods that passed verification in `file'."},
 	{"-i", 'i', 0, 0, 0},
 	{"--ignore-load-errors", 'i', 0,
 		"--ignore-load-errors    or -i",
 		"Ignore metadata errors when loading (discouraged)."},
+	{"--gc-markers", 'm', 1,
+		"--gc-markers count",
+		"Use `count' threads to mark the heap during collections."},
+	{"--gc-incremental", 'n', 0,
+		"--gc-incremental",
+		"Collect the heap incrementally to shorten pauses."},
+	{"--gc-pause-target", 'p', 1,
+		"--gc-pause-target ms",
+		"Aim for incremental collection pauses of `ms' milliseconds."},
+	{"--gc-finalizers", 'f', 1,
+		"--gc-finalizers count",
+		"Use up to `count' threads to run finalizers in parallel."},
+	{"--gc-stats", 's', 0,
+		"--gc-stats",
+		"Report garbage collection statistics on exit."},
 	{"-O", 'O', 1, 0, 0},
 	{"--optimization-level", 'O', 1,
 		"--optimization-level level	or -O level",
@@ -125,6 +222,14 @@ static ILCmdLineOption const options[] = {
 		"--debugger-url [url]    or -G",
 		"Connect to debugger client using specific connection string."},
 #endif
+	{"-b", 'b', 1, 0, 0},
+	{"--branch-profile", 'b', 1,
+		"--branch-profile file   or -b file",
+		"Count the conditional branches and write the counts to file on exit."},
+	{"-B", 'B', 1, 0, 0},
+	{"--use-branch-profile", 'B', 1,
+		"--use-branch-profile file or -B file",
+		"Lay out the jitted code using the branch counts in file."},
 	{"-T", 'T', 0, 0, 0},
 	{"--trace",	  'T', 0,
 		"--trace                 or -T",
@@ -163,10 +268,14 @@ int main(int argc, char *argv[])
 {
 	char *progname = argv[0];
 	unsigned long heapSize = IL_CONFIG_GC_HEAP_SIZE;
-	unsigned long stackSize = IL_CONFIG_STACK_SIZE;
+	unsigned long stackSize = IL_CONFIG_STACK_MAX_SIZE;
 	unsigned long methodCachePageSize = IL_CONFIG_CACHE_PAGE_SIZE;
 	char **libraryDirs;
 	int numLibraryDirs;
+	char **trustedNames;
+	int numTrustedNames;
+	char *verifyCacheFile = 0;
+	FILE *verifyCache;
 	int state, opt;
 	char *param;
 	ILExecProcess *process;
@@ -181,10 +290,14 @@ int main(int argc, char *argv[])
 	int loadFlags = 0;
 	int optimizationLeve = 0;
 	int setOptimizationLevel = 0;
+	ILGCOptions gcOptions;
 #ifndef IL_CONFIG_REDUCE_CODE
 	int dumpInsnProfile = 0;
 	int dumpVarProfile = 0;
 	int dumpMethodProfile = 0;
+	char *branchProfileOut = 0;
+	char *branchProfileIn = 0;
+	FILE *branchProfile;
 	int dumpParams = 0;
 	int dumpConfig = 0;
 #endif
@@ -204,6 +317,17 @@ int main(int argc, char *argv[])
 	libraryDirs = (char **)ILMalloc(sizeof(char *) * argc);
 	numLibraryDirs = 0;
 
+	/* Allocate space for the trusted assembly list */
+	trustedNames = (char **)ILMalloc(sizeof(char *) * argc);
+	numTrustedNames = 0;
+
+	/* No garbage collector tuning by default */
+	gcOptions.markers = 0;
+	gcOptions.incremental = 0;
+	gcOptions.pauseTarget = 0;
+	gcOptions.reportPauses = 0;
+	gcOptions.finalizers = 0;
+
 	/* Parse the command-line arguments */
 	state = 0;
 	while((opt = ILCmdLineNextOption(&argc, &argv, &state,
@@ -261,6 +385,70 @@ int main(int argc, char *argv[])
 			}
 			break;
 
+			case 't':
+			{
+				if(trustedNames != 0)
+				{
+					trustedNames[numTrustedNames++] = param;
+				}
+			}
+			break;
+
+			case 'k':
+			{
+				verifyCacheFile = param;
+			}
+			break;
+
+			case 'm':
+			{
+				gcOptions.markers = 0;
+				while(*param >= '0' && *param <= '9')
+				{
+					gcOptions.markers = gcOptions.markers * 10 +
+										(int)(*param - '0');
+					++param;
+				}
+			}
+			break;
+
+			case 'n':
+			{
+				gcOptions.incremental = 1;
+			}
+			break;
+
+			case 'p':
+			{
+				gcOptions.pauseTarget = 0;
+				while(*param >= '0' && *param <= '9')
+				{
+					gcOptions.pauseTarget = gcOptions.pauseTarget * 10 +
+											(unsigned long)(*param - '0');
+					++param;
+				}
+				gcOptions.incremental = 1;
+			}
+			break;
+
+			case 'f':
+			{
+				gcOptions.finalizers = 0;
+				while(*param >= '0' && *param <= '9')
+				{
+					gcOptions.finalizers = gcOptions.finalizers * 10 +
+										   (int)(*param - '0');
+					++param;
+				}
+			}
+			break;
+
+			case 's':
+			{
+				gcOptions.reportPauses = 1;
+			}
+			break;
+
 			case 'r': case 'u':
 			{
 				registerMode = opt;
@@ -334,6 +522,19 @@ int main(int argc, char *argv[])
 				flags |= IL_CODER_FLAG_METHOD_TRACE;
 			}
 			break;
+
+			case 'b':
+			{
+				flags |= IL_CODER_FLAG_BRANCH_PROFILE;
+				branchProfileOut = param;
+			}
+			break;
+
+			case 'B':
+			{
+				branchProfileIn = param;
+			}
+			break;
 		#endif
 
 		#ifdef IL_DEBUGGER
@@ -401,6 +602,7 @@ int main(int argc, char *argv[])
 	}
 
 	/* Initialize the engine and set the maximum heap size */
+	ILGCSetOptions(&gcOptions);
 	if (ILExecInit(heapSize) != IL_EXEC_INIT_OK)
 	{
 		#ifndef REDUCED_STDIO
@@ -456,6 +658,25 @@ int main(int argc, char *argv[])
 	{
 		ILCoderSetOptimizationLevel(process->coder, optimizationLeve);
 	}
+#if !defined(IL_CONFIG_REDUCE_CODE) && !defined(IL_WITHOUT_TOOLS)
+	if(branchProfileIn)
+	{
+		/* Load the branch counts of a previous run */
+		if((branchProfile = fopen(branchProfileIn, "r")) == NULL)
+		{
+			perror(branchProfileIn);
+		}
+		else
+		{
+			if(!_ILLoadBranchProfile(branchProfile, process))
+			{
+				fprintf(stderr, "%s: could not load branch profile from %s\n",
+						progname, branchProfileIn);
+			}
+			fclose(branchProfile);
+		}
+	}
+#endif
 
 	/* Set the list of directories to use for path searching */
 	if(numLibraryDirs > 0)
@@ -463,6 +684,31 @@ int main(int argc, char *argv[])
 		ILExecProcessSetLibraryDirs(process, libraryDirs, numLibraryDirs);
 	}
 
+	/* Set the list of assemblies whose code is trusted */
+	for(opt = 0; opt < numTrustedNames; ++opt)
+	{
+		ILExecProcessTrustAssembly(process, trustedNames[opt]);
+	}
+
+	/* Load the methods that have been verified on previous runs.
+	   A missing file starts a new cache */
+	if(verifyCacheFile)
+	{
+		verifyCache = fopen(verifyCacheFile, "rb");
+		if(!_ILLoadVerifyCache(verifyCache, process))
+		{
+			fprintf(stderr, "%s: ignoring invalid verification cache %s\n",
+					progname, verifyCacheFile);
+		}
+		if(verifyCache)
+		{
+			fclose(verifyCache);
+		}
+		verifyCacheSaveFile = verifyCacheFile;
+		verifyCacheSaveProcess = process;
+		atexit(SaveVerifyCacheOnExit);
+	}
+
 	/* Get the name of the IL program, appending ".exe" if necessary */
 	ilprogram = argv[1];
 	ilprogramLen = strlen(ilprogram);
@@ -514,6 +760,7 @@ int main(int argc, char *argv[])
 		else if(error == IL_EXECUTE_LOADERR_NOT_IL)
 		{
 			/* This is a regular Windows executable */
+			SaveVerifyCacheOnExit();
 			ILExecDeinit();
 			argv[1] = ilprogram;
 		#ifndef IL_WIN32_PLATFORM
@@ -556,6 +803,7 @@ int main(int argc, char *argv[])
 			printf("%s: invalid entry point\n", ilprogram);
 		#endif
 		}
+		SaveVerifyCacheOnExit();
 		ILExecDeinit();
 		return 1;
 	}
@@ -604,6 +852,22 @@ int main(int argc, char *argv[])
 					);
 		}
 	}
+	if(branchProfileOut)
+	{
+		if((branchProfile = fopen(branchProfileOut, "w")) == NULL)
+		{
+			perror(branchProfileOut);
+		}
+		else
+		{
+			if(!_ILDumpBranchProfile(branchProfile, process))
+			{
+				fprintf(stderr, "%s: branch profiles are not available\n",
+						progname);
+			}
+			fclose(branchProfile);
+		}
+	}
 	if(dumpVarProfile)
 	{
 		if(!_ILDumpVarProfile(stdout))
@@ -627,6 +891,11 @@ int main(int argc, char *argv[])
 	}
 #endif
 
+	/* Save the verification cache for the next run.  The cache is
+	   written to a temporary file and then renamed, so that a crash
+	   or a concurrent run cannot leave a partially written file */
+	SaveVerifyCacheOnExit();
+
 	/* Clean up the process and exit */
 	error = ILExecProcessGetStatus(process);
 	ILExecDeinit();
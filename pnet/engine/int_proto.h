@@ -459,6 +459,14 @@ extern void _IL_Thread_Resume(ILExecThread * _thread, ILObject * _this);
 extern void _IL_Thread_SpinWait(ILExecThread * _thread, ILInt32 iterations);
 extern void _IL_Thread_Suspend(ILExecThread * _thread, ILObject * _this);
 
+extern ILBool _IL_ThreadPool_InternalQueueWorkItem(ILExecThread * _thread, ILObject * item, ILInt32 pool);
+extern ILInt32 _IL_ThreadPool_InternalGetMinThreads(ILExecThread * _thread, ILInt32 pool);
+extern ILInt32 _IL_ThreadPool_InternalGetMaxThreads(ILExecThread * _thread, ILInt32 pool);
+extern ILInt32 _IL_ThreadPool_InternalGetAvailableThreads(ILExecThread * _thread, ILInt32 pool);
+extern ILBool _IL_ThreadPool_InternalSetMinThreads(ILExecThread * _thread, ILInt32 pool, ILInt32 count);
+extern ILBool _IL_ThreadPool_InternalSetMaxThreads(ILExecThread * _thread, ILInt32 pool, ILInt32 count);
+extern ILBool _IL_ThreadPool_InternalWatchHandle(ILExecThread * _thread, ILNativeInt handle, ILBool write, ILObject * item);
+
 extern void _IL_Monitor_Enter(ILExecThread * _thread, ILObject * obj);
 extern void _IL_Monitor_Exit(ILExecThread * _thread, ILObject * obj);
 extern void _IL_Monitor_Pulse(ILExecThread * _thread, ILObject * obj);
@@ -604,6 +612,8 @@ extern void _IL_CryptoMethods_HashUpdate(ILExecThread * _thread, ILNativeInt sta
 extern void _IL_CryptoMethods_HashFinal(ILExecThread * _thread, ILNativeInt state, System_Array * hash);
 extern void _IL_CryptoMethods_Decrypt(ILExecThread * _thread, ILNativeInt state, System_Array * inBuffer, ILInt32 inOffset, System_Array * outBuffer, ILInt32 outOffset);
 extern void _IL_CryptoMethods_Encrypt(ILExecThread * _thread, ILNativeInt state, System_Array * inBuffer, ILInt32 inOffset, System_Array * outBuffer, ILInt32 outOffset);
+extern void _IL_CryptoMethods_DecryptBlocks(ILExecThread * _thread, ILNativeInt state, System_Array * iv, System_Array * inBuffer, ILInt32 inOffset, System_Array * outBuffer, ILInt32 outOffset, ILInt32 count);
+extern void _IL_CryptoMethods_EncryptBlocks(ILExecThread * _thread, ILNativeInt state, System_Array * iv, System_Array * inBuffer, ILInt32 inOffset, System_Array * outBuffer, ILInt32 outOffset, ILInt32 count);
 extern ILNativeInt _IL_CryptoMethods_EncryptCreate(ILExecThread * _thread, ILInt32 algorithm, System_Array * key);
 extern ILNativeInt _IL_CryptoMethods_DecryptCreate(ILExecThread * _thread, ILInt32 algorithm, System_Array * key);
 extern void _IL_CryptoMethods_SymmetricFree(ILExecThread * _thread, ILNativeInt state);
@@ -701,6 +711,9 @@ extern ILBool _IL_SocketMethods_Accept(ILExecThread * _thread, ILNativeInt handl
 extern ILBool _IL_SocketMethods_GetSockName(ILExecThread * _thread, ILNativeInt handle, System_Array * addrReturn);
 extern ILInt32 _IL_SocketMethods_ReceiveFrom(ILExecThread * _thread, ILNativeInt handle, System_Array * buffer, ILInt32 offset, ILInt32 size, ILInt32 flags, System_Array * addrReturn);
 extern ILInt32 _IL_SocketMethods_SendTo(ILExecThread * _thread, ILNativeInt handle, System_Array * buffer, ILInt32 offset, ILInt32 size, ILInt32 flags, System_Array * addr);
+extern ILInt32 _IL_SocketMethods_SendV(ILExecThread * _thread, ILNativeInt handle, System_Array * buffers, System_Array * offsets, System_Array * counts, ILInt32 flags);
+extern ILInt32 _IL_SocketMethods_ReceiveV(ILExecThread * _thread, ILNativeInt handle, System_Array * buffers, System_Array * offsets, System_Array * counts, ILInt32 flags);
+extern ILInt64 _IL_SocketMethods_SendFile(ILExecThread * _thread, ILNativeInt handle, ILNativeInt file, ILInt64 offset, ILInt64 count);
 extern ILBool _IL_SocketMethods_Bind(ILExecThread * _thread, ILNativeInt handle, System_Array * addr);
 extern ILBool _IL_SocketMethods_GetSocketOption(ILExecThread * _thread, ILNativeInt handle, ILInt32 level, ILInt32 name, ILInt32 * value);
 extern ILBool _IL_SocketMethods_GetLingerOption(ILExecThread * _thread, ILNativeInt handle, ILBool * enabled, ILInt32 * seconds);
@@ -708,6 +721,12 @@ extern ILBool _IL_SocketMethods_GetMulticastOption(ILExecThread * _thread, ILNat
 extern ILBool _IL_SocketMethods_DiscoverIrDADevices(ILExecThread * _thread, ILNativeInt handle, System_Array * buf);
 extern ILBool _IL_SocketMethods_Listen(ILExecThread * _thread, ILNativeInt handle, ILInt32 backlog);
 extern ILInt32 _IL_SocketMethods_Select(ILExecThread * _thread, System_Array * readarray, System_Array * writearray, System_Array * errorarray, ILInt64 timeout);
+extern ILNativeInt _IL_SocketMethods_PollSetCreate(ILExecThread * _thread);
+extern void _IL_SocketMethods_PollSetDestroy(ILExecThread * _thread, ILNativeInt pollSet);
+extern void _IL_SocketMethods_PollSetWakeup(ILExecThread * _thread, ILNativeInt pollSet);
+extern ILBool _IL_SocketMethods_PollSetAdd(ILExecThread * _thread, ILNativeInt pollSet, ILNativeInt handle, ILInt32 events, ILInt32 id);
+extern ILBool _IL_SocketMethods_PollSetRemove(ILExecThread * _thread, ILNativeInt pollSet, ILNativeInt handle);
+extern ILInt32 _IL_SocketMethods_PollSetWait(ILExecThread * _thread, ILNativeInt pollSet, System_Array * ids, System_Array * events, ILInt64 timeout);
 extern ILBool _IL_SocketMethods_SetSocketOption(ILExecThread * _thread, ILNativeInt handle, ILInt32 level, ILInt32 name, ILInt32 value);
 extern ILBool _IL_SocketMethods_SetLingerOption(ILExecThread * _thread, ILNativeInt handle, ILBool enabled, ILInt32 seconds);
 extern ILBool _IL_SocketMethods_SetMulticastOption(ILExecThread * _thread, ILNativeInt handle, ILInt32 af, ILInt32 name, System_Array * group, System_Array * mcint);
@@ -715,6 +734,7 @@ extern ILBool _IL_SocketMethods_Shutdown(ILExecThread * _thread, ILNativeInt han
 extern ILBool _IL_SocketMethods_SetBlocking(ILExecThread * _thread, ILNativeInt handle, ILBool blocking);
 extern ILBool _IL_SocketMethods_CanStartThreads(ILExecThread * _thread);
 extern ILBool _IL_SocketMethods_QueueCompletionItem(ILExecThread * _thread, ILObject * callback, ILObject * state);
+extern ILBool _IL_SocketMethods_QueueCompletionOnReady(ILExecThread * _thread, ILNativeInt handle, ILBool write, ILObject * callback, ILObject * state);
 extern ILObject * _IL_SocketMethods_CreateManualResetEvent(ILExecThread * _thread);
 extern void _IL_SocketMethods_WaitHandleSet(ILExecThread * _thread, ILObject * waitHandle);
 
@@ -2130,6 +2130,38 @@ IL_METHOD_END
 
 #endif
 
+#if !defined(HAVE_LIBFFI)
+
+static void marshal_bpii(void (*fn)(), void *rvalue, void **avalue)
+{
+	*((ILNativeInt *)rvalue) = (*(ILInt8 (*)(void *, ILInt32, ILInt32))fn)(*((void * *)(avalue[0])), *((ILInt32 *)(avalue[1])), *((ILInt32 *)(avalue[2])));
+}
+
+#endif
+
+#if !defined(HAVE_LIBFFI)
+
+static void marshal_bpjbp(void (*fn)(), void *rvalue, void **avalue)
+{
+	*((ILNativeInt *)rvalue) = (*(ILInt8 (*)(void *, ILNativeUInt, ILInt8, void *))fn)(*((void * *)(avalue[0])), *((ILNativeUInt *)(avalue[1])), *((ILInt8 *)(avalue[2])), *((void * *)(avalue[3])));
+}
+
+#endif
+
+#ifndef _IL_ThreadPool_suppressed
+
+IL_METHOD_BEGIN(ThreadPool_Methods)
+	IL_METHOD("InternalQueueWorkItem", "(oSystem.Object;i)Z", _IL_ThreadPool_InternalQueueWorkItem, marshal_bppi)
+	IL_METHOD("InternalGetMinThreads", "(i)i", _IL_ThreadPool_InternalGetMinThreads, marshal_ipi)
+	IL_METHOD("InternalGetMaxThreads", "(i)i", _IL_ThreadPool_InternalGetMaxThreads, marshal_ipi)
+	IL_METHOD("InternalGetAvailableThreads", "(i)i", _IL_ThreadPool_InternalGetAvailableThreads, marshal_ipi)
+	IL_METHOD("InternalSetMinThreads", "(ii)Z", _IL_ThreadPool_InternalSetMinThreads, marshal_bpii)
+	IL_METHOD("InternalSetMaxThreads", "(ii)Z", _IL_ThreadPool_InternalSetMaxThreads, marshal_bpii)
+	IL_METHOD("InternalWatchHandle", "(jZoSystem.Object;)Z", _IL_ThreadPool_InternalWatchHandle, marshal_bpjbp)
+IL_METHOD_END
+
+#endif
+
 #ifndef _IL_Monitor_suppressed
 
 IL_METHOD_BEGIN(Monitor_Methods)
@@ -2665,6 +2697,15 @@ static void marshal_vpjpipi(void (*fn)(), void *rvalue, void **avalue)
 
 #if !defined(HAVE_LIBFFI)
 
+static void marshal_vpjppipii(void (*fn)(), void *rvalue, void **avalue)
+{
+	(*(void (*)(void *, ILNativeUInt, void *, void *, ILInt32, void *, ILInt32, ILInt32))fn)(*((void * *)(avalue[0])), *((ILNativeUInt *)(avalue[1])), *((void * *)(avalue[2])), *((void * *)(avalue[3])), *((ILInt32 *)(avalue[4])), *((void * *)(avalue[5])), *((ILInt32 *)(avalue[6])), *((ILInt32 *)(avalue[7])));
+}
+
+#endif
+
+#if !defined(HAVE_LIBFFI)
+
 static void marshal_jpip(void (*fn)(), void *rvalue, void **avalue)
 {
 	*((ILNativeUInt *)rvalue) = (*(ILNativeUInt (*)(void *, ILInt32, void *))fn)(*((void * *)(avalue[0])), *((ILInt32 *)(avalue[1])), *((void * *)(avalue[2])));
@@ -2701,6 +2742,8 @@ IL_METHOD_BEGIN(CryptoMethods_Methods)
 	IL_METHOD("HashFinal", "(j[B)V", _IL_CryptoMethods_HashFinal, marshal_vpjp)
 	IL_METHOD("Decrypt", "(j[Bi[Bi)V", _IL_CryptoMethods_Decrypt, marshal_vpjpipi)
 	IL_METHOD("Encrypt", "(j[Bi[Bi)V", _IL_CryptoMethods_Encrypt, marshal_vpjpipi)
+	IL_METHOD("DecryptBlocks", "(j[B[Bi[Bii)V", _IL_CryptoMethods_DecryptBlocks, marshal_vpjppipii)
+	IL_METHOD("EncryptBlocks", "(j[B[Bi[Bii)V", _IL_CryptoMethods_EncryptBlocks, marshal_vpjppipii)
 	IL_METHOD("EncryptCreate", "(i[B)j", _IL_CryptoMethods_EncryptCreate, marshal_jpip)
 	IL_METHOD("DecryptCreate", "(i[B)j", _IL_CryptoMethods_DecryptCreate, marshal_jpip)
 	IL_METHOD("SymmetricFree", "(j)V", _IL_CryptoMethods_SymmetricFree, marshal_vpj)
@@ -3015,6 +3058,47 @@ static void marshal_bpjb(void (*fn)(), void *rvalue, void **avalue)
 
 #endif
 
+#if !defined(HAVE_LIBFFI)
+
+static void marshal_bpjbpp(void (*fn)(), void *rvalue, void **avalue)
+{
+	*((ILNativeInt *)rvalue) = (*(ILInt8 (*)(void *, ILNativeUInt, ILInt8, void *, void *))fn)(*((void * *)(avalue[0])), *((ILNativeUInt *)(avalue[1])), *((ILInt8 *)(avalue[2])), *((void * *)(avalue[3])), *((void * *)(avalue[4])));
+}
+
+#endif
+
+#if !defined(HAVE_LIBFFI)
+
+static void marshal_bpjjii(void (*fn)(), void *rvalue, void **avalue)
+{
+	*((ILNativeInt *)rvalue) = (*(ILInt8 (*)(void *, ILNativeUInt, ILNativeUInt, ILInt32, ILInt32))fn)(*((void * *)(avalue[0])), *((ILNativeUInt *)(avalue[1])), *((ILNativeUInt *)(avalue[2])), *((ILInt32 *)(avalue[3])), *((ILInt32 *)(avalue[4])));
+}
+
+#endif
+
+#if !defined(HAVE_LIBFFI)
+
+static void marshal_ipjppl(void (*fn)(), void *rvalue, void **avalue)
+{
+	*((ILNativeInt *)rvalue) = (*(ILInt32 (*)(void *, ILNativeUInt, void *, void *, ILInt64))fn)(*((void * *)(avalue[0])), *((ILNativeUInt *)(avalue[1])), *((void * *)(avalue[2])), *((void * *)(avalue[3])), *((ILInt64 *)(avalue[4])));
+}
+
+#endif
+
+#if !defined(HAVE_LIBFFI)
+
+static void marshal_ipjpppi(void (*fn)(), void *rvalue, void **avalue)
+{
+	*((ILNativeInt *)rvalue) = (*(ILInt32 (*)(void *, ILNativeUInt, void *, void *, void *, ILInt32))fn)(*((void * *)(avalue[0])), *((ILNativeUInt *)(avalue[1])), *((void * *)(avalue[2])), *((void * *)(avalue[3])), *((void * *)(avalue[4])), *((ILInt32 *)(avalue[5])));
+}
+
+static void marshal_lpjjll(void (*fn)(), void *rvalue, void **avalue)
+{
+	*((ILInt64 *)rvalue) = (*(ILInt64 (*)(void *, ILNativeUInt, ILNativeUInt, ILInt64, ILInt64))fn)(*((void * *)(avalue[0])), *((ILNativeUInt *)(avalue[1])), *((ILNativeUInt *)(avalue[2])), *((ILInt64 *)(avalue[3])), *((ILInt64 *)(avalue[4])));
+}
+
+#endif
+
 #ifndef _IL_SocketMethods_suppressed
 
 IL_METHOD_BEGIN(SocketMethods_Methods)
@@ -3032,6 +3116,9 @@ IL_METHOD_BEGIN(SocketMethods_Methods)
 	IL_METHOD("GetSockName", "(j[B)Z", _IL_SocketMethods_GetSockName, marshal_bpjp)
 	IL_METHOD("ReceiveFrom", "(j[Biii[B)i", _IL_SocketMethods_ReceiveFrom, marshal_ipjpiiip)
 	IL_METHOD("SendTo", "(j[Biii[B)i", _IL_SocketMethods_SendTo, marshal_ipjpiiip)
+	IL_METHOD("SendV", "(j[[B[i[ii)i", _IL_SocketMethods_SendV, marshal_ipjpppi)
+	IL_METHOD("ReceiveV", "(j[[B[i[ii)i", _IL_SocketMethods_ReceiveV, marshal_ipjpppi)
+	IL_METHOD("SendFile", "(jjll)l", _IL_SocketMethods_SendFile, marshal_lpjjll)
 	IL_METHOD("Bind", "(j[B)Z", _IL_SocketMethods_Bind, marshal_bpjp)
 	IL_METHOD("GetSocketOption", "(jii&i)Z", _IL_SocketMethods_GetSocketOption, marshal_bpjiip)
 	IL_METHOD("GetLingerOption", "(j&Z&i)Z", _IL_SocketMethods_GetLingerOption, marshal_bpjpp)
@@ -3039,6 +3126,12 @@ IL_METHOD_BEGIN(SocketMethods_Methods)
 	IL_METHOD("DiscoverIrDADevices", "(j[B)Z", _IL_SocketMethods_DiscoverIrDADevices, marshal_bpjp)
 	IL_METHOD("Listen", "(ji)Z", _IL_SocketMethods_Listen, marshal_bpji)
 	IL_METHOD("Select", "([j[j[jl)i", _IL_SocketMethods_Select, marshal_ippppl)
+	IL_METHOD("PollSetCreate", "()j", _IL_SocketMethods_PollSetCreate, marshal_jp)
+	IL_METHOD("PollSetDestroy", "(j)V", _IL_SocketMethods_PollSetDestroy, marshal_vpj)
+	IL_METHOD("PollSetWakeup", "(j)V", _IL_SocketMethods_PollSetWakeup, marshal_vpj)
+	IL_METHOD("PollSetAdd", "(jjii)Z", _IL_SocketMethods_PollSetAdd, marshal_bpjjii)
+	IL_METHOD("PollSetRemove", "(jj)Z", _IL_SocketMethods_PollSetRemove, marshal_bpjj)
+	IL_METHOD("PollSetWait", "(j[i[il)i", _IL_SocketMethods_PollSetWait, marshal_ipjppl)
 	IL_METHOD("SetSocketOption", "(jiii)Z", _IL_SocketMethods_SetSocketOption, marshal_bpjiii)
 	IL_METHOD("SetLingerOption", "(jZi)Z", _IL_SocketMethods_SetLingerOption, marshal_bpjbi)
 	IL_METHOD("SetMulticastOption", "(jii[B[B)Z", _IL_SocketMethods_SetMulticastOption, marshal_bpjiipp)
@@ -3046,6 +3139,7 @@ IL_METHOD_BEGIN(SocketMethods_Methods)
 	IL_METHOD("SetBlocking", "(jZ)Z", _IL_SocketMethods_SetBlocking, marshal_bpjb)
 	IL_METHOD("CanStartThreads", "()Z", _IL_SocketMethods_CanStartThreads, marshal_bp)
 	IL_METHOD("QueueCompletionItem", "(oSystem.AsyncCallback;oSystem.IAsyncResult;)Z", _IL_SocketMethods_QueueCompletionItem, marshal_bppp)
+	IL_METHOD("QueueCompletionOnReady", "(jZoSystem.AsyncCallback;oSystem.IAsyncResult;)Z", _IL_SocketMethods_QueueCompletionOnReady, marshal_bpjbpp)
 	IL_METHOD("CreateManualResetEvent", "()oSystem.Threading.WaitHandle;", _IL_SocketMethods_CreateManualResetEvent, marshal_pp)
 	IL_METHOD("WaitHandleSet", "(oSystem.Threading.WaitHandle;)V", _IL_SocketMethods_WaitHandleSet, marshal_vpp)
 IL_METHOD_END
@@ -3082,15 +3176,6 @@ IL_METHOD_END
 
 #if !defined(HAVE_LIBFFI)
 
-static void marshal_bpii(void (*fn)(), void *rvalue, void **avalue)
-{
-	*((ILNativeInt *)rvalue) = (*(ILInt8 (*)(void *, ILInt32, ILInt32))fn)(*((void * *)(avalue[0])), *((ILInt32 *)(avalue[1])), *((ILInt32 *)(avalue[2])));
-}
-
-#endif
-
-#if !defined(HAVE_LIBFFI)
-
 static void marshal_jpiip(void (*fn)(), void *rvalue, void **avalue)
 {
 	*((ILNativeUInt *)rvalue) = (*(ILNativeUInt (*)(void *, ILInt32, ILInt32, void *))fn)(*((void * *)(avalue[0])), *((ILInt32 *)(avalue[1])), *((ILInt32 *)(avalue[2])), *((void * *)(avalue[3])));
@@ -3366,6 +3451,9 @@ static InternalClassInfo const internalClassTable[] = {
 #ifndef _IL_Thread_suppressed
 	{"Thread", "System.Threading", Thread_Methods},
 #endif
+#ifndef _IL_ThreadPool_suppressed
+	{"ThreadPool", "System.Threading", ThreadPool_Methods},
+#endif
 #ifndef _IL_TimeMethods_suppressed
 	{"TimeMethods", "Platform", TimeMethods_Methods},
 #endif
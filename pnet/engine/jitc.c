@@ -337,6 +337,26 @@ static ILJitType _ILJitSignature_ILSArrayCopy_AI4AI4I4 = 0;
  */
 static ILJitType _ILJitSignature_ILSArrayClear_AI4I4 = 0;
 
+/*
+ * int ILDecimalAdd(ILDecimal *result, const ILDecimal *valuea,
+ *					const ILDecimal *valueb, int roundMode)
+ * (also used for ILDecimalSub, ILDecimalMul and ILDecimalDiv)
+ */
+static ILJitType _ILJitSignature_ILDecimalBinary = 0;
+
+/*
+ * int ILDecimalCmp(const ILDecimal *valuea, const ILDecimal *valueb)
+ */
+static ILJitType _ILJitSignature_ILDecimalCmp = 0;
+
+/*
+ * void _IL_Decimal_Add(ILExecThread *thread, ILDecimal *result,
+ *						ILDecimal *valuea, ILDecimal *valueb)
+ * (also used for _IL_Decimal_Subtract, _IL_Decimal_Multiply and
+ * _IL_Decimal_Divide)
+ */
+static ILJitType _ILJitSignature_ILDecimalInternal = 0;
+
 #if !defined(IL_CONFIG_REDUCE_CODE) && !defined(IL_WITHOUT_TOOLS)
 #ifdef ENHANCED_PROFILER
 /*
@@ -385,6 +405,7 @@ static void *JITCoder_HandleLockedMethod(ILCoder *coder, ILMethod *method);
 #include "jitc_delegate.c"
 #include "jitc_math.c"
 #include "jitc_profile.c"
+#include "jitc_escape.c"
 #undef	IL_JITC_DECLARATIONS
 
 #define _IL_JIT_IMPL_DEFAULT		0x000
@@ -436,6 +457,7 @@ struct _tagILJITCoder
 #include "jitc_labels.c"
 #include "jitc_profile.c"
 #include "jitc_except.c"
+#include "jitc_escape.c"
 #undef	IL_JITC_CODER_INSTANCE
 
 	/* The current jitted function. */
@@ -2076,6 +2098,7 @@ static void *_ILJitOnDemandDriver(ILJitFunction func)
 	void *entry_point;
 	jit_on_demand_func onDemandCompiler;
 	int result = JIT_RESULT_OK;
+	int haveCCtors;
 	jit_context_t context = jit_function_get_context(func);
 
 	if(!context)
@@ -2096,11 +2119,19 @@ static void *_ILJitOnDemandDriver(ILJitFunction func)
 		return entry_point;
 	}
 
+	/* Lock down the function.  The context has the concurrent build
+	   option set, so this does not keep other threads from compiling
+	   other functions once they have the metadata lock. */
+	jit_function_build_start(func);
+
 	/* Check if the function is compiled now */
 	if(jit_function_is_compiled(func))
 	{
 		if(jit_function_compile_entry(func, &entry_point))
 		{
+			/* Unlock the function. */
+			jit_function_build_end(func);
+
 			/* Unlock the metadata. */
 			METADATA_UNLOCK(process);
 
@@ -2113,15 +2144,12 @@ static void *_ILJitOnDemandDriver(ILJitFunction func)
 	ILCCtorMgr_SetCurrentMethod(&(jitCoder->cctorMgr), method);
 	jitCoder->cctorMgr.currentJitFunction = func;
 
-	/* Lock down the context. */
-	jit_context_build_start(context);
-
 	if(!(onDemandCompiler = jit_function_get_on_demand_compiler(func)))
 	{
 		result = JIT_RESULT_COMPILE_ERROR;
 
-		/* Unlock the context. */
-		jit_context_build_end(context);
+		/* Unlock the function. */
+		jit_function_build_end(func);
 
 		/* Unlock the metadata. */
 		METADATA_UNLOCK(process);
@@ -2143,26 +2171,51 @@ static void *_ILJitOnDemandDriver(ILJitFunction func)
 	#endif	/* _IL_JIT_DUMP_FUNCTION */
 	#endif
 
+		/* The coder is done with the function now, unless class
+		   initializers were queued for it.  The cctor manager then
+		   needs the metadata lock until they have run. */
+		haveCCtors = (jitCoder->cctorMgr.lastClass != 0);
+		if(!haveCCtors)
+		{
+			/* Unlock the metadata, so that other threads can convert
+			   their methods while this one is compiled. */
+			METADATA_UNLOCK(process);
+		}
+
 		/* Now compile the function to it's native form. */
 		if(!jit_function_compile_entry(func, &entry_point))
 		{
 			/* How are errors handled ? */
 
-			/* Unlock the context. */
-			jit_context_build_end(context);
+			/* Unlock the function. */
+			jit_function_build_end(func);
 
-			/* Unlock the metadata. */
-			METADATA_UNLOCK(process);
+			if(haveCCtors)
+			{
+				/* Unlock the metadata. */
+				METADATA_UNLOCK(process);
+			}
 
 			/* And throw an exception. */
 			jit_exception_builtin(JIT_RESULT_OUT_OF_MEMORY);
 		}
 
-		/* Unlock the context. */
-		jit_context_build_end(context);
+		if(!haveCCtors)
+		{
+			/* Make the function available. */
+			jit_function_setup_entry(func, entry_point);
+
+			/* Unlock the function. */
+			jit_function_build_end(func);
+		}
+		else
+		{
+			/* Unlock the function. */
+			jit_function_build_end(func);
 
-		/* and run the queued class initializers. */
-		ILCCtorMgr_RunCCtors(&(jitCoder->cctorMgr), entry_point);
+			/* and run the queued class initializers. */
+			ILCCtorMgr_RunCCtors(&(jitCoder->cctorMgr), entry_point);
+		}
 
 	#if !defined(IL_CONFIG_REDUCE_CODE) && !defined(IL_WITHOUT_TOOLS) && defined(_IL_JIT_ENABLE_DEBUG)
 	#ifdef _IL_JIT_DISASSEMBLE_FUNCTION
@@ -2177,8 +2230,8 @@ static void *_ILJitOnDemandDriver(ILJitFunction func)
 	}
 	else
 	{
-		/* Unlock the context. */
-		jit_context_build_end(context);
+		/* Unlock the function. */
+		jit_function_build_end(func);
 
 		/* This is ugly but it's the only fast solution now */
 		if(onDemandCompiler != _ILJitCompile)
@@ -2563,6 +2616,37 @@ int ILJitInit()
 		return 0;
 	}
 
+	args[0] = _IL_JIT_TYPE_VPTR;
+	args[1] = _IL_JIT_TYPE_VPTR;
+	args[2] = _IL_JIT_TYPE_VPTR;
+	args[3] = _IL_JIT_TYPE_INT32;
+	returnType = _IL_JIT_TYPE_INT32;
+	if(!(_ILJitSignature_ILDecimalBinary =
+		jit_type_create_signature(IL_JIT_CALLCONV_CDECL, returnType, args, 4, 1)))
+	{
+		return 0;
+	}
+
+	args[0] = _IL_JIT_TYPE_VPTR;
+	args[1] = _IL_JIT_TYPE_VPTR;
+	returnType = _IL_JIT_TYPE_INT32;
+	if(!(_ILJitSignature_ILDecimalCmp =
+		jit_type_create_signature(IL_JIT_CALLCONV_CDECL, returnType, args, 2, 1)))
+	{
+		return 0;
+	}
+
+	args[0] = _IL_JIT_TYPE_VPTR;
+	args[1] = _IL_JIT_TYPE_VPTR;
+	args[2] = _IL_JIT_TYPE_VPTR;
+	args[3] = _IL_JIT_TYPE_VPTR;
+	returnType = _IL_JIT_TYPE_VOID;
+	if(!(_ILJitSignature_ILDecimalInternal =
+		jit_type_create_signature(IL_JIT_CALLCONV_CDECL, returnType, args, 4, 1)))
+	{
+		return 0;
+	}
+
 #if !defined(IL_CONFIG_REDUCE_CODE) && !defined(IL_WITHOUT_TOOLS)
 #ifdef ENHANCED_PROFILER
 	args[0] = _IL_JIT_TYPE_VPTR;
@@ -2637,6 +2721,12 @@ static ILCoder *JITCoder_Create(ILExecProcess *process, ILUInt32 size,
 	jit_context_set_on_demand_driver(coder->context,
 									 _ILJitOnDemandDriver);
 
+	/* Let threads compile different methods at the same time.  The
+	   driver still converts one method at a time under the metadata
+	   lock, because all threads share this coder. */
+	jit_context_set_meta_numeric(coder->context,
+								 JIT_OPTION_CONCURRENT_BUILD, 1);
+
 #ifndef IL_JIT_THREAD_IN_SIGNATURE
 	coder->thread = 0;
 #endif
@@ -2648,6 +2738,7 @@ static ILCoder *JITCoder_Create(ILExecProcess *process, ILUInt32 size,
 #include "jitc_labels.c"
 #include "jitc_profile.c"
 #include "jitc_except.c"
+#include "jitc_escape.c"
 #undef IL_JITC_CODER_INIT
 
 	/* Ready to go */
@@ -2877,6 +2968,7 @@ static void JITCoder_Destroy(ILCoder *_coder)
 #include "jitc_stack.c"
 #include "jitc_labels.c"
 #include "jitc_profile.c"
+#include "jitc_escape.c"
 #undef IL_JITC_CODER_DESTROY
 
 	if(coder->context)
@@ -4156,6 +4248,8 @@ static int _ILJitSetMethodInfo(ILJITCoder *jitCoder, ILMethod *method,
 		jitMethodInfo->implementationType = implementationType;
 		jitMethodInfo->fnInfo = fnInfo;
 		jitMethodInfo->inlineFunc = inlineFunc;
+		jitMethodInfo->branchCounters = 0;
+		jitMethodInfo->invokeThunk = 0;
 
 		/* and link the new jitFunction to the method. */
 		method->userData = (void *)jitMethodInfo;
@@ -4332,6 +4426,271 @@ int ILJitCallMethod(ILExecThread *thread, ILMethod *method, void **jitArgs, void
 	return 1;
 }
 
+/*
+ * Build the invocation stub for a method.  The stub loads each argument
+ * from its ILExecValue slot, converts it to the type of the parameter,
+ * and calls the method directly.  Exceptions are caught in the stub so
+ * that they never unwind through the C code that called it.
+ */
+static ILJitInvokeThunk _ILJitCreateInvokeThunk(ILJITCoder *jitCoder,
+												ILMethod *method,
+												ILJitFunction target)
+{
+	ILType *signature = ILMethod_Signature(method);
+	ILJitType targetSignature = jit_function_get_signature(target);
+	ILUInt32 numArgs = jit_type_num_params(targetSignature);
+	ILUInt32 numParams = ILTypeNumParams(signature);
+	ILJitType returnType = jit_type_get_return(targetSignature);
+	ILJitType thunkArgTypes[4];
+	ILJitType thunkSignature;
+	ILJitFunction thunk;
+	ILJitValue thread, _this, args, result;
+	ILJitValue callArgs[numArgs + 1];
+	ILJitValue value;
+	ILJitType paramJitType;
+	ILType *paramType;
+	ILUInt32 param, current;
+	ILUInt32 offset;
+	jit_label_t noResult = jit_label_undefined;
+
+	/* The thread, "this" and the parameters must account for all
+	   of the arguments of the jit function */
+#ifdef IL_JIT_THREAD_IN_SIGNATURE
+	current = 1;
+#else
+	current = 0;
+#endif
+	if(ILType_HasThis(signature))
+	{
+		++current;
+	}
+	if(current + numParams != numArgs)
+	{
+		return 0;
+	}
+
+	/* Create the stub function */
+	thunkArgTypes[0] = _IL_JIT_TYPE_VPTR;
+	thunkArgTypes[1] = _IL_JIT_TYPE_VPTR;
+	thunkArgTypes[2] = _IL_JIT_TYPE_VPTR;
+	thunkArgTypes[3] = _IL_JIT_TYPE_VPTR;
+	if(!(thunkSignature = jit_type_create_signature(jit_abi_cdecl,
+													_IL_JIT_TYPE_INT32,
+													thunkArgTypes, 4, 1)))
+	{
+		return 0;
+	}
+	thunk = jit_function_create(jitCoder->context, thunkSignature);
+	jit_type_free(thunkSignature);
+	if(!thunk)
+	{
+		return 0;
+	}
+	jit_insn_uses_catcher(thunk);
+	thread = jit_value_get_param(thunk, 0);
+	_this = jit_value_get_param(thunk, 1);
+	args = jit_value_get_param(thunk, 2);
+	result = jit_value_get_param(thunk, 3);
+
+	/* Collect the arguments for the call */
+	current = 0;
+#ifdef IL_JIT_THREAD_IN_SIGNATURE
+	callArgs[current++] = thread;
+#endif
+	if(ILType_HasThis(signature))
+	{
+		callArgs[current++] = _this;
+	}
+	for(param = 1; param <= numParams; ++param)
+	{
+		paramType = ILTypeGetEnumType(ILTypeGetParam(signature, param));
+		paramJitType = jit_type_get_param(targetSignature, current);
+		offset = (param - 1) * sizeof(ILExecValue);
+		if(ILType_IsPrimitive(paramType))
+		{
+			switch(ILType_ToElement(paramType))
+			{
+				case IL_META_ELEMTYPE_BOOLEAN:
+				case IL_META_ELEMTYPE_I1:
+				case IL_META_ELEMTYPE_I2:
+				case IL_META_ELEMTYPE_CHAR:
+				case IL_META_ELEMTYPE_I4:
+			#ifdef IL_NATIVE_INT32
+				case IL_META_ELEMTYPE_I:
+			#endif
+				{
+					value = jit_insn_load_relative(thunk, args, offset,
+												   _IL_JIT_TYPE_INT32);
+				}
+				break;
+
+				case IL_META_ELEMTYPE_U1:
+				case IL_META_ELEMTYPE_U2:
+				case IL_META_ELEMTYPE_U4:
+			#ifdef IL_NATIVE_INT32
+				case IL_META_ELEMTYPE_U:
+			#endif
+				{
+					value = jit_insn_load_relative(thunk, args, offset,
+												   _IL_JIT_TYPE_UINT32);
+				}
+				break;
+
+				case IL_META_ELEMTYPE_I8:
+			#ifdef IL_NATIVE_INT64
+				case IL_META_ELEMTYPE_I:
+			#endif
+				{
+					value = jit_insn_load_relative(thunk, args, offset,
+												   _IL_JIT_TYPE_INT64);
+				}
+				break;
+
+				case IL_META_ELEMTYPE_U8:
+			#ifdef IL_NATIVE_INT64
+				case IL_META_ELEMTYPE_U:
+			#endif
+				{
+					value = jit_insn_load_relative(thunk, args, offset,
+												   _IL_JIT_TYPE_UINT64);
+				}
+				break;
+
+				case IL_META_ELEMTYPE_R4:
+				case IL_META_ELEMTYPE_R8:
+				case IL_META_ELEMTYPE_R:
+				{
+					value = jit_insn_load_relative(thunk, args, offset,
+												   _IL_JIT_TYPE_NFLOAT);
+				}
+				break;
+
+				case IL_META_ELEMTYPE_TYPEDBYREF:
+				{
+					value = jit_insn_load_relative(thunk, args, offset,
+												   paramJitType);
+				}
+				break;
+
+				default:
+				{
+					/* Let the generic path deal with anything else */
+					jit_function_abandon(thunk);
+					return 0;
+				}
+				/* Not reached */
+			}
+			if(jit_value_get_type(value) != paramJitType)
+			{
+				value = jit_insn_convert(thunk, value, paramJitType, 0);
+			}
+		}
+		else if(ILType_IsValueType(paramType))
+		{
+			/* The slot points to the value to be copied */
+			value = jit_insn_load_relative(thunk, args, offset,
+										   _IL_JIT_TYPE_VPTR);
+			value = jit_insn_load_relative(thunk, value, 0, paramJitType);
+		}
+		else
+		{
+			/* Object references, byrefs and everything else */
+			value = jit_insn_load_relative(thunk, args, offset,
+										   _IL_JIT_TYPE_VPTR);
+		}
+		callArgs[current++] = value;
+	}
+
+	/* Call the method and store its return value */
+	value = jit_insn_call(thunk, 0, target, 0, callArgs, numArgs, 0);
+	if(returnType != _IL_JIT_TYPE_VOID)
+	{
+		jit_insn_branch_if_not(thunk, result, &noResult);
+		jit_insn_store_relative(thunk, result, 0, value);
+		jit_insn_label(thunk, &noResult);
+	}
+	jit_insn_return(thunk, jit_value_create_nint_constant
+								(thunk, _IL_JIT_TYPE_INT32, 0));
+
+	/* The exception has already been stored in the thread */
+	jit_insn_start_catcher(thunk);
+	jit_insn_return(thunk, jit_value_create_nint_constant
+								(thunk, _IL_JIT_TYPE_INT32, 1));
+
+	if(!jit_function_compile(thunk))
+	{
+		jit_function_abandon(thunk);
+		return 0;
+	}
+	return (ILJitInvokeThunk)jit_function_to_closure(thunk);
+}
+
+/*
+ * Get the invocation stub for an ILMethod, creating it on first use.
+ * Returns 0 if the method cannot be called through a stub.
+ */
+ILJitInvokeThunk ILJitGetInvokeThunk(ILExecThread *thread, ILMethod *method)
+{
+	ILJITCoder *jitCoder = (ILJITCoder *)(thread->process->coder);
+	ILJitMethodInfo *jitMethodInfo;
+	ILJitInvokeThunk thunk;
+
+	/* Make sure that the jit function for the method exists */
+	if(!ILJitFunctionFromILMethod(method))
+	{
+		if(!_LayoutClass(thread, ILMethod_Owner(method)))
+		{
+			return 0;
+		}
+		if(!ILJitFunctionFromILMethod(method))
+		{
+			/* This can be a generic method instance. */
+			if(!ILJitFunctionCreate(thread->process->coder, method))
+			{
+				return 0;
+			}
+		}
+	}
+	jitMethodInfo = (ILJitMethodInfo *)(method->userData);
+	if(!jitMethodInfo || !(jitMethodInfo->jitFunction))
+	{
+		return 0;
+	}
+
+	/* Use the stub that was created by an earlier call */
+	thunk = (ILJitInvokeThunk)ILInterlockedLoadP_Acquire
+		((void * const volatile *)&(jitMethodInfo->invokeThunk));
+	if(thunk)
+	{
+		return thunk;
+	}
+
+	/* Vararg methods need the generic path */
+	if((ILType_CallConv(ILMethod_Signature(method)) &
+			IL_META_CALLCONV_MASK) == IL_META_CALLCONV_VARARG)
+	{
+		return 0;
+	}
+
+	/* Build the stub while we hold the builder lock, unless some
+	   other thread did it in the meantime */
+	jit_context_build_start(jitCoder->context);
+	thunk = (ILJitInvokeThunk)(jitMethodInfo->invokeThunk);
+	if(!thunk)
+	{
+		thunk = _ILJitCreateInvokeThunk(jitCoder, method,
+										jitMethodInfo->jitFunction);
+		if(thunk)
+		{
+			ILInterlockedStoreP_Release
+				((void * volatile *)&(jitMethodInfo->invokeThunk),
+				 (void *)thunk);
+		}
+	}
+	jit_context_build_end(jitCoder->context);
+	return thunk;
+}
+
 /*
  * Get the ILJitFunction for an ILMethod.
  * Returns 0 if the jit function stub isn't created yet.
@@ -4737,6 +5096,135 @@ int _ILDumpMethodProfile(FILE *stream, ILExecProcess *process)
 	return haveCounts;
 }
 
+/*
+ * Dump the branch counts collected by the jitted code.
+ */
+int _ILDumpBranchProfile(FILE *stream, ILExecProcess *process)
+{
+	ILJITCoder *coder = (ILJITCoder *)(process->coder);
+	ILJitFunction function = 0;
+	ILJitMethodInfo *jitMethodInfo;
+	ILJitBranchCounter *counter;
+	const char *assembly;
+	ILUInt32 numBranches;
+	ILUInt32 taken;
+	int haveCounts = 0;
+	ILMethod *method;
+
+	function = jit_function_next(coder->context, 0);
+	while(function)
+	{
+		method = (ILMethod *)jit_function_get_meta(function, IL_JIT_META_METHOD);
+		jitMethodInfo = method ? (ILJitMethodInfo *)(method->userData) : 0;
+		if(jitMethodInfo && jitMethodInfo->branchCounters &&
+		   (assembly = ILImageGetAssemblyName(ILProgramItem_Image(method))) != 0)
+		{
+			numBranches = 0;
+			for(counter = jitMethodInfo->branchCounters; counter;
+				counter = counter->next)
+			{
+				++numBranches;
+			}
+
+			/* One line per method with the taken and not taken counts */
+			fprintf(stream, "%s 0x%08lX %lu", assembly,
+					(unsigned long)ILMethod_Token(method),
+					(unsigned long)numBranches);
+			for(counter = jitMethodInfo->branchCounters; counter;
+				counter = counter->next)
+			{
+				if(counter->notTaken < counter->total)
+				{
+					taken = counter->total - counter->notTaken;
+				}
+				else
+				{
+					taken = 0;
+				}
+				fprintf(stream, " %lu %lu", (unsigned long)taken,
+						(unsigned long)(counter->notTaken));
+			}
+			putc('\n', stream);
+			haveCounts = 1;
+		}
+		function = jit_function_next(coder->context, function);
+	}
+	return haveCounts;
+}
+
+/*
+ * Load branch counts written by _ILDumpBranchProfile.  The counts are
+ * used as branch weights for the methods that are compiled afterwards.
+ */
+int _ILLoadBranchProfile(FILE *stream, ILExecProcess *process)
+{
+	ILJITCoder *coder = (ILJITCoder *)(process->coder);
+	ILJitBranchProfile *profile;
+	char assembly[256];
+	unsigned long token;
+	unsigned long numBranches;
+	unsigned long weight;
+	ILUInt32 index;
+	int len;
+
+	if(!(coder->branchProfiles))
+	{
+		coder->branchProfiles =
+			ILHashCreate(0, (ILHashComputeFunc)_ILJitBranchProfileCompute,
+						 (ILHashKeyComputeFunc)_ILJitBranchProfileCompute,
+						 (ILHashMatchFunc)_ILJitBranchProfileMatch,
+						 (ILHashFreeFunc)_ILJitBranchProfileFree);
+		if(!(coder->branchProfiles))
+		{
+			return 0;
+		}
+	}
+
+	while(fscanf(stream, "%255s %lx %lu", assembly, &token, &numBranches) == 3)
+	{
+		if(numBranches > 0x10000)
+		{
+			return 0;
+		}
+
+		/* Allocate the entry with the weights and the name behind it */
+		len = strlen(assembly);
+		profile = (ILJitBranchProfile *)ILMalloc
+			(sizeof(ILJitBranchProfile) + numBranches * 2 * sizeof(ILUInt32) +
+			 len + 1);
+		if(!profile)
+		{
+			return 0;
+		}
+		profile->weights = (ILUInt32 *)(profile + 1);
+		profile->assembly = (const char *)(profile->weights + numBranches * 2);
+		ILMemCpy((char *)(profile->assembly), assembly, len + 1);
+		profile->token = (ILUInt32)token;
+		profile->numBranches = (ILUInt32)numBranches;
+		for(index = 0; index < numBranches * 2; ++index)
+		{
+			if(fscanf(stream, "%lu", &weight) != 1)
+			{
+				ILFree(profile);
+				return 0;
+			}
+			profile->weights[index] = (ILUInt32)weight;
+		}
+
+		if(ILHashFind(coder->branchProfiles, profile))
+		{
+			/* Keep the first entry for the method */
+			ILFree(profile);
+		}
+		else if(!ILHashAdd(coder->branchProfiles, profile))
+		{
+			ILFree(profile);
+			return 0;
+		}
+	}
+	return feof(stream);
+}
+
 static void ILJitTraceIn(ILExecThread *thread, ILMethod *method)
 {
 	/* TODO: nesting level */
@@ -5004,6 +5492,7 @@ void ILJitBacktrace(void *frame, void *pc, int numFrames)
 #include "jitc_delegate.c"
 #include "jitc_math.c"
 #include "jitc_profile.c"
+#include "jitc_escape.c"
 #undef	IL_JITC_FUNCTIONS
 
 /*
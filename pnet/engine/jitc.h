@@ -162,6 +162,44 @@ typedef int (*ILJitInlineFunc)(ILJITCoder *jitCoder,
 									  ILJitStackItem *args,
 									  ILInt32 numArgs);
 
+/*
+ * Execution counts of a conditional branch in jitted code.
+ * The number of times the branch was taken is total - notTaken.
+ */
+typedef struct _tagILJitBranchCounter ILJitBranchCounter;
+struct _tagILJitBranchCounter
+{
+	ILUInt32 total;					/* Number of times the branch was reached. */
+	ILUInt32 notTaken;				/* Number of times the branch fell through. */
+	ILJitBranchCounter *next;		/* Counter of the next branch in the method. */
+};
+
+/*
+ * Branch weights of a method loaded from a branch profile.
+ */
+typedef struct _tagILJitBranchProfile ILJitBranchProfile;
+struct _tagILJitBranchProfile
+{
+	const char *assembly;			/* Name of the assembly of the method. */
+	ILUInt32 token;					/* Token of the method. */
+	ILUInt32 numBranches;			/* Number of conditional branches. */
+	ILUInt32 *weights;				/* Taken and not taken weight pairs. */
+};
+
+/*
+ * A "newobj" instruction of the method being compiled and what the
+ * escape analysis found out about the object that it creates.
+ */
+typedef struct _tagILJitEscapeSite ILJitEscapeSite;
+struct _tagILJitEscapeSite
+{
+	ILMethod *ctor;					/* Constructor called by the instruction. */
+	ILUInt32 offset;				/* IL offset of the instruction. */
+	ILInt32 local;					/* Local that holds the object or -1. */
+	int escapes;					/* Non-zero if the object may escape. */
+	ILJitValue frame;				/* Frame memory for the object. */
+};
+
 /*
  * Private method information for the jit coder.
  */
@@ -172,6 +210,8 @@ struct _tagILJitMethodInfo
 	ILUInt32 implementationType;	/* Flag how the method is implemented. */
 	ILInternalInfo fnInfo;			/* Information for internal calls or pinvokes. */
 	ILJitInlineFunc inlineFunc;		/* Function for inlining. */
+	ILJitBranchCounter *branchCounters;	/* Counters of the conditional branches. */
+	void *invokeThunk;				/* Stub for calls with ILExecValue args. */
 };
 
 /*
@@ -225,6 +265,21 @@ ILJitFunction ILJitFunctionFromILMethod(ILMethod *method);
 int ILJitCallMethod(ILExecThread *thread, ILMethod *method,
 					void**jitArgs, void *result);
 
+/*
+ * Compiled stub that calls a method with its arguments taken from an
+ * ILExecValue array, in the same layout as "ILExecThreadCallV".
+ * "_this" is ignored for static methods.  Returns non-zero if the
+ * method threw an exception.
+ */
+typedef int (*ILJitInvokeThunk)(ILExecThread *thread, void *_this,
+								ILExecValue *args, void *result);
+
+/*
+ * Get the invocation stub for an ILMethod, creating it on first use.
+ * Returns 0 if the method cannot be called through a stub.
+ */
+ILJitInvokeThunk ILJitGetInvokeThunk(ILExecThread *thread, ILMethod *method);
+
 /*
  * Get the ILMethod for the call frame up n slots.
  * Returns 0 if the function at that slot is not a jitted function.
@@ -429,4 +429,115 @@ static void JITCoder_Unary(ILCoder *coder, int opcode, ILEngineType type)
 	_ILJitStackPushValue(jitCoder, result);
 }
 
+/*
+ * Emit an inline call to one of the decimal arithmetic helpers.
+ * The two operands are on the top of the stack.  The helper is
+ * called directly, without the thread or the internalcall wrapper.
+ * If it fails, the internalcall is made to throw the exception.
+ */
+static void _ILJitDecimalBinary(ILJITCoder *jitCoder, int inlineType)
+{
+	_ILJitStackItemNew(stackItem1);
+	_ILJitStackItemNew(stackItem2);
+	ILJitValue result;
+	ILJitValue status;
+	ILJitValue args[4];
+	jit_label_t label = jit_label_undefined;
+	const char *name;
+	void *func;
+	const char *internalName;
+	void *internalFunc;
+
+	switch(inlineType)
+	{
+		case IL_INLINEMETHOD_DECIMAL_ADD:
+		{
+			name = "ILDecimalAdd";
+			func = (void *)ILDecimalAdd;
+			internalName = "_IL_Decimal_Add";
+			internalFunc = (void *)_IL_Decimal_Add;
+		}
+		break;
+
+		case IL_INLINEMETHOD_DECIMAL_SUB:
+		{
+			name = "ILDecimalSub";
+			func = (void *)ILDecimalSub;
+			internalName = "_IL_Decimal_Subtract";
+			internalFunc = (void *)_IL_Decimal_Subtract;
+		}
+		break;
+
+		case IL_INLINEMETHOD_DECIMAL_MUL:
+		{
+			name = "ILDecimalMul";
+			func = (void *)ILDecimalMul;
+			internalName = "_IL_Decimal_Multiply";
+			internalFunc = (void *)_IL_Decimal_Multiply;
+		}
+		break;
+
+		default:
+		{
+			name = "ILDecimalDiv";
+			func = (void *)ILDecimalDiv;
+			internalName = "_IL_Decimal_Divide";
+			internalFunc = (void *)_IL_Decimal_Divide;
+		}
+		break;
+	}
+
+	_ILJitStackPop(jitCoder, stackItem2);
+	_ILJitStackPop(jitCoder, stackItem1);
+	result = jit_value_create(jitCoder->jitFunction,
+					jit_value_get_type(_ILJitStackItemValue(stackItem1)));
+	args[0] = jit_insn_address_of(jitCoder->jitFunction, result);
+	args[1] = jit_insn_address_of(jitCoder->jitFunction,
+								  _ILJitStackItemValue(stackItem1));
+	args[2] = jit_insn_address_of(jitCoder->jitFunction,
+								  _ILJitStackItemValue(stackItem2));
+	args[3] = jit_value_create_nint_constant(jitCoder->jitFunction,
+											 _IL_JIT_TYPE_INT32,
+											 IL_DECIMAL_ROUND_HALF_EVEN);
+	status = jit_insn_call_native(jitCoder->jitFunction, name, func,
+								  _ILJitSignature_ILDecimalBinary,
+								  args, 4, JIT_CALL_NOTHROW);
+	jit_insn_branch_if(jitCoder->jitFunction, status, &label);
+
+	/* Overflow or division by zero: let the internalcall throw */
+	args[3] = args[2];
+	args[2] = args[1];
+	args[1] = args[0];
+	args[0] = _ILJitCoderGetThread(jitCoder);
+	_ILJitBeginNativeCall(jitCoder->jitFunction, args[0]);
+	jit_insn_call_native(jitCoder->jitFunction, internalName, internalFunc,
+						 _ILJitSignature_ILDecimalInternal, args, 4, 0);
+	_ILJitEndNativeCall(jitCoder->jitFunction, args[0]);
+
+	jit_insn_label(jitCoder->jitFunction, &label);
+	_ILJitStackPushValue(jitCoder, result);
+}
+
+/*
+ * Emit an inline call to the decimal comparison helper.
+ */
+static void _ILJitDecimalCompare(ILJITCoder *jitCoder)
+{
+	_ILJitStackItemNew(stackItem1);
+	_ILJitStackItemNew(stackItem2);
+	ILJitValue args[2];
+	ILJitValue result;
+
+	_ILJitStackPop(jitCoder, stackItem2);
+	_ILJitStackPop(jitCoder, stackItem1);
+	args[0] = jit_insn_address_of(jitCoder->jitFunction,
+								  _ILJitStackItemValue(stackItem1));
+	args[1] = jit_insn_address_of(jitCoder->jitFunction,
+								  _ILJitStackItemValue(stackItem2));
+	result = jit_insn_call_native(jitCoder->jitFunction, "ILDecimalCmp",
+								  ILDecimalCmp, _ILJitSignature_ILDecimalCmp,
+								  args, 2, JIT_CALL_NOTHROW);
+	_ILJitStackPushValue(jitCoder, result);
+}
+
 #endif	/* IL_JITC_CODE */
@@ -26,18 +26,19 @@
 #define _IL_JIT_SARRAY_HEADERSIZE	sizeof(System_Array)
 
 /*
- * Check if the elementtype e needs to be scanned by the GC.
+ * Check if the elementtype e needs to be scanned by the GC.  Primitive
+ * types and value types without managed fields (c is the element class)
+ * never contain object references.
  *
  * Use the following conservative check if you encounter any problems with
  * objects prematurely collected.
  *
- * 		((ILType_IsPrimitive(e) &&
+ * 		(!(ILType_IsPrimitive(e) &&
  *		   (e) != ILType_TypedRef))
  */
 #define _IL_JIT_ARRAY_TYPE_NEEDS_GC(e, c) \
-	(!(ILType_IsPrimitive((e)) && ((e) != ILType_TypedRef)) || \
-	 (ILTypeIsReference(e)) || \
-	 (ILType_IsValueType((e)) && (c)->managedInstance))
+	(!((ILType_IsPrimitive((e)) && ((e) != ILType_TypedRef)) || \
+	   (ILType_IsValueType((e)) && !((c)->managedInstance))))
 
 /*
  * Validate the array index.
@@ -201,6 +201,9 @@ static void JITCoder_Branch(ILCoder *coder, int opcode, ILUInt32 dest,
 {
 	ILJITCoder *jitCoder = _ILCoderToILJITCoder(coder);
 	ILJITLabel *label = 0;
+#if !defined(IL_CONFIG_REDUCE_CODE) && !defined(IL_WITHOUT_TOOLS)
+	ILJitBranchCounter *counter = 0;
+#endif
 	_ILJitStackItemNew(value2);
 	_ILJitStackItemNew(value1);
 
@@ -213,6 +216,13 @@ static void JITCoder_Branch(ILCoder *coder, int opcode, ILUInt32 dest,
 			dest);
 		ILMutexUnlock(globalTraceMutex);
 	}
+
+	if(opcode != IL_OP_BR && opcode != IL_OP_BR_S &&
+	   opcode != IL_OP_LEAVE && opcode != IL_OP_LEAVE_S)
+	{
+		/* Count the conditional branch if branch profiling is enabled */
+		counter = _ILJitBranchProfileStart(jitCoder);
+	}
 #endif
 	/* Determine what form of branch to use */
 	switch(opcode)
@@ -432,6 +442,14 @@ static void JITCoder_Branch(ILCoder *coder, int opcode, ILUInt32 dest,
 		break;
 	}
 
+#if !defined(IL_CONFIG_REDUCE_CODE) && !defined(IL_WITHOUT_TOOLS)
+	if(opcode != IL_OP_BR && opcode != IL_OP_BR_S &&
+	   opcode != IL_OP_LEAVE && opcode != IL_OP_LEAVE_S)
+	{
+		/* Count the fall through and apply the profiled weights */
+		_ILJitBranchProfileEnd(jitCoder, counter);
+	}
+#endif
 }
 
 /*
@@ -175,10 +175,19 @@ static ILJitValue _ILJitGetVirtualFunction(ILJITCoder *jitCoder,
 
 /*
  * Create a new object and push it on the stack.
+ * The object is created in the stack frame if "site" is not 0.
  */
-static void _ILJitNewObj(ILJITCoder *coder, ILClass *info, ILJitValue *newArg)
+static void _ILJitNewObj(ILJITCoder *coder, ILClass *info,
+						 ILJitEscapeSite *site, ILJitValue *newArg)
 {
-	*newArg = _ILJitAllocObjectGen(coder->jitFunction, info);
+	if(site)
+	{
+		*newArg = _ILJitEscapeAllocObject(coder, site, info);
+	}
+	else
+	{
+		*newArg = _ILJitAllocObjectGen(coder->jitFunction, info);
+	}
 }
 
 /*
@@ -772,6 +781,7 @@ static void JITCoder_CallCtor(ILCoder *coder, ILCoderMethodInfo *info,
 	ILInternalInfo fnInfo;
 	int internalType = _IL_JIT_IMPL_DEFAULT;
 	char *methodName = 0;
+	ILJitEscapeSite *escapeSite;
 	
 #if !defined(IL_CONFIG_REDUCE_CODE) && !defined(IL_WITHOUT_TOOLS)
 	if (jitCoder->flags & IL_CODER_FLAG_STATS)
@@ -816,6 +826,9 @@ static void JITCoder_CallCtor(ILCoder *coder, ILCoderMethodInfo *info,
 	type = ILType_FromClass(classInfo);
 	synType = ILClassGetSynType(classInfo);
 
+	/* Check if the object can be created in the stack frame. */
+	escapeSite = _ILJitEscapeNextSite(jitCoder, methodInfo);
+
 	/* Check if the function is implemented in the engine. */
 	if((internalType = _ILJitFunctionIsInternal(jitCoder, methodInfo, &fnInfo, 1)))
 	{
@@ -853,7 +866,8 @@ static void JITCoder_CallCtor(ILCoder *coder, ILCoderMethodInfo *info,
 		else
 		{
 			/* create a newobj and add it to the jitParams[0]. */
-			_ILJitNewObj(jitCoder, ILMethod_Owner(methodInfo), &jitParams[0]); 
+			_ILJitNewObj(jitCoder, ILMethod_Owner(methodInfo), 0,
+						 &jitParams[0]);
 			destroyCallSignature = _ILJitFillArguments(jitCoder,
 													   methodInfo,
 													   info,
@@ -907,7 +921,8 @@ static void JITCoder_CallCtor(ILCoder *coder, ILCoderMethodInfo *info,
 	{
 	#ifdef IL_JIT_THREAD_IN_SIGNATURE
 		/* create a newobj and add it to the jitParams[1]. */
-		_ILJitNewObj(jitCoder, ILMethod_Owner(methodInfo), &jitParams[1]);
+		_ILJitNewObj(jitCoder, ILMethod_Owner(methodInfo), escapeSite,
+					 &jitParams[1]);
 		destroyCallSignature = _ILJitFillArguments(jitCoder,
 												   methodInfo,
 												   info,
@@ -923,7 +938,8 @@ static void JITCoder_CallCtor(ILCoder *coder, ILCoderMethodInfo *info,
 		_ILJitStackPushNotNullValue(jitCoder, jitParams[1]);
 	#else
 		/* create a newobj and add it to the jitParams[0]. */
-		_ILJitNewObj(jitCoder, ILMethod_Owner(methodInfo), &jitParams[0]);
+		_ILJitNewObj(jitCoder, ILMethod_Owner(methodInfo), escapeSite,
+					 &jitParams[0]);
 		destroyCallSignature = _ILJitFillArguments(jitCoder,
 												   methodInfo,
 												   info,
@@ -1769,6 +1785,26 @@ static int JITCoder_CallInlineable(ILCoder *coder, int inlineType,
 			return 1;
 		}
 		/* Not reached */
+
+		/*
+		 * Cases for Decimal class inlines.
+		 */
+		case IL_INLINEMETHOD_DECIMAL_ADD:
+		case IL_INLINEMETHOD_DECIMAL_SUB:
+		case IL_INLINEMETHOD_DECIMAL_MUL:
+		case IL_INLINEMETHOD_DECIMAL_DIV:
+		{
+			_ILJitDecimalBinary(jitCoder, inlineType);
+			return 1;
+		}
+		/* Not reached */
+
+		case IL_INLINEMETHOD_DECIMAL_CMP:
+		{
+			_ILJitDecimalCompare(jitCoder);
+			return 1;
+		}
+		/* Not reached */
 	}
 	/* If we get here, then we don't know how to inline the method */
 	return 0;
@@ -0,0 +1,1227 @@
+/*
+ * jitc_escape.c - Escape analysis and stack allocation for the JIT coder.
+ *
+ * Copyright (C) 2026  Free Software Foundation, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Objects that are created with "newobj" and never leave the method
+ * that creates them are allocated in the method's stack frame instead
+ * of the GC heap.  An object qualifies if:
+ *
+ *   - its class is a plain reference type without a finalizer and is
+ *     small enough,
+ *   - the "newobj" is directly followed by a store to a local and no
+ *     other "newobj" stores to that local,
+ *   - the local is only used to load and store fields of the object,
+ *     to compare it and as "this" of calls that don't leak "this"
+ *     and are not tail calls,
+ *   - the constructor does not leak "this".
+ *
+ * Whether a callee leaks "this" is found out by running the same
+ * analysis over its code with "this" as the only tracked value, up to
+ * a small nesting depth.  Anything that the analysis doesn't understand
+ * makes the object escape.
+ *
+ * The frame slot of a site is reused each time the "newobj" is
+ * executed.  This is safe because the only reference that survives
+ * the current instruction is the local, which is overwritten right
+ * after the object was created again.
+ */
+
+#ifdef IL_JITC_CODER_INSTANCE
+
+	/* The "newobj" sites of the method being compiled in IL order */
+	ILJitEscapeSite	   *escapeSites;
+	ILUInt32			numEscapeSites;
+	ILUInt32			maxEscapeSites;
+	ILUInt32			nextEscapeSite;
+
+	/* Frame types for stack allocated objects indexed by size in words */
+	ILJitType			escapeTypes[IL_JIT_STACK_OBJECT_MAX / sizeof(void *)];
+
+#endif	/* IL_JITC_CODER_INSTANCE */
+
+#ifdef IL_JITC_CODER_INIT
+
+	/* Initialize the escape analysis */
+	coder->escapeSites = 0;
+	coder->numEscapeSites = 0;
+	coder->maxEscapeSites = 0;
+	coder->nextEscapeSite = 0;
+	ILMemZero(coder->escapeTypes, sizeof(coder->escapeTypes));
+
+#endif	/* IL_JITC_CODER_INIT */
+
+#ifdef IL_JITC_CODER_DESTROY
+
+	/* Free the escape analysis results */
+	if(coder->escapeSites)
+	{
+		ILFree(coder->escapeSites);
+		coder->escapeSites = 0;
+	}
+	{
+		ILUInt32 escapeType;
+
+		for(escapeType = 0;
+			escapeType < IL_JIT_STACK_OBJECT_MAX / sizeof(void *);
+			++escapeType)
+		{
+			if(coder->escapeTypes[escapeType])
+			{
+				jit_type_free(coder->escapeTypes[escapeType]);
+				coder->escapeTypes[escapeType] = 0;
+			}
+		}
+	}
+
+#endif	/* IL_JITC_CODER_DESTROY */
+
+#ifdef IL_JITC_DECLARATIONS
+
+/*
+ * Maximum size of an object, including its header, that is allocated
+ * in the stack frame.
+ */
+#define IL_JIT_STACK_OBJECT_MAX		256
+
+/*
+ * Maximum nesting depth and code size of the methods that are examined
+ * to find out if they leak their "this" argument.
+ */
+#define IL_JIT_ESCAPE_MAX_DEPTH		3
+#define IL_JIT_ESCAPE_MAX_CODE		512
+
+/*
+ * Run the escape analysis over the code of the method that is about
+ * to be compiled.
+ */
+static void _ILJitEscapeAnalyze(ILJITCoder *jitCoder, ILMethod *method,
+								ILMethodCode *code,
+								ILCoderExceptions *coderExceptions);
+
+/*
+ * Forget the escape analysis results of the current method.
+ */
+static void _ILJitEscapeReset(ILJITCoder *jitCoder);
+
+/*
+ * Get the site of the next "newobj" in the current method.
+ * Returns 0 if the object has to be allocated on the heap.
+ */
+static ILJitEscapeSite *_ILJitEscapeNextSite(ILJITCoder *jitCoder,
+											 ILMethod *ctor);
+
+/*
+ * Generate the code to create an object in the stack frame.
+ * Returns the ILJitValue with the pointer to the new object.
+ */
+static ILJitValue _ILJitEscapeAllocObject(ILJITCoder *jitCoder,
+										  ILJitEscapeSite *site,
+										  ILClass *classInfo);
+
+#endif	/* IL_JITC_DECLARATIONS */
+
+#ifdef IL_JITC_FUNCTIONS
+
+/*
+ * State of the abstract interpretation.  Every stack slot and local
+ * holds the index of the site whose object it may refer to, or -1.
+ * When a callee is examined, "thisClass" is the exact class of the
+ * object and its "this" argument is tracked as 0.
+ */
+typedef struct
+{
+	ILJITCoder	   *coder;
+	ILMethod	   *method;
+	ILClass		   *thisClass;
+	int				thisEscapes;
+	int				depth;
+	ILInt32		   *locals;
+	ILUInt32		numLocals;
+	ILInt32		   *stack;
+	ILUInt32		stackSize;
+	ILUInt32		maxStack;
+	ILUInt32		nextSite;
+
+} ILJitEscapeState;
+
+static int _ILJitEscapeThisSafe(ILJITCoder *jitCoder, ILMethod *method,
+								ILClass *classInfo, int isVirtual, int depth);
+
+/*
+ * Mark a tracked value as escaping.
+ */
+static void _ILJitEscapeValue(ILJitEscapeState *state, ILInt32 value)
+{
+	if(value < 0)
+	{
+		return;
+	}
+	if(state->thisClass)
+	{
+		state->thisEscapes = 1;
+	}
+	else
+	{
+		state->coder->escapeSites[value].escapes = 1;
+	}
+}
+
+/*
+ * Pop a value from the abstract stack.  Popping past the bottom yields an
+ * untracked value, because the stack is assumed to be empty at the start
+ * of blocks that aren't reached by falling through.
+ */
+static ILInt32 _ILJitEscapePop(ILJitEscapeState *state)
+{
+	if(state->stackSize > 0)
+	{
+		--(state->stackSize);
+		return state->stack[state->stackSize];
+	}
+	return -1;
+}
+
+/*
+ * Push a value onto the abstract stack.  Returns zero on overflow.
+ */
+static int _ILJitEscapePush(ILJitEscapeState *state, ILInt32 value)
+{
+	if(state->stackSize >= state->maxStack)
+	{
+		return 0;
+	}
+	state->stack[(state->stackSize)++] = value;
+	return 1;
+}
+
+/*
+ * Let the values on the stack escape at the end of a block, where they
+ * would merge with the values from other paths.
+ */
+static void _ILJitEscapeFlush(ILJitEscapeState *state)
+{
+	ILUInt32 posn;
+
+	for(posn = 0; posn < state->stackSize; ++posn)
+	{
+		_ILJitEscapeValue(state, state->stack[posn]);
+		state->stack[posn] = -1;
+	}
+}
+
+/*
+ * Get the value of a local variable.
+ */
+static ILInt32 _ILJitEscapeLocal(ILJitEscapeState *state, ILUInt32 index)
+{
+	if(index < state->numLocals && state->locals[index] >= 0)
+	{
+		return state->locals[index];
+	}
+	return -1;
+}
+
+/*
+ * Get the value of an argument.
+ */
+static ILInt32 _ILJitEscapeArg(ILJitEscapeState *state, ILUInt32 index)
+{
+	if(state->thisClass && index == 0)
+	{
+		return 0;
+	}
+	return -1;
+}
+
+/*
+ * Get the size of the instruction at "pc".  Returns zero if the
+ * instruction can't be handled by the escape analysis.
+ */
+static ILUInt32 _ILJitEscapeInsnSize(unsigned char *pc, ILUInt32 len,
+									 const ILOpcodeSmallInfo **info)
+{
+	const ILOpcodeSmallInfo *insn;
+	ILUInt32 size;
+	ILUInt32 numCases;
+
+	if(pc[0] != IL_OP_PREFIX)
+	{
+		insn = &(ILMainOpcodeSmallTable[pc[0]]);
+	}
+	else
+	{
+		if(len < 2)
+		{
+			return 0;
+		}
+		insn = &(ILPrefixOpcodeSmallTable[pc[1]]);
+	}
+	switch(insn->args)
+	{
+		case IL_OPCODE_ARGS_INVALID:
+		case IL_OPCODE_ARGS_ANN_DATA:
+		case IL_OPCODE_ARGS_ANN_PHI:
+		{
+			return 0;
+		}
+		/* Not reached */
+
+		case IL_OPCODE_ARGS_SWITCH:
+		{
+			if(len < 5)
+			{
+				return 0;
+			}
+			numCases = IL_READ_UINT32(pc + 1);
+			if(numCases >= 0x20000000)
+			{
+				return 0;
+			}
+			size = 5 + numCases * 4;
+		}
+		break;
+
+		default:
+		{
+			size = (ILUInt32)(insn->size);
+		}
+		break;
+	}
+	if(size == 0 || size > len)
+	{
+		return 0;
+	}
+	*info = insn;
+	return size;
+}
+
+/*
+ * Mark the jump targets of the instruction at "pc".
+ * Returns zero if a target is out of range.
+ */
+static int _ILJitEscapeMarkTargets(unsigned char *code, ILUInt32 codeLen,
+								   unsigned char *pc, ILUInt32 size,
+								   const ILOpcodeSmallInfo *insn,
+								   unsigned char *jumpMask)
+{
+	ILUInt32 next = (ILUInt32)(pc - code) + size;
+	ILUInt32 dest;
+	ILUInt32 numCases;
+
+	switch(insn->args)
+	{
+		case IL_OPCODE_ARGS_SHORT_JUMP:
+		{
+			dest = next + (ILUInt32)(ILInt32)(ILInt8)(pc[1]);
+			if(dest >= codeLen)
+			{
+				return 0;
+			}
+			jumpMask[dest / 8] |= (unsigned char)(1 << (dest % 8));
+		}
+		break;
+
+		case IL_OPCODE_ARGS_LONG_JUMP:
+		{
+			dest = next + (ILUInt32)(IL_READ_INT32(pc + 1));
+			if(dest >= codeLen)
+			{
+				return 0;
+			}
+			jumpMask[dest / 8] |= (unsigned char)(1 << (dest % 8));
+		}
+		break;
+
+		case IL_OPCODE_ARGS_SWITCH:
+		{
+			numCases = IL_READ_UINT32(pc + 1);
+			while(numCases > 0)
+			{
+				--numCases;
+				dest = next + (ILUInt32)(IL_READ_INT32(pc + 5 + numCases * 4));
+				if(dest >= codeLen)
+				{
+					return 0;
+				}
+				jumpMask[dest / 8] |= (unsigned char)(1 << (dest % 8));
+			}
+		}
+		break;
+	}
+	return 1;
+}
+
+/*
+ * Get the method referenced by the token of a call instruction.
+ */
+static ILMethod *_ILJitEscapeGetMethod(ILMethod *method, unsigned char *pc)
+{
+	ILUInt32 token = IL_READ_UINT32(pc + 1);
+	ILMethodSpec *mspec;
+	ILMethod *methodInfo;
+
+	if((token & IL_META_TOKEN_MASK) == IL_META_TOKEN_METHOD_SPEC)
+	{
+		mspec = ILMethodSpec_FromToken(ILProgramItem_Image(method), token);
+		if(!mspec)
+		{
+			return 0;
+		}
+		return ILMethodSpecToMethod(mspec, method);
+	}
+	methodInfo = ILProgramItemToMethod((ILProgramItem *)
+						ILImageTokenInfo(ILProgramItem_Image(method), token));
+	if(!methodInfo)
+	{
+		return 0;
+	}
+	return (ILMethod *)ILMemberResolveToInstance((ILMember *)methodInfo,
+												 method);
+}
+
+/*
+ * Get the signature of a method if the escape analysis can handle it.
+ */
+static ILType *_ILJitEscapeGetSignature(ILMethod *method)
+{
+	ILType *signature = ILMethod_Signature(method);
+	ILUInt32 callConv = ILType_CallConv(signature);
+
+	if((callConv & IL_META_CALLCONV_MASK) == IL_META_CALLCONV_VARARG ||
+	   (callConv & IL_META_CALLCONV_EXPLICITTHIS) != 0)
+	{
+		return 0;
+	}
+	return signature;
+}
+
+/*
+ * Run the abstract interpretation over the code of a method.
+ * Returns zero if the code contains something that can't be handled,
+ * in which case all tracked values have to be treated as escaping.
+ */
+static int _ILJitEscapeScan(ILJitEscapeState *state, ILMethodCode *code)
+{
+	unsigned char *start = (unsigned char *)(code->code);
+	unsigned char *pc;
+	unsigned char *jumpMask;
+	const ILOpcodeSmallInfo *insn;
+	ILUInt32 len;
+	ILUInt32 size;
+	ILUInt32 offset;
+	ILUInt32 opcode;
+	ILUInt32 index;
+	ILUInt32 posn;
+	ILInt32 value;
+	ILMethod *methodInfo;
+	ILType *signature;
+	ILClass *classInfo;
+	ILJitEscapeSite *site;
+	int tailCall = 0;
+	int result = 0;
+
+	state->maxStack = code->maxStack + 2;
+	state->stackSize = 0;
+	state->nextSite = 0;
+	state->stack = (ILInt32 *)ILMalloc(sizeof(ILInt32) * state->maxStack);
+	jumpMask = (unsigned char *)ILCalloc((code->codeLen + 7) / 8, 1);
+	if(!(state->stack) || !jumpMask)
+	{
+		goto done;
+	}
+
+	/* Find the jump targets */
+	pc = start;
+	len = code->codeLen;
+	while(len > 0)
+	{
+		if(!(size = _ILJitEscapeInsnSize(pc, len, &insn)) ||
+		   !_ILJitEscapeMarkTargets(start, code->codeLen, pc, size,
+									insn, jumpMask))
+		{
+			goto done;
+		}
+		pc += size;
+		len -= size;
+	}
+
+#define	ESCAPE_PUSH(value)	\
+	do { \
+		if(!_ILJitEscapePush(state, (value))) \
+		{ \
+			goto done; \
+		} \
+	} while(0)
+
+	/* Follow the tracked values through the code */
+	pc = start;
+	len = code->codeLen;
+	while(len > 0)
+	{
+		offset = (ILUInt32)(pc - start);
+		size = _ILJitEscapeInsnSize(pc, len, &insn);
+		if((jumpMask[offset / 8] & (1 << (offset % 8))) != 0)
+		{
+			_ILJitEscapeFlush(state);
+		}
+		opcode = pc[0];
+		if(opcode == IL_OP_PREFIX)
+		{
+			opcode = IL_OP_PREFIX + pc[1];
+		}
+		switch(opcode)
+		{
+			case IL_OP_LDLOC_0:
+			case IL_OP_LDLOC_1:
+			case IL_OP_LDLOC_2:
+			case IL_OP_LDLOC_3:
+			{
+				ESCAPE_PUSH(_ILJitEscapeLocal(state, opcode - IL_OP_LDLOC_0));
+			}
+			break;
+
+			case IL_OP_LDLOC_S:
+			{
+				ESCAPE_PUSH(_ILJitEscapeLocal(state, pc[1]));
+			}
+			break;
+
+			case IL_OP_PREFIX + IL_PREFIX_OP_LDLOC:
+			{
+				ESCAPE_PUSH(_ILJitEscapeLocal(state, IL_READ_UINT16(pc + 2)));
+			}
+			break;
+
+			case IL_OP_STLOC_0:
+			case IL_OP_STLOC_1:
+			case IL_OP_STLOC_2:
+			case IL_OP_STLOC_3:
+			case IL_OP_STLOC_S:
+			case IL_OP_PREFIX + IL_PREFIX_OP_STLOC:
+			{
+				if(opcode == IL_OP_STLOC_S)
+				{
+					index = pc[1];
+				}
+				else if(opcode == IL_OP_PREFIX + IL_PREFIX_OP_STLOC)
+				{
+					index = IL_READ_UINT16(pc + 2);
+				}
+				else
+				{
+					index = opcode - IL_OP_STLOC_0;
+				}
+				value = _ILJitEscapePop(state);
+				if(value != _ILJitEscapeLocal(state, index))
+				{
+					/* Copying an object to another local */
+					_ILJitEscapeValue(state, value);
+				}
+			}
+			break;
+
+			case IL_OP_LDLOCA_S:
+			case IL_OP_PREFIX + IL_PREFIX_OP_LDLOCA:
+			{
+				if(opcode == IL_OP_LDLOCA_S)
+				{
+					index = pc[1];
+				}
+				else
+				{
+					index = IL_READ_UINT16(pc + 2);
+				}
+				_ILJitEscapeValue(state, _ILJitEscapeLocal(state, index));
+				ESCAPE_PUSH(-1);
+			}
+			break;
+
+			case IL_OP_LDARG_0:
+			case IL_OP_LDARG_1:
+			case IL_OP_LDARG_2:
+			case IL_OP_LDARG_3:
+			{
+				ESCAPE_PUSH(_ILJitEscapeArg(state, opcode - IL_OP_LDARG_0));
+			}
+			break;
+
+			case IL_OP_LDARG_S:
+			{
+				ESCAPE_PUSH(_ILJitEscapeArg(state, pc[1]));
+			}
+			break;
+
+			case IL_OP_PREFIX + IL_PREFIX_OP_LDARG:
+			{
+				ESCAPE_PUSH(_ILJitEscapeArg(state, IL_READ_UINT16(pc + 2)));
+			}
+			break;
+
+			case IL_OP_LDARGA_S:
+			case IL_OP_PREFIX + IL_PREFIX_OP_LDARGA:
+			{
+				if(opcode == IL_OP_LDARGA_S)
+				{
+					index = pc[1];
+				}
+				else
+				{
+					index = IL_READ_UINT16(pc + 2);
+				}
+				_ILJitEscapeValue(state, _ILJitEscapeArg(state, index));
+				ESCAPE_PUSH(-1);
+			}
+			break;
+
+			case IL_OP_DUP:
+			{
+				value = _ILJitEscapePop(state);
+				ESCAPE_PUSH(value);
+				ESCAPE_PUSH(value);
+			}
+			break;
+
+			case IL_OP_POP:
+			{
+				_ILJitEscapePop(state);
+			}
+			break;
+
+			case IL_OP_LDFLD:
+			{
+				_ILJitEscapePop(state);
+				ESCAPE_PUSH(-1);
+			}
+			break;
+
+			case IL_OP_STFLD:
+			{
+				_ILJitEscapeValue(state, _ILJitEscapePop(state));
+				_ILJitEscapePop(state);
+			}
+			break;
+
+			case IL_OP_PREFIX + IL_PREFIX_OP_CEQ:
+			case IL_OP_PREFIX + IL_PREFIX_OP_CGT_UN:
+			{
+				_ILJitEscapePop(state);
+				_ILJitEscapePop(state);
+				ESCAPE_PUSH(-1);
+			}
+			break;
+
+			case IL_OP_BRFALSE_S:
+			case IL_OP_BRTRUE_S:
+			case IL_OP_BRFALSE:
+			case IL_OP_BRTRUE:
+			case IL_OP_SWITCH:
+			{
+				_ILJitEscapePop(state);
+				_ILJitEscapeFlush(state);
+			}
+			break;
+
+			case IL_OP_BEQ_S:
+			case IL_OP_BNE_UN_S:
+			case IL_OP_BEQ:
+			case IL_OP_BNE_UN:
+			{
+				_ILJitEscapePop(state);
+				_ILJitEscapePop(state);
+				_ILJitEscapeFlush(state);
+			}
+			break;
+
+			case IL_OP_BR_S:
+			case IL_OP_BR:
+			case IL_OP_LEAVE_S:
+			case IL_OP_LEAVE:
+			case IL_OP_ENDFINALLY:
+			case IL_OP_PREFIX + IL_PREFIX_OP_RETHROW:
+			{
+				_ILJitEscapeFlush(state);
+				state->stackSize = 0;
+			}
+			break;
+
+			case IL_OP_THROW:
+			case IL_OP_PREFIX + IL_PREFIX_OP_ENDFILTER:
+			{
+				_ILJitEscapeValue(state, _ILJitEscapePop(state));
+				_ILJitEscapeFlush(state);
+				state->stackSize = 0;
+			}
+			break;
+
+			case IL_OP_RET:
+			{
+				signature = ILMethod_Signature(state->method);
+				if(ILTypeGetReturn(signature) != ILType_Void)
+				{
+					_ILJitEscapeValue(state, _ILJitEscapePop(state));
+				}
+				_ILJitEscapeFlush(state);
+				state->stackSize = 0;
+			}
+			break;
+
+			case IL_OP_PREFIX + IL_PREFIX_OP_TAIL:
+			{
+				/* The next call replaces the frame of this method */
+				tailCall = 1;
+			}
+			break;
+
+			case IL_OP_CALL:
+			case IL_OP_CALLVIRT:
+			{
+				if(!(methodInfo = _ILJitEscapeGetMethod(state->method, pc)) ||
+				   !(signature = _ILJitEscapeGetSignature(methodInfo)))
+				{
+					goto done;
+				}
+				for(posn = ILTypeNumParams(signature); posn > 0; --posn)
+				{
+					_ILJitEscapeValue(state, _ILJitEscapePop(state));
+				}
+				if(ILType_HasThis(signature))
+				{
+					value = _ILJitEscapePop(state);
+					if(value >= 0 && tailCall)
+					{
+						/* The frame that holds the object is gone
+						   by the time that the callee runs */
+						_ILJitEscapeValue(state, value);
+					}
+					else if(value >= 0)
+					{
+						if(state->thisClass)
+						{
+							classInfo = state->thisClass;
+						}
+						else
+						{
+							site = &(state->coder->escapeSites[value]);
+							classInfo = ILMethod_Owner(site->ctor);
+						}
+						if(!_ILJitEscapeThisSafe(state->coder, methodInfo,
+												 classInfo,
+												 opcode == IL_OP_CALLVIRT,
+												 state->depth + 1))
+						{
+							_ILJitEscapeValue(state, value);
+						}
+					}
+				}
+				if(ILTypeGetReturn(signature) != ILType_Void)
+				{
+					ESCAPE_PUSH(-1);
+				}
+				tailCall = 0;
+			}
+			break;
+
+			case IL_OP_NEWOBJ:
+			{
+				if(!(methodInfo = _ILJitEscapeGetMethod(state->method, pc)) ||
+				   !(signature = _ILJitEscapeGetSignature(methodInfo)))
+				{
+					goto done;
+				}
+				for(posn = ILTypeNumParams(signature); posn > 0; --posn)
+				{
+					_ILJitEscapeValue(state, _ILJitEscapePop(state));
+				}
+				value = -1;
+				if(!(state->thisClass) &&
+				   state->nextSite < state->coder->numEscapeSites &&
+				   state->coder->escapeSites[state->nextSite].offset == offset)
+				{
+					/* The previous object of this site must be dead */
+					value = (ILInt32)((state->nextSite)++);
+					for(posn = 0; posn < state->stackSize; ++posn)
+					{
+						if(state->stack[posn] == value)
+						{
+							_ILJitEscapeValue(state, value);
+						}
+					}
+				}
+				ESCAPE_PUSH(value);
+			}
+			break;
+
+			case IL_OP_JMP:
+			case IL_OP_CALLI:
+			case IL_OP_PREFIX + IL_PREFIX_OP_JMPI:
+			{
+				/* Too hard to follow */
+				goto done;
+			}
+			/* Not reached */
+
+			default:
+			{
+				/* Anything else lets its operands escape */
+				for(posn = (ILUInt32)(insn->popped); posn > 0; --posn)
+				{
+					_ILJitEscapeValue(state, _ILJitEscapePop(state));
+				}
+				for(posn = (ILUInt32)(insn->pushed); posn > 0; --posn)
+				{
+					ESCAPE_PUSH(-1);
+				}
+				if(insn->args == IL_OPCODE_ARGS_SHORT_JUMP ||
+				   insn->args == IL_OPCODE_ARGS_LONG_JUMP)
+				{
+					_ILJitEscapeFlush(state);
+				}
+			}
+			break;
+		}
+		pc += size;
+		len -= size;
+	}
+	result = 1;
+
+#undef	ESCAPE_PUSH
+
+done:
+	if(state->stack)
+	{
+		ILFree(state->stack);
+		state->stack = 0;
+	}
+	if(jumpMask)
+	{
+		ILFree(jumpMask);
+	}
+	return result;
+}
+
+/*
+ * Determine if an instance method never lets its "this" argument
+ * escape when it is called on an object of the exact class "classInfo".
+ */
+static int _ILJitEscapeThisSafe(ILJITCoder *jitCoder, ILMethod *method,
+								ILClass *classInfo, int isVirtual, int depth)
+{
+	ILJitEscapeState state;
+	ILJitMethodInfo *jitMethodInfo;
+	ILMethodCode code;
+
+	if(depth > IL_JIT_ESCAPE_MAX_DEPTH)
+	{
+		return 0;
+	}
+	if(ILMethod_IsStatic(method) || ILMethod_IsAbstract(method) ||
+	   ILMethod_IsSynchronized(method) || !ILMethod_IsIL(method) ||
+	   ILMethod_IsInternalCall(method) || ILMethod_HasPInvokeImpl(method) ||
+	   ILMember_IsGenericInstance(method))
+	{
+		return 0;
+	}
+
+	/* A virtual call on the exact class can only reach its own methods */
+	if(isVirtual && ILMethod_IsVirtual(method) && !ILMethod_IsFinal(method) &&
+	   ILMethod_Owner(method) != classInfo)
+	{
+		return 0;
+	}
+
+	/* The engine may replace the code with its own implementation */
+	if(!(method->userData))
+	{
+		if(!_LayoutClass(ILExecThreadCurrent(), ILMethod_Owner(method)))
+		{
+			return 0;
+		}
+	}
+	jitMethodInfo = (ILJitMethodInfo *)(method->userData);
+	if(jitMethodInfo &&
+	   (jitMethodInfo->implementationType & _IL_JIT_IMPL_INTERNALMASK) != 0)
+	{
+		return 0;
+	}
+
+	if(!ILMethodGetCode(method, &code) || !(code.code) ||
+	   code.codeLen > IL_JIT_ESCAPE_MAX_CODE)
+	{
+		return 0;
+	}
+
+	state.coder = jitCoder;
+	state.method = method;
+	state.thisClass = classInfo;
+	state.thisEscapes = 0;
+	state.depth = depth;
+	state.locals = 0;
+	state.numLocals = 0;
+	state.stack = 0;
+	return _ILJitEscapeScan(&state, &code) && !(state.thisEscapes);
+}
+
+/*
+ * Determine if the class of a "newobj" can be allocated in the frame.
+ */
+static int _ILJitEscapeClassOk(ILClass *classInfo)
+{
+	ILType *type = ILType_FromClass(classInfo);
+
+	if(ILClass_IsAbstract(classInfo) || ILTypeIsDelegate(type) ||
+	   ILTypeIsStringClass(type) || ILClassGetSynType(classInfo) ||
+	   ILClassIsValueType(classInfo))
+	{
+		return 0;
+	}
+	return 1;
+}
+
+static void _ILJitEscapeReset(ILJITCoder *jitCoder)
+{
+	jitCoder->numEscapeSites = 0;
+	jitCoder->nextEscapeSite = 0;
+}
+
+static void _ILJitEscapeAnalyze(ILJITCoder *jitCoder, ILMethod *method,
+								ILMethodCode *code,
+								ILCoderExceptions *coderExceptions)
+{
+	ILJitEscapeState state;
+	ILJitEscapeSite *site;
+	const ILOpcodeSmallInfo *insn;
+	unsigned char *start = (unsigned char *)(code->code);
+	unsigned char *pc;
+	ILUInt32 len;
+	ILUInt32 size;
+	ILUInt32 nextSize;
+	ILUInt32 index;
+	ILUInt32 posn;
+	ILUInt32 numCandidates;
+	ILMethod *ctor;
+	ILType *localVars;
+	ILCoderExceptionBlock *block;
+
+	_ILJitEscapeReset(jitCoder);
+	if(!start || jitCoder->optimizationLevel == 0)
+	{
+		return;
+	}
+
+	/* Collect the "newobj" instructions that allocate reference types,
+	   which are the ones that the verifier passes to "CallCtor" */
+	numCandidates = 0;
+	pc = start;
+	len = code->codeLen;
+	while(len > 0)
+	{
+		if(!(size = _ILJitEscapeInsnSize(pc, len, &insn)))
+		{
+			_ILJitEscapeReset(jitCoder);
+			return;
+		}
+		if(pc[0] == IL_OP_NEWOBJ)
+		{
+			if(!(ctor = _ILJitEscapeGetMethod(method, pc)))
+			{
+				_ILJitEscapeReset(jitCoder);
+				return;
+			}
+			if(!ILClassIsValueType(ILMethod_Owner(ctor)))
+			{
+				if(jitCoder->numEscapeSites >= jitCoder->maxEscapeSites)
+				{
+					ILUInt32 newMax = jitCoder->maxEscapeSites + 16;
+
+					site = (ILJitEscapeSite *)ILRealloc
+						(jitCoder->escapeSites,
+						 sizeof(ILJitEscapeSite) * newMax);
+					if(!site)
+					{
+						_ILJitEscapeReset(jitCoder);
+						return;
+					}
+					jitCoder->escapeSites = site;
+					jitCoder->maxEscapeSites = newMax;
+				}
+				site = &(jitCoder->escapeSites[(jitCoder->numEscapeSites)++]);
+				site->ctor = ctor;
+				site->offset = (ILUInt32)(pc - start);
+				site->local = -1;
+				site->escapes = 1;
+				site->frame = 0;
+
+				/* The object has to be stored to a local right away */
+				if(len > size && _ILJitEscapeClassOk(ILMethod_Owner(ctor)) &&
+				   (nextSize = _ILJitEscapeInsnSize(pc + size, len - size,
+													&insn)) != 0)
+				{
+					switch(pc[size])
+					{
+						case IL_OP_STLOC_0:
+						case IL_OP_STLOC_1:
+						case IL_OP_STLOC_2:
+						case IL_OP_STLOC_3:
+						{
+							site->local = pc[size] - IL_OP_STLOC_0;
+						}
+						break;
+
+						case IL_OP_STLOC_S:
+						{
+							site->local = pc[size + 1];
+						}
+						break;
+
+						case IL_OP_PREFIX:
+						{
+							if(pc[size + 1] == IL_PREFIX_OP_STLOC)
+							{
+								site->local = IL_READ_UINT16(pc + size + 2);
+							}
+						}
+						break;
+					}
+					if(site->local >= 0)
+					{
+						site->escapes = 0;
+						++numCandidates;
+					}
+				}
+			}
+		}
+		pc += size;
+		len -= size;
+	}
+
+	/* If a constructor throws inside a "try" block then the handlers
+	   could see the partially initialized object through the local */
+	for(index = 0; coderExceptions && index < coderExceptions->numBlocks;
+		++index)
+	{
+		block = &(coderExceptions->blocks[index]);
+		if((block->flags & IL_CODER_HANDLER_TYPE_MASK) !=
+				IL_CODER_HANDLER_TYPE_TRY)
+		{
+			continue;
+		}
+		for(posn = 0; posn < jitCoder->numEscapeSites; ++posn)
+		{
+			site = &(jitCoder->escapeSites[posn]);
+			if(!(site->escapes) && site->offset >= block->startOffset &&
+			   site->offset < block->endOffset)
+			{
+				site->escapes = 1;
+				--numCandidates;
+			}
+		}
+	}
+	if(!numCandidates)
+	{
+		return;
+	}
+
+	/* Map the locals to the sites that store to them */
+	if(code->localVarSig)
+	{
+		localVars = ILStandAloneSigGetType(code->localVarSig);
+		state.numLocals = ILTypeNumLocals(localVars);
+	}
+	else
+	{
+		state.numLocals = 0;
+	}
+	state.locals = (ILInt32 *)ILMalloc(sizeof(ILInt32) *
+									   (state.numLocals + 1));
+	if(!(state.locals))
+	{
+		_ILJitEscapeReset(jitCoder);
+		return;
+	}
+	for(index = 0; index < state.numLocals; ++index)
+	{
+		state.locals[index] = -1;
+	}
+	for(index = 0; index < jitCoder->numEscapeSites; ++index)
+	{
+		site = &(jitCoder->escapeSites[index]);
+		if(site->escapes)
+		{
+			continue;
+		}
+		if((ILUInt32)(site->local) >= state.numLocals)
+		{
+			site->escapes = 1;
+		}
+		else if(state.locals[site->local] == -1)
+		{
+			state.locals[site->local] = (ILInt32)index;
+		}
+		else
+		{
+			/* Two sites share a local: they could see each other's
+			   objects, so neither is allocated in the frame */
+			if(state.locals[site->local] >= 0)
+			{
+				jitCoder->escapeSites[state.locals[site->local]].escapes = 1;
+			}
+			state.locals[site->local] = -2;
+			site->escapes = 1;
+		}
+	}
+
+	/* Follow the objects through the method */
+	state.coder = jitCoder;
+	state.method = method;
+	state.thisClass = 0;
+	state.thisEscapes = 0;
+	state.depth = 0;
+	state.stack = 0;
+	if(!_ILJitEscapeScan(&state, code))
+	{
+		for(index = 0; index < jitCoder->numEscapeSites; ++index)
+		{
+			jitCoder->escapeSites[index].escapes = 1;
+		}
+	}
+	ILFree(state.locals);
+
+	/* The constructors must not leak the objects either */
+	for(index = 0; index < jitCoder->numEscapeSites; ++index)
+	{
+		site = &(jitCoder->escapeSites[index]);
+		if(!(site->escapes) &&
+		   !_ILJitEscapeThisSafe(jitCoder, site->ctor,
+								 ILMethod_Owner(site->ctor), 0, 0))
+		{
+			site->escapes = 1;
+		}
+	}
+}
+
+static ILJitEscapeSite *_ILJitEscapeNextSite(ILJITCoder *jitCoder,
+											 ILMethod *ctor)
+{
+	ILJitEscapeSite *site;
+	ILClass *classInfo;
+	ILClassPrivate *classPrivate;
+
+	if(jitCoder->nextEscapeSite >= jitCoder->numEscapeSites)
+	{
+		return 0;
+	}
+	site = &(jitCoder->escapeSites[(jitCoder->nextEscapeSite)++]);
+	if(site->ctor != ctor)
+	{
+		/* We are out of step with the verifier, so give up */
+		_ILJitEscapeReset(jitCoder);
+		return 0;
+	}
+	if(site->escapes)
+	{
+		return 0;
+	}
+
+	/* The class must be laid out to know its size and finalizer */
+	classInfo = ILMethod_Owner(ctor);
+	classPrivate = (ILClassPrivate *)(classInfo->userData);
+	if(!classPrivate || classPrivate->inLayout)
+	{
+		if(!_LayoutClass(ILExecThreadCurrent(), classInfo))
+		{
+			return 0;
+		}
+		classPrivate = (ILClassPrivate *)(classInfo->userData);
+	}
+	if(classPrivate->hasFinalizer ||
+	   classPrivate->size + IL_OBJECT_HEADER_SIZE + sizeof(void *) >
+			IL_JIT_STACK_OBJECT_MAX)
+	{
+		return 0;
+	}
+	return site;
+}
+
+static ILJitValue _ILJitEscapeAllocObject(ILJITCoder *jitCoder,
+										  ILJitEscapeSite *site,
+										  ILClass *classInfo)
+{
+	ILClassPrivate *classPrivate = (ILClassPrivate *)(classInfo->userData);
+	ILUInt32 size = IL_OBJECT_HEADER_SIZE + classPrivate->size;
+	ILUInt32 index;
+	ILJitValue object;
+
+	/* Round the size up to whole words */
+	index = (size + sizeof(void *) - 1) / sizeof(void *) - 1;
+	size = (index + 1) * sizeof(void *);
+
+#if !defined(IL_CONFIG_REDUCE_CODE) && !defined(IL_WITHOUT_TOOLS)
+	if (jitCoder->flags & IL_CODER_FLAG_STATS)
+	{
+		ILMutexLock(globalTraceMutex);
+		fprintf(stdout,
+			"StackAlloc: %s (%u bytes)\n",
+			ILClass_Name(classInfo),
+			(unsigned int)size);
+		ILMutexUnlock(globalTraceMutex);
+	}
+#endif
+
+	if(!(site->frame))
+	{
+		/* Reserve a slot in the stack frame for the site */
+		if(!(jitCoder->escapeTypes[index]))
+		{
+			ILJitType type = jit_type_create_struct(0, 0, 0);
+
+			if(!type)
+			{
+				return 0;
+			}
+			jit_type_set_size_and_alignment(type, size, IL_BEST_ALIGNMENT);
+			jitCoder->escapeTypes[index] = type;
+		}
+		if(!(site->frame = jit_value_create(jitCoder->jitFunction,
+											jitCoder->escapeTypes[index])))
+		{
+			return 0;
+		}
+		jit_value_set_addressable(site->frame);
+	}
+
+	/* Clear the object and set its class */
+	object = jit_insn_address_of(jitCoder->jitFunction, site->frame);
+	jit_insn_memset(jitCoder->jitFunction, object,
+					jit_value_create_nint_constant(jitCoder->jitFunction,
+												   _IL_JIT_TYPE_BYTE,
+												   (jit_nint)0),
+					jit_value_create_nint_constant(jitCoder->jitFunction,
+												   _IL_JIT_TYPE_UINT32,
+												   (jit_nint)size));
+	jit_insn_store_relative(jitCoder->jitFunction, object,
+							offsetof(ILObjectHeader, classPrivate),
+							jit_value_create_nint_constant
+								(jitCoder->jitFunction, _IL_JIT_TYPE_VPTR,
+								 (jit_nint)classPrivate));
+	return jit_insn_add_relative(jitCoder->jitFunction, object,
+								 IL_OBJECT_HEADER_SIZE);
+}
+
+#endif	/* IL_JITC_FUNCTIONS */
@@ -863,22 +863,17 @@ static int NeedMarshalValue(ILType *type)
     return 0;
 }
 
+/*
+ * Structures that don't need any of their fields converted are passed
+ * to native code directly.  The answer is computed when the class is
+ * laid out, so we don't need to walk the fields each time.
+ */
 static int NeedMarshalStruct(ILType *structureILType)
 {
-	ILClass *classInfo = ILClassResolve(ILType_ToValueType(structureILType));
-	ILField *field = 0;
-	ILType *type;
+	ILExecThread *thread = ILExecThreadCurrent();
 
-	while((field = (ILField *)ILClassNextMemberByKind
-			(classInfo, (ILMember *)field, IL_META_MEMBERKIND_FIELD)) != 0)
-	{
-		if(!ILField_IsStatic(field))
-		{
-			type = ILTypeGetEnumType(ILField_Type(field));
-			if(NeedMarshalValue(type))return 1;
-		}
-	}
-	return 0;
+	return !_ILTypeIsBlittableLocked(_ILExecThreadProcess(thread),
+									 structureILType);
 }
 
 static ILJitValue MarshalValue(jit_function_t function, ILJitValue in, ILType *type, ILUInt32 marshalType,
@@ -1194,6 +1189,13 @@ static ILJitValue MarshalValue(jit_function_t function, ILJitValue in, ILType *t
 			    else jit_insn_store(function, srcArray, in);
 			    elemType = ILType_Ref(type);
 			    elemType = ILTypeGetEnumType(elemType);
+			    /* Blittable structures are passed by pointer into the
+			       managed value.  The collector does not move objects,
+			       so no pinning is needed for the duration of the call.
+			       Other structures are converted in place, because a
+			       copy would not be converted back after the call and
+			       the values that native code stores through a "ref"
+			       or "out" argument would be lost */
 			    if(NeedMarshalValue(elemType))
 			    {
 				        MarshalValue(function, jit_insn_dup(function, srcArray),
@@ -1222,6 +1224,8 @@ static ILJitValue MarshalValue(jit_function_t function, ILJitValue in, ILType *t
 		    elemType = ILTypeGetEnumType(elemType);
 		    if(!NeedMarshalValue(elemType))
 		    {
+			    /* Arrays of blittable elements are passed as a pointer
+			       to the first element without copying */
 			    jit_insn_store(function, newArray, srcArray);
 			    if(addressKind==MARSHAL_FIRST_LEVEL_VALUE)
 			    {
@@ -30,6 +30,21 @@
 #endif /* ENHANCED_PROFILER */
 #endif /* !IL_CONFIG_REDUCE_CODE */
 
+#if !defined(IL_CONFIG_REDUCE_CODE) && !defined(IL_WITHOUT_TOOLS)
+	/* Pool for the branch counters */
+	ILMemPool		branchCounterPool;
+
+	/* Where to link the counter of the next branch in the current method */
+	ILJitBranchCounter **nextBranchCounter;
+
+	/* Branch weights loaded with _ILLoadBranchProfile */
+	ILHashTable	   *branchProfiles;
+
+	/* Branch weights of the current method and index of the next branch */
+	ILJitBranchProfile *branchProfile;
+	ILUInt32		branchIndex;
+#endif /* !IL_CONFIG_REDUCE_CODE && !IL_WITHOUT_TOOLS */
+
 #endif /* IL_JITC_CODER_INSTANCE */
 
 #ifdef IL_JITC_CODER_INIT
@@ -42,8 +57,31 @@
 #endif /* ENHANCED_PROFILER */
 #endif /* !IL_CONFIG_REDUCE_CODE */
 
+#if !defined(IL_CONFIG_REDUCE_CODE) && !defined(IL_WITHOUT_TOOLS)
+	/* Initialize the branch profiling */
+	ILMemPoolInit(&(coder->branchCounterPool), sizeof(ILJitBranchCounter), 256);
+	coder->nextBranchCounter = 0;
+	coder->branchProfiles = 0;
+	coder->branchProfile = 0;
+	coder->branchIndex = 0;
+#endif /* !IL_CONFIG_REDUCE_CODE && !IL_WITHOUT_TOOLS */
+
 #endif /* IL_JITC_CODER_INIT */
 
+#ifdef IL_JITC_CODER_DESTROY
+
+#if !defined(IL_CONFIG_REDUCE_CODE) && !defined(IL_WITHOUT_TOOLS)
+	/* Free the branch counters and the loaded branch weights */
+	ILMemPoolDestroy(&(coder->branchCounterPool));
+	if(coder->branchProfiles)
+	{
+		ILHashDestroy(coder->branchProfiles);
+		coder->branchProfiles = 0;
+	}
+#endif /* !IL_CONFIG_REDUCE_CODE && !IL_WITHOUT_TOOLS */
+
+#endif /* IL_JITC_CODER_DESTROY */
+
 #ifdef IL_JITC_DECLARATIONS
 
 #if !defined(IL_CONFIG_REDUCE_CODE) && !defined(IL_WITHOUT_TOOLS)
@@ -56,6 +94,34 @@ static void _ILJitProfileStart(ILJITCoder *jitCoder, ILMethod *method);
  * Emit the code for end profiling an internal call or inlined method.
  */
 static void _ILJitProfileEnd(ILJITCoder *jitCoder, ILMethod *method);
+
+/*
+ * Prepare the branch counters and weights for compiling a method.
+ */
+static void _ILJitBranchProfileSetup(ILJITCoder *jitCoder, ILMethod *method);
+
+/*
+ * Emit the code for counting a conditional branch.
+ * This must be called before the code for the branch condition.
+ * Returns the counter of the branch or 0 if the branch is not counted.
+ */
+static ILJitBranchCounter *_ILJitBranchProfileStart(ILJITCoder *jitCoder);
+
+/*
+ * Emit the code for counting the fall through of a conditional branch
+ * and annotate the branch with the weights from the branch profile.
+ * This must be called right after the conditional branch.
+ */
+static void _ILJitBranchProfileEnd(ILJITCoder *jitCoder,
+								   ILJitBranchCounter *counter);
+
+/*
+ * Hash table functions for the branch profile entries.
+ */
+static unsigned long _ILJitBranchProfileCompute(const ILJitBranchProfile *profile);
+static int _ILJitBranchProfileMatch(const ILJitBranchProfile *profile,
+									const ILJitBranchProfile *key);
+static void _ILJitBranchProfileFree(ILJitBranchProfile *profile);
 #endif /* !IL_CONFIG_REDUCE_CODE && !IL_WITHOUT_TOOLS */
 
 #endif	/* IL_JITC_DECLARATIONS */
@@ -164,6 +230,130 @@ static void _ILJitProfileEnd(ILJITCoder *jitCoder, ILMethod *method)
 	jit_insn_label(jitCoder->jitFunction, &label);
 #endif  /* ENHANCED_PROFILER */
 }
+
+/*
+ * Compute the hash value of a branch profile entry.
+ */
+static unsigned long _ILJitBranchProfileCompute(const ILJitBranchProfile *profile)
+{
+	return ILHashString(profile->token, profile->assembly, -1);
+}
+
+/*
+ * Match a branch profile entry against a key.
+ */
+static int _ILJitBranchProfileMatch(const ILJitBranchProfile *profile,
+									const ILJitBranchProfile *key)
+{
+	return (profile->token == key->token &&
+			!strcmp(profile->assembly, key->assembly));
+}
+
+/*
+ * Free a branch profile entry.
+ */
+static void _ILJitBranchProfileFree(ILJitBranchProfile *profile)
+{
+	ILFree(profile);
+}
+
+/*
+ * Emit the code to increment a 32 bit counter.
+ * This isn't done atomically so some counts may be lost if more than one
+ * thread executes the code at the same time.
+ */
+static void _ILJitIncrementCounter(ILJITCoder *jitCoder, ILUInt32 *counter)
+{
+	ILJitValue address;
+	ILJitValue value;
+
+	address = jit_value_create_nint_constant(jitCoder->jitFunction,
+											 _IL_JIT_TYPE_VPTR,
+											 (jit_nint)counter);
+	value = jit_insn_load_relative(jitCoder->jitFunction, address, 0,
+								   _IL_JIT_TYPE_UINT32);
+	value = jit_insn_add(jitCoder->jitFunction, value,
+						 jit_value_create_nint_constant(jitCoder->jitFunction,
+														_IL_JIT_TYPE_UINT32,
+														1));
+	jit_insn_store_relative(jitCoder->jitFunction, address, 0, value);
+}
+
+static void _ILJitBranchProfileSetup(ILJITCoder *jitCoder, ILMethod *method)
+{
+	ILJitMethodInfo *jitMethodInfo = (ILJitMethodInfo *)(method->userData);
+	ILJitBranchProfile key;
+
+	jitCoder->nextBranchCounter = 0;
+	jitCoder->branchProfile = 0;
+	jitCoder->branchIndex = 0;
+
+	if(!jitMethodInfo)
+	{
+		return;
+	}
+
+	/* Counters are reused if the method is compiled again */
+	jitCoder->nextBranchCounter = &(jitMethodInfo->branchCounters);
+
+	if(jitCoder->branchProfiles)
+	{
+		key.assembly = ILImageGetAssemblyName(ILProgramItem_Image(method));
+		key.token = ILMethod_Token(method);
+		if(key.assembly)
+		{
+			jitCoder->branchProfile = ILHashFindType(jitCoder->branchProfiles,
+													 &key, ILJitBranchProfile);
+		}
+	}
+}
+
+static ILJitBranchCounter *_ILJitBranchProfileStart(ILJITCoder *jitCoder)
+{
+	ILJitBranchCounter *counter;
+
+	if(!(jitCoder->flags & IL_CODER_FLAG_BRANCH_PROFILE) ||
+	   !(jitCoder->nextBranchCounter))
+	{
+		return 0;
+	}
+
+	counter = *(jitCoder->nextBranchCounter);
+	if(!counter)
+	{
+		if(!(counter = ILMemPoolAlloc(&(jitCoder->branchCounterPool),
+									  ILJitBranchCounter)))
+		{
+			return 0;
+		}
+		counter->total = 0;
+		counter->notTaken = 0;
+		counter->next = 0;
+		*(jitCoder->nextBranchCounter) = counter;
+	}
+	jitCoder->nextBranchCounter = &(counter->next);
+
+	_ILJitIncrementCounter(jitCoder, &(counter->total));
+	return counter;
+}
+
+static void _ILJitBranchProfileEnd(ILJITCoder *jitCoder,
+								   ILJitBranchCounter *counter)
+{
+	ILJitBranchProfile *profile = jitCoder->branchProfile;
+	ILUInt32 index = jitCoder->branchIndex++;
+
+	if(profile && index < profile->numBranches)
+	{
+		jit_insn_set_branch_weights(jitCoder->jitFunction,
+									profile->weights[index * 2],
+									profile->weights[index * 2 + 1]);
+	}
+	if(counter)
+	{
+		_ILJitIncrementCounter(jitCoder, &(counter->notTaken));
+	}
+}
 #endif /* !IL_CONFIG_REDUCE_CODE && !IL_WITHOUT_TOOLS */
 
 #endif	/* IL_JITC_FUNCTIONS */
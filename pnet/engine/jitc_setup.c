@@ -61,6 +61,9 @@ static int JITCoder_Setup(ILCoder *_coder, unsigned char **start,
 		args[1] = jit_value_create_nint_constant(coder->jitFunction, _IL_JIT_TYPE_VPTR, (jit_nint) method);
 		jit_insn_call_native(coder->jitFunction, "ILJitTraceIn", ILJitTraceIn, _ILJitSignature_ILJitTraceInOut, args, 2, JIT_CALL_NOTHROW);
 	}
+
+	/* Set up the branch counters and weights for the method */
+	_ILJitBranchProfileSetup(coder, method);
 #endif
 
 #ifdef IL_DEBUGGER
@@ -92,6 +95,9 @@ static int JITCoder_Setup(ILCoder *_coder, unsigned char **start,
 	{
 		return 0;
 	}
+
+	/* Find the objects that can be allocated in the stack frame. */
+	_ILJitEscapeAnalyze(coder, method, code, coderExceptions);
 #ifdef _IL_JIT_OPTIMIZE_INIT_LOCALS
 	coder->localsInitialized = 0;
 #endif
@@ -173,6 +179,9 @@ static int JITCoder_Finish(ILCoder *_coder)
 	/* Destroy the mem stack for the label stackstates. */
 	ILMemStackDestroy(&(jitCoder->stackStates));
 
+	/* Forget the results of the escape analysis. */
+	_ILJitEscapeReset(jitCoder);
+
 	/* Clear the label pool */
 	ILMemPoolClear(&(jitCoder->labelPool));
 	jitCoder->labelList = 0;
@@ -48,6 +48,7 @@ typedef struct
 	int			hasFinalizer;
 	int			managedInstance;
 	int			managedStatic;
+	int			blittable;
 #ifdef IL_USE_JIT
 	void	  **jitVtable;
 	ILJitTypes *jitTypes;
@@ -521,6 +522,28 @@ ILNativeUInt ILGCBuildStaticTypeDescriptor(ILClass *classInfo,
 }
 #endif	/* IL_USE_TYPED_ALLOCATION */
 
+/*
+ * Determine if a field of a non-primitive, non-value type can be
+ * passed to native code as-is.  Value types record this in their
+ * layout instead.  Strings, delegates, arrays and managed pointers
+ * must be converted by the marshalling code.  Other object references
+ * and unmanaged pointers are passed through unchanged.
+ */
+static int BlittableType(ILType *type)
+{
+	type = ILTypeStripPrefixes(type);
+	if(ILType_IsClass(type))
+	{
+		return !ILTypeIsStringClass(type) && !ILTypeIsDelegateSubClass(type);
+	}
+	else if(type != 0 && ILType_IsComplex(type))
+	{
+		return (ILType_Kind(type) != IL_TYPE_COMPLEX_BYREF &&
+				!ILType_IsArray(type));
+	}
+	return 1;
+}
+
 /*
  * Get the layout information for a type.  Returns zero
  * if there is something wrong with the type.
@@ -658,6 +681,7 @@ static int LayoutType(ILExecProcess *process, ILType *type, LayoutInfo *layout)
 		layout->staticSize = 0;
 		layout->hasFinalizer = 0;
 		layout->managedStatic = 0;
+		layout->blittable = 1;
 		return 1;
 	}
 	else if(ILType_IsValueType(type))
@@ -703,6 +727,7 @@ static int LayoutType(ILExecProcess *process, ILType *type, LayoutInfo *layout)
 		layout->hasFinalizer = 0;
 		layout->managedInstance = ILTypeIsReference(ILTypeStripPrefixes(type));
 		layout->managedStatic = 0;
+		layout->blittable = 1;
 		return 1;
 	}
 }
@@ -1126,6 +1151,7 @@ static int LayoutClass(ILExecProcess *process, ILClass *info, LayoutInfo *layout
 			layout->hasFinalizer = classPrivate->hasFinalizer;
 			layout->managedInstance = classPrivate->managedInstance;
 			layout->managedStatic = classPrivate->managedStatic;
+			layout->blittable = classPrivate->blittable;
 		#ifdef IL_USE_JIT
 			layout->jitVtable = classPrivate->jitVtable;
 			layout->jitTypes = &(classPrivate->jitTypes);
@@ -1149,6 +1175,7 @@ static int LayoutClass(ILExecProcess *process, ILClass *info, LayoutInfo *layout
 		info->userData = (void *)classPrivate;
 		classPrivate->inLayout = 1;
 		classPrivate->gcTypeDescriptor = IL_MAX_NATIVE_UINT;
+		classPrivate->finalizeMethod = 0;
 		classPrivate->process = process;
 	}
 
@@ -1188,6 +1215,10 @@ static int LayoutClass(ILExecProcess *process, ILClass *info, LayoutInfo *layout
 		layout->managedStatic = 0;
 	}
 
+	/* Only value types can be passed to native code without conversion.
+	   This is cleared below if any of the instance fields need it */
+	layout->blittable = ILClassIsValueType(info);
+
 	/* Zero the static size, which must be recomputed for each class */
 	layout->staticSize = 0;
 #ifdef IL_USE_JIT
@@ -1338,6 +1369,14 @@ static int LayoutClass(ILExecProcess *process, ILClass *info, LayoutInfo *layout
 			{
 				layout->managedInstance = 1;
 			}
+
+			/* Clear the "blittable" flag if the field needs conversion */
+			if(layout->blittable &&
+			   (!(typeLayout.blittable) ||
+			    !BlittableType(field->member.signature)))
+			{
+				layout->blittable = 0;
+			}
 		}
 	}
 
@@ -1375,6 +1414,7 @@ static int LayoutClass(ILExecProcess *process, ILClass *info, LayoutInfo *layout
 	classPrivate->nativeSize = layout->nativeSize;
 	classPrivate->nativeAlignment = layout->nativeAlignment;
 	classPrivate->managedInstance = layout->managedInstance;
+	classPrivate->blittable = layout->blittable;
 #ifdef IL_USE_JIT
 	if(!ILJitTypeCreate(classPrivate, process))
 	{
@@ -1695,6 +1735,66 @@ ILUInt32 _ILSizeOfTypeLocked(ILExecProcess *process, ILType *type)
 	}
 }
 
+int _ILTypeHasManagedFieldsLocked(ILExecProcess *process, ILType *type)
+{
+	LayoutInfo layout;
+	type = ILTypeStripPrefixes(type);
+	if(ILType_IsPrimitive(type))
+	{
+		return (type == ILType_TypedRef);
+	}
+	else if(!ILType_IsValueType(type))
+	{
+		/* Object references, and anything else we can't be sure of */
+		return 1;
+	}
+	else if(!LayoutType(process, type, &layout))
+	{
+		/* Play it safe if the value type cannot be laid out */
+		return 1;
+	}
+	else
+	{
+		return layout.managedInstance;
+	}
+}
+
+int _ILTypeIsBlittableLocked(ILExecProcess *process, ILType *type)
+{
+	LayoutInfo layout;
+	type = ILTypeStripPrefixes(type);
+	if(!ILType_IsValueType(type) || !LayoutType(process, type, &layout))
+	{
+		return 0;
+	}
+	return layout.blittable;
+}
+
+int _ILTypeHasManagedFields(ILExecThread *thread, ILType *type)
+{
+	ILClass *classInfo;
+	int managed;
+	if(!ILType_IsValueType(type))
+	{
+		/* We can take a shortcut because the type is not a value type */
+		return _ILTypeHasManagedFieldsLocked
+			(_ILExecThreadProcess(thread), type);
+	}
+
+	/* Quick check to see if the class is already laid out,
+	   to avoid acquiring the metadata lock if possible */
+	classInfo = ILClassResolve(ILType_ToValueType(type));
+	if(ILClassGetSynType(classInfo) == 0 && _ILLayoutAlreadyDone(classInfo))
+	{
+		return ((ILClassPrivate *)(classInfo->userData))->managedInstance;
+	}
+
+	IL_METADATA_WRLOCK(_ILExecThreadProcess(thread));
+	managed = _ILTypeHasManagedFieldsLocked(_ILExecThreadProcess(thread), type);
+	IL_METADATA_UNLOCK(_ILExecThreadProcess(thread));
+	return managed;
+}
+
 ILUInt32 ILSizeOfType(ILExecThread *thread, ILType *type)
 {
 	if(!ILType_IsValueType(type))
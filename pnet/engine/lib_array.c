@@ -95,8 +95,7 @@ static System_Array *System_SArray_ctor(ILExecThread *thread,
 	}
 
 	/* Allocate the array, initialize, and return it */
-	if(ILType_IsPrimitive(ILType_ElemType(type)) &&
-	   ILType_ElemType(type) != ILType_TypedRef)
+	if(!_ILTypeHasManagedFields(thread, ILType_ElemType(type)))
 	{
 		/* The array will never contain pointers, so use atomic allocation */
 		array = (System_Array *)_ILEngineAllocAtomic
@@ -151,8 +150,7 @@ static System_MArray *ConstructMArrayHeader(ILExecThread *thread,
 		/* Shouldn't happen, but do something sane anyway */
 		elemType = ILType_Int32;
 	}
-	*elemIsPrimitive = (ILType_IsPrimitive(elemType) &&
-						elemType != ILType_TypedRef);
+	*elemIsPrimitive = !_ILTypeHasManagedFields(thread, elemType);
 
 	/* Allocate space for the array header */
 	_this = (System_MArray *)_ILEngineAlloc
@@ -3134,8 +3132,8 @@ ILObject *_IL_Array_CreateArray_jiiii(ILExecThread *thread,
 	/* Compute the element size */
 	elemSize = ILSizeOfType(thread, elemType);
 
-	/* Determine if the element type is primitive */
-	if(ILType_IsPrimitive(elemType) && elemType != ILType_TypedRef)
+	/* Determine if the elements can never contain pointers */
+	if(!_ILTypeHasManagedFields(thread, elemType))
 	{
 		isPrimitive = 1;
 	}
@@ -3415,7 +3413,7 @@ ILObject *_IL_Array_CreateArray_jaiai(ILExecThread *thread,
 	}
 
 	/* Allocate the data portion of the array */
-	if(ILType_IsPrimitive(elemType) && elemType != ILType_TypedRef)
+	if(!_ILTypeHasManagedFields(thread, elemType))
 	{
 		/* The array will never contain pointers,
 		   so use atomic allocation */
@@ -4350,8 +4348,8 @@ ILObject *_ILCloneSArray(ILExecThread *thread, System_Array *array)
 	/* Get the total length of the array object */
 	totalLen = sizeof(System_Array) + elemSize * ((ILUInt32)(ArrayLength(array)));
 
-	/* Allocate differently for primitive and non-primitive arrays */
-	if(ILType_IsPrimitive(elemType) && elemType != ILType_TypedRef)
+	/* Allocate differently for arrays that never contain pointers */
+	if(!_ILTypeHasManagedFields(thread, elemType))
 	{
 		newArray = (System_Array *)_ILEngineAllocAtomic
 				(thread, GetObjectClass(array), totalLen);
@@ -4402,8 +4400,8 @@ ILObject *_ILCloneMArray(ILExecThread *thread, System_MArray *array)
 	}
 	ILMemCpy(newArray, array, headerLen);
 
-	/* Allocate the data differently for primitive and non-primitive arrays */
-	if(ILType_IsPrimitive(elemType) && elemType != ILType_TypedRef)
+	/* Allocate the data differently if it never contains pointers */
+	if(!_ILTypeHasManagedFields(thread, elemType))
 	{
 		newArray->data = (System_Array *)_ILEngineAllocAtomic
 				(thread, 0, totalLen);
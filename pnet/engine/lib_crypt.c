@@ -78,14 +78,34 @@ typedef struct
 typedef void (*SymResetFunc)(void *ctx);
 typedef void (*SymCryptFunc)(void *ctx, unsigned char *input,
 							 unsigned char *output);
+typedef void (*SymBlocksFunc)(void *ctx, unsigned char *input,
+							  unsigned char *output, unsigned long numBlocks);
+typedef void (*SymChainFunc)(void *ctx, unsigned char *iv,
+							 unsigned char *input, unsigned char *output,
+							 unsigned long numBlocks);
 typedef struct
 {
 	SymResetFunc	reset;
 	SymCryptFunc	encrypt;
 	SymCryptFunc	decrypt;
+	SymBlocksFunc	encryptECB;
+	SymBlocksFunc	decryptECB;
+	SymChainFunc	encryptCBC;
+	SymChainFunc	decryptCBC;
+	int				blockSize;
 
 } SymContext;
 
+/*
+ * Get the algorithm-specific state that follows a symmetric context header.
+ */
+#define	SymState(context)	((void *)&(((RC2Context *)(context))->rc2))
+
+/*
+ * Largest block size of the symmetric algorithms.
+ */
+#define	IL_SYM_MAX_BLOCK_SIZE	16
+
 /*
  * Hash context for the MD5 algorithm.
  */
@@ -541,6 +561,22 @@ void _IL_CryptoMethods_GenerateRandom(ILExecThread *thread,
 	ILMutexUnlock(thread->process->randomLock);
 }
 
+/*
+ * Initialize the block size and the multi-block functions of a symmetric
+ * context.  Algorithms without their own multi-block functions are
+ * handled one block at a time by "EncryptBlocks" and "DecryptBlocks".
+ */
+static void SymInitBlocks(SymContext *context, int blockSize,
+						  SymBlocksFunc encryptECB, SymBlocksFunc decryptECB,
+						  SymChainFunc encryptCBC, SymChainFunc decryptCBC)
+{
+	context->blockSize = blockSize;
+	context->encryptECB = encryptECB;
+	context->decryptECB = decryptECB;
+	context->encryptCBC = encryptCBC;
+	context->decryptCBC = decryptCBC;
+}
+
 /*
  * public static IntPtr EncryptCreate(int algorithm, byte[] key);
  */
@@ -563,6 +599,7 @@ ILNativeInt _IL_CryptoMethods_EncryptCreate(ILExecThread *_thread,
 			context->reset = (SymResetFunc)ILDESFinalize;
 			context->encrypt = (SymCryptFunc)ILDESProcess;
 			context->decrypt = (SymCryptFunc)ILDESProcess;
+			SymInitBlocks(context, 8, 0, 0, 0, 0);
 			ILDESInit(&(((DESContext *)context)->des),
 					  ArrayToBuffer(key), 0);
 			return (ILNativeInt)context;
@@ -581,6 +618,7 @@ ILNativeInt _IL_CryptoMethods_EncryptCreate(ILExecThread *_thread,
 			context->reset = (SymResetFunc)ILDES3Finalize;
 			context->encrypt = (SymCryptFunc)ILDES3Process;
 			context->decrypt = (SymCryptFunc)ILDES3Process;
+			SymInitBlocks(context, 8, 0, 0, 0, 0);
 			ILDES3Init(&(((DES3Context *)context)->des3),
 					   ArrayToBuffer(key), (int)(ArrayLength(key) * 8), 0);
 			return (ILNativeInt)context;
@@ -599,6 +637,7 @@ ILNativeInt _IL_CryptoMethods_EncryptCreate(ILExecThread *_thread,
 			context->reset = (SymResetFunc)ILRC2Finalize;
 			context->encrypt = (SymCryptFunc)ILRC2Encrypt;
 			context->decrypt = (SymCryptFunc)ILRC2Decrypt;
+			SymInitBlocks(context, 8, 0, 0, 0, 0);
 			ILRC2Init(&(((RC2Context *)context)->rc2),
 					  ArrayToBuffer(key), (int)(ArrayLength(key) * 8));
 			return (ILNativeInt)context;
@@ -617,6 +656,11 @@ ILNativeInt _IL_CryptoMethods_EncryptCreate(ILExecThread *_thread,
 			context->reset = (SymResetFunc)ILAESFinalize;
 			context->encrypt = (SymCryptFunc)ILAESEncrypt;
 			context->decrypt = (SymCryptFunc)ILAESDecrypt;
+			SymInitBlocks(context, 16,
+						  (SymBlocksFunc)ILAESEncryptECB,
+						  (SymBlocksFunc)ILAESDecryptECB,
+						  (SymChainFunc)ILAESEncryptCBC,
+						  (SymChainFunc)ILAESDecryptCBC);
 			ILAESInit(&(((AESContext *)context)->aes),
 					  ArrayToBuffer(key), (int)(ArrayLength(key) * 8));
 			return (ILNativeInt)context;
@@ -653,6 +697,7 @@ ILNativeInt _IL_CryptoMethods_DecryptCreate(ILExecThread *_thread,
 			context->reset = (SymResetFunc)ILDESFinalize;
 			context->encrypt = (SymCryptFunc)ILDESProcess;
 			context->decrypt = (SymCryptFunc)ILDESProcess;
+			SymInitBlocks(context, 8, 0, 0, 0, 0);
 			ILDESInit(&(((DESContext *)context)->des),
 					  ArrayToBuffer(key), 1);
 			return (ILNativeInt)context;
@@ -671,6 +716,7 @@ ILNativeInt _IL_CryptoMethods_DecryptCreate(ILExecThread *_thread,
 			context->reset = (SymResetFunc)ILDES3Finalize;
 			context->encrypt = (SymCryptFunc)ILDES3Process;
 			context->decrypt = (SymCryptFunc)ILDES3Process;
+			SymInitBlocks(context, 8, 0, 0, 0, 0);
 			ILDES3Init(&(((DES3Context *)context)->des3),
 					   ArrayToBuffer(key), (int)(ArrayLength(key) * 8), 1);
 			return (ILNativeInt)context;
@@ -719,6 +765,148 @@ void _IL_CryptoMethods_Decrypt(ILExecThread *_thread,
 	}
 }
 
+/*
+ * public static void EncryptBlocks(IntPtr state, byte[] iv,
+ *									byte[] inBuffer, int inOffset,
+ *									byte[] outBuffer, int outOffset,
+ *									int count);
+ */
+void _IL_CryptoMethods_EncryptBlocks(ILExecThread *_thread,
+									 ILNativeInt state, System_Array *iv,
+									 System_Array *inBuffer, ILInt32 inOffset,
+									 System_Array *outBuffer,
+									 ILInt32 outOffset, ILInt32 count)
+{
+	SymContext *context = (SymContext *)state;
+	unsigned char *input;
+	unsigned char *output;
+	unsigned char *chain;
+	unsigned long numBlocks;
+	int blockSize, posn;
+
+	if(!context)
+	{
+		return;
+	}
+	blockSize = context->blockSize;
+	input = ((unsigned char *)(ArrayToBuffer(inBuffer))) + inOffset;
+	output = ((unsigned char *)(ArrayToBuffer(outBuffer))) + outOffset;
+	numBlocks = (unsigned long)(count / blockSize);
+	if(!iv)
+	{
+		/* ECB mode */
+		if(context->encryptECB)
+		{
+			(*(context->encryptECB))
+				(SymState(context), input, output, numBlocks);
+			return;
+		}
+		while(numBlocks > 0)
+		{
+			(*(context->encrypt))(SymState(context), input, output);
+			input += blockSize;
+			output += blockSize;
+			--numBlocks;
+		}
+	}
+	else
+	{
+		/* CBC mode: "iv" is updated with the last ciphertext block */
+		chain = (unsigned char *)(ArrayToBuffer(iv));
+		if(context->encryptCBC)
+		{
+			(*(context->encryptCBC))
+				(SymState(context), chain, input, output, numBlocks);
+			return;
+		}
+		while(numBlocks > 0)
+		{
+			for(posn = 0; posn < blockSize; ++posn)
+			{
+				chain[posn] ^= input[posn];
+			}
+			(*(context->encrypt))(SymState(context), chain, chain);
+			ILMemCpy(output, chain, blockSize);
+			input += blockSize;
+			output += blockSize;
+			--numBlocks;
+		}
+	}
+}
+
+/*
+ * public static void DecryptBlocks(IntPtr state, byte[] iv,
+ *									byte[] inBuffer, int inOffset,
+ *									byte[] outBuffer, int outOffset,
+ *									int count);
+ */
+void _IL_CryptoMethods_DecryptBlocks(ILExecThread *_thread,
+									 ILNativeInt state, System_Array *iv,
+									 System_Array *inBuffer, ILInt32 inOffset,
+									 System_Array *outBuffer,
+									 ILInt32 outOffset, ILInt32 count)
+{
+	SymContext *context = (SymContext *)state;
+	unsigned char *input;
+	unsigned char *output;
+	unsigned char *chain;
+	unsigned char block[IL_SYM_MAX_BLOCK_SIZE];
+	unsigned long numBlocks;
+	int blockSize, posn;
+
+	if(!context)
+	{
+		return;
+	}
+	blockSize = context->blockSize;
+	input = ((unsigned char *)(ArrayToBuffer(inBuffer))) + inOffset;
+	output = ((unsigned char *)(ArrayToBuffer(outBuffer))) + outOffset;
+	numBlocks = (unsigned long)(count / blockSize);
+	if(!iv)
+	{
+		/* ECB mode */
+		if(context->decryptECB)
+		{
+			(*(context->decryptECB))
+				(SymState(context), input, output, numBlocks);
+			return;
+		}
+		while(numBlocks > 0)
+		{
+			(*(context->decrypt))(SymState(context), input, output);
+			input += blockSize;
+			output += blockSize;
+			--numBlocks;
+		}
+	}
+	else
+	{
+		/* CBC mode: "iv" is updated with the last ciphertext block */
+		chain = (unsigned char *)(ArrayToBuffer(iv));
+		if(context->decryptCBC)
+		{
+			(*(context->decryptCBC))
+				(SymState(context), chain, input, output, numBlocks);
+			return;
+		}
+		while(numBlocks > 0)
+		{
+			/* Save the ciphertext first, in case "input == output" */
+			ILMemCpy(block, input, blockSize);
+			(*(context->decrypt))(SymState(context), input, output);
+			for(posn = 0; posn < blockSize; ++posn)
+			{
+				output[posn] ^= chain[posn];
+			}
+			ILMemCpy(chain, block, blockSize);
+			input += blockSize;
+			output += blockSize;
+			--numBlocks;
+		}
+		ILMemZero(block, sizeof(block));
+	}
+}
+
 /*
  * public static void SymmetricFree(IntPtr state);
  */
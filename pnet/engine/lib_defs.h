@@ -22,6 +22,7 @@
 #define	_ENGINE_LIB_DEFS_H
 
 #include "il_decimal.h"
+#include "il_errno.h"
 #include "engine.h"
 
 #ifdef	__cplusplus
@@ -209,6 +210,27 @@ typedef union
  */
 #define ArrayLength(array)		(((System_Array *)(array))->__header.length)
 
+/*
+ * Perform a system call that writes into collected memory.  If the
+ * collector protects the buffer while the call is blocked, then the
+ * call fails with EFAULT and must be retried.
+ */
+#define	IL_GC_WRITE_SYSCALL(result,buf,len,call)	\
+			do { \
+				int __mayProtect; \
+				for(;;) \
+				{ \
+					__mayProtect = ILGCPrepareWrite \
+						((buf), (unsigned long)(len)); \
+					(result) = (call); \
+					if((result) >= 0 || !__mayProtect || \
+					   ILSysIOGetErrno() != IL_ERRNO_EFAULT) \
+					{ \
+						break; \
+					} \
+				} \
+			} while (0)
+
 /*
  * Determine if an array inherits from "$Synthetic.SArray".
  */
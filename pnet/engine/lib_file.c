@@ -141,7 +141,10 @@ ILInt32 _IL_FileMethods_Read(ILExecThread *thread, ILNativeInt handle,
 							 ILInt32 count)
 {
 	ILUInt8 *buf = (ILUInt8 *)(ArrayToBuffer(array));
-	return ILSysIORead((ILSysIOHandle)handle, buf + offset, count);
+	ILInt32 result;
+	IL_GC_WRITE_SYSCALL(result, buf + offset, count,
+		ILSysIORead((ILSysIOHandle)handle, buf + offset, count));
+	return result;
 }
 
 /*
@@ -185,6 +188,7 @@ ILInt64 _IL_FileMethods_Seek(ILExecThread *thread, ILNativeInt handle,
  */
 ILBool _IL_FileMethods_Close(ILExecThread *thread, ILNativeInt handle)
 {
+	_ILExecProcessUnwatchHandle(_ILExecThreadProcess(thread), handle);
 	return (ILBool)(ILSysIOClose((ILSysIOHandle)handle));
 }
 
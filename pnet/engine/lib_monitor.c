@@ -189,6 +189,12 @@ ILBool _IL_Monitor_InternalWait(ILExecThread *thread,
 		return 0;
 	}
 
+	/* Give back the stack memory that we won't need while waiting */
+	if(timeout != 0)
+	{
+		_ILExecThreadShrinkStack(thread);
+	}
+
 	result = ILMonitorTimedWait((void **)GetObjectLockWordPtr(thread, obj), timeout);
 
 	if((result != IL_THREAD_OK) && (result != IL_THREAD_BUSY))
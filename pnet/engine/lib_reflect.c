@@ -22,6 +22,7 @@
 #include "lib_defs.h"
 #include "il_serialize.h"
 #include "il_crypt.h"
+#include "interlocked.h"
 
 #ifdef	__cplusplus
 extern	"C" {
@@ -92,6 +93,45 @@ static ILInt32 NumMatchingAttrs(ILExecThread *thread, ILProgramItem *item,
 	return num;
 }
 
+/*
+ * Determine if any attribute matches particular conditions.  This only
+ * looks at the attribute types and never constructs the attributes.
+ */
+static int HasMatchingAttr(ILExecThread *thread, ILProgramItem *item,
+						   ILClass *type, ILBool inherit)
+{
+	ILClass *classInfo;
+	ILAttribute *attr;
+	if(inherit && (classInfo = ILProgramItemToClass(item)) != 0)
+	{
+		while(classInfo != 0)
+		{
+			attr = 0;
+			while((attr = ILProgramItemNextAttribute
+						((ILProgramItem *)classInfo, attr)) != 0)
+			{
+				if(!type || AttrMatch(thread, attr, type))
+				{
+					return 1;
+				}
+			}
+			classInfo = ILClass_ParentClass(classInfo);
+		}
+	}
+	else
+	{
+		attr = 0;
+		while((attr = ILProgramItemNextAttribute(item, attr)) != 0)
+		{
+			if(!type || AttrMatch(thread, attr, type))
+			{
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
 /*
  * prototype for InvokeMethod
  */
@@ -310,108 +350,312 @@ static ILObject *DeserializeObject(ILExecThread *thread,
 }
 
 /*
- * De-serialize a custom attribute and construct an object for it.
+ * Decoded form of a custom attribute blob.  Decoded attributes are cached
+ * per process, so that constructing the same attribute again does not
+ * need to parse the blob.  Only values that cannot be modified by the
+ * attribute's code (boxed values, strings and types) are cached.
  */
-static ILObject *DeserializeAttribute(ILExecThread *thread,
-									  ILAttribute *attr)
+#ifdef IL_CONFIG_REDUCE_DATA
+#define	IL_ATTRIBUTE_HASH_SIZE		8
+#else
+#define	IL_ATTRIBUTE_HASH_SIZE		256
+#endif
+typedef struct _tagILAttrDecoded ILAttrDecoded;
+struct _tagILAttrDecoded
+{
+	ILAttribute	   *attr;			/* Attribute that was decoded */
+	ILAttrDecoded  *next;			/* Next entry in the hash bucket */
+	ILMethod	   *ctor;			/* Resolved constructor */
+	ILInt32			numArgs;		/* Number of constructor arguments */
+	ILInt32			numNamed;		/* Number of property assignments */
+	ILObject	  **args;			/* Constructor argument values */
+	ILMethod	  **setters;		/* Setters for the named properties */
+	ILObject	  **namedArgs;		/* Values for the named properties */
+
+};
+
+/*
+ * Determine if a decoded attribute value can be shared between
+ * all instances of the attribute.  Arrays can be modified by the
+ * code that receives them, so they are decoded every time.
+ */
+static int IsSharedAttrValue(ILObject *value)
 {
-	ILProgramItem * item=ILAttribute_TypeAsItem(attr);
+	ILType *synType;
+	if(!value)
+	{
+		return 1;
+	}
+	synType = ILClassGetSynType(GetObjectClass(value));
+	return !(synType && ILType_IsArray(synType));
+}
+
+/*
+ * Decode the blob for a custom attribute.  Returns NULL if
+ * an exception was thrown.
+ */
+static ILAttrDecoded *DecodeAttribute(ILExecThread *thread,
+									  ILAttribute *attr, int *shared)
+{
+	ILProgramItem *item = ILAttribute_TypeAsItem(attr);
 	ILMethod *method;
-	System_Array *parameters;
-	ILInt32 numParams=0;
-	ILInt32 paramNum;
 	ILSerializeReader *reader;
-	void *blob;
+	ILAttrDecoded *decoded;
+	const void *blob;
 	ILUInt32 len;
-	ILObject **buf;
-	ILType *sig=NULL,*param=NULL;
-	ILObject *retval;
+	ILType *sig;
+	ILInt32 numArgs, numExtra, numNamed, posn;
+	ILMember *member;
+	const char *name;
+	int nameLen;
 	int serialType;
-	/* see below for named args */
-	ILMember *member=NULL;
-	const char *name=NULL;
-	ILObject *obj;
+	ILObject *value;
 
-	blob=(void*)ILAttributeGetValue(attr,&len); 
-	/* keep blob for cooking later */
-	
-	/* Is this a type member? */
+	/* Resolve the attribute's constructor */
 	method = ILProgramItemToMethod(item);
 	if(!method)
 	{
 		return 0;
 	}
-	method = (ILMethod*)ILMemberResolve((ILMember*)method);
+	method = (ILMethod *)ILMemberResolve((ILMember *)method);
 	if(!method)
 	{
 		return 0;
 	}
-	sig=ILMethod_Signature(method);
-	numParams=ILTypeNumParams(sig);
-
-	reader=ILSerializeReaderInit(method,blob,len);
+	sig = ILMethod_Signature(method);
+	numArgs = (ILInt32)ILTypeNumParams(sig);
 
-	parameters = (System_Array *)ILExecThreadNew
-				(thread, "[oSystem.Object;", "(Ti)V", (ILVaInt)numParams);
-	buf=(ILObject**)(ArrayToBuffer(parameters));
-	/* *
-	 * Note: Contructors have a `this' passed to it !!
-	 *       so numParams start from 1 to n-1 ?
-	 *       Also , I'm going the path of maximum safety
-	 *       here.. By going via method sigs first.
-	 * */
-	paramNum=0;
-	while(numParams--)
-	{
-		param=ILTypeGetParam(sig,paramNum+1);
-		if((serialType=ILSerializeReaderGetParamType(reader))<=0)
-		{
-			ILExecThreadThrowSystem(thread, 
+	/* Start reading the blob */
+	blob = ILAttributeGetValue(attr, &len);
+	reader = ILSerializeReaderInit(method, blob, len);
+	if(!reader)
+	{
+		ILExecThreadThrowSystem(thread,
 			"System.Runtime.Serialization.SerializationException", 0);
+		return 0;
+	}
+
+	/* Allocate the decoded form, with room for the constructor arguments.
+	   This comes from the garbage-collected heap so that the values are
+	   kept alive */
+	decoded = (ILAttrDecoded *)ILGCAlloc
+		(sizeof(ILAttrDecoded) + numArgs * sizeof(ILObject *));
+	if(!decoded)
+	{
+		ILSerializeReaderDestroy(reader);
+		ILExecThreadThrowOutOfMemory(thread);
+		return 0;
+	}
+	decoded->attr = attr;
+	decoded->next = 0;
+	decoded->ctor = method;
+	decoded->numArgs = numArgs;
+	decoded->args = (ILObject **)(decoded + 1);
+	decoded->numNamed = 0;
+	decoded->namedArgs = 0;
+	decoded->setters = 0;
+	*shared = 1;
+
+	/* Decode the constructor arguments */
+	for(posn = 0; posn < numArgs; ++posn)
+	{
+		if((serialType = ILSerializeReaderGetParamType(reader)) <= 0)
+		{
+			ILSerializeReaderDestroy(reader);
+			ILExecThreadThrowSystem(thread,
+				"System.Runtime.Serialization.SerializationException", 0);
 			return 0;
 		}
-		buf[paramNum++]=DeserializeObject(thread,reader,param,serialType);
+		value = DeserializeObject(thread, reader,
+								  ILTypeGetParam(sig, posn + 1), serialType);
+		if(ILExecThreadHasException(thread))
+		{
+			ILSerializeReaderDestroy(reader);
+			return 0;
+		}
+		decoded->args[posn] = value;
+		*shared = (*shared && IsSharedAttrValue(value));
 	}
-	retval=InvokeMethod(thread, method, sig, 0, 
-					parameters, 1);
-	/* numParams is reused again .. bad code :-) */
-	numParams=ILSerializeReaderGetNumExtra(reader);
-	while(numParams--)
+
+	/* Allocate space for the named arguments, which follow the
+	   constructor arguments in the blob */
+	numExtra = ILSerializeReaderGetNumExtra(reader);
+	if(numExtra > 0)
 	{
-		/*
-		 * TODO : Named Arguments 
-		 */
-		int nameLen;
+		decoded->namedArgs = (ILObject **)ILGCAlloc
+			(numExtra * (sizeof(ILObject *) + sizeof(ILMethod *)));
+		if(!(decoded->namedArgs))
+		{
+			ILSerializeReaderDestroy(reader);
+			ILExecThreadThrowOutOfMemory(thread);
+			return 0;
+		}
+		decoded->setters = (ILMethod **)(decoded->namedArgs + numExtra);
+	}
 
-		serialType=ILSerializeReaderGetExtra(reader,&member,&name,&nameLen);
-		member = ILMemberResolve(member);
-		switch(ILMemberGetKind(member))
+	/* Decode the named arguments.  Only properties are supported */
+	numNamed = 0;
+	while(numExtra-- > 0)
+	{
+		serialType = ILSerializeReaderGetExtra
+			(reader, &member, &name, &nameLen);
+		if(serialType <= 0 || !(member = ILMemberResolve(member)))
 		{
-			case IL_META_MEMBERKIND_FIELD:
-					/* TODO */
-					break;
-			case IL_META_MEMBERKIND_PROPERTY:
-					/* reusing `method' & 'sig' variable */
-					method = ILProperty_Setter((ILProperty*)member);
-					method = (ILMethod*)ILMemberResolve((ILMember*)method);
-					sig = ILMethod_Signature(method);
-					obj = DeserializeObject(thread,	reader,
-							ILTypeGetParam(sig,1)
-							,serialType);
-
-					parameters = (System_Array *)ILExecThreadNew
-						(thread, "[oSystem.Object;", "(Ti)V", (ILVaInt)1);
-			
-					buf=(ILObject**)(ArrayToBuffer(parameters));
-					buf[0] = obj;
-					
-					InvokeMethod(thread, method, sig, retval,
-					parameters, 0);
-					break;
+			break;
 		}
+		if(ILMemberGetKind(member) != IL_META_MEMBERKIND_PROPERTY)
+		{
+			/* TODO: fields.  Skip over the value for now */
+			if(ILMemberGetKind(member) == IL_META_MEMBERKIND_FIELD)
+			{
+				DeserializeObject(thread, reader,
+								  ILField_Type((ILField *)member), serialType);
+				if(ILExecThreadHasException(thread))
+				{
+					ILSerializeReaderDestroy(reader);
+					return 0;
+				}
+			}
+			continue;
+		}
+		method = ILProperty_Setter((ILProperty *)member);
+		method = (ILMethod *)ILMemberResolve((ILMember *)method);
+		if(!method)
+		{
+			continue;
+		}
+		value = DeserializeObject(thread, reader,
+								  ILTypeGetParam(ILMethod_Signature(method), 1),
+								  serialType);
+		if(ILExecThreadHasException(thread))
+		{
+			ILSerializeReaderDestroy(reader);
+			return 0;
+		}
+		decoded->setters[numNamed] = method;
+		decoded->namedArgs[numNamed] = value;
+		++numNamed;
+		*shared = (*shared && IsSharedAttrValue(value));
 	}
+	decoded->numNamed = numNamed;
 
 	ILSerializeReaderDestroy(reader);
+	return decoded;
+}
+
+/*
+ * Get the decoded form of a custom attribute, from the cache if possible.
+ */
+static ILAttrDecoded *GetDecodedAttribute(ILExecThread *thread,
+										  ILAttribute *attr)
+{
+	ILExecProcess *process = _ILExecThreadProcess(thread);
+	ILAttrDecoded **table;
+	ILAttrDecoded *decoded;
+	ILUInt32 hash;
+	int shared;
+
+	/* Look for an existing decoded form */
+	hash = ILProgramItem_Token((ILProgramItem *)attr);
+	hash = ((hash + (hash >> 20)) & (IL_ATTRIBUTE_HASH_SIZE - 1));
+	table = (ILAttrDecoded **)(process->attributeHash);
+	if(table)
+	{
+		decoded = (ILAttrDecoded *)ILInterlockedLoadP_Acquire
+			((void * const volatile *)&(table[hash]));
+		while(decoded != 0)
+		{
+			if(decoded->attr == attr)
+			{
+				return decoded;
+			}
+			decoded = decoded->next;
+		}
+	}
+
+	/* Decode the attribute blob */
+	decoded = DecodeAttribute(thread, attr, &shared);
+	if(!decoded || !shared)
+	{
+		return decoded;
+	}
+
+	/* Add the decoded form to the cache.  If another thread decoded
+	   the same attribute in the meantime, we just have two copies */
+	ILMutexLock(process->lock);
+	if(!(process->attributeHash))
+	{
+		process->attributeHash = ILGCAllocPersistent
+			(sizeof(ILAttrDecoded *) * IL_ATTRIBUTE_HASH_SIZE);
+	}
+	table = (ILAttrDecoded **)(process->attributeHash);
+	if(table)
+	{
+		decoded->next = table[hash];
+		ILInterlockedStoreP_Release
+			((void * volatile *)&(table[hash]), (void *)decoded);
+	}
+	ILMutexUnlock(process->lock);
+	return decoded;
+}
+
+/*
+ * De-serialize a custom attribute and construct an object for it.
+ */
+static ILObject *DeserializeAttribute(ILExecThread *thread,
+									  ILAttribute *attr)
+{
+	ILAttrDecoded *decoded;
+	System_Array *parameters;
+	ILObject *retval;
+	ILInt32 posn;
+
+	/* Get the decoded attribute values */
+	decoded = GetDecodedAttribute(thread, attr);
+	if(!decoded)
+	{
+		return 0;
+	}
+
+	/* Construct the attribute object.  The argument arrays are copied
+	   each time because the invocation may write back to them */
+	parameters = (System_Array *)ILExecThreadNew
+		(thread, "[oSystem.Object;", "(Ti)V", (ILVaInt)(decoded->numArgs));
+	if(!parameters)
+	{
+		return 0;
+	}
+	for(posn = 0; posn < decoded->numArgs; ++posn)
+	{
+		((ILObject **)(ArrayToBuffer(parameters)))[posn] = decoded->args[posn];
+	}
+	retval = InvokeMethod(thread, decoded->ctor,
+						  ILMethod_Signature(decoded->ctor), 0,
+						  parameters, 1);
+	if(!retval)
+	{
+		return 0;
+	}
+
+	/* Set the named properties */
+	for(posn = 0; posn < decoded->numNamed; ++posn)
+	{
+		parameters = (System_Array *)ILExecThreadNew
+			(thread, "[oSystem.Object;", "(Ti)V", (ILVaInt)1);
+		if(!parameters)
+		{
+			return 0;
+		}
+		((ILObject **)(ArrayToBuffer(parameters)))[0] =
+			decoded->namedArgs[posn];
+		InvokeMethod(thread, decoded->setters[posn],
+					 ILMethod_Signature(decoded->setters[posn]), retval,
+					 parameters, 0);
+		if(ILExecThreadHasException(thread))
+		{
+			return 0;
+		}
+	}
 	return retval;
 }
 
@@ -507,7 +751,7 @@ ILBool _IL_ClrHelpers_IsDefined
 	/* Check that we have reflection access to the item */
 	if(item && _ILClrCheckItemAccess(thread, item))
 	{
-		return (NumMatchingAttrs(thread, item, type, inherit) != 0);
+		return (ILBool)HasMatchingAttr(thread, item, type, inherit);
 	}
 	else
 	{
@@ -2759,6 +3003,12 @@ static ILObject* PromoteToFloat(ILExecThread *thread, ILType *paramType,
 	return ILExecThreadBoxFloat(thread, paramType, &nativeValue);
 }
 
+/*
+ * Number of arguments that can be passed to a reflected method
+ * without allocating the argument array from the heap.
+ */
+#define	IL_INVOKE_STACK_ARGS		8
+
 /*
  * Invoke a method via reflection.
  */
@@ -2766,6 +3016,7 @@ static ILObject *InvokeMethod(ILExecThread *thread, ILMethod *method,
 							  ILType *signature, ILObject *_this,
 							  System_Array *parameters, int isCtor)
 {
+	ILExecValue stackArgs[IL_INVOKE_STACK_ARGS];
 	ILExecValue *args;
 	ILExecValue result;
 	ILInt32 numParams;
@@ -2795,8 +3046,14 @@ static ILObject *InvokeMethod(ILExecThread *thread, ILMethod *method,
 		}
 	}
 
-	/* Allocate an argument array for the invocation */
-	if(numParams != 0 || _this != 0)
+	/* Allocate an argument array for the invocation.  Small argument
+	   lists live on the stack, which the collector scans anyway */
+	if((numParams + (_this ? 1 : 0)) <= IL_INVOKE_STACK_ARGS)
+	{
+		ILMemZero(stackArgs, sizeof(stackArgs));
+		args = stackArgs;
+	}
+	else
 	{
 		args = (ILExecValue *)ILGCAlloc(sizeof(ILExecValue) *
 									    (numParams + (_this ? 1 : 0)));
@@ -2806,10 +3063,6 @@ static ILObject *InvokeMethod(ILExecThread *thread, ILMethod *method,
 			return 0;
 		}
 	}
-	else
-	{
-		args = 0;
-	}
 
 	/* Copy the parameter values into the array, and check their types */
 	if(_this != 0)
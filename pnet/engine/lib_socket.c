@@ -144,9 +144,11 @@ ILInt32 _IL_SocketMethods_Receive(ILExecThread *_thread, ILNativeInt handle,
 								  System_Array *buffer, ILInt32 offset,
 								  ILInt32 size, ILInt32 flags)
 {
-	return ILSysIOSocketReceive((ILSysIOHandle)handle,
-								((ILUInt8 *)(ArrayToBuffer(buffer))) + offset,
-								size, flags);
+	ILUInt8 *buf = ((ILUInt8 *)(ArrayToBuffer(buffer))) + offset;
+	ILInt32 result;
+	IL_GC_WRITE_SYSCALL(result, buf, size,
+		ILSysIOSocketReceive((ILSysIOHandle)handle, buf, size, flags));
+	return result;
 }
 
 /*
@@ -161,12 +163,14 @@ ILInt32 _IL_SocketMethods_ReceiveFrom(ILExecThread *_thread,
 									  ILInt32 flags,
 									  System_Array *addrReturn)
 {
-	return ILSysIOSocketRecvFrom
-				((ILSysIOHandle)handle,
-			     ((ILUInt8 *)(ArrayToBuffer(buffer))) + offset,
-				 size, flags,
+	ILUInt8 *buf = ((ILUInt8 *)(ArrayToBuffer(buffer))) + offset;
+	ILInt32 result;
+	IL_GC_WRITE_SYSCALL(result, buf, size,
+		ILSysIOSocketRecvFrom
+				((ILSysIOHandle)handle, buf, size, flags,
 				 (unsigned char *)ArrayToBuffer(addrReturn),
-				 ArrayLength(addrReturn));
+				 ArrayLength(addrReturn)));
+	return result;
 }
 
 /*
@@ -200,8 +204,121 @@ ILInt32 _IL_SocketMethods_SendTo(ILExecThread *_thread, ILNativeInt handle,
 				 ArrayLength(addr));
 }
 
+/*
+ * Number of segments that can be described without allocating memory.
+ */
+#define	IL_STACK_SEGMENTS	16
+
+/*
+ * Send or receive on a list of byte array segments.  The collector does
+ * not move arrays, and the caller's arrays keep them alive, so they can
+ * be passed to the kernel in place.
+ */
+static ILInt32 SocketVector(ILExecThread *thread, ILNativeInt handle,
+							System_Array *buffers, System_Array *offsets,
+							System_Array *counts, ILInt32 flags, int sending)
+{
+	ILSysIOBuffer stackSegments[IL_STACK_SEGMENTS];
+	ILSysIOBuffer *segments;
+	System_Array **arrays;
+	ILInt32 *offs;
+	ILInt32 *lens;
+	ILInt32 num, posn, result;
+	int mayProtect;
+
+	/* Describe the segments to the support layer */
+	num = ArrayLength(buffers);
+	if(num <= IL_STACK_SEGMENTS)
+	{
+		segments = stackSegments;
+	}
+	else if((segments = (ILSysIOBuffer *)ILMalloc
+				(sizeof(ILSysIOBuffer) * num)) == 0)
+	{
+		ILExecThreadThrowOutOfMemory(thread);
+		return -1;
+	}
+	arrays = (System_Array **)ArrayToBuffer(buffers);
+	offs = (ILInt32 *)ArrayToBuffer(offsets);
+	lens = (ILInt32 *)ArrayToBuffer(counts);
+	for(posn = 0; posn < num; ++posn)
+	{
+		segments[posn].data =
+			((ILUInt8 *)(ArrayToBuffer(arrays[posn]))) + offs[posn];
+		segments[posn].length = lens[posn];
+	}
+
+	/* Perform the operation */
+	if(sending)
+	{
+		result = ILSysIOSocketSendV((ILSysIOHandle)handle, segments,
+									num, flags);
+	}
+	else
+	{
+		for(;;)
+		{
+			mayProtect = 0;
+			for(posn = 0; posn < num; ++posn)
+			{
+				mayProtect |= ILGCPrepareWrite
+					(segments[posn].data,
+					 (unsigned long)(segments[posn].length));
+			}
+			result = ILSysIOSocketReceiveV((ILSysIOHandle)handle, segments,
+										   num, flags);
+			if(result >= 0 || !mayProtect ||
+			   ILSysIOGetErrno() != IL_ERRNO_EFAULT)
+			{
+				break;
+			}
+		}
+	}
+	if(segments != stackSegments)
+	{
+		ILFree(segments);
+	}
+	return result;
+}
+
+/*
+ * public static int SendV(IntPtr handle, byte[][] buffers,
+ *						   int[] offsets, int[] counts, int flags);
+ */
+ILInt32 _IL_SocketMethods_SendV(ILExecThread *_thread, ILNativeInt handle,
+								System_Array *buffers, System_Array *offsets,
+								System_Array *counts, ILInt32 flags)
+{
+	return SocketVector(_thread, handle, buffers, offsets, counts, flags, 1);
+}
+
+/*
+ * public static int ReceiveV(IntPtr handle, byte[][] buffers,
+ *							  int[] offsets, int[] counts, int flags);
+ */
+ILInt32 _IL_SocketMethods_ReceiveV(ILExecThread *_thread, ILNativeInt handle,
+								   System_Array *buffers,
+								   System_Array *offsets,
+								   System_Array *counts, ILInt32 flags)
+{
+	return SocketVector(_thread, handle, buffers, offsets, counts, flags, 0);
+}
+
+/*
+ * public static long SendFile(IntPtr handle, IntPtr file,
+ *							   long offset, long count);
+ */
+ILInt64 _IL_SocketMethods_SendFile(ILExecThread *_thread, ILNativeInt handle,
+								   ILNativeInt file, ILInt64 offset,
+								   ILInt64 count)
+{
+	return ILSysIOSocketSendFile((ILSysIOHandle)handle, (ILSysIOHandle)file,
+								 offset, count);
+}
+
 ILBool _IL_SocketMethods_Close(ILExecThread *_thread, ILNativeInt handle)
 {
+	_ILExecProcessUnwatchHandle(_ILExecThreadProcess(_thread), handle);
 	return (ILBool)(ILSysIOSocketClose((ILSysIOHandle)handle));
 }
 
@@ -224,6 +341,90 @@ ILInt32 _IL_SocketMethods_Select(ILExecThread *_thread,
 		 (errorarray ? ArrayLength(errorarray) : 0), timeout);
 }
 
+/*
+ * public static IntPtr PollSetCreate();
+ */
+ILNativeInt _IL_SocketMethods_PollSetCreate(ILExecThread *_thread)
+{
+	return (ILNativeInt)ILSysIOPollSetCreate();
+}
+
+/*
+ * public static void PollSetDestroy(IntPtr pollSet);
+ */
+void _IL_SocketMethods_PollSetDestroy(ILExecThread *_thread,
+									  ILNativeInt pollSet)
+{
+	if(pollSet)
+	{
+		ILSysIOPollSetDestroy((ILSysIOPollSet *)pollSet);
+	}
+}
+
+/*
+ * public static void PollSetWakeup(IntPtr pollSet);
+ */
+void _IL_SocketMethods_PollSetWakeup(ILExecThread *_thread,
+									 ILNativeInt pollSet)
+{
+	if(pollSet)
+	{
+		ILSysIOPollSetWakeup((ILSysIOPollSet *)pollSet);
+	}
+}
+
+/*
+ * public static bool PollSetAdd(IntPtr pollSet, IntPtr handle,
+ *								 int events, int id);
+ */
+ILBool _IL_SocketMethods_PollSetAdd(ILExecThread *_thread,
+									ILNativeInt pollSet,
+									ILNativeInt handle,
+									ILInt32 events,
+									ILInt32 id)
+{
+	return (ILBool)ILSysIOPollSetAdd
+		((ILSysIOPollSet *)pollSet, (ILSysIOHandle)handle, events, id);
+}
+
+/*
+ * public static bool PollSetRemove(IntPtr pollSet, IntPtr handle);
+ */
+ILBool _IL_SocketMethods_PollSetRemove(ILExecThread *_thread,
+									   ILNativeInt pollSet,
+									   ILNativeInt handle)
+{
+	return (ILBool)ILSysIOPollSetRemove
+		((ILSysIOPollSet *)pollSet, (ILSysIOHandle)handle);
+}
+
+/*
+ * public static int PollSetWait(IntPtr pollSet, int[] ids,
+ *								 int[] events, long timeout);
+ */
+ILInt32 _IL_SocketMethods_PollSetWait(ILExecThread *_thread,
+									  ILNativeInt pollSet,
+									  System_Array *ids,
+									  System_Array *events,
+									  ILInt64 timeout)
+{
+	ILInt32 maxEvents;
+
+	if(!ids || !events)
+	{
+		ILExecThreadThrowArgNull(_thread, (!ids ? "ids" : "events"));
+		return -1;
+	}
+	maxEvents = ArrayLength(ids);
+	if(ArrayLength(events) < maxEvents)
+	{
+		maxEvents = ArrayLength(events);
+	}
+	return ILSysIOPollSetWait
+		((ILSysIOPollSet *)pollSet, (ILInt32 *)(ArrayToBuffer(ids)),
+		 (ILInt32 *)(ArrayToBuffer(events)), maxEvents, timeout);
+}
+
 /*
  * public static bool SetBlocking(IntPtr handle, bool blocking);
  */
@@ -413,6 +614,27 @@ ILBool _IL_SocketMethods_QueueCompletionItem(ILExecThread *_thread,
 	return result;
 }
 
+/*
+ * public static bool QueueCompletionOnReady(IntPtr handle, bool write,
+ *											 AsyncCallback callback,
+ *											 IAsyncResult state);
+ */
+ILBool _IL_SocketMethods_QueueCompletionOnReady(ILExecThread *_thread,
+												ILNativeInt handle,
+												ILBool write,
+												ILObject *callback,
+												ILObject *state)
+{
+	/* This provides backdoor access to "ThreadPool.QueueCompletionOnReady",
+	   which cannot be called directly from C# code due to security checks */
+	ILBool result = 0;
+	ILExecThreadCallNamed(_thread, "System.Threading.ThreadPool",
+						  "QueueCompletionOnReady",
+						  "(jZoSystem.AsyncCallback;oSystem.IAsyncResult;)Z",
+						  &result, handle, (ILVaInt)write, callback, state);
+	return result;
+}
+
 /*
  * public static WaitHandle CreateManualResetEvent();
  */
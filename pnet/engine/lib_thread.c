@@ -433,6 +433,10 @@ void _IL_Thread_InternalSleep(ILExecThread *thread, ILInt32 timeout)
 			"System.ArgumentOutOfRangeException", (const char *)0);
 	}
 	
+	if(timeout != 0)
+	{
+		_ILExecThreadShrinkStack(thread);
+	}
 	result = ILThreadSleep((ILUInt32)timeout);
 	_ILExecThreadHandleError(thread, result);
 }
@@ -885,6 +889,10 @@ ILBool _IL_WaitHandle_InternalWaitAll(ILExecThread *_thread,
 	handles = (ILWaitHandle **)ArrayToBuffer(waitHandles);
 
 	/* Perform the wait */
+	if(timeout != 0)
+	{
+		_ILExecThreadShrinkStack(_thread);
+	}
 	result = ILWaitAll(handles, (ILUInt32)(ArrayLength(waitHandles)), timeout);
 
 	if (result == IL_WAIT_TIMEOUT)
@@ -924,6 +932,10 @@ ILInt32 _IL_WaitHandle_InternalWaitAny(ILExecThread *_thread,
 	handles = (ILWaitHandle **)ArrayToBuffer(waitHandles);
 
 	/* Perform the wait */
+	if(timeout != 0)
+	{
+		_ILExecThreadShrinkStack(_thread);
+	}
 	result = ILWaitAny(handles, (ILUInt32)(ArrayLength(waitHandles)), timeout);
 
 	if (result == IL_WAIT_TIMEOUT)
@@ -949,7 +961,12 @@ ILBool _IL_WaitHandle_InternalWaitOne(ILExecThread *_thread,
 {
 	if(privateData)
 	{
-		int result = ILWaitOne((ILWaitHandle *)privateData, timeout);
+		int result;
+		if(timeout != 0)
+		{
+			_ILExecThreadShrinkStack(_thread);
+		}
+		result = ILWaitOne((ILWaitHandle *)privateData, timeout);
 		_ILExecThreadHandleWaitResult(_thread, result);
 		return (result == 0);
 	}
@@ -1067,6 +1084,294 @@ void _IL_BlockingOperation_ThreadSigAbort(ILExecThread * _thread, ILObject * thr
 	}
 }
 
+/*
+ * Internal ThreadPool methods.
+ */
+
+/*
+ * Kinds of native thread pools.  These must match "ThreadPool.cs".
+ */
+#define	IL_THREADPOOL_WORKER		0
+#define	IL_THREADPOOL_COMPLETION	1
+
+/*
+ * Prepare a new pool worker thread to run managed code.
+ */
+static int ThreadPoolWorkerStart(void *userData)
+{
+	ILExecProcess *process = (ILExecProcess *)userData;
+	ILExecThread *thread;
+
+	thread = ILThreadRegisterForManagedExecution(process, ILThreadSelf());
+	if(!thread)
+	{
+		/* The process is unloading */
+		return 0;
+	}
+
+#ifdef IL_USE_JIT
+	/* Set the exception handler which converts builtin
+	   libjit exceptions into clr exceptions */
+	jit_exception_set_handler(_ILJitExceptionHandler);
+#endif
+
+	/* Let the class library flag the thread as a pool thread */
+	if(ILExecThreadCallNamed(thread, "System.Threading.ThreadPool",
+							 "InitializeWorker", "()V", (void *)0))
+	{
+		_ILExecThreadClearException(thread);
+	}
+	return 1;
+}
+
+/*
+ * Run a work item on a pool worker thread.
+ */
+static int ThreadPoolWorkerRun(void *userData, void *item)
+{
+	ILExecProcess *process = (ILExecProcess *)userData;
+	ILExecThread *thread = ILExecThreadCurrent();
+	ILObject *exception;
+
+	ILExecThreadCall(thread, process->workItemExecute, (void *)0,
+					 (ILObject *)item);
+
+	/* "WorkItem.Execute" catches everything except thread aborts */
+	if(_ILExecThreadHasException(thread))
+	{
+		exception = _ILExecThreadGetException(thread);
+		if(ILExecThreadIsThreadAbortException(thread, exception))
+		{
+			/* Let the pool replace this thread */
+			return 1;
+		}
+		ILExecThreadPrintException(thread);
+		_ILExecThreadClearException(thread);
+	}
+	return (process->state >= _IL_PROCESS_STATE_UNLOADING);
+}
+
+/*
+ * Get a native thread pool of the current process, creating it
+ * on first use.
+ */
+static ILThreadPool *GetThreadPool(ILExecThread *_thread, ILInt32 kind)
+{
+	ILExecProcess *process = _ILExecThreadProcess(_thread);
+	ILThreadPool * volatile *pool;
+
+	if(kind == IL_THREADPOOL_COMPLETION)
+	{
+		pool = &(process->completionPool);
+	}
+	else
+	{
+		pool = &(process->workerPool);
+	}
+	if(!ILInterlockedLoadP_Acquire((void * const volatile *)pool))
+	{
+		ILMutexLock(process->lock);
+		if(!(*pool) && process->state < _IL_PROCESS_STATE_UNLOADING)
+		{
+			ILInterlockedStoreP_Release
+				((void * volatile *)pool,
+				 ILThreadPoolCreate(ThreadPoolWorkerStart,
+				 					ThreadPoolWorkerRun, process));
+		}
+		ILMutexUnlock(process->lock);
+	}
+	return *pool;
+}
+
+/*
+ * Resolve "WorkItem.Execute" the first time that a work item is queued.
+ */
+static int ResolveWorkItemExecute(ILExecThread *_thread, ILObject *item)
+{
+	ILExecProcess *process = _ILExecThreadProcess(_thread);
+	ILMethod *method;
+
+	if(!item)
+	{
+		ILExecThreadThrowArgNull(_thread, "item");
+		return 0;
+	}
+	if(ILInterlockedLoadP_Acquire
+			((void * const volatile *)&(process->workItemExecute)))
+	{
+		return 1;
+	}
+	method = ILExecThreadLookupMethodInClass
+		(_thread, GetObjectClass(item), "Execute", "(T)V");
+	if(!method)
+	{
+		ILExecThreadThrowSystem(_thread, "System.MissingMethodException",
+								(const char *)0);
+		return 0;
+	}
+	ILMutexLock(process->lock);
+	if(!(process->workItemExecute))
+	{
+		ILInterlockedStoreP_Release
+			((void * volatile *)&(process->workItemExecute), method);
+	}
+	ILMutexUnlock(process->lock);
+	return 1;
+}
+
+/*
+ * private static bool InternalQueueWorkItem(Object item, int pool);
+ */
+ILBool _IL_ThreadPool_InternalQueueWorkItem(ILExecThread *_thread,
+											ILObject *item, ILInt32 kind)
+{
+	ILThreadPool *pool;
+
+	if(!ResolveWorkItemExecute(_thread, item))
+	{
+		return 0;
+	}
+	if((pool = GetThreadPool(_thread, kind)) == 0)
+	{
+		return 0;
+	}
+	return (ILBool)ILThreadPoolQueue(pool, item);
+}
+
+/*
+ * Queue a work item whose handle became ready onto the completion pool.
+ * This is called on one of the reactor's completion threads.
+ */
+static void ReactorReady(void *userData, void *cookie)
+{
+	ILExecProcess *process = (ILExecProcess *)userData;
+	ILThreadPool *pool;
+
+	pool = (ILThreadPool *)ILInterlockedLoadP_Acquire
+		((void * const volatile *)&(process->completionPool));
+	if(pool)
+	{
+		/* This only fails if the process is unloading */
+		ILThreadPoolQueue(pool, cookie);
+	}
+}
+
+/*
+ * private static bool InternalWatchHandle(IntPtr handle, bool write,
+ *										   Object item);
+ */
+ILBool _IL_ThreadPool_InternalWatchHandle(ILExecThread *_thread,
+										  ILNativeInt handle, ILBool write,
+										  ILObject *item)
+{
+	ILExecProcess *process = _ILExecThreadProcess(_thread);
+
+	/* The completion pool must exist before the reactor can fire */
+	if(!ILSysIOHasAsync())
+	{
+		/* No readiness notification on this platform */
+		return 0;
+	}
+	if(!ResolveWorkItemExecute(_thread, item) ||
+	   !GetThreadPool(_thread, IL_THREADPOOL_COMPLETION))
+	{
+		return 0;
+	}
+	if(!ILInterlockedLoadP_Acquire
+			((void * const volatile *)&(process->reactor)))
+	{
+		ILMutexLock(process->lock);
+		if(!(process->reactor) && process->state < _IL_PROCESS_STATE_UNLOADING)
+		{
+			ILInterlockedStoreP_Release
+				((void * volatile *)&(process->reactor),
+				 ILSysIOReactorCreate(ReactorReady, process, 0));
+		}
+		ILMutexUnlock(process->lock);
+		if(!(process->reactor))
+		{
+			/* No readiness notification on this platform */
+			return 0;
+		}
+	}
+	return (ILBool)ILSysIOReactorWatch
+		(process->reactor, (ILSysIOHandle)handle,
+		 (write ? IL_REACTOR_WRITE : IL_REACTOR_READ), item);
+}
+
+/*
+ * Stop watching a handle that is about to be closed.  Pending
+ * operations on the handle are queued, so that they can fail.
+ */
+void _ILExecProcessUnwatchHandle(ILExecProcess *process, ILNativeInt handle)
+{
+	ILSysIOReactor *reactor;
+
+	reactor = (ILSysIOReactor *)ILInterlockedLoadP_Acquire
+		((void * const volatile *)&(process->reactor));
+	if(reactor)
+	{
+		ILSysIOReactorUnwatch(reactor, (ILSysIOHandle)handle);
+	}
+}
+
+/*
+ * private static int InternalGetMinThreads(int pool);
+ */
+ILInt32 _IL_ThreadPool_InternalGetMinThreads(ILExecThread *_thread,
+											 ILInt32 kind)
+{
+	ILThreadPool *pool = GetThreadPool(_thread, kind);
+	return (pool ? ILThreadPoolGetMinThreads(pool) : 1);
+}
+
+/*
+ * private static int InternalGetMaxThreads(int pool);
+ */
+ILInt32 _IL_ThreadPool_InternalGetMaxThreads(ILExecThread *_thread,
+											 ILInt32 kind)
+{
+	ILThreadPool *pool = GetThreadPool(_thread, kind);
+	return (pool ? ILThreadPoolGetMaxThreads(pool) : 1);
+}
+
+/*
+ * private static int InternalGetAvailableThreads(int pool);
+ */
+ILInt32 _IL_ThreadPool_InternalGetAvailableThreads(ILExecThread *_thread,
+												   ILInt32 kind)
+{
+	ILThreadPool *pool = GetThreadPool(_thread, kind);
+	int numBusy;
+
+	if(!pool)
+	{
+		return 0;
+	}
+	ILThreadPoolGetCounts(pool, 0, &numBusy, 0);
+	return ILThreadPoolGetMaxThreads(pool) - numBusy;
+}
+
+/*
+ * private static bool InternalSetMinThreads(int pool, int count);
+ */
+ILBool _IL_ThreadPool_InternalSetMinThreads(ILExecThread *_thread,
+											ILInt32 kind, ILInt32 count)
+{
+	ILThreadPool *pool = GetThreadPool(_thread, kind);
+	return (ILBool)(pool ? ILThreadPoolSetMinThreads(pool, count) : 0);
+}
+
+/*
+ * private static bool InternalSetMaxThreads(int pool, int count);
+ */
+ILBool _IL_ThreadPool_InternalSetMaxThreads(ILExecThread *_thread,
+											ILInt32 kind, ILInt32 count)
+{
+	ILThreadPool *pool = GetThreadPool(_thread, kind);
+	return (ILBool)(pool ? ILThreadPoolSetMaxThreads(pool, count) : 0);
+}
+
 #ifdef	__cplusplus
 };
 #endif
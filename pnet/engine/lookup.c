@@ -66,6 +66,7 @@ An example of a signature:
 */
 
 #include "engine.h"
+#include "interlocked.h"
 
 #ifdef	__cplusplus
 extern	"C" {
@@ -710,12 +711,307 @@ static int MatchSignatureName(ILType *signature, const char *name)
 	}
 }
 
+/*
+ * Size of the per-process call site hash table.
+ */
+#ifdef IL_CONFIG_REDUCE_DATA
+#define	IL_CALL_SITE_HASH_SIZE		16
+#else
+#define	IL_CALL_SITE_HASH_SIZE		256
+#endif
+
+/*
+ * Determine how an argument of a particular type is passed,
+ * for the layout of a call site.
+ */
+static ILUInt32 CallSiteArgKind(ILExecThread *thread, ILType *paramType)
+{
+	paramType = ILTypeGetEnumType(paramType);
+	if(ILType_IsPrimitive(paramType))
+	{
+		switch(ILType_ToElement(paramType))
+		{
+			case IL_META_ELEMTYPE_VOID:			return 0;
+			case IL_META_ELEMTYPE_BOOLEAN:
+			case IL_META_ELEMTYPE_I1:			return IL_CALL_ARG_I1;
+			case IL_META_ELEMTYPE_U1:			return IL_CALL_ARG_U1;
+			case IL_META_ELEMTYPE_I2:			return IL_CALL_ARG_I2;
+			case IL_META_ELEMTYPE_U2:
+			case IL_META_ELEMTYPE_CHAR:			return IL_CALL_ARG_U2;
+			case IL_META_ELEMTYPE_I4:			return IL_CALL_ARG_I4;
+			case IL_META_ELEMTYPE_U4:			return IL_CALL_ARG_U4;
+			case IL_META_ELEMTYPE_I8:			return IL_CALL_ARG_I8;
+			case IL_META_ELEMTYPE_U8:			return IL_CALL_ARG_U8;
+		#ifdef IL_NATIVE_INT32
+			case IL_META_ELEMTYPE_I:			return IL_CALL_ARG_I4;
+			case IL_META_ELEMTYPE_U:			return IL_CALL_ARG_U4;
+		#else
+			case IL_META_ELEMTYPE_I:			return IL_CALL_ARG_I8;
+			case IL_META_ELEMTYPE_U:			return IL_CALL_ARG_U8;
+		#endif
+			case IL_META_ELEMTYPE_R4:			return IL_CALL_ARG_R4;
+			case IL_META_ELEMTYPE_R8:			return IL_CALL_ARG_R8;
+			case IL_META_ELEMTYPE_R:			return IL_CALL_ARG_R;
+			case IL_META_ELEMTYPE_TYPEDBYREF:	return IL_CALL_ARG_TYPEDREF;
+		}
+		return 0;
+	}
+	else if(ILType_IsValueType(paramType))
+	{
+		return IL_CALL_ARG_VALUE |
+			   (ILSizeOfType(thread, paramType) << IL_CALL_ARG_SIZE_SHIFT);
+	}
+	else
+	{
+		/* Object references, pointers and everything else */
+		return IL_CALL_ARG_PTR;
+	}
+}
+
+/*
+ * Create a call site for a method that has been found by name.
+ */
+static ILExecCallSite *CreateCallSite(ILExecThread *thread, ILMethod *method,
+									  const char *typeName,
+									  const char *methodName,
+									  const char *signature,
+									  unsigned long hash)
+{
+	ILType *methodSignature = ILMethod_Signature(method);
+	ILUInt32 numParams = ILTypeNumParams(methodSignature);
+	int typeNameLen = strlen(typeName) + 1;
+	int methodNameLen = strlen(methodName) + 1;
+	int signatureLen = strlen(signature) + 1;
+	ILExecCallSite *site;
+	char *names;
+	ILUInt32 param, kind;
+
+	/* Allocate the call site with its layout and names in one block */
+	site = (ILExecCallSite *)ILMalloc
+		(sizeof(ILExecCallSite) + numParams * sizeof(ILUInt32) +
+		 typeNameLen + methodNameLen + signatureLen);
+	if(!site)
+	{
+		return 0;
+	}
+	names = (char *)(&(site->args[numParams + 1]));
+	ILMemCpy(names, typeName, typeNameLen);
+	site->typeName = names;
+	names += typeNameLen;
+	ILMemCpy(names, methodName, methodNameLen);
+	site->methodName = names;
+	names += methodNameLen;
+	ILMemCpy(names, signature, signatureLen);
+	site->signature = names;
+	site->next = 0;
+	site->hash = hash;
+	site->method = method;
+	site->classReady = 0;
+
+	/* Work out how each argument is passed, so that calls through
+	   the site don't need to walk the signature again */
+	site->numArgs = 0;
+	for(param = 1; param <= numParams; ++param)
+	{
+		kind = CallSiteArgKind(thread, ILTypeGetParam(methodSignature, param));
+		if(kind != 0)
+		{
+			site->args[(site->numArgs)++] = kind;
+		}
+	}
+	return site;
+}
+
+/*
+ * Hash the names that identify a call site.
+ */
+static unsigned long CallSiteHash(const char *typeName,
+								  const char *methodName,
+								  const char *signature)
+{
+	unsigned long hash;
+	hash = ILHashString(0, typeName, -1);
+	hash = ILHashString(hash, methodName, -1);
+	return ILHashString(hash, signature, -1);
+}
+
+/*
+ * Find a call site that was already resolved.  The table and its
+ * buckets are only ever added to, so no lock is needed here.
+ */
+static ILExecCallSite *FindCallSite(ILExecProcess *process,
+									const char *typeName,
+									const char *methodName,
+									const char *signature,
+									unsigned long hash)
+{
+	ILExecCallSite * volatile *table;
+	ILExecCallSite *site;
+
+	table = (ILExecCallSite * volatile *)ILInterlockedLoadP_Acquire
+		((void * const volatile *)&(process->callSiteHash));
+	if(!table)
+	{
+		return 0;
+	}
+	site = (ILExecCallSite *)ILInterlockedLoadP_Acquire
+		((void * const volatile *)
+			&(table[hash & (IL_CALL_SITE_HASH_SIZE - 1)]));
+	while(site != 0)
+	{
+		if(site->hash == hash && !strcmp(site->signature, signature) &&
+		   !strcmp(site->methodName, methodName) &&
+		   !strcmp(site->typeName, typeName))
+		{
+			return site;
+		}
+		site = site->next;
+	}
+	return 0;
+}
+
+/*
+ * Resolve a method by name through the call site cache, creating
+ * a new call site if the method has not been resolved before.
+ */
+static ILExecCallSite *ResolveCallSite(ILExecThread *thread,
+									   const char *typeName,
+									   const char *methodName,
+									   const char *signature)
+{
+	ILExecProcess *process;
+	ILExecCallSite * volatile *table;
+	ILExecCallSite *site;
+	ILClass *classInfo;
+	ILMethod *method;
+	unsigned long hash;
+
+	/* Sanity-check the arguments */
+	if(!thread || !typeName || !methodName || !signature)
+	{
+		return 0;
+	}
+	process = _ILExecThreadProcess(thread);
+
+	/* Look for a call site that was already resolved */
+	hash = CallSiteHash(typeName, methodName, signature);
+	site = FindCallSite(process, typeName, methodName, signature, hash);
+	if(site)
+	{
+		return site;
+	}
+
+	/* Resolve the method the slow way.  Failures are not cached,
+	   because the type may be loaded later */
+	classInfo = ILExecThreadLookupClass(thread, typeName);
+	method = ILExecThreadLookupMethodInClass
+		(thread, classInfo, methodName, signature);
+	if(!method)
+	{
+		return 0;
+	}
+	site = CreateCallSite(thread, method, typeName, methodName,
+						  signature, hash);
+	if(!site)
+	{
+		return 0;
+	}
+
+	/* Add the call site to the table.  Another thread may have
+	   beaten us to it, in which case we use its call site instead */
+	ILMutexLock(process->lock);
+	if(!(process->callSiteHash))
+	{
+		table = (ILExecCallSite * volatile *)ILCalloc
+			(IL_CALL_SITE_HASH_SIZE, sizeof(ILExecCallSite *));
+		if(!table)
+		{
+			ILMutexUnlock(process->lock);
+			ILFree(site);
+			return 0;
+		}
+		ILInterlockedStoreP_Release
+			((void * volatile *)&(process->callSiteHash), (void *)table);
+	}
+	table = process->callSiteHash;
+	hash &= (IL_CALL_SITE_HASH_SIZE - 1);
+	{
+		ILExecCallSite *existing = table[hash];
+		while(existing != 0)
+		{
+			if(existing->hash == site->hash &&
+			   !strcmp(existing->signature, signature) &&
+			   !strcmp(existing->methodName, methodName) &&
+			   !strcmp(existing->typeName, typeName))
+			{
+				ILMutexUnlock(process->lock);
+				ILFree(site);
+				return existing;
+			}
+			existing = existing->next;
+		}
+	}
+	site->next = table[hash];
+	ILInterlockedStoreP_Release((void * volatile *)&(table[hash]), site);
+	ILMutexUnlock(process->lock);
+	return site;
+}
+
+ILExecCallSite *ILExecThreadResolveMethod(ILExecThread *thread,
+										  const char *typeName,
+										  const char *methodName,
+										  const char *signature)
+{
+	return ResolveCallSite(thread, typeName, methodName, signature);
+}
+
+ILMethod *ILExecCallSiteGetMethod(ILExecCallSite *site)
+{
+	return (site ? site->method : 0);
+}
+
+void _ILExecCallSiteDestroy(ILExecProcess *process)
+{
+	ILExecCallSite *site, *next;
+	ILUInt32 posn;
+
+	if(process->callSiteHash)
+	{
+		for(posn = 0; posn < IL_CALL_SITE_HASH_SIZE; ++posn)
+		{
+			site = process->callSiteHash[posn];
+			while(site != 0)
+			{
+				next = site->next;
+				ILFree(site);
+				site = next;
+			}
+		}
+		ILFree((void *)(process->callSiteHash));
+		process->callSiteHash = 0;
+	}
+}
+
 ILMethod *ILExecThreadLookupMethod(ILExecThread *thread,
 								   const char *typeName,
 								   const char *methodName,
 								   const char *signature)
 {
+	ILExecCallSite *site;
 	ILClass *classInfo;
+
+	/* Use a call site if the method was already resolved, but don't
+	   create one: only the call site API needs to keep them */
+	if(thread && typeName && methodName && signature)
+	{
+		site = FindCallSite(_ILExecThreadProcess(thread), typeName,
+							methodName, signature,
+							CallSiteHash(typeName, methodName, signature));
+		if(site)
+		{
+			return site->method;
+		}
+	}
 	classInfo = ILExecThreadLookupClass(thread, typeName);
 	return ILExecThreadLookupMethodInClass
 			(thread, classInfo, methodName, signature);
@@ -20,6 +20,7 @@
 
 #include "engine.h"
 #include "lib_defs.h"
+#include "interlocked.h"
 #if defined(IL_WIN32_PLATFORM)
 #include <objbase.h>
 #endif
@@ -68,6 +69,148 @@ extern	"C" {
 	#define ILFreeNativeString(str) do { ; } while (0)
 #endif
 
+/*
+ * Cache of "ffi" descriptors that have already been built for
+ * PInvoke and "internalcall" methods, constructors and structures.
+ * The converter is re-run on the same method whenever the coder's
+ * cache is flushed, so we hand back the existing descriptor rather
+ * than rebuilding it (and leaking the previous one).  Lookups are
+ * lock-free; insertions are done under the process lock.
+ */
+#ifdef IL_CONFIG_REDUCE_DATA
+#define	IL_FFI_CACHE_SIZE		16
+#else
+#define	IL_FFI_CACHE_SIZE		256
+#endif
+#define	IL_FFI_CACHE_METHOD		0
+#define	IL_FFI_CACHE_CTOR		2
+#define	IL_FFI_CACHE_STRUCT		4
+typedef struct _tagILFFICacheEntry ILFFICacheEntry;
+struct _tagILFFICacheEntry
+{
+	ILFFICacheEntry * volatile next;
+	void			   *item;
+	int					kind;
+	void			   *descr;
+};
+
+/*
+ * Compute the hash bucket for a program item.
+ */
+#define	FFICacheHash(item,kind)	\
+			((((ILNativeUInt)(item)) >> 3) + (ILNativeUInt)(kind))
+
+/*
+ * Look up a cached descriptor.  Returns NULL if not cached.
+ */
+static void *FFICacheLookup(ILExecProcess *process, void *item, int kind)
+{
+	ILFFICacheEntry * volatile *table;
+	ILFFICacheEntry *entry;
+
+	table = (ILFFICacheEntry * volatile *)ILInterlockedLoadP_Acquire
+		((void * const volatile *)&(process->ffiCache));
+	if(!table)
+	{
+		return 0;
+	}
+	entry = (ILFFICacheEntry *)ILInterlockedLoadP_Acquire
+		((void * const volatile *)&(table[FFICacheHash(item, kind) &
+										  (IL_FFI_CACHE_SIZE - 1)]));
+	while(entry != 0)
+	{
+		if(entry->item == item && entry->kind == kind)
+		{
+			return entry->descr;
+		}
+		entry = entry->next;
+	}
+	return 0;
+}
+
+/*
+ * Add a newly built descriptor to the cache.  If another thread
+ * got there first, then "descr" is freed and the existing one is
+ * returned instead.  Returns NULL if out of memory.
+ */
+static void *FFICacheAdd(ILExecProcess *process, void *item,
+						 int kind, void *descr)
+{
+	ILFFICacheEntry * volatile *table;
+	ILFFICacheEntry *entry;
+	ILNativeUInt hash;
+
+	ILMutexLock(process->lock);
+	table = (ILFFICacheEntry * volatile *)(process->ffiCache);
+	if(!table)
+	{
+		table = (ILFFICacheEntry * volatile *)ILCalloc
+			(IL_FFI_CACHE_SIZE, sizeof(ILFFICacheEntry *));
+		if(!table)
+		{
+			ILMutexUnlock(process->lock);
+			ILFree(descr);
+			return 0;
+		}
+		ILInterlockedStoreP_Release
+			((void * volatile *)&(process->ffiCache), (void *)table);
+	}
+	hash = FFICacheHash(item, kind) & (IL_FFI_CACHE_SIZE - 1);
+	entry = table[hash];
+	while(entry != 0)
+	{
+		if(entry->item == item && entry->kind == kind)
+		{
+			ILMutexUnlock(process->lock);
+			ILFree(descr);
+			return entry->descr;
+		}
+		entry = entry->next;
+	}
+	entry = (ILFFICacheEntry *)ILMalloc(sizeof(ILFFICacheEntry));
+	if(!entry)
+	{
+		ILMutexUnlock(process->lock);
+		ILFree(descr);
+		return 0;
+	}
+	entry->item = item;
+	entry->kind = kind;
+	entry->descr = descr;
+	entry->next = table[hash];
+	ILInterlockedStoreP_Release
+		((void * volatile *)&(table[hash]), (void *)entry);
+	ILMutexUnlock(process->lock);
+	return descr;
+}
+
+void _ILFFICacheDestroy(ILExecProcess *process)
+{
+	ILFFICacheEntry * volatile *table;
+	ILFFICacheEntry *entry;
+	ILFFICacheEntry *next;
+	int hash;
+
+	table = (ILFFICacheEntry * volatile *)(process->ffiCache);
+	if(!table)
+	{
+		return;
+	}
+	for(hash = 0; hash < IL_FFI_CACHE_SIZE; ++hash)
+	{
+		entry = table[hash];
+		while(entry != 0)
+		{
+			next = entry->next;
+			ILFree(entry->descr);
+			ILFree(entry);
+			entry = next;
+		}
+	}
+	ILFree((void *)table);
+	process->ffiCache = 0;
+}
+
 /*
  * Structure type for passing typed references on the stack.
  */
@@ -166,6 +309,14 @@ static ffi_type *StructToFFI(ILExecProcess *process, ILClass *classInfo)
 	ILUInt32 explicitSize;
 	ILUInt32 explicitAlignment;
 
+	/* Use the descriptor from a previous conversion if possible */
+	descr = (ffi_type *)FFICacheLookup
+		(process, classInfo, IL_FFI_CACHE_STRUCT);
+	if(descr)
+	{
+		return descr;
+	}
+
 	/* Count the number of non-static fields in the class */
 	numFields = 0;
 	if(!ILClass_IsExplicitLayout(classInfo))
@@ -220,8 +371,9 @@ static ffi_type *StructToFFI(ILExecProcess *process, ILClass *classInfo)
 		}
 	}
 
-	/* Return the descriptor to the caller */
-	return descr;
+	/* Cache the descriptor and return it to the caller */
+	return (ffi_type *)FFICacheAdd(process, classInfo,
+								   IL_FFI_CACHE_STRUCT, descr);
 #else
 	char *name = ILTypeToName(ILType_FromValueType(classInfo));
 	if(name)
@@ -303,6 +455,14 @@ void *_ILMakeCifForMethod(ILExecProcess *process, ILMethod *method, int isIntern
 	ILUInt32 arg;
 	ILUInt32 param;
 
+	/* Reuse the "cif" from a previous conversion of this method */
+	cif = (ffi_cif *)FFICacheLookup
+		(process, method, IL_FFI_CACHE_METHOD + (isInternal != 0));
+	if(cif)
+	{
+		return (void *)cif;
+	}
+
 	/* Determine the number of argument blocks that we need */
 	numArgs = numParams = ILTypeNumParams(signature);
 	if(ILType_HasThis(signature))
@@ -371,11 +531,13 @@ void *_ILMakeCifForMethod(ILExecProcess *process, ILMethod *method, int isIntern
 	{
 		fprintf(stderr, "Cannot marshal a type in the definition of %s::%s\n",
 				ILClass_Name(ILMethod_Owner(method)), ILMethod_Name(method));
+		ILFree(cif);
 		return 0;
 	}
 
-	/* Ready to go */
-	return (void *)cif;
+	/* Cache the "cif" so that later conversions can share it */
+	return FFICacheAdd(process, method,
+					    IL_FFI_CACHE_METHOD + (isInternal != 0), cif);
 }
 
 void *_ILMakeCifForConstructor(ILExecProcess *process, ILMethod *method, int isInternal)
@@ -389,6 +551,14 @@ void *_ILMakeCifForConstructor(ILExecProcess *process, ILMethod *method, int isI
 	ILUInt32 arg;
 	ILUInt32 param;
 
+	/* Reuse the "cif" from a previous conversion of this method */
+	cif = (ffi_cif *)FFICacheLookup
+		(process, method, IL_FFI_CACHE_CTOR + (isInternal != 0));
+	if(cif)
+	{
+		return (void *)cif;
+	}
+
 	/* Determine the number of argument blocks that we need */
 	numArgs = numParams = ILTypeNumParams(signature);
 	if(isInternal)
@@ -437,11 +607,13 @@ void *_ILMakeCifForConstructor(ILExecProcess *process, ILMethod *method, int isI
 	{
 		fprintf(stderr, "Cannot marshal a type in the definition of %s::%s\n",
 				ILClass_Name(ILMethod_Owner(method)), ILMethod_Name(method));
+		ILFree(cif);
 		return 0;
 	}
 
-	/* Ready to go */
-	return (void *)cif;
+	/* Cache the "cif" so that later conversions can share it */
+	return FFICacheAdd(process, method,
+					    IL_FFI_CACHE_CTOR + (isInternal != 0), cif);
 }
 
 #if FFI_CLOSURES
@@ -453,9 +625,13 @@ void *_ILMakeCifForConstructor(ILExecProcess *process, ILMethod *method, int isI
 			do { \
 				if((stacktop + (nwords)) > stacklimit) \
 				{ \
-					_ILExecThreadSetException(thread, _ILSystemException \
-						(thread, "System.StackOverflowException")); \
-					return 1; \
+					if(!_ILGrowStack(thread, stacktop, (nwords))) \
+					{ \
+						_ILExecThreadSetException(thread, _ILSystemException \
+							(thread, "System.StackOverflowException")); \
+						return 1; \
+					} \
+					stacklimit = thread->stackLimit; \
 				} \
 			} while (0)
 
@@ -182,7 +182,7 @@ static void _ILExecProcessUnloadInternal(ILExecProcess *process)
 
 	while(thread)
 	{
-		if(thread != process->finalizerThread &&
+		if(!thread->isFinalizerThread &&
 		   thread->supportThread &&
 		   thread->supportThread != self)
 		{
@@ -247,6 +247,8 @@ static void _ILExecProcessUnloadInternal(ILExecProcess *process)
 static void _ILExecProcessDestroyInternal(ILExecProcess *process,
 										  int isFinalizing)
 {
+	ILExecThread *finalizerThread;
+
 #ifdef PROCESS_DEBUG
 #ifndef REDUCED_STDIO
 	fprintf(stderr, "Start destroying process : %p\n", (void *)process);	
@@ -260,12 +262,34 @@ static void _ILExecProcessDestroyInternal(ILExecProcess *process,
 	/* during finalization. */
 	process->finalizationContext->process = 0;
 
-	/* Destroy the finalizer thread */
-	if (process->finalizerThread)
+	/* Destroy the reactor first, because it queues completions
+	   onto the completion thread pool */
+	if(process->reactor)
+	{
+		ILSysIOReactorDestroy(process->reactor);
+		process->reactor = 0;
+	}
+
+	/* Destroy the thread pools.  Their workers have exited or were
+	   aborted while the process was unloading */
+	if(process->workerPool)
+	{
+		ILThreadPoolDestroy(process->workerPool);
+		process->workerPool = 0;
+	}
+	if(process->completionPool)
+	{
+		ILThreadPoolDestroy(process->completionPool);
+		process->completionPool = 0;
+	}
+
+	/* Destroy the finalizer threads */
+	while ((finalizerThread = process->finalizerThread) != 0)
 	{
 		/* Only destroy the engine thread.  The support thread is shared by other
 		   engine processes and is destroyed when the engine is deinitialized */
-		_ILExecThreadDestroy(process->finalizerThread);
+		process->finalizerThread = finalizerThread->nextFinalizerThread;
+		_ILExecThreadDestroy(finalizerThread);
 	}
 
 #ifdef IL_DEBUGGER
@@ -315,6 +339,36 @@ static void _ILExecProcessDestroyInternal(ILExecProcess *process,
 		process->reflectionHash = 0;
 	}
 
+	if (process->attributeHash)
+	{
+		/* Destroy the main part of the decoded attribute hash table.
+		The rest will be cleaned up by the garbage collector */
+		ILGCFreePersistent(process->attributeHash);
+		process->attributeHash = 0;
+	}
+
+	/* Destroy the methods that were resolved by name */
+	_ILExecCallSiteDestroy(process);
+
+#if defined(HAVE_LIBFFI)
+	/* Destroy the cached "ffi" descriptors */
+	_ILFFICacheDestroy(process);
+#endif
+
+	/* Destroy the verification cache and the trusted assembly list */
+	_ILVerifyCacheDestroy(process);
+	if(process->trustedAssemblies)
+	{
+		int posn;
+		for(posn = 0; posn < process->numTrustedAssemblies; ++posn)
+		{
+			ILFree(process->trustedAssemblies[posn]);
+		}
+		ILFree(process->trustedAssemblies);
+		process->trustedAssemblies = 0;
+		process->numTrustedAssemblies = 0;
+	}
+
 #ifdef IL_CONFIG_PINVOKE
 	/* Destroy the loaded module list */
 	{
@@ -448,6 +502,14 @@ static ILExecProcess *_ILExecProcessCreateInternal(void)
 	ILGetCurrTime(&(process->startTime));
 	process->internHash = 0;
 	process->reflectionHash = 0;
+	process->attributeHash = 0;
+	process->callSiteHash = 0;
+	process->ffiCache = 0;
+	process->trustedAssemblies = 0;
+	process->numTrustedAssemblies = 0;
+	process->verifyImage = 0;
+	process->verifyImageTrusted = 0;
+	process->verifyCache = 0;
 	process->loadedModules = 0;
 	process->gcHandles = 0;
 	process->entryImage = 0;
@@ -458,6 +520,10 @@ static ILExecProcess *_ILExecProcessCreateInternal(void)
 	process->randomLastTime = 0;
 	process->randomCount = 0;
 	process->numThreadStaticSlots = 0;
+	process->workerPool = 0;
+	process->completionPool = 0;
+	process->workItemExecute = 0;
+	process->reactor = 0;
 	process->loadFlags = IL_LOADFLAG_FORCE_32BIT;
 #if IL_CONFIG_DEBUG_LINES
 	process->debugHookFunc = 0;
@@ -558,6 +624,12 @@ ILExecProcess *ILExecProcessCreate(unsigned long stackSize, unsigned long cacheP
 	}
 
 #ifdef IL_USE_CVM
+	/* The stack size is the most that the operand stack for a thread
+	   can grow to.  Threads start with a smaller stack if possible */
+	if(stackSize == 0)
+	{
+		stackSize = IL_CONFIG_STACK_MAX_SIZE;
+	}
 	process->stackSize = ((stackSize < IL_CONFIG_STACK_SIZE)
 							? IL_CONFIG_STACK_SIZE : stackSize);
 	process->frameStackSize = IL_CONFIG_FRAME_STACK_SIZE;
@@ -725,7 +797,7 @@ void ILExecProcessDestroy(ILExecProcess *process)
 		{
 			thread = ILExecThreadCurrent();
 			if (thread &&
-				thread != process->finalizerThread &&
+				!thread->isFinalizerThread &&
 				thread->process == process)
 			{
 				ILThreadUnregisterForManagedExecution(ILThreadSelf());
@@ -758,7 +830,7 @@ void ILExecProcessDestroy(ILExecProcess *process)
 	   wasn't destroyed above and if it belongs to this domain */
 	thread = ILExecThreadCurrent();
 	if (thread &&
-		thread != process->finalizerThread &&
+		!thread->isFinalizerThread &&
 		thread->process == process)
 	{
 		ILThreadUnregisterForManagedExecution(ILThreadSelf());
@@ -779,6 +851,34 @@ void ILExecProcessSetLibraryDirs(ILExecProcess *process,
 	ILContextSetLibraryDirs(process->context, libraryDirs, numLibraryDirs);
 }
 
+int ILExecProcessTrustAssembly(ILExecProcess *process, const char *name)
+{
+	char **list;
+	char *copy;
+
+	/* Expand the path in the same way as the image loader does,
+	   so that it can be compared against "ILImageGetFileName" */
+	copy = ILExpandFilename(name, (char *)0);
+	if(!copy)
+	{
+		return 0;
+	}
+	list = (char **)ILRealloc(process->trustedAssemblies,
+							  sizeof(char *) *
+								(process->numTrustedAssemblies + 1));
+	if(!list)
+	{
+		ILFree(copy);
+		return 0;
+	}
+	list[(process->numTrustedAssemblies)++] = copy;
+	process->trustedAssemblies = list;
+
+	/* Force the verifier to re-check the trust level of images */
+	process->verifyImage = 0;
+	return 1;
+}
+
 ILContext *ILExecProcessGetContext(ILExecProcess *process)
 {
 	return process->context;
@@ -632,6 +632,128 @@ static IL_INLINE void ILExecThreadDetachFromProcess(ILExecThread *thread)
 	thread->nextThread = thread->prevThread = 0;
 }
 
+#ifdef IL_USE_CVM
+
+/*
+ * Get the number of bytes of address space to reserve for a stack of
+ * "words" words.  An extra page is left unused at the end as a guard.
+ */
+static unsigned long StackReserveSize(ILUInt32 words)
+{
+	unsigned long pageSize = ILPageAllocSize();
+	return ((words * sizeof(CVMWord) + pageSize - 1) / pageSize + 1)
+				* pageSize;
+}
+
+/*
+ * Create the operand stack for a thread.  Address space is reserved
+ * for "maxWords" words, but memory is only committed on demand.  The
+ * collector scans the usable part of every reserved stack through a
+ * root region, so there is no limit on the number of them.
+ */
+static int CreateStack(ILExecThread *thread, ILUInt32 maxWords)
+{
+	ILUInt32 initial;
+
+	/* Reserve address space for the entire stack if we can */
+	thread->stackBase = (CVMWord *)ILPageReserve(StackReserveSize(maxWords));
+	if(thread->stackBase)
+	{
+	#ifdef IL_CONFIG_GROW_STACK
+		ILUInt32 pageWords =
+			(ILUInt32)(ILPageAllocSize() / sizeof(CVMWord));
+		initial = ((IL_CONFIG_STACK_SIZE + pageWords - 1) / pageWords)
+						* pageWords;
+		if(initial > maxWords)
+		{
+			initial = maxWords;
+		}
+	#else
+		initial = maxWords;
+	#endif
+		if(ILPageCommit(thread->stackBase, initial * sizeof(CVMWord)))
+		{
+			thread->stackReserved = 1;
+			thread->stackLimit = thread->stackBase + initial;
+			thread->stackCommit = thread->stackLimit;
+			thread->stackMax = thread->stackBase + maxWords;
+			thread->stackRoots.start = (void *)(thread->stackBase);
+			thread->stackRoots.end = (void *)(thread->stackLimit);
+			ILGCAddRootRegion(&(thread->stackRoots));
+			return 1;
+		}
+		ILPageRelease(thread->stackBase, StackReserveSize(maxWords));
+	}
+
+	/* Fall back to a stack of the full size within the garbage-collected
+	   heap if address space cannot be reserved on this platform.  It
+	   cannot grow later, because the engine keeps pointers into it */
+	if((thread->stackBase = (CVMWord *)ILGCAllocPersistent
+					(sizeof(CVMWord) * maxWords)) == 0)
+	{
+		return 0;
+	}
+	thread->stackReserved = 0;
+	thread->stackLimit = thread->stackBase + maxWords;
+	thread->stackCommit = thread->stackLimit;
+	thread->stackMax = thread->stackLimit;
+	return 1;
+}
+
+/*
+ * Destroy the operand stack for a thread.
+ */
+static void DestroyStack(ILExecThread *thread)
+{
+	if(thread->stackReserved)
+	{
+		ILGCRemoveRootRegion(&(thread->stackRoots));
+		ILPageRelease(thread->stackBase, StackReserveSize
+			((ILUInt32)(thread->stackMax - thread->stackBase)));
+		thread->stackReserved = 0;
+	}
+	else
+	{
+		ILGCFreePersistent(thread->stackBase);
+	}
+	thread->stackBase = 0;
+}
+
+#endif /* IL_USE_CVM */
+
+void _ILExecThreadShrinkStack(ILExecThread *thread)
+{
+#if defined(IL_USE_CVM) && defined(IL_CONFIG_GROW_STACK)
+	ILUInt32 pageWords;
+	ILUInt32 keep;
+	CVMWord *limit;
+
+	if(!(thread->stackReserved))
+	{
+		return;
+	}
+
+	/* Keep the pages in use, plus the initial stack size as slack */
+	pageWords = (ILUInt32)(ILPageAllocSize() / sizeof(CVMWord));
+	keep = (ILUInt32)(thread->stackTop - thread->stackBase) +
+		   IL_CONFIG_STACK_SIZE;
+	keep = ((keep + pageWords - 1) / pageWords) * pageWords;
+	if(keep >= (ILUInt32)(thread->stackLimit - thread->stackBase))
+	{
+		return;
+	}
+
+	/* Give the memory above that back to the system.  The pages stay
+	   committed, so growing again is cheap.  The collector stops
+	   scanning them once the root region has been shortened */
+	limit = thread->stackLimit;
+	thread->stackLimit = thread->stackBase + keep;
+	thread->stackRoots.end = (void *)(thread->stackLimit);
+	ILPageDiscard(thread->stackLimit,
+				  (limit - thread->stackLimit) * sizeof(CVMWord));
+#endif
+}
+
 ILExecThread *_ILExecThreadCreate(ILExecProcess *process, int ignoreProcessState)
 {
 	ILExecThread *thread;
@@ -657,6 +779,7 @@ ILExecThread *_ILExecThreadCreate(ILExecProcess *process, int ignoreProcessState
 	thread->freeMonitor = 0;
 	thread->freeMonitorCount = 0;
 	thread->isFinalizerThread = 0;
+	thread->nextFinalizerThread = 0;
 	thread->method = 0;
 	thread->thrownException = 0;
 	thread->threadStaticSlots = 0;
@@ -698,21 +821,19 @@ ILExecThread *_ILExecThreadCreate(ILExecProcess *process, int ignoreProcessState
 
 #ifdef IL_USE_CVM
 		/* Allocate space for the thread-specific value stack */
-		if((thread->stackBase = (CVMWord *)ILGCAllocPersistent
-						(sizeof(CVMWord) * process->stackSize)) == 0)
+		if(!CreateStack(thread, process->stackSize))
 		{
 			ILMutexUnlock(process->lock);
 			ILGCFreePersistent(thread);
 			return 0;
 		}
-		thread->stackLimit = thread->stackBase + process->stackSize;
 
 		/* Allocate space for the initial frame stack */
 		if((thread->frameStack = (ILCallFrame *)ILGCAllocPersistent
 					(sizeof(ILCallFrame) * process->frameStackSize)) == 0)
 		{
 			ILMutexUnlock(process->lock);
-			ILGCFreePersistent(thread->stackBase);
+			DestroyStack(thread);
 			ILGCFreePersistent(thread);
 			return 0;
 		}
@@ -741,10 +862,18 @@ void _ILExecThreadDestroy(ILExecThread *thread)
 		/* Lock down the process */
 		ILMutexLock(process->lock);
 
-		/* If this is the finalizer thread then clear process->finalizerThread */
-		if (process->finalizerThread == thread)
+		/* If this is an idle finalizer thread then remove it from the list */
+		if (thread->isFinalizerThread)
 		{
-			process->finalizerThread = 0;
+			ILExecThread **prev = &(process->finalizerThread);
+			while(*prev != 0 && *prev != thread)
+			{
+				prev = &((*prev)->nextFinalizerThread);
+			}
+			if(*prev != 0)
+			{
+				*prev = thread->nextFinalizerThread;
+			}
 		}
 
 		/* Detach the thread from its process */
@@ -765,7 +894,7 @@ void _ILExecThreadDestroy(ILExecThread *thread)
 	/* Destroy the operand stack */
 	if(thread->stackBase)
 	{
-		ILGCFreePersistent(thread->stackBase);
+		DestroyStack(thread);
 	}
 
 	/* Destroy the call frame stack */
@@ -804,8 +933,7 @@ void _ILExecThreadClearExecutionState(ILExecThread *thread)
 	/* Destroy the operand stack */
 	if(thread->stackBase)
 	{
-		ILGCFreePersistent(thread->stackBase);
-		thread->stackBase = 0;
+		DestroyStack(thread);
 	}
 	/* Destroy the call frame stack */
 	if(thread->frameStack)
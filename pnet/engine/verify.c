@@ -26,6 +26,7 @@
 #include "il_align.h"
 #include "il_debug.h"
 #include "debugger.h"
+#include "il_crypt.h"
 #ifdef IL_USE_JIT
 #include "jitc.h"
 #endif
@@ -686,6 +687,325 @@ static int IsSubClass(ILType *type, ILClass *classInfo)
 #define	VERIFY_MEMORY_ERROR()	VERIFY_REPORT(); goto cleanup
 #define	VERIFY_PREFIX_ERROR()	VERIFY_PREFIX_REPORT(); goto cleanup
 
+/*
+ * Determine if the code in an image has been marked as trusted.
+ * Trust is granted by file path only: assembly names and public
+ * keys are declared by the image itself, and no strong name
+ * signature is checked, so they cannot be relied upon.  The
+ * caller must have the metadata write lock.
+ */
+static int ImageIsTrusted(ILExecProcess *process, ILImage *image)
+{
+	const char *filename;
+	int trusted = 0;
+	int posn;
+
+	if(process->numTrustedAssemblies == 0)
+	{
+		return 0;
+	}
+	if(image == process->verifyImage)
+	{
+		return process->verifyImageTrusted;
+	}
+	filename = ILImageGetFileName(image);
+	if(filename)
+	{
+		for(posn = 0; posn < process->numTrustedAssemblies; ++posn)
+		{
+			if(!strcmp(filename, process->trustedAssemblies[posn]))
+			{
+				trusted = 1;
+				break;
+			}
+		}
+	}
+	process->verifyImage = image;
+	process->verifyImageTrusted = trusted;
+	return trusted;
+}
+
+/*
+ * Cache of method bodies that have passed verification before.
+ * Each key is the SHA-256 hash of the module's MVID, the MVIDs of
+ * all assemblies that the image references directly or indirectly,
+ * the method's token, the image's security state, and the method's
+ * header and code.  The table is open addressed, and a key of all
+ * zeroes marks an empty slot.
+ *
+ * The cache file holds at most "IL_VERIFY_CACHE_MAX" keys.  Keys
+ * that were used by the current run are written first, so that
+ * keys for code that is no longer run are the first to be dropped.
+ */
+#define	IL_VERIFY_KEY_SIZE		IL_SHA256_HASH_SIZE
+#define	IL_VERIFY_CACHE_MAX		65536
+typedef struct
+{
+	unsigned char	hash[IL_VERIFY_KEY_SIZE];
+	unsigned char	used;
+
+} ILVerifyCacheKey;
+typedef struct _tagILVerifyDeps ILVerifyDeps;
+struct _tagILVerifyDeps
+{
+	ILImage		   *image;
+	unsigned char	hash[IL_VERIFY_KEY_SIZE];
+	ILVerifyDeps   *next;
+
+};
+typedef struct
+{
+	ILVerifyCacheKey   *keys;
+	ILUInt32			size;
+	ILUInt32			count;
+	ILVerifyDeps	   *deps;
+
+} ILVerifyCache;
+#define	IL_VERIFY_CACHE_MAGIC	"PNETVC03"
+
+/*
+ * Determine if a verification cache key is empty.
+ */
+static int VerifyKeyIsEmpty(const ILVerifyCacheKey *key)
+{
+	int posn;
+	for(posn = 0; posn < IL_VERIFY_KEY_SIZE; ++posn)
+	{
+		if(key->hash[posn] != 0)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*
+ * Get the starting hash table position for a key.
+ */
+#define	VerifyKeyPosn(key,size)	\
+			((((ILUInt32)((key)->hash[0])) | \
+			  (((ILUInt32)((key)->hash[1])) << 8) | \
+			  (((ILUInt32)((key)->hash[2])) << 16) | \
+			  (((ILUInt32)((key)->hash[3])) << 24)) & ((size) - 1))
+
+/*
+ * Add the MVID of an image's module to a hash.
+ */
+static void HashImageMVID(ILSHA256Context *sha, ILImage *image)
+{
+	ILModule *module;
+	const unsigned char *mvid;
+
+	module = (ILModule *)ILImageTokenInfo(image, IL_META_TOKEN_MODULE | 1);
+	mvid = (module ? ILModule_MVID(module) : 0);
+	if(mvid)
+	{
+		ILSHA256Data(sha, mvid, 16);
+	}
+}
+
+/*
+ * Get the hash of the MVIDs of the assemblies that an image depends
+ * upon.  Verification looks at the metadata of referenced assemblies,
+ * so a method that verified against one version of them must be
+ * verified again if any of them is rebuilt.  The assemblies are
+ * visited breadth first in AssemblyRef order, which does not depend
+ * on the order in which they were loaded.  Returns NULL if out of
+ * memory.  The caller must have the metadata write lock.
+ */
+static const unsigned char *VerifyDepsHash(ILVerifyCache *cache,
+										   ILImage *image)
+{
+	ILVerifyDeps *deps;
+	ILImage **images;
+	ILImage **newImages;
+	ILImage *refImage;
+	ILAssembly *assem;
+	ILSHA256Context sha;
+	int numImages, maxImages;
+	int posn, index;
+
+	/* Have we already computed the hash for this image? */
+	deps = cache->deps;
+	while(deps != 0)
+	{
+		if(deps->image == image)
+		{
+			return deps->hash;
+		}
+		deps = deps->next;
+	}
+	if((deps = (ILVerifyDeps *)ILMalloc(sizeof(ILVerifyDeps))) == 0)
+	{
+		return 0;
+	}
+
+	/* Walk the assemblies that are reachable from the image */
+	maxImages = 16;
+	if((images = (ILImage **)ILMalloc(sizeof(ILImage *) * maxImages)) == 0)
+	{
+		ILFree(deps);
+		return 0;
+	}
+	images[0] = image;
+	numImages = 1;
+	ILSHA256Init(&sha);
+	for(posn = 0; posn < numImages; ++posn)
+	{
+		assem = 0;
+		while((assem = (ILAssembly *)ILImageNextToken
+					(images[posn], IL_META_TOKEN_ASSEMBLY_REF, assem)) != 0)
+		{
+			refImage = ILAssemblyToImage(assem);
+			if(!refImage)
+			{
+				/* Unresolved references are identified by name */
+				ILSHA256Data(&sha, (const unsigned char *)"", 1);
+				ILSHA256Data(&sha, (const unsigned char *)
+										ILAssembly_Name(assem),
+							 strlen(ILAssembly_Name(assem)));
+				continue;
+			}
+			for(index = 0; index < numImages; ++index)
+			{
+				if(images[index] == refImage)
+				{
+					break;
+				}
+			}
+			if(index < numImages)
+			{
+				continue;
+			}
+			if(numImages >= maxImages)
+			{
+				maxImages *= 2;
+				newImages = (ILImage **)ILRealloc
+					(images, sizeof(ILImage *) * maxImages);
+				if(!newImages)
+				{
+					ILFree(images);
+					ILFree(deps);
+					return 0;
+				}
+				images = newImages;
+			}
+			images[numImages++] = refImage;
+			HashImageMVID(&sha, refImage);
+		}
+	}
+	ILFree(images);
+	ILSHA256Finalize(&sha, deps->hash);
+
+	/* Remember the hash for the next method in the image */
+	deps->image = image;
+	deps->next = cache->deps;
+	cache->deps = deps;
+	return deps->hash;
+}
+
+/*
+ * Compute the verification cache key for a method body.  The
+ * security state is included so that a body that was verified
+ * with unsafe code allowed does not match when it is loaded
+ * from an untrusted location.  Returns zero if out of memory.
+ */
+static int VerifyCacheKey(ILVerifyCache *cache, ILVerifyCacheKey *key,
+						  ILMethod *method, ILMethodCode *code,
+						  int unsafeAllowed)
+{
+	ILImage *image = ILProgramItem_Image(method);
+	const unsigned char *deps;
+	ILSHA256Context sha;
+	unsigned char buf[6];
+	ILUInt32 token = ILMethod_Token(method);
+
+	if((deps = VerifyDepsHash(cache, image)) == 0)
+	{
+		return 0;
+	}
+	ILSHA256Init(&sha);
+	HashImageMVID(&sha, image);
+	ILSHA256Data(&sha, deps, IL_VERIFY_KEY_SIZE);
+	buf[0] = (unsigned char)token;
+	buf[1] = (unsigned char)(token >> 8);
+	buf[2] = (unsigned char)(token >> 16);
+	buf[3] = (unsigned char)(token >> 24);
+	buf[4] = (unsigned char)(unsafeAllowed != 0);
+	buf[5] = (unsigned char)(ILImageIsSecure(image) != 0);
+	ILSHA256Data(&sha, buf, 6);
+	ILSHA256Data(&sha, ((const unsigned char *)(code->code)) -
+							code->headerSize,
+				 code->headerSize + code->codeLen);
+	ILSHA256Finalize(&sha, key->hash);
+	if(VerifyKeyIsEmpty(key))
+	{
+		key->hash[0] = 1;
+	}
+	key->used = 1;
+	return 1;
+}
+
+/*
+ * Look for a key in the verification cache, or add it.  A key that
+ * is found is marked as used if "key" is.
+ */
+static int VerifyCacheFind(ILVerifyCache *cache,
+						   const ILVerifyCacheKey *key, int add)
+{
+	ILVerifyCacheKey *keys;
+	ILUInt32 size, posn, index;
+
+	if(add && (cache->count + 1) * 4 > cache->size * 3)
+	{
+		/* Grow the table to keep the load factor below 3/4 */
+		size = (cache->size ? cache->size * 2 : 1024);
+		keys = (ILVerifyCacheKey *)ILCalloc(size, sizeof(ILVerifyCacheKey));
+		if(!keys)
+		{
+			return 0;
+		}
+		for(index = 0; index < cache->size; ++index)
+		{
+			if(!VerifyKeyIsEmpty(&(cache->keys[index])))
+			{
+				posn = VerifyKeyPosn(&(cache->keys[index]), size);
+				while(!VerifyKeyIsEmpty(&(keys[posn])))
+				{
+					posn = (posn + 1) & (size - 1);
+				}
+				keys[posn] = cache->keys[index];
+			}
+		}
+		if(cache->keys)
+		{
+			ILFree(cache->keys);
+		}
+		cache->keys = keys;
+		cache->size = size;
+	}
+	if(!(cache->size))
+	{
+		return 0;
+	}
+	posn = VerifyKeyPosn(key, cache->size);
+	while(!VerifyKeyIsEmpty(&(cache->keys[posn])))
+	{
+		if(!ILMemCmp(cache->keys[posn].hash, key->hash, IL_VERIFY_KEY_SIZE))
+		{
+			cache->keys[posn].used |= key->used;
+			return 1;
+		}
+		posn = (posn + 1) & (cache->size - 1);
+	}
+	if(add)
+	{
+		cache->keys[posn] = *key;
+		++(cache->count);
+	}
+	return 0;
+}
+
 /*
  * Declare global definitions that are required by the include files.
  */
@@ -753,6 +1073,10 @@ int _ILVerify(ILCoder *coder, unsigned char **start, ILMethod *method,
 #else
 	int haveDebug = 0;
 #endif
+	ILExecProcess *verifyProcess = (thread ? _ILExecThreadProcess(thread) : 0);
+	ILVerifyCacheKey cacheKey;
+	int haveCacheKey = 0;
+	int trusted = 0;
 
 	/* Include local variables that are required by the include files */
 #define IL_VERIFY_LOCALS
@@ -775,6 +1099,25 @@ int _ILVerify(ILCoder *coder, unsigned char **start, ILMethod *method,
 		return 0;
 	}
 
+	/* Methods in trusted assemblies, and methods that have passed
+	   verification on a previous run, skip the type safety checks.
+	   The instruction stream must still be walked to drive the coder */
+	if(verifyProcess)
+	{
+		if(ImageIsTrusted(verifyProcess, ILProgramItem_Image(method)))
+		{
+			trusted = 1;
+		}
+		else if(verifyProcess->verifyCache &&
+				VerifyCacheKey((ILVerifyCache *)(verifyProcess->verifyCache),
+							   &cacheKey, method, code, unsafeAllowed))
+		{
+			haveCacheKey = 1;
+			trusted = VerifyCacheFind
+				((ILVerifyCache *)(verifyProcess->verifyCache), &cacheKey, 0);
+		}
+	}
+
 	/* Clear the exception management structure */
 	ILMemZero(&coderExceptions, sizeof(ILCoderExceptions));
 	/*
@@ -1420,6 +1763,13 @@ restart:
 #endif
 	result = (result == IL_CODER_END_OK);
 
+	/* Remember that the method verified for the next run */
+	if(result && !trusted && haveCacheKey)
+	{
+		VerifyCacheFind
+			((ILVerifyCache *)(verifyProcess->verifyCache), &cacheKey, 1);
+	}
+
 	/* Clean up and exit */
 cleanup:
 	TempAllocatorDestroy(&allocator);
@@ -1435,6 +1785,110 @@ cleanup:
 	return result;
 }
 
+int _ILLoadVerifyCache(FILE *stream, ILExecProcess *process)
+{
+	ILVerifyCache *cache;
+	unsigned char buf[8];
+	ILVerifyCacheKey key;
+	ILUInt32 count;
+
+	cache = (ILVerifyCache *)(process->verifyCache);
+	if(!cache)
+	{
+		cache = (ILVerifyCache *)ILCalloc(1, sizeof(ILVerifyCache));
+		if(!cache)
+		{
+			return 0;
+		}
+		process->verifyCache = (void *)cache;
+	}
+	if(!stream)
+	{
+		return 1;
+	}
+	if(fread(buf, 1, 8, stream) != 8 ||
+	   ILMemCmp(buf, IL_VERIFY_CACHE_MAGIC, 8) != 0)
+	{
+		/* Not a cache file: start again with an empty cache */
+		return 0;
+	}
+	key.used = 0;
+	count = 0;
+	while(count < IL_VERIFY_CACHE_MAX &&
+		  fread(key.hash, 1, IL_VERIFY_KEY_SIZE, stream) ==
+				IL_VERIFY_KEY_SIZE)
+	{
+		if(!VerifyKeyIsEmpty(&key))
+		{
+			VerifyCacheFind(cache, &key, 1);
+			++count;
+		}
+	}
+	return 1;
+}
+
+int _ILDumpVerifyCache(FILE *stream, ILExecProcess *process)
+{
+	ILVerifyCache *cache = (ILVerifyCache *)(process->verifyCache);
+	ILUInt32 index, count;
+	int used;
+
+	if(fwrite(IL_VERIFY_CACHE_MAGIC, 1, 8, stream) != 8)
+	{
+		return 0;
+	}
+	if(!cache)
+	{
+		return 1;
+	}
+
+	/* Write the keys that were used by this run, and then as many
+	   of the keys from previous runs as will fit in the file */
+	count = 0;
+	for(used = 1; used >= 0; --used)
+	{
+		for(index = 0; index < cache->size; ++index)
+		{
+			if(count >= IL_VERIFY_CACHE_MAX)
+			{
+				return 1;
+			}
+			if(!VerifyKeyIsEmpty(&(cache->keys[index])) &&
+			   cache->keys[index].used == used)
+			{
+				if(fwrite(cache->keys[index].hash, 1, IL_VERIFY_KEY_SIZE,
+						  stream) != IL_VERIFY_KEY_SIZE)
+				{
+					return 0;
+				}
+				++count;
+			}
+		}
+	}
+	return 1;
+}
+
+void _ILVerifyCacheDestroy(ILExecProcess *process)
+{
+	ILVerifyCache *cache = (ILVerifyCache *)(process->verifyCache);
+	ILVerifyDeps *deps;
+	if(cache)
+	{
+		if(cache->keys)
+		{
+			ILFree(cache->keys);
+		}
+		while(cache->deps != 0)
+		{
+			deps = cache->deps->next;
+			ILFree(cache->deps);
+			cache->deps = deps;
+		}
+		ILFree(cache);
+		process->verifyCache = 0;
+	}
+}
+
 #ifdef	__cplusplus
 };
 #endif
@@ -548,12 +548,13 @@ static ILType *GetCallSiteSig(ILMethod *method, unsigned char *pc)
 /*
  * Match a method signature against the contents of the stack.
  * Returns -1 if a type error has been detected, or the number
- * of parameters to be popped otherwise.
+ * of parameters to be popped otherwise.  If "trusted" is non-zero,
+ * then object references are not checked against the parameter types.
  */
 static ILInt32 MatchSignature(ILCoder *coder, ILEngineStackItem *stack,
 						      ILUInt32 stackSize, ILType *signature,
 						      ILMethod *method, int unsafeAllowed,
-							  int suppressThis, int indirectCall,
+							  int trusted, int suppressThis, int indirectCall,
 							  ILCoderMethodInfo *callInfo, int tailCall)
 {
 	ILClass *owner = (method ? ILMethod_Owner(method) : 0);
@@ -735,7 +736,7 @@ static ILInt32 MatchSignature(ILCoder *coder, ILEngineStackItem *stack,
 				{
 					/* The "this" parameter must be an object reference */
 					if(item->engineType != ILEngineType_O ||
-					   (item->typeInfo != 0 &&
+					   (item->typeInfo != 0 && !trusted &&
 					    !AssignCompatible(method, item, thisType,
 										  unsafeAllowed)))
 					{
@@ -964,7 +965,7 @@ static ILInt32 MatchSignature(ILCoder *coder, ILEngineStackItem *stack,
 			{
 				/* The supplied value is O */
 				if(IsObjectRef(paramType) &&
-				   (item->typeInfo == 0 ||
+				   (item->typeInfo == 0 || trusted ||
 				    AssignCompatible(method, item, paramType,
 									 unsafeAllowed)))
 				{
@@ -1296,6 +1297,24 @@ static InlineMethodInfo const InlineMethods[] = {
 	{"RuntimeHelpers", "System.Runtime.CompilerServices",
 	 "get_OffsetToStringData", "()i", IL_INLINEMETHOD_OFFSETTOSTRINGDATA},
 
+#if defined(IL_CONFIG_FP_SUPPORTED) && defined(IL_CONFIG_EXTENDED_NUMERICS)
+	{"Decimal", "System", "Add",
+	 "(vSystem.Decimal;vSystem.Decimal;)vSystem.Decimal;",
+	 IL_INLINEMETHOD_DECIMAL_ADD},
+	{"Decimal", "System", "Subtract",
+	 "(vSystem.Decimal;vSystem.Decimal;)vSystem.Decimal;",
+	 IL_INLINEMETHOD_DECIMAL_SUB},
+	{"Decimal", "System", "Multiply",
+	 "(vSystem.Decimal;vSystem.Decimal;)vSystem.Decimal;",
+	 IL_INLINEMETHOD_DECIMAL_MUL},
+	{"Decimal", "System", "Divide",
+	 "(vSystem.Decimal;vSystem.Decimal;)vSystem.Decimal;",
+	 IL_INLINEMETHOD_DECIMAL_DIV},
+	{"Decimal", "System", "Compare",
+	 "(vSystem.Decimal;vSystem.Decimal;)i", IL_INLINEMETHOD_DECIMAL_CMP},
+#endif
+
+
 	{"Math", "System", "Abs", "(i)i", IL_INLINEMETHOD_ABS_I4},
 	{"Math", "System", "Max", "(ii)i", IL_INLINEMETHOD_MAX_I4},
 	{"Math", "System", "Min", "(ii)i", IL_INLINEMETHOD_MIN_I4},
@@ -1656,11 +1675,12 @@ case IL_OP_CALL:
 								&methodSignature);
 	if(methodInfo && !ILMethod_IsAbstract(methodInfo))
 	{
-		if(ILMemberAccessible((ILMember *)methodInfo, ILMethod_Owner(method)))
+		if(trusted ||
+		   ILMemberAccessible((ILMember *)methodInfo, ILMethod_Owner(method)))
 		{
 			numParams = MatchSignature(coder, stack, stackSize,
 									   methodSignature, methodInfo,
-									   unsafeAllowed, 0, 0,
+									   unsafeAllowed, trusted, 0, 0,
 									   &callInfo, tailCall);
 			if(numParams >= 0)
 			{
@@ -2243,7 +2263,7 @@ case IL_OP_CALLI:
 		/* Match the signature against the current stack contents */
 		numParams = MatchSignature(coder, stack, stackSize,
 								   methodSignature, 0,
-								   unsafeAllowed, 0, 1,
+								   unsafeAllowed, trusted, 0, 1,
 								   &callInfo, tailCall);
 		if(numParams >= 0)
 		{
@@ -2286,7 +2306,8 @@ case IL_OP_RET:
 		}
 
 		/* Validate the type of the return value */
-		if(!AssignCompatible(method, &(stack[stackSize - 1]),
+		if(!trusted &&
+		   !AssignCompatible(method, &(stack[stackSize - 1]),
 							 returnType, unsafeAllowed))
 		{
 			VERIFY_TYPE_ERROR();
@@ -2385,7 +2406,7 @@ case IL_OP_CALLVIRT:
 			constrainedType = prefixInfo.constrainedType;
 		}
 		classInfo = ILMethod_Owner(method);
-		if(ILMemberAccessible((ILMember *)methodInfo, classInfo))
+		if(trusted || ILMemberAccessible((ILMember *)methodInfo, classInfo))
 		{
 			if(constrainedType)
 			{
@@ -2443,7 +2464,7 @@ case IL_OP_CALLVIRT:
 			}
 			numParams = MatchSignature(coder, stack, stackSize,
 									   methodSignature, methodInfo,
-									   unsafeAllowed, 0, 0,
+									   unsafeAllowed, trusted, 0, 0,
 									   &callInfo, tailCall);
 			if(numParams >= 0)
 			{
@@ -2531,7 +2552,7 @@ case IL_OP_NEWOBJ:
 			/* Match the signature for the allocation constructor */
 			numParams = MatchSignature(coder, stack, stackSize,
 									   methodSignature, methodInfo,
-									   unsafeAllowed, 1, 0,
+									   unsafeAllowed, trusted, 1, 0,
 									   &callInfo, 0);
 			if(numParams < 0)
 			{
@@ -2571,7 +2592,7 @@ case IL_OP_NEWOBJ:
 			/* Match the constructor signature */
 			numParams = MatchSignature(coder, stack, stackSize,
 									   methodSignature, methodInfo,
-									   unsafeAllowed, 0, 0,
+									   unsafeAllowed, trusted, 0, 0,
 									   &callInfo, 0);
 			if(numParams < 0)
 			{
@@ -160,7 +160,8 @@ checkSTArg:
 		   This should be done using "stobj" instead */
 		VERIFY_TYPE_ERROR();
 	}
-	else if(!AssignCompatible(method, &(stack[stackSize - 1]),
+	else if(!trusted &&
+			!AssignCompatible(method, &(stack[stackSize - 1]),
 							  type, unsafeAllowed))
 	{
 		VERIFY_TYPE_ERROR();
@@ -249,7 +250,8 @@ checkSTLoc:
 		VERIFY_INSN_ERROR();
 	}
 	type = ILTypeGetLocal(localVars, argNum);
-	if(!AssignCompatible(method, &(stack[stackSize - 1]),
+	if(!trusted &&
+	   !AssignCompatible(method, &(stack[stackSize - 1]),
 						 type, unsafeAllowed))
 	{
 		VERIFY_TYPE_ERROR();
@@ -242,6 +242,11 @@ typedef struct
 #define IL_INLINEMETHOD_ARRAY_COPY_AI4AI4I4	50
 #define IL_INLINEMETHOD_ARRAY_CLEAR_AI4I4	51
 #define IL_INLINEMETHOD_OFFSETTOSTRINGDATA	52
+#define	IL_INLINEMETHOD_DECIMAL_ADD			53
+#define	IL_INLINEMETHOD_DECIMAL_SUB			54
+#define	IL_INLINEMETHOD_DECIMAL_MUL			55
+#define	IL_INLINEMETHOD_DECIMAL_DIV			56
+#define	IL_INLINEMETHOD_DECIMAL_CMP			57
 
 /*
  * Return values for "ILCoderFinish".
@@ -257,6 +262,7 @@ typedef struct
 #define IL_CODER_FLAG_METHOD_PROFILE 2	/* emit profiling code */
 #define IL_CODER_FLAG_METHOD_TRACE	 4	/* emit trace code */
 #define IL_CODER_FLAG_STATS			 8	/* print code generation informaton */
+#define IL_CODER_FLAG_BRANCH_PROFILE 16	/* emit branch counting code */
 
 /*
  * Coder class definition.
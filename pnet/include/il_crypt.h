@@ -27,6 +27,37 @@
 extern	"C" {
 #endif
 
+/*
+ * Determine if the compiler can generate the x86 instructions for
+ * AES and SHA on a per-function basis.  The instructions are only
+ * used if the CPU reports them at runtime.
+ */
+#if (defined(__i386__) || defined(__x86_64__)) && \
+	((defined(__GNUC__) && __GNUC__ >= 5) || defined(__clang__))
+	#define	IL_CRYPT_X86_HW		1
+#endif
+
+/*
+ * Hardware features that may be used by the cryptographic primitives.
+ */
+#define	IL_CRYPT_HW_AES			0x0001	/* AES-NI */
+#define	IL_CRYPT_HW_SHA			0x0002	/* SHA-NI with SSE4.1 */
+#define	IL_CRYPT_HW_SSSE3		0x0004	/* SSSE3 */
+
+/*
+ * Get the hardware features that the cryptographic primitives may use.
+ * The CPU is queried the first time this is called.
+ */
+int ILCryptHardware(void);
+
+/*
+ * Restrict the hardware features that the cryptographic primitives may
+ * use to those in "mask", and return the previous mask.  This is used
+ * to test and measure the portable code on machines with the hardware.
+ * AES contexts that were already initialized are not affected.
+ */
+int ILCryptSetHardware(int mask);
+
 /*
  * The size of SHA1 hash values.
  */
@@ -289,6 +320,9 @@ typedef struct
 {
 	int			numRounds;
 	ILInt32		keySchedule[15 * 4];
+	int			useHardware;
+	unsigned char encryptKeys[15 * 16];
+	unsigned char decryptKeys[15 * 16];
 
 } ILAESContext;
 
@@ -311,6 +345,38 @@ void ILAESEncrypt(ILAESContext *aes, unsigned char *input,
 void ILAESDecrypt(ILAESContext *aes, unsigned char *input,
 				  unsigned char *output);
 
+/*
+ * Encrypt "numBlocks" 128-bit blocks using AES in ECB mode.
+ * The input and output buffers can be the same.
+ */
+void ILAESEncryptECB(ILAESContext *aes, unsigned char *input,
+					 unsigned char *output, unsigned long numBlocks);
+
+/*
+ * Decrypt "numBlocks" 128-bit blocks using AES in ECB mode.
+ * The input and output buffers can be the same.
+ */
+void ILAESDecryptECB(ILAESContext *aes, unsigned char *input,
+					 unsigned char *output, unsigned long numBlocks);
+
+/*
+ * Encrypt "numBlocks" 128-bit blocks using AES in CBC mode.  On exit,
+ * "iv" holds the last ciphertext block, ready for the next call.
+ * The input and output buffers can be the same.
+ */
+void ILAESEncryptCBC(ILAESContext *aes, unsigned char *iv,
+					 unsigned char *input, unsigned char *output,
+					 unsigned long numBlocks);
+
+/*
+ * Decrypt "numBlocks" 128-bit blocks using AES in CBC mode.  On exit,
+ * "iv" holds the last ciphertext block, ready for the next call.
+ * The input and output buffers can be the same.
+ */
+void ILAESDecryptCBC(ILAESContext *aes, unsigned char *iv,
+					 unsigned char *input, unsigned char *output,
+					 unsigned long numBlocks);
+
 /*
  * Finalize an AES encryption context, clearing all sensitive values.
  */
@@ -43,6 +43,12 @@ typedef struct _tagILExecProcess ILExecProcess;
  */
 typedef struct _tagILExecThread ILExecThread;
 
+/*
+ * A method that has been resolved by name, ready to be called
+ * repeatedly.  Call sites belong to the process that resolved them.
+ */
+typedef struct _tagILExecCallSite ILExecCallSite;
+
 /*
  * Object and string handles.
  */
@@ -226,7 +232,9 @@ ILExecThread *ILThreadRegisterForManagedExecution(ILExecProcess *process, ILThre
 void ILThreadUnregisterForManagedExecution(ILThread *thread);
 
 /*
- * Create a new process where code can be executed.
+ * Create a new process where code can be executed.  The stack size
+ * is the maximum size of a thread's operand stack, in stack words.
+ * Zero selects the default for the profile.
  */
 ILExecProcess *ILExecProcessCreate(unsigned long frameStackSize, unsigned long cachePageSize);
 
@@ -269,6 +277,13 @@ void ILExecProcessSetLibraryDirs(ILExecProcess *process,
 								 char **libraryDirs,
 								 int numLibraryDirs);
 
+/*
+ * Mark an assembly as trusted, so that the verifier skips the
+ * type safety checks on its code.  The assembly is identified
+ * by the path of its file.  Returns zero if out of memory.
+ */
+int ILExecProcessTrustAssembly(ILExecProcess *process, const char *name);
+
 /*
  *Set the flags for profiling, debugging etc
  */
@@ -582,6 +597,41 @@ ILObject *ILExecThreadNew(ILExecThread *thread, const char *typeName,
 ILObject *ILExecThreadNewV(ILExecThread *thread, const char *typeName,
 						   const char *signature, ILExecValue *args);
 
+/*
+ * Resolve a method by type name, method name, and signature into
+ * a call site.  Resolving the same names again returns the same
+ * call site.  Returns NULL if the method could not be found.
+ */
+ILExecCallSite *ILExecThreadResolveMethod(ILExecThread *thread,
+										  const char *typeName,
+										  const char *methodName,
+										  const char *signature);
+
+/*
+ * Get the method that a call site refers to.
+ */
+ILMethod *ILExecCallSiteGetMethod(ILExecCallSite *site);
+
+/*
+ * Call the method for a call site.  The arguments are passed in
+ * the same way as for "ILExecThreadCall".
+ */
+int ILExecThreadCallSite(ILExecThread *thread, ILExecCallSite *site,
+						 void *result, ...);
+
+/*
+ * Call the method for a call site, as a virtual method on "_this".
+ */
+int ILExecThreadCallSiteVirtual(ILExecThread *thread, ILExecCallSite *site,
+								void *result, void *_this, ...);
+
+/*
+ * Create a new object instance using the constructor for a call site.
+ * Returns NULL if an exception occurred.
+ */
+ILObject *ILExecThreadNewSite(ILExecThread *thread, ILExecCallSite *site,
+							  ...);
+
 /*
  * Determine if there is a last-occuring exception
  * for a thread.  Returns non-zero if so.
@@ -27,6 +27,31 @@
 extern	"C" {
 #endif
 
+/*
+ * Options that tune the garbage collector.  Zero values select
+ * the collector's defaults.
+ */
+typedef struct
+{
+	int				markers;		/* Number of parallel mark threads */
+	int				incremental;	/* Non-zero for incremental marking */
+	unsigned long	pauseTarget;	/* Incremental pause target, in ms */
+	int				reportPauses;	/* Report pause times on exit */
+	int				finalizers;		/* Number of finalizer threads */
+
+} ILGCOptions;
+
+/*
+ * Maximum number of threads that can run finalizers at once.
+ */
+#define	IL_GC_MAX_FINALIZER_THREADS		16
+
+/*
+ * Set the options for the garbage collector.  This must be called
+ * before "ILGCInit" to have any effect.
+ */
+void ILGCSetOptions(const ILGCOptions *options);
+
 /*
  * Initialize the garbage collector with a specific maximum heap size.
  * If "maxSize" is zero, then the collector will use all of memory.
@@ -88,6 +113,47 @@ void ILGCRegisterFinalizer(void *block, ILGCFinalizer func, void *data);
  */
 void ILGCMarkNoPointers(void *start, unsigned long size);
 
+/*
+ * Register a region of memory outside the heap that may contain
+ * object pointers.  Registering a larger region with the same start
+ * address extends the existing registration.
+ */
+void ILGCRegisterRoots(void *start, unsigned long size);
+
+/*
+ * Unregister a region of memory that was registered with
+ * "ILGCRegisterRoots".
+ */
+void ILGCUnregisterRoots(void *start, unsigned long size);
+
+/*
+ * A region of memory outside the heap that may contain object
+ * pointers, and whose end moves while it is registered, such as a
+ * stack.  The collector scans from "start" up to the current value
+ * of "end", so the region can grow or shrink without telling the
+ * collector.  The memory up to "end" must always be readable.
+ */
+typedef struct _tagILGCRootRegion ILGCRootRegion;
+struct _tagILGCRootRegion
+{
+	void			   *start;
+	void * volatile		end;
+	ILGCRootRegion	   *prev;
+	ILGCRootRegion	   *next;
+
+};
+
+/*
+ * Add a root region.  Unlike "ILGCRegisterRoots", this does not use
+ * up one of the collector's limited number of root sets.
+ */
+void ILGCAddRootRegion(ILGCRootRegion *region);
+
+/*
+ * Remove a root region that was added with "ILGCAddRootRegion".
+ */
+void ILGCRemoveRootRegion(ILGCRootRegion *region);
+
 /*
  * Trigger explicit garbage collection.
  */
@@ -129,6 +195,53 @@ void ILGCEnableFinalizers(void);
  */
 long ILGCGetHeapSize(void);
 
+/*
+ * Statistics about the times that the garbage collector has stopped
+ * all threads.  Times are in microseconds.
+ */
+typedef struct
+{
+	ILUInt64		numPauses;
+	ILUInt64		totalTime;
+	ILUInt64		maxTime;
+	ILUInt64		lastTime;
+
+} ILGCPauseStats;
+
+/*
+ * Get the pause statistics for the garbage collector.
+ */
+void ILGCGetPauseStats(ILGCPauseStats *stats);
+
+/*
+ * Statistics about the finalization queue.  "pending" is the number of
+ * objects that are currently waiting for their finalizers to be run,
+ * and "maxPending" is the largest backlog seen by the finalizer thread.
+ */
+typedef struct
+{
+	unsigned long	pending;
+	unsigned long	maxPending;
+	ILUInt64		numFinalized;
+	int				numThreads;
+	int				numBusy;
+
+} ILGCFinalizerStats;
+
+/*
+ * Get the statistics for the finalization queue.
+ */
+void ILGCGetFinalizerStats(ILGCFinalizerStats *stats);
+
+/*
+ * Prepare a block of collected memory to be written by a system call.
+ * Incremental collection tracks writes by protecting pages, and the
+ * kernel fails with EFAULT instead of taking the collector's fault.
+ * Returns non-zero if the pages may become protected again, in which
+ * case a call that fails with EFAULT should prepare and retry.
+ */
+int ILGCPrepareWrite(void *start, unsigned long size);
+
 /*
  * Register a pointer to a weak reference.
  */
@@ -249,6 +249,42 @@ ILInt32 ILSysIOSocketReceive(ILSysIOHandle sockfd, void *buff,
 ILInt32 ILSysIOSocketSend(ILSysIOHandle sockfd, const void *msg,
 					      ILInt32 len, ILInt32 flags);
 
+/*
+ * A buffer for vectored socket I/O.
+ */
+typedef struct
+{
+	void	   *data;
+	ILInt32		length;
+
+} ILSysIOBuffer;
+
+/*
+ * Send data from a list of buffers on a socket, as a single message.
+ * Returns the number of bytes sent, or -1 on error.
+ */
+ILInt32 ILSysIOSocketSendV(ILSysIOHandle sockfd, const ILSysIOBuffer *buffers,
+						   ILInt32 numBuffers, ILInt32 flags);
+
+/*
+ * Receive data on a socket into a list of buffers, filling them in
+ * order.  Returns the number of bytes received, or -1 on error.
+ */
+ILInt32 ILSysIOSocketReceiveV(ILSysIOHandle sockfd,
+							  const ILSysIOBuffer *buffers,
+							  ILInt32 numBuffers, ILInt32 flags);
+
+/*
+ * Send "count" bytes from a file on a socket, starting at "offset".
+ * If "count" is negative, then send until the end of the file.  The
+ * data does not pass through the garbage collected heap, and the file
+ * position is unchanged.  Returns the number of bytes sent, which is
+ * less than "count" only at EOF or on a partial error, or -1 if an
+ * error occurred before any data was sent.
+ */
+ILInt64 ILSysIOSocketSendFile(ILSysIOHandle sockfd, ILSysIOHandle file,
+							  ILInt64 offset, ILInt64 count);
+
 /*
  * Send data on a socket to a specific address.
  */
@@ -291,6 +327,61 @@ ILInt32 ILSysIOSocketSelect(ILSysIOHandle **readfds, ILInt32 numRead,
 						    ILSysIOHandle **exceptfds, ILInt32 numExcept,
 						    ILInt64 timeout);
 
+/*
+ * Opaque type for a persistent set of handles to poll for readiness.
+ * Handles stay in the set between waits, so that event loops do not
+ * have to pass all of their handles to the kernel on every iteration.
+ * Handles can be added and removed while another thread waits on the
+ * set, but only one thread may wait on a poll set at a time.
+ */
+typedef struct _tagILSysIOPollSet ILSysIOPollSet;
+
+/*
+ * Events that a handle in a poll set can be watched for.
+ */
+#define	IL_POLL_READ			0x01
+#define	IL_POLL_WRITE			0x02
+#define	IL_POLL_ERROR			0x04
+
+/*
+ * Create a new poll set.  Returns NULL on error.
+ */
+ILSysIOPollSet *ILSysIOPollSetCreate(void);
+
+/*
+ * Destroy a poll set.
+ */
+void ILSysIOPollSetDestroy(ILSysIOPollSet *set);
+
+/*
+ * Wake up the thread that is waiting on a poll set.
+ */
+void ILSysIOPollSetWakeup(ILSysIOPollSet *set);
+
+/*
+ * Add a handle to a poll set, or change the events that it is
+ * watched for if it is already in the set.  Waits report "id"
+ * when the handle fires.  Returns zero on error.
+ */
+int ILSysIOPollSetAdd(ILSysIOPollSet *set, ILSysIOHandle handle,
+					  ILInt32 events, ILInt32 id);
+
+/*
+ * Remove a handle from a poll set.  Returns zero on error.
+ */
+int ILSysIOPollSetRemove(ILSysIOPollSet *set, ILSysIOHandle handle);
+
+/*
+ * Wait for handles in a poll set to become ready.  Up to "maxEvents"
+ * identifiers and the events that fired for them are stored in "ids"
+ * and "events".  Returns the number of handles, 0 on timeout or if
+ * the wait was woken up, or -1 on error.  The timeout is in
+ * microseconds, or -1 to wait forever.
+ */
+ILInt32 ILSysIOPollSetWait(ILSysIOPollSet *set, ILInt32 *ids,
+						   ILInt32 *events, ILInt32 maxEvents,
+						   ILInt64 timeout);
+
 /*
  * Set or reset the blocking flag on a socket.  Returns zero on error.
  */
@@ -468,6 +559,56 @@ int ILSysIOGetFileAttributes(const char *path, ILInt32 *attributes);
  */
 int ILSysIOSetFileAttributes(const char *path, ILInt32 attributes);
 
+/*
+ * Opaque type for a readiness notification engine.  Sockets and
+ * pipes are registered with a reactor together with a cookie, and
+ * the cookie is passed to the reactor's callback from one of a small
+ * number of completion threads once the handle becomes ready.
+ */
+typedef struct _tagILSysIOReactor ILSysIOReactor;
+
+/*
+ * Directions that a handle can be watched for.
+ */
+#define	IL_REACTOR_READ			0
+#define	IL_REACTOR_WRITE		1
+
+/*
+ * Function that is called on a completion thread when a watched
+ * handle is ready, or when the watch is cancelled.
+ */
+typedef void (*ILSysIOReactorFunc)(void *userData, void *cookie);
+
+/*
+ * Create a reactor with "numThreads" completion threads.  If
+ * "numThreads" is zero, then a default based on the number of
+ * processors is used.  Returns NULL if the platform has no
+ * readiness notification support, or if out of memory.
+ */
+ILSysIOReactor *ILSysIOReactorCreate(ILSysIOReactorFunc func,
+									 void *userData, int numThreads);
+
+/*
+ * Destroy a reactor.  Pending cookies are discarded.
+ */
+void ILSysIOReactorDestroy(ILSysIOReactor *reactor);
+
+/*
+ * Watch a handle for readiness in a particular direction.  The
+ * cookie is delivered exactly once.  Returns zero if the handle
+ * can not be watched, or if there is already a pending watch in
+ * the same direction, in which case the caller must fall back to
+ * performing the operation on a thread of its own.
+ */
+int ILSysIOReactorWatch(ILSysIOReactor *reactor, ILSysIOHandle handle,
+						int direction, void *cookie);
+
+/*
+ * Stop watching a handle and deliver all of its pending cookies.
+ * This must be called before the handle is closed.
+ */
+void ILSysIOReactorUnwatch(ILSysIOReactor *reactor, ILSysIOHandle handle);
+
 #ifdef	__cplusplus 
 };
 #endif
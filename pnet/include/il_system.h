@@ -56,6 +56,14 @@ unsigned long ILPageMapSize(void);		/* For mapping files */
 void *ILPageAlloc(unsigned long size);
 void  ILPageFree(void *ptr, unsigned long size);
 
+/* Reserve address space and commit memory to it on demand.  Committed
+   pages start out zeroed; discarded pages remain committed, but the
+   system may reclaim their contents and they read as zero again */
+void *ILPageReserve(unsigned long size);
+int   ILPageCommit(void *ptr, unsigned long size);
+void  ILPageDiscard(void *ptr, unsigned long size);
+void  ILPageRelease(void *ptr, unsigned long size);
+
 /* Memory copy, compare, set, etc, routines */
 #ifdef HAVE_MEMSET
 	#define	ILMemSet(dest,ch,len)	(memset((dest), (ch), (len)))
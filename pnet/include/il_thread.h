@@ -630,7 +630,62 @@ int ILMonitorPulseAll(void **monitorLocation);
  */
 void ILMonitorReclaim(void **monitorLocation);
 
-#ifdef	__cplusplus 
+/*
+ * Opaque type for a thread pool.
+ */
+typedef struct _tagILThreadPool ILThreadPool;
+
+/*
+ * Function that is called on every new worker thread of a pool before
+ * it runs its first item.  Returns zero if the worker can not run items.
+ */
+typedef int (*ILThreadPoolStartFunc)(void *userData);
+
+/*
+ * Function that runs an item on a worker thread.  Returns non-zero
+ * if the worker thread must exit after the item.
+ */
+typedef int (*ILThreadPoolRunFunc)(void *userData, void *item);
+
+/*
+ * Create a work-stealing thread pool.  Returns NULL if out of memory
+ * or if the system does not support threads.  Worker threads are
+ * started on demand and are background threads.
+ */
+ILThreadPool *ILThreadPoolCreate(ILThreadPoolStartFunc startFunc,
+								 ILThreadPoolRunFunc runFunc,
+								 void *userData);
+
+/*
+ * Destroy a thread pool.  This waits for the items that are currently
+ * running.  Items that are still queued are discarded.
+ */
+void ILThreadPoolDestroy(ILThreadPool *pool);
+
+/*
+ * Queue a non-NULL item on a thread pool.  The item is visible to
+ * the garbage collector while it is queued.  Returns zero if out of
+ * memory or if the pool is shutting down.
+ */
+int ILThreadPoolQueue(ILThreadPool *pool, void *item);
+
+/*
+ * Get or set the minimum and maximum number of worker threads.
+ * The set functions return zero if the value is out of range.
+ */
+int ILThreadPoolGetMinThreads(ILThreadPool *pool);
+int ILThreadPoolGetMaxThreads(ILThreadPool *pool);
+int ILThreadPoolSetMinThreads(ILThreadPool *pool, int count);
+int ILThreadPoolSetMaxThreads(ILThreadPool *pool, int count);
+
+/*
+ * Get the number of worker threads, the number of workers that are
+ * running an item and the number of queued items.
+ */
+void ILThreadPoolGetCounts(ILThreadPool *pool, int *numThreads,
+						   int *numBusy, int *numQueued);
+
+#ifdef	__cplusplus
 };
 #endif
 
@@ -326,6 +326,31 @@ GC_API GC_start_callback_proc GC_CALL GC_get_start_callback(void)
     return fn;
 }
 
+/* STATIC */ GC_on_collection_event_proc GC_on_collection_event = 0;
+                        /* Notified of world stops and restarts.        */
+                        /* Called with the allocation lock held.        */
+
+GC_API void GC_CALL GC_set_on_collection_event(GC_on_collection_event_proc fn)
+{
+    DCL_LOCK_STATE;
+    LOCK();
+    GC_on_collection_event = fn;
+    UNLOCK();
+}
+
+GC_API GC_on_collection_event_proc GC_CALL GC_get_on_collection_event(void)
+{
+    GC_on_collection_event_proc fn;
+    DCL_LOCK_STATE;
+    LOCK();
+    fn = GC_on_collection_event;
+    UNLOCK();
+    return fn;
+}
+
+#define GC_NOTIFY_EVENT(event) \
+        if (GC_on_collection_event != 0) (*GC_on_collection_event)(event)
+
 GC_INLINE void GC_notify_full_gc(void)
 {
     if (GC_start_call_back != 0) {
@@ -601,7 +626,9 @@ STATIC GC_bool GC_stopped_mark(GC_stop_func stop_func)
         GET_TIME(start_time);
 #   endif
 
+    GC_NOTIFY_EVENT(GC_EVENT_PRE_STOP_WORLD);
     STOP_WORLD();
+    GC_NOTIFY_EVENT(GC_EVENT_POST_STOP_WORLD);
 #   ifdef THREAD_LOCAL_ALLOC
       GC_world_stopped = TRUE;
 #   endif
@@ -632,7 +659,9 @@ STATIC GC_bool GC_stopped_mark(GC_stop_func stop_func)
 #                   ifdef THREAD_LOCAL_ALLOC
                       GC_world_stopped = FALSE;
 #                   endif
+                    GC_NOTIFY_EVENT(GC_EVENT_PRE_START_WORLD);
                     START_WORLD();
+                    GC_NOTIFY_EVENT(GC_EVENT_POST_START_WORLD);
                     return(FALSE);
             }
             if (GC_mark_some((ptr_t)(&dummy))) break;
@@ -654,7 +683,9 @@ STATIC GC_bool GC_stopped_mark(GC_stop_func stop_func)
 #   ifdef THREAD_LOCAL_ALLOC
       GC_world_stopped = FALSE;
 #   endif
+    GC_NOTIFY_EVENT(GC_EVENT_PRE_START_WORLD);
     START_WORLD();
+    GC_NOTIFY_EVENT(GC_EVENT_POST_START_WORLD);
 #   ifndef SMALL_CONFIG
       if (GC_print_stats) {
         unsigned long time_diff;
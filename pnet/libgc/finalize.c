@@ -79,6 +79,9 @@ static struct finalizable_object {
 STATIC struct finalizable_object * GC_finalize_now = 0;
         /* List of objects that should be finalized now.        */
 
+STATIC word GC_finalize_now_count = 0;
+        /* Number of objects in GC_finalize_now.                */
+
 static signed_word log_fo_table_size = -1;
 
 word GC_fo_entries = 0; /* used also in extra/MacOS.c */
@@ -601,6 +604,7 @@ GC_INNER void GC_finalize(void)
             /* Add to list of objects awaiting finalization.    */
               fo_set_next(curr_fo, GC_finalize_now);
               GC_finalize_now = curr_fo;
+              GC_finalize_now_count++;
               /* unhide object pointer so any future collections will   */
               /* see it.                                                */
               curr_fo -> fo_hidden_base =
@@ -649,6 +653,7 @@ GC_INNER void GC_finalize(void)
                 GC_finalize_now = next_fo;
               else
                 fo_set_next(prev_fo, next_fo);
+              GC_finalize_now_count--;
 
               curr_fo -> fo_hidden_base =
                                 GC_HIDE_POINTER(curr_fo -> fo_hidden_base);
@@ -733,6 +738,7 @@ GC_INNER void GC_finalize(void)
           /* Add to list of objects awaiting finalization.      */
           fo_set_next(curr_fo, GC_finalize_now);
           GC_finalize_now = curr_fo;
+          GC_finalize_now_count++;
 
           /* unhide object pointer so any future collections will       */
           /* see it.                                            */
@@ -787,6 +793,13 @@ GC_API int GC_CALL GC_should_invoke_finalizers(void)
     return GC_finalize_now != 0;
 }
 
+/* Returns the number of objects that are ready to be finalized.      */
+/* The count is only a hint, so the allocation lock is not taken.     */
+GC_API GC_word GC_CALL GC_count_ready_finalizers(void)
+{
+    return *(volatile word *)&GC_finalize_now_count;
+}
+
 /* Invoke finalizers for all objects that are ready to be finalized.    */
 /* Should be called without allocation lock.                            */
 GC_API int GC_CALL GC_invoke_finalizers(void)
@@ -806,11 +819,15 @@ GC_API int GC_CALL GC_invoke_finalizers(void)
         }
         curr_fo = GC_finalize_now;
 #       ifdef THREADS
-            if (curr_fo != 0) GC_finalize_now = fo_next(curr_fo);
+            if (curr_fo != 0) {
+              GC_finalize_now = fo_next(curr_fo);
+              GC_finalize_now_count--;
+            }
             UNLOCK();
             if (curr_fo == 0) break;
 #       else
             GC_finalize_now = fo_next(curr_fo);
+            GC_finalize_now_count--;
 #       endif
         fo_set_next(curr_fo, 0);
         (*(curr_fo -> fo_fn))((ptr_t)(curr_fo -> fo_hidden_base),
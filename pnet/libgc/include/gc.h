@@ -484,6 +484,30 @@ GC_API int GC_CALL GC_try_to_collect(GC_stop_func /* stop_func */);
 GC_API void GC_CALL GC_set_stop_func(GC_stop_func /* stop_func */);
 GC_API GC_stop_func GC_CALL GC_get_stop_func(void);
 
+/* Collection events, as in later collector releases.  This version     */
+/* reports only the world stop and restart events.                      */
+typedef enum {
+    GC_EVENT_START /* COLLECTION */,
+    GC_EVENT_MARK_START,
+    GC_EVENT_MARK_END,
+    GC_EVENT_RECLAIM_START,
+    GC_EVENT_RECLAIM_END,
+    GC_EVENT_END /* COLLECTION */,
+    GC_EVENT_PRE_STOP_WORLD /* STOPWORLD_BEGIN */,
+    GC_EVENT_POST_STOP_WORLD /* STOPWORLD_END */,
+    GC_EVENT_PRE_START_WORLD /* STARTWORLD_BEGIN */,
+    GC_EVENT_POST_START_WORLD /* STARTWORLD_END */,
+    GC_EVENT_THREAD_SUSPENDED,
+    GC_EVENT_THREAD_UNSUSPENDED
+} GC_EventType;
+
+/* Set and get the procedure that is notified of collection events.    */
+/* It is called with the allocation lock held, possibly with the world  */
+/* stopped, so it must not allocate or take locks.  0 means none.       */
+typedef void (GC_CALLBACK * GC_on_collection_event_proc)(GC_EventType);
+GC_API void GC_CALL GC_set_on_collection_event(GC_on_collection_event_proc);
+GC_API GC_on_collection_event_proc GC_CALL GC_get_on_collection_event(void);
+
 /* Return the number of bytes in the heap.  Excludes collector private  */
 /* data structures.  Excludes the unmapped memory (retuned to the OS).  */
 /* Includes empty blocks and fragmentation loss.  Includes some pages   */
@@ -917,6 +941,11 @@ GC_API int GC_CALL GC_unregister_disappearing_link(void ** /* link */);
 /* Returns !=0 if GC_invoke_finalizers has something to do.     */
 GC_API int GC_CALL GC_should_invoke_finalizers(void);
 
+GC_API GC_word GC_CALL GC_count_ready_finalizers(void);
+        /* Returns the number of objects that are waiting for   */
+        /* GC_invoke_finalizers.  Several threads may call      */
+        /* GC_invoke_finalizers at once to drain the queue.     */
+
 GC_API int GC_CALL GC_invoke_finalizers(void);
         /* Run finalizers for all objects that are ready to     */
         /* be finalized.  Return the number of finalizers       */
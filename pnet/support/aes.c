@@ -22,7 +22,10 @@
  * This file implements the AES symmetric encryption algorithm for
  * 128-bit, 192-bit, and 256-bit keys, based on the description that
  * can be found on the NIST Web site at "http://www.nist.gov/aes/".
- * This implementation is designed for correctness, not speed.
+ * The portable implementation is designed for correctness, not speed.
+ * On x86 CPUs with the AES-NI instructions, the block operations are
+ * done in hardware instead, several blocks at a time where the mode
+ * permits it.
  */
 
 #include "il_crypt.h"
@@ -133,6 +136,266 @@ static unsigned char const invsbox[256] =
 	 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d
 	};
 
+#ifdef IL_CRYPT_X86_HW
+
+#include <wmmintrin.h>
+#include <smmintrin.h>
+
+/*
+ * Compile a function for CPUs with AES-NI.
+ */
+#define	IL_AES_HW	__attribute__((__target__("aes,sse4.1")))
+
+/*
+ * Number of blocks that are processed together by the hardware,
+ * to hide the latency of the AES instructions.
+ */
+#define	IL_AES_HW_BLOCKS	4
+
+/*
+ * Set up the round keys for the AES-NI instructions from the
+ * key schedule.  Decryption uses the "equivalent inverse cipher",
+ * which needs InvMixColumns() applied to the middle round keys.
+ */
+static IL_AES_HW void HWSetupKeys(ILAESContext *aes)
+{
+	int nr = aes->numRounds;
+	__m128i *ek = (__m128i *)(aes->encryptKeys);
+	__m128i *dk = (__m128i *)(aes->decryptKeys);
+	int i;
+	for(i = 0; i < (nr + 1) * 4; ++i)
+	{
+		IL_BWRITE_INT32(aes->encryptKeys + i * 4, aes->keySchedule[i]);
+	}
+	_mm_storeu_si128(dk, _mm_loadu_si128(ek + nr));
+	for(i = 1; i < nr; ++i)
+	{
+		_mm_storeu_si128
+			(dk + i, _mm_aesimc_si128(_mm_loadu_si128(ek + nr - i)));
+	}
+	_mm_storeu_si128(dk + nr, _mm_loadu_si128(ek));
+}
+
+/*
+ * Encrypt a single block in hardware.
+ */
+static IL_AES_HW __m128i HWEncryptBlock(const __m128i *keys, int nr,
+										__m128i block)
+{
+	int round;
+	block = _mm_xor_si128(block, _mm_loadu_si128(keys));
+	for(round = 1; round < nr; ++round)
+	{
+		block = _mm_aesenc_si128(block, _mm_loadu_si128(keys + round));
+	}
+	return _mm_aesenclast_si128(block, _mm_loadu_si128(keys + nr));
+}
+
+/*
+ * Decrypt a single block in hardware.
+ */
+static IL_AES_HW __m128i HWDecryptBlock(const __m128i *keys, int nr,
+										__m128i block)
+{
+	int round;
+	block = _mm_xor_si128(block, _mm_loadu_si128(keys));
+	for(round = 1; round < nr; ++round)
+	{
+		block = _mm_aesdec_si128(block, _mm_loadu_si128(keys + round));
+	}
+	return _mm_aesdeclast_si128(block, _mm_loadu_si128(keys + nr));
+}
+
+/*
+ * Encrypt a run of blocks in ECB mode using hardware.
+ */
+static IL_AES_HW void HWEncryptECB(ILAESContext *aes, unsigned char *input,
+								   unsigned char *output,
+								   unsigned long numBlocks)
+{
+	const __m128i *keys = (const __m128i *)(aes->encryptKeys);
+	int nr = aes->numRounds;
+	__m128i *in = (__m128i *)input;
+	__m128i *out = (__m128i *)output;
+	__m128i b0, b1, b2, b3, key;
+	int round;
+
+	while(numBlocks >= IL_AES_HW_BLOCKS)
+	{
+		key = _mm_loadu_si128(keys);
+		b0 = _mm_xor_si128(_mm_loadu_si128(in), key);
+		b1 = _mm_xor_si128(_mm_loadu_si128(in + 1), key);
+		b2 = _mm_xor_si128(_mm_loadu_si128(in + 2), key);
+		b3 = _mm_xor_si128(_mm_loadu_si128(in + 3), key);
+		for(round = 1; round < nr; ++round)
+		{
+			key = _mm_loadu_si128(keys + round);
+			b0 = _mm_aesenc_si128(b0, key);
+			b1 = _mm_aesenc_si128(b1, key);
+			b2 = _mm_aesenc_si128(b2, key);
+			b3 = _mm_aesenc_si128(b3, key);
+		}
+		key = _mm_loadu_si128(keys + nr);
+		_mm_storeu_si128(out, _mm_aesenclast_si128(b0, key));
+		_mm_storeu_si128(out + 1, _mm_aesenclast_si128(b1, key));
+		_mm_storeu_si128(out + 2, _mm_aesenclast_si128(b2, key));
+		_mm_storeu_si128(out + 3, _mm_aesenclast_si128(b3, key));
+		in += IL_AES_HW_BLOCKS;
+		out += IL_AES_HW_BLOCKS;
+		numBlocks -= IL_AES_HW_BLOCKS;
+	}
+	while(numBlocks > 0)
+	{
+		_mm_storeu_si128
+			(out, HWEncryptBlock(keys, nr, _mm_loadu_si128(in)));
+		++in;
+		++out;
+		--numBlocks;
+	}
+}
+
+/*
+ * Decrypt a run of blocks in ECB mode using hardware.
+ */
+static IL_AES_HW void HWDecryptECB(ILAESContext *aes, unsigned char *input,
+								   unsigned char *output,
+								   unsigned long numBlocks)
+{
+	const __m128i *keys = (const __m128i *)(aes->decryptKeys);
+	int nr = aes->numRounds;
+	__m128i *in = (__m128i *)input;
+	__m128i *out = (__m128i *)output;
+	__m128i b0, b1, b2, b3, key;
+	int round;
+
+	while(numBlocks >= IL_AES_HW_BLOCKS)
+	{
+		key = _mm_loadu_si128(keys);
+		b0 = _mm_xor_si128(_mm_loadu_si128(in), key);
+		b1 = _mm_xor_si128(_mm_loadu_si128(in + 1), key);
+		b2 = _mm_xor_si128(_mm_loadu_si128(in + 2), key);
+		b3 = _mm_xor_si128(_mm_loadu_si128(in + 3), key);
+		for(round = 1; round < nr; ++round)
+		{
+			key = _mm_loadu_si128(keys + round);
+			b0 = _mm_aesdec_si128(b0, key);
+			b1 = _mm_aesdec_si128(b1, key);
+			b2 = _mm_aesdec_si128(b2, key);
+			b3 = _mm_aesdec_si128(b3, key);
+		}
+		key = _mm_loadu_si128(keys + nr);
+		_mm_storeu_si128(out, _mm_aesdeclast_si128(b0, key));
+		_mm_storeu_si128(out + 1, _mm_aesdeclast_si128(b1, key));
+		_mm_storeu_si128(out + 2, _mm_aesdeclast_si128(b2, key));
+		_mm_storeu_si128(out + 3, _mm_aesdeclast_si128(b3, key));
+		in += IL_AES_HW_BLOCKS;
+		out += IL_AES_HW_BLOCKS;
+		numBlocks -= IL_AES_HW_BLOCKS;
+	}
+	while(numBlocks > 0)
+	{
+		_mm_storeu_si128
+			(out, HWDecryptBlock(keys, nr, _mm_loadu_si128(in)));
+		++in;
+		++out;
+		--numBlocks;
+	}
+}
+
+/*
+ * Encrypt a run of blocks in CBC mode using hardware.  Each block
+ * depends upon the previous one, so there is no pipelining here.
+ */
+static IL_AES_HW void HWEncryptCBC(ILAESContext *aes, unsigned char *iv,
+								   unsigned char *input,
+								   unsigned char *output,
+								   unsigned long numBlocks)
+{
+	const __m128i *keys = (const __m128i *)(aes->encryptKeys);
+	int nr = aes->numRounds;
+	__m128i *in = (__m128i *)input;
+	__m128i *out = (__m128i *)output;
+	__m128i chain = _mm_loadu_si128((__m128i *)iv);
+
+	while(numBlocks > 0)
+	{
+		chain = HWEncryptBlock
+			(keys, nr, _mm_xor_si128(_mm_loadu_si128(in), chain));
+		_mm_storeu_si128(out, chain);
+		++in;
+		++out;
+		--numBlocks;
+	}
+	_mm_storeu_si128((__m128i *)iv, chain);
+}
+
+/*
+ * Decrypt a run of blocks in CBC mode using hardware.  The ciphertext
+ * blocks are all known in advance, so decryption can be pipelined.
+ */
+static IL_AES_HW void HWDecryptCBC(ILAESContext *aes, unsigned char *iv,
+								   unsigned char *input,
+								   unsigned char *output,
+								   unsigned long numBlocks)
+{
+	const __m128i *keys = (const __m128i *)(aes->decryptKeys);
+	int nr = aes->numRounds;
+	__m128i *in = (__m128i *)input;
+	__m128i *out = (__m128i *)output;
+	__m128i chain = _mm_loadu_si128((__m128i *)iv);
+	__m128i c0, c1, c2, c3;
+	__m128i b0, b1, b2, b3, key;
+	int round;
+
+	while(numBlocks >= IL_AES_HW_BLOCKS)
+	{
+		/* Load all of the ciphertext first, in case "in == out" */
+		c0 = _mm_loadu_si128(in);
+		c1 = _mm_loadu_si128(in + 1);
+		c2 = _mm_loadu_si128(in + 2);
+		c3 = _mm_loadu_si128(in + 3);
+		key = _mm_loadu_si128(keys);
+		b0 = _mm_xor_si128(c0, key);
+		b1 = _mm_xor_si128(c1, key);
+		b2 = _mm_xor_si128(c2, key);
+		b3 = _mm_xor_si128(c3, key);
+		for(round = 1; round < nr; ++round)
+		{
+			key = _mm_loadu_si128(keys + round);
+			b0 = _mm_aesdec_si128(b0, key);
+			b1 = _mm_aesdec_si128(b1, key);
+			b2 = _mm_aesdec_si128(b2, key);
+			b3 = _mm_aesdec_si128(b3, key);
+		}
+		key = _mm_loadu_si128(keys + nr);
+		b0 = _mm_aesdeclast_si128(b0, key);
+		b1 = _mm_aesdeclast_si128(b1, key);
+		b2 = _mm_aesdeclast_si128(b2, key);
+		b3 = _mm_aesdeclast_si128(b3, key);
+		_mm_storeu_si128(out, _mm_xor_si128(b0, chain));
+		_mm_storeu_si128(out + 1, _mm_xor_si128(b1, c0));
+		_mm_storeu_si128(out + 2, _mm_xor_si128(b2, c1));
+		_mm_storeu_si128(out + 3, _mm_xor_si128(b3, c2));
+		chain = c3;
+		in += IL_AES_HW_BLOCKS;
+		out += IL_AES_HW_BLOCKS;
+		numBlocks -= IL_AES_HW_BLOCKS;
+	}
+	while(numBlocks > 0)
+	{
+		c0 = _mm_loadu_si128(in);
+		b0 = HWDecryptBlock(keys, nr, c0);
+		_mm_storeu_si128(out, _mm_xor_si128(b0, chain));
+		chain = c0;
+		++in;
+		++out;
+		--numBlocks;
+	}
+	_mm_storeu_si128((__m128i *)iv, chain);
+}
+
+#endif /* IL_CRYPT_X86_HW */
+
 /*
  * Perform a finite field multiplication in GF(2^8).
  */
@@ -275,6 +538,16 @@ void ILAESInit(ILAESContext *aes, unsigned char *key, int keyBits)
 		aes->keySchedule[i] = aes->keySchedule[i - nk] ^ temp;
 	}
 
+	/* Prepare the round keys for the hardware, if it is available */
+	aes->useHardware = 0;
+#ifdef IL_CRYPT_X86_HW
+	if((ILCryptHardware() & IL_CRYPT_HW_AES) != 0)
+	{
+		HWSetupKeys(aes);
+		aes->useHardware = 1;
+	}
+#endif
+
 	/* Clear temporary values */
 	temp = 0;
 }
@@ -289,6 +562,14 @@ void ILAESEncrypt(ILAESContext *aes, unsigned char *input,
 	ILInt32 ncol0, ncol1, ncol2, ncol3;
 	int keyIndex, round;
 
+#ifdef IL_CRYPT_X86_HW
+	if(aes->useHardware)
+	{
+		HWEncryptECB(aes, input, output, 1);
+		return;
+	}
+#endif
+
 	/* Unpack the input block into the state columns */
 	col0 = IL_BREAD_INT32(input);
 	col1 = IL_BREAD_INT32(input + 4);
@@ -379,6 +660,14 @@ void ILAESDecrypt(ILAESContext *aes, unsigned char *input,
 	ILInt32 ncol0, ncol1, ncol2, ncol3;
 	int keyIndex, round;
 
+#ifdef IL_CRYPT_X86_HW
+	if(aes->useHardware)
+	{
+		HWDecryptECB(aes, input, output, 1);
+		return;
+	}
+#endif
+
 	/* Unpack the input block into the state columns */
 	col0 = IL_BREAD_INT32(input);
 	col1 = IL_BREAD_INT32(input + 4);
@@ -459,6 +748,99 @@ void ILAESDecrypt(ILAESContext *aes, unsigned char *input,
 	ncol0 = ncol1 = ncol2 = ncol3 = 0;
 }
 
+void ILAESEncryptECB(ILAESContext *aes, unsigned char *input,
+					 unsigned char *output, unsigned long numBlocks)
+{
+#ifdef IL_CRYPT_X86_HW
+	if(aes->useHardware)
+	{
+		HWEncryptECB(aes, input, output, numBlocks);
+		return;
+	}
+#endif
+	while(numBlocks > 0)
+	{
+		ILAESEncrypt(aes, input, output);
+		input += 16;
+		output += 16;
+		--numBlocks;
+	}
+}
+
+void ILAESDecryptECB(ILAESContext *aes, unsigned char *input,
+					 unsigned char *output, unsigned long numBlocks)
+{
+#ifdef IL_CRYPT_X86_HW
+	if(aes->useHardware)
+	{
+		HWDecryptECB(aes, input, output, numBlocks);
+		return;
+	}
+#endif
+	while(numBlocks > 0)
+	{
+		ILAESDecrypt(aes, input, output);
+		input += 16;
+		output += 16;
+		--numBlocks;
+	}
+}
+
+void ILAESEncryptCBC(ILAESContext *aes, unsigned char *iv,
+					 unsigned char *input, unsigned char *output,
+					 unsigned long numBlocks)
+{
+	int posn;
+#ifdef IL_CRYPT_X86_HW
+	if(aes->useHardware)
+	{
+		HWEncryptCBC(aes, iv, input, output, numBlocks);
+		return;
+	}
+#endif
+	while(numBlocks > 0)
+	{
+		for(posn = 0; posn < 16; ++posn)
+		{
+			iv[posn] ^= input[posn];
+		}
+		ILAESEncrypt(aes, iv, iv);
+		ILMemCpy(output, iv, 16);
+		input += 16;
+		output += 16;
+		--numBlocks;
+	}
+}
+
+void ILAESDecryptCBC(ILAESContext *aes, unsigned char *iv,
+					 unsigned char *input, unsigned char *output,
+					 unsigned long numBlocks)
+{
+	unsigned char block[16];
+	int posn;
+#ifdef IL_CRYPT_X86_HW
+	if(aes->useHardware)
+	{
+		HWDecryptCBC(aes, iv, input, output, numBlocks);
+		return;
+	}
+#endif
+	while(numBlocks > 0)
+	{
+		ILMemCpy(block, input, 16);
+		ILAESDecrypt(aes, input, output);
+		for(posn = 0; posn < 16; ++posn)
+		{
+			output[posn] ^= iv[posn];
+		}
+		ILMemCpy(iv, block, 16);
+		input += 16;
+		output += 16;
+		--numBlocks;
+	}
+	ILMemZero(block, sizeof(block));
+}
+
 void ILAESFinalize(ILAESContext *aes)
 {
 	ILMemZero(aes, sizeof(ILAESContext));
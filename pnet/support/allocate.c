@@ -366,6 +366,71 @@ void  ILPageFree(void *ptr, unsigned long size)
 #endif
 }
 
+/*
+ * Determine how to reserve address space without committing memory.
+ */
+#if defined(_WIN32)
+	#define	IL_RESERVE_WIN32
+#elif !defined(IL_USE_MALLOC_FOR_PAGES) && defined(MAP_ANON) && \
+	  defined(HAVE_MPROTECT)
+	#define	IL_RESERVE_MMAP
+#endif
+
+void *ILPageReserve(unsigned long size)
+{
+#if defined(IL_RESERVE_WIN32)
+	return VirtualAlloc(0, size, MEM_RESERVE, PAGE_NOACCESS);
+#elif defined(IL_RESERVE_MMAP)
+	void *addr;
+#ifdef MAP_NORESERVE
+	addr = mmap((void *)0, size, PROT_NONE,
+				MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0);
+#else
+	addr = mmap((void *)0, size, PROT_NONE, MAP_PRIVATE | MAP_ANON, -1, 0);
+#endif
+	if(addr == (void *)(-1))
+	{
+		return 0;
+	}
+	return addr;
+#else
+	/* No way to reserve without committing, so allocate it all now */
+	return ILCalloc(size, 1);
+#endif
+}
+
+int ILPageCommit(void *ptr, unsigned long size)
+{
+#if defined(IL_RESERVE_WIN32)
+	return (VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != 0);
+#elif defined(IL_RESERVE_MMAP)
+	return (mprotect(ptr, size, PROT_READ | PROT_WRITE) == 0);
+#else
+	return 1;
+#endif
+}
+
+void ILPageDiscard(void *ptr, unsigned long size)
+{
+#if defined(IL_RESERVE_WIN32)
+	VirtualAlloc(ptr, size, MEM_RESET, PAGE_READWRITE);
+#elif defined(IL_RESERVE_MMAP) && defined(HAVE_MADVISE) && \
+	  defined(MADV_DONTNEED)
+	madvise(ptr, size, MADV_DONTNEED);
+#endif
+}
+
+void ILPageRelease(void *ptr, unsigned long size)
+{
+#if defined(IL_RESERVE_WIN32)
+	VirtualFree(ptr, 0, MEM_RELEASE);
+#elif defined(IL_RESERVE_MMAP)
+	munmap(ptr, size);
+#else
+	ILFree(ptr);
+#endif
+}
+
 #ifdef	__cplusplus
 };
 #endif
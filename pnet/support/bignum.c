@@ -19,9 +19,10 @@
  */
 
 /*
- * Note: this implementation is designed for clarity and ease
- * of debugging, not speed.  If you really want speed, then
- * replace this entire file with assembly code.
+ * Note: this implementation is mostly designed for clarity and ease
+ * of debugging, not speed.  The exceptions are the Karatsuba method
+ * in "ILBigNumMul" and the Montgomery method in "ILBigNumPow", which
+ * dominate the cost of public key operations.
  */
 
 #include "il_bignum.h"
@@ -907,13 +908,154 @@ static int DivRem(ILBigNum *numx, ILBigNum *numy,
 	return 1;
 }
 
+/*
+ * Operands that are at least this many words long are multiplied
+ * using the Karatsuba method.  Below this, the extra additions cost
+ * more than the multiplications that they save.
+ */
+#define	IL_BIG_KARATSUBA_THRESHOLD	32
+
+/*
+ * Multiply two word arrays using the schoolbook method.
+ * "result" must have room for "xsize + ysize" words.
+ */
+static void MulWords(ILUInt32 *result, const ILUInt32 *x, ILInt32 xsize,
+					 const ILUInt32 *y, ILInt32 ysize)
+{
+	ILInt32 xposn, yposn, posn;
+	ILUInt64 temp;
+
+	ILMemZero(result, (xsize + ysize) * sizeof(ILUInt32));
+	for(xposn = 0; xposn < xsize; ++xposn)
+	{
+		temp = 0;
+		posn = xposn;
+		for(yposn = 0; yposn < ysize; ++yposn)
+		{
+			temp += ((ILUInt64)(x[xposn])) * ((ILUInt64)(y[yposn])) +
+					((ILUInt64)(result[posn]));
+			result[posn] = (ILUInt32)temp;
+			temp >>= 32;
+			++posn;
+		}
+		result[posn] = (ILUInt32)temp;
+	}
+}
+
+/*
+ * Add "x" to "result", propagating the carry through "rsize" words.
+ */
+static void AddWordsTo(ILUInt32 *result, ILInt32 rsize,
+					   const ILUInt32 *x, ILInt32 xsize)
+{
+	ILUInt64 temp = 0;
+	ILInt32 posn;
+	for(posn = 0; posn < xsize; ++posn)
+	{
+		temp += ((ILUInt64)(result[posn])) + ((ILUInt64)(x[posn]));
+		result[posn] = (ILUInt32)temp;
+		temp >>= 32;
+	}
+	while(temp != 0 && posn < rsize)
+	{
+		temp += (ILUInt64)(result[posn]);
+		result[posn] = (ILUInt32)temp;
+		temp >>= 32;
+		++posn;
+	}
+}
+
+/*
+ * Subtract "x" from "result", propagating the borrow through
+ * "rsize" words.  The result must not be negative.
+ */
+static void SubWordsFrom(ILUInt32 *result, ILInt32 rsize,
+						 const ILUInt32 *x, ILInt32 xsize)
+{
+	ILUInt32 borrow = 0;
+	ILUInt32 word;
+	ILInt32 posn;
+	for(posn = 0; posn < xsize; ++posn)
+	{
+		word = result[posn] - x[posn] - borrow;
+		borrow = (result[posn] < x[posn] ||
+				  (result[posn] == x[posn] && borrow));
+		result[posn] = word;
+	}
+	while(borrow && posn < rsize)
+	{
+		borrow = (result[posn] == 0);
+		--(result[posn]);
+		++posn;
+	}
+}
+
+/*
+ * Get the number of scratch words that "KaratsubaMul" needs
+ * for operands of a particular size.
+ */
+static ILInt32 KaratsubaScratch(ILInt32 size)
+{
+	ILInt32 high;
+	if(size < IL_BIG_KARATSUBA_THRESHOLD)
+	{
+		return 0;
+	}
+	high = size - size / 2;
+	return 4 * (high + 1) + KaratsubaScratch(high + 1);
+}
+
+/*
+ * Multiply two word arrays of the same size using the Karatsuba
+ * method, which replaces one of the four half-size products with
+ * additions.  "result" must have room for "2 * size" words.
+ */
+static void KaratsubaMul(ILUInt32 *result, const ILUInt32 *x,
+						 const ILUInt32 *y, ILInt32 size, ILUInt32 *scratch)
+{
+	ILInt32 low, high;
+	ILUInt32 *sumx;
+	ILUInt32 *sumy;
+	ILUInt32 *middle;
+
+	if(size < IL_BIG_KARATSUBA_THRESHOLD)
+	{
+		MulWords(result, x, size, y, size);
+		return;
+	}
+
+	/* Split "x" and "y" into "x1 * B + x0" and "y1 * B + y0",
+	   and compute "x0 * y0" and "x1 * y1" in place */
+	low = size / 2;
+	high = size - low;
+	KaratsubaMul(result, x, y, low, scratch);
+	KaratsubaMul(result + 2 * low, x + low, y + low, high, scratch);
+
+	/* Compute "(x0 + x1) * (y0 + y1) - x0 * y0 - x1 * y1" */
+	sumx = scratch;
+	sumy = sumx + high + 1;
+	middle = sumy + high + 1;
+	ILMemCpy(sumx, x + low, high * sizeof(ILUInt32));
+	sumx[high] = 0;
+	AddWordsTo(sumx, high + 1, x, low);
+	ILMemCpy(sumy, y + low, high * sizeof(ILUInt32));
+	sumy[high] = 0;
+	AddWordsTo(sumy, high + 1, y, low);
+	KaratsubaMul(middle, sumx, sumy, high + 1, middle + 2 * (high + 1));
+	SubWordsFrom(middle, 2 * (high + 1), result, 2 * low);
+	SubWordsFrom(middle, 2 * (high + 1), result + 2 * low, 2 * high);
+
+	/* Add the middle term into the result.  Its top words are zero
+	   beyond the end of the result */
+	AddWordsTo(result + low, 2 * size - low, middle, 2 * (high + 1));
+}
+
 ILBigNum *ILBigNumMul(ILBigNum *numx, ILBigNum *numy, ILBigNum *modulus)
 {
 	ILBigNum *product;
 	ILBigNum *modProduct;
-	ILInt32 size;
-	ILInt32 xposn, yposn, posn;
-	ILUInt64 temp;
+	ILInt32 size, half;
+	ILUInt32 *scratch;
 
 	/* Allocate space for the intermediate product */
 	size = numx->size + numy->size;
@@ -922,6 +1064,19 @@ ILBigNum *ILBigNumMul(ILBigNum *numx, ILBigNum *numy, ILBigNum *modulus)
 		/* We know that the answer will be zero */
 		return ILBigNumFromInt(0);
 	}
+	if(numx->size >= IL_BIG_KARATSUBA_THRESHOLD &&
+	   numy->size >= IL_BIG_KARATSUBA_THRESHOLD &&
+	   numx->size <= numy->size * 2 && numy->size <= numx->size * 2)
+	{
+		/* Both values are large and of similar size: pad them to
+		   the same size and use the Karatsuba method */
+		half = (numx->size > numy->size ? numx->size : numy->size);
+		size = half * 2;
+	}
+	else
+	{
+		half = 0;
+	}
 	product = (ILBigNum *)ILMalloc(sizeof(ILBigNum) +
 								   (size - 1) * sizeof(ILUInt32));
 	if(!product)
@@ -930,30 +1085,30 @@ ILBigNum *ILBigNumMul(ILBigNum *numx, ILBigNum *numy, ILBigNum *modulus)
 	}
 	product->size = size;
 	product->neg = (numx->neg ^ numy->neg);
-	ILMemZero(product->words, size * sizeof(ILUInt32));
 
 	/* Calculate the intermediate product */
-	for(xposn = 0; xposn < numx->size; ++xposn)
+	if(half)
 	{
-		temp = 0;
-		posn = xposn;
-		for(yposn = 0; yposn < numy->size; ++yposn)
+		scratch = (ILUInt32 *)ILMalloc
+			((half * 2 + KaratsubaScratch(half)) * sizeof(ILUInt32));
+		if(!scratch)
 		{
-			temp += ((ILUInt64)(numx->words[xposn])) *
-			        ((ILUInt64)(numy->words[yposn])) +
-					((ILUInt64)(product->words[posn]));
-			product->words[posn] = (ILUInt32)temp;
-			temp >>= 32;
-			++posn;
-		}
-		while(temp != 0)
-		{
-			/* Propagate the carry */
-			temp += product->words[posn];
-			product->words[posn] = (ILUInt32)temp;
-			temp >>= 32;
-			++posn;
+			ILFree(product);
+			return 0;
 		}
+		ILMemZero(scratch, half * 2 * sizeof(ILUInt32));
+		ILMemCpy(scratch, numx->words, numx->size * sizeof(ILUInt32));
+		ILMemCpy(scratch + half, numy->words, numy->size * sizeof(ILUInt32));
+		KaratsubaMul(product->words, scratch, scratch + half, half,
+					 scratch + half * 2);
+		ILMemZero(scratch, (half * 2 + KaratsubaScratch(half)) *
+								sizeof(ILUInt32));
+		ILFree(scratch);
+	}
+	else
+	{
+		MulWords(product->words, numx->words, numx->size,
+				 numy->words, numy->size);
 	}
 
 	/* Normalize the intermediate product */
@@ -1105,6 +1260,325 @@ cleanup:
 	return 0;
 }
 
+/*
+ * Limb type for Montgomery multiplication.  64-bit limbs are used
+ * if the compiler has a 128-bit type to hold their products.
+ */
+#if defined(__SIZEOF_INT128__)
+typedef ILUInt64 ILBigLimb;
+typedef unsigned __int128 ILBigDoubleLimb;
+#define	IL_BIG_LIMB_BITS	64
+#else
+typedef ILUInt32 ILBigLimb;
+typedef ILUInt64 ILBigDoubleLimb;
+#define	IL_BIG_LIMB_BITS	32
+#endif
+#define	IL_BIG_WORDS_PER_LIMB	(IL_BIG_LIMB_BITS / 32)
+
+/*
+ * Context for exponentiation modulo an odd number using Montgomery
+ * multiplication.  All values are "size" limbs long and live in a
+ * single scratch buffer, so the main loop never allocates memory.
+ */
+typedef struct
+{
+	ILInt32		size;
+	ILBigLimb	minv;
+	ILBigLimb  *modulus;
+	ILBigLimb  *temp;
+
+} MontContext;
+
+/*
+ * Copy the words of a big number into a limb array.
+ */
+static void WordsToLimbs(ILBigLimb *limbs, ILInt32 size, ILBigNum *num)
+{
+	ILInt32 posn;
+	ILMemZero(limbs, size * sizeof(ILBigLimb));
+	for(posn = 0; posn < num->size; ++posn)
+	{
+		limbs[posn / IL_BIG_WORDS_PER_LIMB] |=
+			((ILBigLimb)(num->words[posn])) <<
+				((posn % IL_BIG_WORDS_PER_LIMB) * 32);
+	}
+}
+
+/*
+ * Compute "result = x * y * R^-1 mod modulus", where R is 2 to the
+ * power of the modulus size in bits.  This uses the "CIOS" method,
+ * which interleaves the multiplication and reduction steps.  The
+ * result may be the same as "x" or "y".
+ */
+static void MontMul(MontContext *ctx, ILBigLimb *result,
+					const ILBigLimb *x, const ILBigLimb *y)
+{
+	ILInt32 size = ctx->size;
+	const ILBigLimb *modulus = ctx->modulus;
+	ILBigLimb *temp = ctx->temp;
+	ILBigDoubleLimb product;
+	ILBigLimb carry, quot, borrow, diff;
+	ILInt32 i, j;
+
+	ILMemZero(temp, (size + 2) * sizeof(ILBigLimb));
+	for(i = 0; i < size; ++i)
+	{
+		/* temp += x * y[i] */
+		carry = 0;
+		for(j = 0; j < size; ++j)
+		{
+			product = ((ILBigDoubleLimb)(x[j])) * ((ILBigDoubleLimb)(y[i])) +
+					  (ILBigDoubleLimb)(temp[j]) + (ILBigDoubleLimb)carry;
+			temp[j] = (ILBigLimb)product;
+			carry = (ILBigLimb)(product >> IL_BIG_LIMB_BITS);
+		}
+		product = ((ILBigDoubleLimb)(temp[size])) + (ILBigDoubleLimb)carry;
+		temp[size] = (ILBigLimb)product;
+		temp[size + 1] = (ILBigLimb)(product >> IL_BIG_LIMB_BITS);
+
+		/* temp = (temp + quot * modulus) / 2^IL_BIG_LIMB_BITS, where
+		   "quot" is chosen to make the bottom limb zero */
+		quot = temp[0] * ctx->minv;
+		product = ((ILBigDoubleLimb)quot) * ((ILBigDoubleLimb)(modulus[0])) +
+				  (ILBigDoubleLimb)(temp[0]);
+		carry = (ILBigLimb)(product >> IL_BIG_LIMB_BITS);
+		for(j = 1; j < size; ++j)
+		{
+			product = ((ILBigDoubleLimb)quot) *
+					  ((ILBigDoubleLimb)(modulus[j])) +
+					  (ILBigDoubleLimb)(temp[j]) + (ILBigDoubleLimb)carry;
+			temp[j - 1] = (ILBigLimb)product;
+			carry = (ILBigLimb)(product >> IL_BIG_LIMB_BITS);
+		}
+		product = ((ILBigDoubleLimb)(temp[size])) + (ILBigDoubleLimb)carry;
+		temp[size - 1] = (ILBigLimb)product;
+		temp[size] = temp[size + 1] +
+					 (ILBigLimb)(product >> IL_BIG_LIMB_BITS);
+	}
+
+	/* The result is less than twice the modulus: subtract it once
+	   if the result is greater than or equal to the modulus */
+	if(temp[size] == 0)
+	{
+		for(i = size - 1; i >= 0; --i)
+		{
+			if(temp[i] != modulus[i])
+			{
+				break;
+			}
+		}
+		if(i >= 0 && temp[i] < modulus[i])
+		{
+			ILMemCpy(result, temp, size * sizeof(ILBigLimb));
+			return;
+		}
+	}
+	borrow = 0;
+	for(i = 0; i < size; ++i)
+	{
+		diff = temp[i] - modulus[i];
+		result[i] = diff - borrow;
+		borrow = ((temp[i] < modulus[i]) | (diff < borrow));
+	}
+}
+
+/*
+ * Compute "numx ^ numy mod modulus" for an odd modulus using Montgomery
+ * multiplication and the sliding window method.  The sign of "numy"
+ * is ignored.  Returns NULL if out of memory.
+ */
+static ILBigNum *MontPow(ILBigNum *numx, ILBigNum *numy, ILBigNum *modulus)
+{
+	MontContext ctx;
+	ILBigNum *temp;
+	ILBigNum *reduced;
+	ILBigNum *result;
+	ILBigLimb *buffer;
+	ILBigLimb *table;
+	ILBigLimb *acc;
+	ILBigLimb *square;
+	ILInt32 size, bufSize, bits, posn, low, index;
+	ILUInt32 window;
+	int windowBits, numEntries, haveAcc, bit;
+
+	/* Determine the window size from the number of exponent bits */
+	bits = numy->size * 32;
+	while(bits > 0 &&
+		  (numy->words[(bits - 1) / 32] & (((ILUInt32)1) << ((bits - 1) % 32)))
+		  		== 0)
+	{
+		--bits;
+	}
+	if(bits > 671)
+	{
+		windowBits = 6;
+	}
+	else if(bits > 239)
+	{
+		windowBits = 5;
+	}
+	else if(bits > 79)
+	{
+		windowBits = 4;
+	}
+	else if(bits > 23)
+	{
+		windowBits = 3;
+	}
+	else
+	{
+		windowBits = 1;
+	}
+	numEntries = (1 << (windowBits - 1));
+
+	/* Allocate a single scratch buffer for all working values: the
+	   modulus, "size + 2" limbs for "MontMul", the table of odd powers,
+	   the accumulator, and the square of "numx" */
+	size = (modulus->size + IL_BIG_WORDS_PER_LIMB - 1) / IL_BIG_WORDS_PER_LIMB;
+	bufSize = size * (numEntries + 4) + 2;
+	buffer = (ILBigLimb *)ILMalloc(bufSize * sizeof(ILBigLimb));
+	if(!buffer)
+	{
+		return 0;
+	}
+	ctx.size = size;
+	ctx.modulus = buffer;
+	ctx.temp = buffer + size;
+	table = ctx.temp + size + 2;
+	acc = table + numEntries * size;
+	square = acc + size;
+	WordsToLimbs(ctx.modulus, size, modulus);
+
+	/* Compute "-modulus^-1 mod 2^IL_BIG_LIMB_BITS" using Newton's
+	   method: each iteration doubles the number of correct bits */
+	ctx.minv = 1;
+	for(bit = 1; bit < IL_BIG_LIMB_BITS; bit *= 2)
+	{
+		ctx.minv *= 2 - ctx.modulus[0] * ctx.minv;
+	}
+	ctx.minv = (ILBigLimb)0 - ctx.minv;
+
+	/* Convert "numx" into Montgomery form by computing "numx * R mod
+	   modulus" with the general division routine.  This is the only
+	   division that is needed */
+	temp = (ILBigNum *)ILMalloc(sizeof(ILBigNum) +
+			(numx->size + size * IL_BIG_WORDS_PER_LIMB - 1) * sizeof(ILUInt32));
+	if(!temp)
+	{
+		ILFree(buffer);
+		return 0;
+	}
+	temp->size = numx->size + size * IL_BIG_WORDS_PER_LIMB;
+	temp->neg = 0;
+	ILMemZero(temp->words, size * IL_BIG_WORDS_PER_LIMB * sizeof(ILUInt32));
+	ILMemCpy(temp->words + size * IL_BIG_WORDS_PER_LIMB, numx->words,
+			 numx->size * sizeof(ILUInt32));
+	NormalizeBigNum(temp);
+	if(!DivRem(temp, modulus, (ILBigNum **)0, &reduced))
+	{
+		ILBigNumFree(temp);
+		ILFree(buffer);
+		return 0;
+	}
+	ILBigNumFree(temp);
+	WordsToLimbs(table, size, reduced);
+	ILBigNumFree(reduced);
+
+	/* Build the table of odd powers "numx^1, numx^3, numx^5, ..." */
+	if(numEntries > 1)
+	{
+		MontMul(&ctx, square, table, table);
+		for(index = 1; index < numEntries; ++index)
+		{
+			MontMul(&ctx, table + index * size,
+					table + (index - 1) * size, square);
+		}
+	}
+
+	/* Scan the exponent from the most significant bit down, squaring
+	   for each bit and multiplying by a table entry for each window */
+	haveAcc = 0;
+	posn = bits - 1;
+	while(posn >= 0)
+	{
+		if((numy->words[posn / 32] & (((ILUInt32)1) << (posn % 32))) == 0)
+		{
+			if(haveAcc)
+			{
+				MontMul(&ctx, acc, acc, acc);
+			}
+			--posn;
+			continue;
+		}
+
+		/* Find the longest window that ends in a 1 bit */
+		low = posn - windowBits + 1;
+		if(low < 0)
+		{
+			low = 0;
+		}
+		while((numy->words[low / 32] & (((ILUInt32)1) << (low % 32))) == 0)
+		{
+			++low;
+		}
+		window = 0;
+		for(index = posn; index >= low; --index)
+		{
+			window = (window << 1) |
+				((numy->words[index / 32] >> (index % 32)) & 1);
+			if(haveAcc)
+			{
+				MontMul(&ctx, acc, acc, acc);
+			}
+		}
+
+		/* Multiply by "numx^window" */
+		if(haveAcc)
+		{
+			MontMul(&ctx, acc, acc, table + (window >> 1) * size);
+		}
+		else
+		{
+			ILMemCpy(acc, table + (window >> 1) * size,
+					 size * sizeof(ILBigLimb));
+			haveAcc = 1;
+		}
+		posn = low - 1;
+	}
+
+	/* Convert the accumulator out of Montgomery form by multiplying
+	   it by 1.  An exponent of zero gives a result of 1 */
+	ILMemZero(square, size * sizeof(ILBigLimb));
+	square[0] = 1;
+	if(haveAcc)
+	{
+		MontMul(&ctx, acc, acc, square);
+	}
+	else
+	{
+		ILMemCpy(acc, square, size * sizeof(ILBigLimb));
+	}
+	result = (ILBigNum *)ILMalloc(sizeof(ILBigNum) +
+				(size * IL_BIG_WORDS_PER_LIMB - 1) * sizeof(ILUInt32));
+	if(result)
+	{
+		result->size = size * IL_BIG_WORDS_PER_LIMB;
+		result->neg = 0;
+		for(posn = 0; posn < result->size; ++posn)
+		{
+			result->words[posn] = (ILUInt32)
+				(acc[posn / IL_BIG_WORDS_PER_LIMB] >>
+					((posn % IL_BIG_WORDS_PER_LIMB) * 32));
+		}
+		NormalizeBigNum(result);
+	}
+
+	/* Clear the scratch buffer, in case it contains sensitive values */
+	ILMemZero(buffer, bufSize * sizeof(ILBigLimb));
+	ILFree(buffer);
+	return result;
+}
+
 ILBigNum *ILBigNumPow(ILBigNum *numx, ILBigNum *numy, ILBigNum *modulus)
 {
 	ILBigNum *power;
@@ -1113,7 +1587,22 @@ ILBigNum *ILBigNumPow(ILBigNum *numx, ILBigNum *numy, ILBigNum *modulus)
 	ILInt32 posn;
 	ILUInt32 mask;
 	int bit;
-	
+
+	/* Use Montgomery multiplication if the modulus is odd and greater
+	   than 1, which is always the case for RSA and DSA */
+	if(modulus != 0 && !(modulus->neg) && !(numx->neg) &&
+	   modulus->size > 0 && (modulus->words[0] & 1) != 0 &&
+	   (modulus->size > 1 || modulus->words[0] > 1))
+	{
+		power = 0;
+		result = MontPow(numx, numy, modulus);
+		if(!result)
+		{
+			return 0;
+		}
+		goto invert;
+	}
+
 	/* Set the initial power value to "numx" */
 	power = ILBigNumCopy(numx);
 	if(!power)
@@ -1169,6 +1658,7 @@ ILBigNum *ILBigNumPow(ILBigNum *numx, ILBigNum *numy, ILBigNum *modulus)
 	}
 
 	/* If "numy" is negative, then invert the result */
+invert:
 	if(numy->neg && modulus != 0)
 	{
 		temp = ILBigNumInv(result, modulus);
@@ -0,0 +1,97 @@
+/*
+ * crypt_hw.c - Detect the hardware support for cryptographic primitives.
+ *
+ * Copyright (C) 2026  Free Software Foundation, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "il_crypt.h"
+#include "il_system.h"
+#ifdef IL_CRYPT_X86_HW
+#include <cpuid.h>
+#endif
+
+#ifdef	__cplusplus
+extern	"C" {
+#endif
+
+/*
+ * The features reported by the CPU, or -1 if not queried yet, and
+ * the mask of features that the caller permits us to use.  Racing
+ * threads compute the same value, so no lock is needed.
+ */
+static int detected = -1;
+static int permitted = ~0;
+
+/*
+ * Query the CPU for the features that we are interested in.
+ */
+static int DetectFeatures(void)
+{
+	int features = 0;
+#ifdef IL_CRYPT_X86_HW
+	unsigned int eax, ebx, ecx, edx;
+	unsigned int maxLeaf;
+
+	maxLeaf = __get_cpuid_max(0, 0);
+	if(maxLeaf < 1)
+	{
+		return 0;
+	}
+	__cpuid(1, eax, ebx, ecx, edx);
+	if((edx & bit_SSE2) == 0)
+	{
+		return 0;
+	}
+	if((ecx & bit_SSSE3) != 0)
+	{
+		features |= IL_CRYPT_HW_SSSE3;
+	}
+	if((ecx & bit_AES) != 0 && (ecx & bit_SSE4_1) != 0)
+	{
+		features |= IL_CRYPT_HW_AES;
+	}
+	if(maxLeaf >= 7 && (ecx & bit_SSSE3) != 0 && (ecx & bit_SSE4_1) != 0)
+	{
+		__cpuid_count(7, 0, eax, ebx, ecx, edx);
+		if((ebx & (1 << 29)) != 0)
+		{
+			features |= IL_CRYPT_HW_SHA;
+		}
+	}
+#endif
+	return features;
+}
+
+int ILCryptHardware(void)
+{
+	if(detected < 0)
+	{
+		detected = DetectFeatures();
+	}
+	return (detected & permitted);
+}
+
+int ILCryptSetHardware(int mask)
+{
+	int previous = permitted;
+	permitted = mask;
+	return previous;
+}
+
+#ifdef	__cplusplus
+};
+#endif
@@ -43,6 +43,21 @@ extern	"C" {
 			((((ILUInt32)(decpt)) << 16) | \
 				((sign) ? (ILUInt32)0x80000000 : (ILUInt32)0))
 
+/*
+ * Get the low 64 bits of a decimal value's mantissa.
+ */
+#define	DECIMAL_LOW64(value)	\
+			((((ILUInt64)((value)->middle)) << 32) | (ILUInt64)((value)->low))
+
+/*
+ * Use 128-bit integers for the multiplication fast path
+ * if the compiler supports them.
+ */
+#if defined(__SIZEOF_INT128__)
+#define	IL_DECIMAL_INT128	1
+typedef unsigned __int128 ILDecimalUInt128;
+#endif
+
 /*
  * Divide a value by ten, returning the result and a remainder.
  */
@@ -260,9 +275,27 @@ static int CmpAbs(const ILDecimal *valuea, const ILDecimal *valueb, int sign)
 {
 	ILUInt32 tempa[6];
 	ILUInt32 tempb[6];
+	ILUInt64 lowa, lowb;
 	int decpta, decptb;
 	int posn;
 
+	/* Values with the same decimal point can be compared directly */
+	if(DECIMAL_GETPT(valuea) == DECIMAL_GETPT(valueb))
+	{
+		lowa = DECIMAL_LOW64(valuea);
+		lowb = DECIMAL_LOW64(valueb);
+		if(valuea->high > valueb->high ||
+		   (valuea->high == valueb->high && lowa > lowb))
+		{
+			return (sign ? -1 : 1);
+		}
+		else if(valuea->high < valueb->high || lowa < lowb)
+		{
+			return (sign ? 1 : -1);
+		}
+		return 0;
+	}
+
 	/* Load "valuea" and "valueb" into 192-bit temporary registers */
 	tempa[0] = tempa[1] = tempa[2] = 0;
 	tempa[3] = valuea->high;
@@ -441,6 +474,110 @@ static int SubValues(ILUInt32 *tempa, const ILDecimal *valuea,
 	return decpta;
 }
 
+/*
+ * Remove trailing zeroes from the fractional part of a 96-bit
+ * value held in "high" and "low".  Returns the new position
+ * of the decimal point.
+ */
+static int StripZeros(ILUInt32 *high, ILUInt64 *low, int decpt)
+{
+	ILUInt64 part;
+	ILUInt64 middle;
+
+	while(decpt > 0)
+	{
+		/* 2^64 is 6 modulo 10, so the last digit can be
+		   found without dividing the whole value */
+		if(((((ILUInt64)(*high % 10)) * 6) + (*low % 10)) % 10 != 0)
+		{
+			break;
+		}
+
+		/* Divide the value by ten, 32 bits at a time */
+		part = (ILUInt64)(*high % 10);
+		*high /= 10;
+		part = (part << 32) | (*low >> 32);
+		middle = part / 10;
+		part = ((part % 10) << 32) | (*low & (ILUInt64)0xFFFFFFFF);
+		*low = (middle << 32) | (part / 10);
+		--decpt;
+	}
+	return decpt;
+}
+
+/*
+ * Store a normalized 96-bit result into a decimal value.
+ */
+static void StoreResult(ILDecimal *result, ILUInt32 high, ILUInt64 low,
+						int sign, int decpt)
+{
+	if(high == 0 && low == 0)
+	{
+		/* The sign of zero must always be positive */
+		sign = 0;
+		decpt = 0;
+	}
+	result->high = high;
+	result->middle = (ILUInt32)(low >> 32);
+	result->low = (ILUInt32)low;
+	result->flags = DECIMAL_MKFLAGS(sign, decpt);
+}
+
+/*
+ * Add two values that have the same decimal point position, with
+ * the signs given by "signa" and "signb".  The arithmetic is done
+ * with 64-bit words and no intermediate scaling.  Returns zero if
+ * the result does not fit, and the general algorithm is needed.
+ */
+static int AddSameScale(ILDecimal *result, const ILDecimal *valuea,
+						const ILDecimal *valueb, int signa, int signb)
+{
+	ILUInt64 lowa, lowb, low, high;
+	ILUInt32 top;
+	int decpt, sign;
+
+	decpt = DECIMAL_GETPT(valuea);
+	if(decpt != DECIMAL_GETPT(valueb) || decpt > 28)
+	{
+		return 0;
+	}
+	lowa = DECIMAL_LOW64(valuea);
+	lowb = DECIMAL_LOW64(valueb);
+	if(signa == signb)
+	{
+		/* Add the magnitudes, bailing out on a carry out of 96 bits */
+		low = lowa + lowb;
+		high = ((ILUInt64)(valuea->high)) + ((ILUInt64)(valueb->high)) +
+			   (low < lowa ? 1 : 0);
+		if(high > (ILUInt64)0xFFFFFFFF)
+		{
+			return 0;
+		}
+		sign = signa;
+	}
+	else if(valuea->high > valueb->high ||
+			(valuea->high == valueb->high && lowa >= lowb))
+	{
+		/* Subtract the second magnitude from the first */
+		low = lowa - lowb;
+		high = ((ILUInt64)(valuea->high)) - ((ILUInt64)(valueb->high)) -
+			   (lowa < lowb ? 1 : 0);
+		sign = signa;
+	}
+	else
+	{
+		/* Subtract the first magnitude from the second */
+		low = lowb - lowa;
+		high = ((ILUInt64)(valueb->high)) - ((ILUInt64)(valuea->high)) -
+			   (lowb < lowa ? 1 : 0);
+		sign = signb;
+	}
+	top = (ILUInt32)high;
+	decpt = StripZeros(&top, &low, decpt);
+	StoreResult(result, top, low, sign, decpt);
+	return 1;
+}
+
 int ILDecimalAdd(ILDecimal *result, const ILDecimal *valuea,
 				 const ILDecimal *valueb, int roundMode)
 {
@@ -448,6 +585,13 @@ int ILDecimalAdd(ILDecimal *result, const ILDecimal *valuea,
 	int decpt;
 	int sign;
 
+	/* Use the fast path if the decimal points line up */
+	if(AddSameScale(result, valuea, valueb,
+					DECIMAL_IS_NEG(valuea), DECIMAL_IS_NEG(valueb)))
+	{
+		return 1;
+	}
+
 	/* Determine how to perform the addition */
 	if(!DECIMAL_IS_NEG(valuea) && !DECIMAL_IS_NEG(valueb))
 	{
@@ -519,6 +663,13 @@ int ILDecimalSub(ILDecimal *result, const ILDecimal *valuea,
 	int decpt;
 	int sign;
 
+	/* Use the fast path if the decimal points line up */
+	if(AddSameScale(result, valuea, valueb,
+					DECIMAL_IS_NEG(valuea), !DECIMAL_IS_NEG(valueb)))
+	{
+		return 1;
+	}
+
 	/* Determine how to perform the subtraction */
 	if(!DECIMAL_IS_NEG(valuea) && DECIMAL_IS_NEG(valueb))
 	{
@@ -622,6 +773,54 @@ static void MulByWord(ILUInt32 *result, int base,
 	}
 }
 
+/*
+ * Multiply two values whose exact product fits in 96 bits, without
+ * going through the 192-bit intermediate form.  Returns zero if the
+ * general algorithm is needed to scale or round the result.
+ */
+static int MulSmall(ILDecimal *result, const ILDecimal *valuea,
+					const ILDecimal *valueb)
+{
+	ILUInt64 low;
+	ILUInt32 high;
+	int decpt;
+#ifdef IL_DECIMAL_INT128
+	ILDecimalUInt128 product;
+#endif
+
+	decpt = DECIMAL_GETPT(valuea) + DECIMAL_GETPT(valueb);
+	if(decpt > 28)
+	{
+		return 0;
+	}
+#ifdef IL_DECIMAL_INT128
+	if(valuea->high != 0 || valueb->high != 0)
+	{
+		return 0;
+	}
+	product = ((ILDecimalUInt128)DECIMAL_LOW64(valuea)) *
+			  ((ILDecimalUInt128)DECIMAL_LOW64(valueb));
+	if((product >> 96) != 0)
+	{
+		return 0;
+	}
+	high = (ILUInt32)(product >> 64);
+	low = (ILUInt64)product;
+#else
+	if(valuea->high != 0 || valuea->middle != 0 ||
+	   valueb->high != 0 || valueb->middle != 0)
+	{
+		return 0;
+	}
+	high = 0;
+	low = ((ILUInt64)(valuea->low)) * ((ILUInt64)(valueb->low));
+#endif
+	decpt = StripZeros(&high, &low, decpt);
+	StoreResult(result, high, low,
+				(DECIMAL_IS_NEG(valuea) ^ DECIMAL_IS_NEG(valueb)), decpt);
+	return 1;
+}
+
 int ILDecimalMul(ILDecimal *result, const ILDecimal *valuea,
 				 const ILDecimal *valueb, int roundMode)
 {
@@ -629,6 +828,12 @@ int ILDecimalMul(ILDecimal *result, const ILDecimal *valuea,
 	int decpt;
 	int sign;
 
+	/* Use the fast path if the product is small */
+	if(MulSmall(result, valuea, valueb))
+	{
+		return 1;
+	}
+
 	/* Calculate the intermediate result */
 	temp[0] = temp[1] = temp[2] = temp[3] = temp[4] = temp[5] = 0;
 	MulByWord(temp, 5, valuea, valueb->low);
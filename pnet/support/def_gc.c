@@ -65,6 +65,11 @@ static void GCLockInit(void)
 	_ILMutexCreate(&gcLock);
 }
 
+void ILGCSetOptions(const ILGCOptions *options)
+{
+	/* Nothing to tune in this implementation */
+}
+
 void ILGCInit(unsigned long maxSize)
 {
 	unsigned long pageSize;
@@ -184,6 +189,26 @@ void ILGCMarkNoPointers(void *start, unsigned long size)
 	/* Nothing to do here */
 }
 
+void ILGCRegisterRoots(void *start, unsigned long size)
+{
+	/* Nothing to do here */
+}
+
+void ILGCUnregisterRoots(void *start, unsigned long size)
+{
+	/* Nothing to do here */
+}
+
+void ILGCAddRootRegion(ILGCRootRegion *region)
+{
+	/* Nothing to do here */
+}
+
+void ILGCRemoveRootRegion(ILGCRootRegion *region)
+{
+	/* Nothing to do here */
+}
+
 void ILGCCollect(void)
 {
 	/* We don't care about threads here because it's a fake value anyways. */
@@ -225,6 +250,24 @@ long ILGCGetHeapSize(void)
 	return (long)heapSize;
 }
 
+void ILGCGetPauseStats(ILGCPauseStats *stats)
+{
+	/* We never collect, so we never pause */
+	ILMemZero(stats, sizeof(ILGCPauseStats));
+}
+
+void ILGCGetFinalizerStats(ILGCFinalizerStats *stats)
+{
+	/* Finalizers are never run */
+	ILMemZero(stats, sizeof(ILGCFinalizerStats));
+}
+
+int ILGCPrepareWrite(void *start, unsigned long size)
+{
+	/* Nothing is ever protected */
+	return 0;
+}
+
 void ILGCRegisterWeak(void *ptr)
 {
 	/* Nothing to do here because we don't do finalization */
@@ -25,6 +25,7 @@
 #include "il_system.h"
 #include "il_sysio.h"
 #include "il_errno.h"
+#include "il_thread.h"
 #ifdef HAVE_SYS_STAT_H
 	#include <sys/stat.h>
 #endif
@@ -526,8 +527,13 @@ int ILSysIOUnlock(ILSysIOHandle handle, ILInt64 position, ILInt64 length)
 
 int ILSysIOHasAsync(void)
 {
+#ifdef HAVE_SYS_EPOLL_H
+	/* Sockets and pipes are completed through "reactor.c" */
+	return ILHasThreads();
+#else
 	/* TODO: asynchronous I/O is not yet supported */
 	return 0;
+#endif
 }
 
 int ILSysIOPathGetLastAccess(const char *path, ILInt64 *time)
@@ -23,7 +23,14 @@
 #include "il_gc.h"
 #include "il_thread.h"
 #include "thr_defs.h"
+#include "interlocked.h"
 #include "stdio.h"
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #ifdef HAVE_LIBGC
 
@@ -95,6 +102,32 @@ static ILWaitHandle *_FinalizerResponse = 0;
  */
 static volatile int _FinalizersRunningSynchronously = 0;
 
+/*
+ * Number of objects waiting for finalization that makes it worth
+ * waking another finalizer thread.
+ */
+#define IL_GC_FINALIZER_BATCH	256
+
+/*
+ * Pool of threads that help the finalizer thread drain a large queue,
+ * and the number of helpers that it may use.
+ */
+static ILThreadPool *_FinalizerPool = 0;
+static int _FinalizerHelpers = 0;
+
+/*
+ * Number of helpers that are still running finalizers, and the event
+ * that is set when the last of them is done.
+ */
+static volatile ILInt32 _FinalizerHelpersActive = 0;
+static ILWaitHandle *_FinalizerHelpersDone = 0;
+
+/*
+ * Finalization statistics, protected by the finalizer lock.
+ */
+static unsigned long _FinalizerMaxPending = 0;
+static ILUInt64 _FinalizerCount = 0;
+
 /*
  *	Tracing macros for the GC.
  */
@@ -110,6 +143,207 @@ static volatile int _FinalizersRunningSynchronously = 0;
  */
 extern GC_signed_word GC_bytes_found;
 
+/*
+ * Internal collector flag that is set when incremental mode is active.
+ */
+extern int GC_incremental;
+
+/*
+ * Internal collector hook that pushes the roots which are not in root
+ * sets, such as thread stacks, and the function to push a range.
+ */
+extern void (*GC_push_other_roots)(void);
+extern void GC_push_all(char *bottom, char *top);
+
+/*
+ * Root regions, and the hook that was installed before ours.  The
+ * list is protected by the collector's allocation lock.
+ */
+static ILGCRootRegion *_GCRootRegions;
+static void (*_GCPushOtherRoots)(void);
+
+/*
+ * Collector options that were set before initialization.
+ */
+static ILGCOptions _GCOptions;
+
+/*
+ * Statistics about world-stopping pauses, protected by the
+ * collector's allocation lock.
+ */
+static ILGCPauseStats _GCPauseStats;
+static ILUInt64 _GCPauseStart;
+
+/*
+ * Size of a virtual memory page, for dirty-bit tracking.
+ */
+static unsigned long _GCPageSize = 4096;
+
+/*
+ * Get the current monotonic time in microseconds.
+ */
+static ILUInt64 GCTimeMicros(void)
+{
+	ILCurrTime timeValue;
+	if(!ILGetSinceRebootTime(&timeValue))
+	{
+		ILGetCurrTime(&timeValue);
+	}
+	return ((ILUInt64)(timeValue.secs)) * (ILUInt64)1000000 +
+		   (ILUInt64)(timeValue.nsecs / 1000);
+}
+
+/*
+ * Record the length of world-stopping pauses.  This is called with
+ * the allocation lock held, so it must not allocate.
+ */
+static void GCCollectionEvent(GC_EventType event)
+{
+	ILUInt64 elapsed;
+
+	if(event == GC_EVENT_PRE_STOP_WORLD)
+	{
+		_GCPauseStart = GCTimeMicros();
+	}
+	else if(event == GC_EVENT_POST_START_WORLD && _GCPauseStart != 0)
+	{
+		elapsed = GCTimeMicros() - _GCPauseStart;
+		_GCPauseStart = 0;
+		++(_GCPauseStats.numPauses);
+		_GCPauseStats.totalTime += elapsed;
+		_GCPauseStats.lastTime = elapsed;
+		if(elapsed > _GCPauseStats.maxTime)
+		{
+			_GCPauseStats.maxTime = elapsed;
+		}
+	}
+}
+
+/*
+ * Copy the pause statistics while holding the allocation lock.
+ */
+static void *GCCopyPauseStats(void *data)
+{
+	*((ILGCPauseStats *)data) = _GCPauseStats;
+	return 0;
+}
+
+/*
+ * Ask the collector to use a specific number of marker threads.  The
+ * collector reads this from the environment when it starts, and only
+ * if it was built with parallel marking.  An explicit "GC_MARKERS"
+ * setting in the environment takes precedence.
+ */
+static void GCSetMarkers(int markers)
+{
+#if defined(HAVE_PUTENV) && defined(HAVE_STDLIB_H)
+	static char markersEnv[32];
+	if(markers > 0 && !getenv("GC_MARKERS"))
+	{
+		sprintf(markersEnv, "GC_MARKERS=%d", markers);
+		putenv(markersEnv);
+	}
+#endif
+}
+
+/*
+ * Invoke finalizers on the current thread and record how many ran.
+ */
+static void GCRunFinalizers(void)
+{
+	int count = GC_invoke_finalizers();
+	if(count > 0)
+	{
+		_ILMutexLock(&_FinalizerLock);
+		_FinalizerCount += (ILUInt64)count;
+		_ILMutexUnlock(&_FinalizerLock);
+	}
+}
+
+/*
+ * Run finalizers on a helper thread from the finalizer pool.
+ */
+static int GCFinalizerHelper(void *userData, void *item)
+{
+	GCRunFinalizers();
+	if(ILInterlockedDecrementI4(&_FinalizerHelpersActive) == 0)
+	{
+		ILWaitEventSet(_FinalizerHelpersDone);
+	}
+	return 0;
+}
+
+/*
+ * Run all pending finalizers from the finalizer thread.  If the queue
+ * is long, helper threads drain it in parallel with this thread, and
+ * this returns once all of them are done.
+ */
+static void GCInvokeFinalizers(void)
+{
+	unsigned long pending;
+	int helpers = 0;
+	int queued = 0;
+
+	if(_FinalizerHelpers > 0)
+	{
+		pending = (unsigned long)GC_count_ready_finalizers();
+		_ILMutexLock(&_FinalizerLock);
+		if(pending > _FinalizerMaxPending)
+		{
+			_FinalizerMaxPending = pending;
+		}
+		_ILMutexUnlock(&_FinalizerLock);
+		helpers = (int)(pending / IL_GC_FINALIZER_BATCH);
+		if(helpers > _FinalizerHelpers)
+		{
+			helpers = _FinalizerHelpers;
+		}
+	}
+
+	/* Create the pool the first time that it is needed */
+	if(helpers > 0 && !_FinalizerPool)
+	{
+		_FinalizerPool = ILThreadPoolCreate(0, GCFinalizerHelper, 0);
+		if(_FinalizerPool)
+		{
+			ILThreadPoolSetMinThreads(_FinalizerPool, 1);
+			ILThreadPoolSetMaxThreads(_FinalizerPool, _FinalizerHelpers);
+			ILThreadPoolSetMinThreads(_FinalizerPool, _FinalizerHelpers);
+		}
+		else
+		{
+			_FinalizerHelpers = 0;
+			helpers = 0;
+		}
+	}
+
+	/* Wake the helpers.  The item is a dummy, because the helpers
+	   take their work directly from the collector's queue */
+	if(helpers > 0)
+	{
+		ILWaitEventReset(_FinalizerHelpersDone);
+		ILInterlockedStoreI4(&_FinalizerHelpersActive, helpers);
+		while(queued < helpers &&
+			  ILThreadPoolQueue(_FinalizerPool, (void *)&_FinalizerPool))
+		{
+			++queued;
+		}
+		if(queued < helpers &&
+		   ILInterlockedAddI4(&_FinalizerHelpersActive,
+							  queued - helpers) == 0)
+		{
+			ILWaitEventSet(_FinalizerHelpersDone);
+		}
+	}
+
+	GCRunFinalizers();
+
+	if(queued > 0)
+	{
+		ILWaitOne(_FinalizerHelpersDone, -1);
+	}
+}
+
 /*
  *	Main entry point for the finalizer thread.
  */
@@ -136,7 +370,7 @@ static void _FinalizerThreadFunc(void *data)
 			
 			++_FinalizingCount;
 
-			GC_invoke_finalizers();
+			GCInvokeFinalizers();
 			
 			GC_TRACE("GC:_FinalizerThread: Finalizers finished [thread:%p]\n", _ILThreadSelf());
 		}
@@ -207,7 +441,7 @@ static int _InvokeFinalizersSynchronously()
 
 		++_FinalizingCount;
 
-		GC_invoke_finalizers();
+		GCRunFinalizers();
 
 		_FinalizersRunning = 0;
 		_FinalizersRunningSynchronously = 0;
@@ -304,10 +538,74 @@ static void GCNotifyFinalize(void)
 	PrivateGCNotifyFinalize(0, 0);
 }
 
+void ILGCSetOptions(const ILGCOptions *options)
+{
+	if(options)
+	{
+		_GCOptions = *options;
+	}
+	else
+	{
+		ILMemZero(&_GCOptions, sizeof(_GCOptions));
+	}
+}
+
+/*
+ * Push the root regions when the collector asks for extra roots.
+ */
+static void GCPushRootRegions(void)
+{
+	ILGCRootRegion *region = _GCRootRegions;
+	char *end;
+	while(region != 0)
+	{
+		end = (char *)(region->end);
+		if(end > (char *)(region->start))
+		{
+			GC_push_all((char *)(region->start), end);
+		}
+		region = region->next;
+	}
+	if(_GCPushOtherRoots)
+	{
+		(*_GCPushOtherRoots)();
+	}
+}
+
 void ILGCInit(unsigned long maxSize)
 {
+	GCSetMarkers(_GCOptions.markers);
 	GC_INIT();		/* For shared library initialization on sparc */	
 	GC_set_max_heap_size((size_t)maxSize);
+
+	/* Record the length of pauses so that they can be reported */
+	ILMemZero(&_GCPauseStats, sizeof(_GCPauseStats));
+	_GCPauseStart = 0;
+	GC_set_on_collection_event(GCCollectionEvent);
+
+	/* Scan the root regions on every collection */
+	if(GC_push_other_roots != GCPushRootRegions)
+	{
+		_GCPushOtherRoots = GC_push_other_roots;
+		GC_push_other_roots = GCPushRootRegions;
+	}
+
+	/* Switch to incremental collection if requested.  The collector's
+	   write fault handler chains to any SIGSEGV handlers that the
+	   engine or the JIT installed before this point, and tracks writes
+	   to the heap from both the interpreter and JIT-compiled code, so
+	   no explicit write barrier is needed */
+	if(_GCOptions.incremental)
+	{
+	#ifdef HAVE_GETPAGESIZE
+		_GCPageSize = (unsigned long)getpagesize();
+	#endif
+		if(_GCOptions.pauseTarget)
+		{
+			GC_set_time_limit(_GCOptions.pauseTarget);
+		}
+		GC_enable_incremental();
+	}
 	
 	/* Set up the finalization system the way we want it */
 	GC_no_dls = 1;
@@ -327,6 +625,22 @@ void ILGCInit(unsigned long maxSize)
 		_FinalizerSignal = ILWaitEventCreate(1, 0);
 		_FinalizerResponse = ILWaitEventCreate(1, 0);
 
+		/* Helper threads are only used if more than one finalizer
+		   thread was requested */
+		if(_GCOptions.finalizers > 1)
+		{
+			_FinalizerHelpers = _GCOptions.finalizers - 1;
+			if(_FinalizerHelpers > IL_GC_MAX_FINALIZER_THREADS - 1)
+			{
+				_FinalizerHelpers = IL_GC_MAX_FINALIZER_THREADS - 1;
+			}
+			_FinalizerHelpersDone = ILWaitEventCreate(1, 0);
+			if(!_FinalizerHelpersDone)
+			{
+				_FinalizerHelpers = 0;
+			}
+		}
+
 		/* Make the finalizer thread a background thread */
 		ILThreadSetBackground(_FinalizerThread, 1);
 
@@ -337,6 +651,8 @@ void ILGCInit(unsigned long maxSize)
 
 void ILGCDeinit()
 {
+	ILGCPauseStats stats;
+
 	_FinalizerStopFlag = 1;
 
 	GC_TRACE("ILGCDeinit: Performing final GC [thread:%p]\n", _ILThreadSelf());
@@ -367,7 +683,73 @@ void ILGCDeinit()
 		ILThreadDestroy(_FinalizerThread);			
 	}
 
+	/* Stop the finalizer helpers */
+	if(_FinalizerPool)
+	{
+		ILThreadPoolDestroy(_FinalizerPool);
+		_FinalizerPool = 0;
+	}
+	_FinalizerHelpers = 0;
+
 	_ILMutexDestroy(&_FinalizerLock);
+
+	/* Report the pauses if requested */
+	if(_GCOptions.reportPauses)
+	{
+		ILGCGetPauseStats(&stats);
+		fprintf(stderr,
+				"GC: %d collections, %lu pauses, %lu.%03lu ms total, "
+				"%lu.%03lu ms max, %s marking, %s\n",
+				ILGCCollectionCount(), (unsigned long)(stats.numPauses),
+				(unsigned long)(stats.totalTime / 1000),
+				(unsigned long)(stats.totalTime % 1000),
+				(unsigned long)(stats.maxTime / 1000),
+				(unsigned long)(stats.maxTime % 1000),
+				(GC_get_parallel() ? "parallel" : "serial"),
+				(GC_incremental ? "incremental" : "stop-the-world"));
+		fprintf(stderr, "GC: %lu objects finalized, %lu max pending\n",
+				(unsigned long)_FinalizerCount, _FinalizerMaxPending);
+	}
+}
+
+void ILGCGetPauseStats(ILGCPauseStats *stats)
+{
+	GC_call_with_alloc_lock(GCCopyPauseStats, stats);
+}
+
+void ILGCGetFinalizerStats(ILGCFinalizerStats *stats)
+{
+	stats->pending = (unsigned long)GC_count_ready_finalizers();
+	stats->numThreads = _FinalizerHelpers + 1;
+	stats->numBusy = (_FinalizersRunning ? 1 : 0) +
+					 (int)ILInterlockedLoadI4(&_FinalizerHelpersActive);
+	_ILMutexLock(&_FinalizerLock);
+	stats->maxPending = _FinalizerMaxPending;
+	stats->numFinalized = _FinalizerCount;
+	_ILMutexUnlock(&_FinalizerLock);
+}
+
+int ILGCPrepareWrite(void *start, unsigned long size)
+{
+	ILNativeUInt addr, end;
+
+	if(!GC_incremental)
+	{
+		return 0;
+	}
+
+	/* Atomically OR zero into a word on each page.  This takes the
+	   collector's write fault if the page is protected, without
+	   disturbing any other thread that is writing to the page */
+	addr = (ILNativeUInt)start;
+	end = addr + (ILNativeUInt)size;
+	while(addr < end)
+	{
+		ILInterlockedOrU4
+			((volatile ILUInt32 *)(addr & ~((ILNativeUInt)3)), 0);
+		addr = (addr | (ILNativeUInt)(_GCPageSize - 1)) + 1;
+	}
+	return 1;
 }
 
 void *ILGCAlloc(unsigned long size)
@@ -423,6 +805,59 @@ void ILGCMarkNoPointers(void *start, unsigned long size)
 	GC_exclude_static_roots(start, (void *)(((unsigned char *)start) + size));
 }
 
+void ILGCRegisterRoots(void *start, unsigned long size)
+{
+	GC_add_roots(start, (void *)(((unsigned char *)start) + size));
+}
+
+void ILGCUnregisterRoots(void *start, unsigned long size)
+{
+	GC_remove_roots(start, (void *)(((unsigned char *)start) + size));
+}
+
+static void *GCAddRootRegion(void *data)
+{
+	ILGCRootRegion *region = (ILGCRootRegion *)data;
+	region->prev = 0;
+	region->next = _GCRootRegions;
+	if(_GCRootRegions)
+	{
+		_GCRootRegions->prev = region;
+	}
+	_GCRootRegions = region;
+	return 0;
+}
+
+void ILGCAddRootRegion(ILGCRootRegion *region)
+{
+	GC_call_with_alloc_lock(GCAddRootRegion, region);
+}
+
+static void *GCRemoveRootRegion(void *data)
+{
+	ILGCRootRegion *region = (ILGCRootRegion *)data;
+	if(region->next)
+	{
+		region->next->prev = region->prev;
+	}
+	if(region->prev)
+	{
+		region->prev->next = region->next;
+	}
+	else
+	{
+		_GCRootRegions = region->next;
+	}
+	region->prev = 0;
+	region->next = 0;
+	return 0;
+}
+
+void ILGCRemoveRootRegion(ILGCRootRegion *region)
+{
+	GC_call_with_alloc_lock(GCRemoveRootRegion, region);
+}
+
 void ILGCCollect(void)
 {
 	GC_gcollect();
@@ -0,0 +1,710 @@
+/*
+ * pollset.c - Persistent sets of handles to poll for readiness.
+ *
+ * Copyright (C) 2026  Free Software Foundation, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+
+Note: a poll set keeps its handles between calls, so that event loops
+do not have to pass every handle to the kernel on every iteration, as
+they would with "ILSysIOSocketSelect".
+
+The set is built on "epoll" if it is available, in which case the cost
+of a wait does not depend on the number of handles in the set.  Otherwise
+a persistent "pollfd" array is used, which at least avoids rebuilding
+the set and has no limit on the descriptor values.
+
+Waits report the identifier that the caller supplied with each handle,
+not the handle itself.  A handle that is closed while a wait is running
+may be reused for a new handle before the caller sees the result, and
+the identifiers keep the two apart.
+
+Handles can be added and removed while a wait is running.  A private
+pipe is watched along with the handles so that "ILSysIOPollSetWakeup"
+can interrupt the wait, for example when the set is being closed.
+
+*/
+
+#include "il_sysio.h"
+#if TIME_WITH_SYS_TIME
+	#include <sys/time.h>
+    #include <time.h>
+#else
+    #if HAVE_SYS_TIME_H
+		#include <sys/time.h>
+    #else
+        #include <time.h>
+    #endif
+#endif
+#ifdef HAVE_UNISTD_H
+	#include <unistd.h>
+#endif
+#ifdef HAVE_FCNTL_H
+	#include <fcntl.h>
+#endif
+#ifdef HAVE_SYS_EPOLL_H
+	#include <sys/epoll.h>
+#endif
+#ifdef HAVE_POLL_H
+	#include <poll.h>
+#endif
+#include "il_thread.h"
+
+#ifdef	__cplusplus
+extern	"C" {
+#endif
+
+#if !defined(IL_WIN32_NATIVE) && \
+	(defined(HAVE_SYS_EPOLL_H) || (defined(HAVE_POLL_H) && defined(HAVE_POLL)))
+
+/*
+ * Compute the end time of a wait with a timeout in microseconds.
+ */
+static void WaitEndTime(ILCurrTime *endtime, ILInt64 timeout)
+{
+	ILGetCurrTime(endtime);
+	endtime->secs += (long)(timeout / (ILInt64)1000000);
+	endtime->nsecs += (long)((timeout % (ILInt64)1000000) * (ILInt64)1000);
+	if(endtime->nsecs >= 1000000000L)
+	{
+		++(endtime->secs);
+		endtime->nsecs -= 1000000000L;
+	}
+}
+
+/*
+ * Get the number of milliseconds until an end time, rounded up.
+ * Returns zero if the end time has passed.
+ */
+static int WaitMilliseconds(const ILCurrTime *endtime)
+{
+	ILCurrTime currtime;
+	ILInt64 msecs;
+
+	ILGetCurrTime(&currtime);
+	msecs = ((ILInt64)(endtime->secs - currtime.secs)) * 1000 +
+			((ILInt64)(endtime->nsecs - currtime.nsecs) + 999999) / 1000000;
+	if(msecs <= 0)
+	{
+		return 0;
+	}
+	else if(msecs > (ILInt64)IL_MAX_INT32)
+	{
+		return IL_MAX_INT32;
+	}
+	return (int)msecs;
+}
+
+/*
+ * Create the wakeup pipe for a poll set.  The read end does not block,
+ * so that it can be drained after a wakeup.  Returns zero on error.
+ */
+static int CreateWakePipe(int *wakeFds)
+{
+	if(pipe(wakeFds) != 0)
+	{
+		wakeFds[0] = -1;
+		wakeFds[1] = -1;
+		return 0;
+	}
+#ifdef FD_CLOEXEC
+	fcntl(wakeFds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(wakeFds[1], F_SETFD, FD_CLOEXEC);
+#endif
+	fcntl(wakeFds[0], F_SETFL, fcntl(wakeFds[0], F_GETFL, 0) | O_NONBLOCK);
+	return 1;
+}
+
+/*
+ * Close the wakeup pipe for a poll set.
+ */
+static void CloseWakePipe(int *wakeFds)
+{
+	if(wakeFds[0] >= 0)
+	{
+		close(wakeFds[0]);
+	}
+	if(wakeFds[1] >= 0)
+	{
+		close(wakeFds[1]);
+	}
+}
+
+/*
+ * Make the wakeup pipe readable.
+ */
+static void SignalWakePipe(int *wakeFds)
+{
+	while(write(wakeFds[1], "x", 1) < 0 && errno == EINTR)
+	{
+		/* Try again */
+	}
+}
+
+/*
+ * Discard the pending wakeups on a wakeup pipe.
+ */
+static void DrainWakePipe(int *wakeFds)
+{
+	char buffer[64];
+	int result;
+	for(;;)
+	{
+		result = read(wakeFds[0], buffer, sizeof(buffer));
+		if(result <= 0 && (result == 0 || errno != EINTR))
+		{
+			break;
+		}
+	}
+}
+
+#endif
+
+#if defined(HAVE_SYS_EPOLL_H) && !defined(IL_WIN32_NATIVE)
+
+/*
+ * Internal structure of an epoll-based poll set.  The identifier and
+ * the requested events are kept in the 64-bit user data of each entry.
+ * The kernel does not modify the set during a wait, so no lock is needed.
+ */
+struct _tagILSysIOPollSet
+{
+	int		epfd;
+	int		wakeFds[2];
+
+};
+
+/*
+ * User data of the wakeup pipe, which no handle can have because
+ * the requested events of a handle never include the top bit.
+ */
+#define	WAKE_DATA		(((ILUInt64)0x80000000) << 32)
+
+ILSysIOPollSet *ILSysIOPollSetCreate(void)
+{
+	ILSysIOPollSet *set;
+	struct epoll_event event;
+
+	if((set = (ILSysIOPollSet *)ILMalloc(sizeof(ILSysIOPollSet))) == 0)
+	{
+		errno = ENOMEM;
+		return 0;
+	}
+	if((set->epfd = epoll_create(64)) < 0)
+	{
+		ILFree(set);
+		return 0;
+	}
+#ifdef FD_CLOEXEC
+	fcntl(set->epfd, F_SETFD, FD_CLOEXEC);
+#endif
+	event.events = EPOLLIN;
+	event.data.u64 = WAKE_DATA;
+	if(!CreateWakePipe(set->wakeFds) ||
+	   epoll_ctl(set->epfd, EPOLL_CTL_ADD, set->wakeFds[0], &event) != 0)
+	{
+		ILSysIOPollSetDestroy(set);
+		return 0;
+	}
+	return set;
+}
+
+void ILSysIOPollSetDestroy(ILSysIOPollSet *set)
+{
+	close(set->epfd);
+	CloseWakePipe(set->wakeFds);
+	ILFree(set);
+}
+
+void ILSysIOPollSetWakeup(ILSysIOPollSet *set)
+{
+	SignalWakePipe(set->wakeFds);
+}
+
+int ILSysIOPollSetAdd(ILSysIOPollSet *set, ILSysIOHandle handle,
+					  ILInt32 events, ILInt32 id)
+{
+	int fd = (int)(ILNativeInt)handle;
+	struct epoll_event event;
+
+	event.events = 0;
+	if((events & IL_POLL_READ) != 0)
+	{
+		event.events |= EPOLLIN;
+	}
+	if((events & IL_POLL_WRITE) != 0)
+	{
+		event.events |= EPOLLOUT;
+	}
+	if((events & IL_POLL_ERROR) != 0)
+	{
+		event.events |= EPOLLPRI;
+	}
+	events &= (IL_POLL_READ | IL_POLL_WRITE | IL_POLL_ERROR);
+	event.data.u64 = (((ILUInt64)(ILUInt32)events) << 32) | (ILUInt32)id;
+	if(epoll_ctl(set->epfd, EPOLL_CTL_ADD, fd, &event) == 0)
+	{
+		return 1;
+	}
+	if(errno == EEXIST)
+	{
+		return (epoll_ctl(set->epfd, EPOLL_CTL_MOD, fd, &event) == 0);
+	}
+	return 0;
+}
+
+int ILSysIOPollSetRemove(ILSysIOPollSet *set, ILSysIOHandle handle)
+{
+	struct epoll_event event;
+
+	/* Older kernels want a non-NULL event for EPOLL_CTL_DEL */
+	ILMemZero(&event, sizeof(event));
+	return (epoll_ctl(set->epfd, EPOLL_CTL_DEL,
+					  (int)(ILNativeInt)handle, &event) == 0);
+}
+
+ILInt32 ILSysIOPollSetWait(ILSysIOPollSet *set, ILInt32 *ids,
+						   ILInt32 *events, ILInt32 maxEvents,
+						   ILInt64 timeout)
+{
+	struct epoll_event stackEvents[64];
+	struct epoll_event *ready;
+	ILCurrTime endtime;
+	ILUInt32 flags;
+	ILInt32 requested, fired, numReady;
+	int result, index;
+
+	if(maxEvents <= 0)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	if(maxEvents <= 64)
+	{
+		ready = stackEvents;
+	}
+	else if((ready = (struct epoll_event *)ILMalloc
+					(sizeof(struct epoll_event) * maxEvents)) == 0)
+	{
+		errno = ENOMEM;
+		return -1;
+	}
+
+	/* Wait for events, restarting if we are interrupted by signals */
+	if(timeout >= 0)
+	{
+		WaitEndTime(&endtime, timeout);
+	}
+	do
+	{
+		result = epoll_wait
+			(set->epfd, ready, (int)maxEvents,
+			 (timeout >= 0 ? WaitMilliseconds(&endtime) : -1));
+	}
+	while(result < 0 && errno == EINTR);
+
+	/* Convert the events into identifiers and "IL_POLL_*" flags */
+	numReady = 0;
+	for(index = 0; index < result; ++index)
+	{
+		if(ready[index].data.u64 == WAKE_DATA)
+		{
+			DrainWakePipe(set->wakeFds);
+			continue;
+		}
+		flags = ready[index].events;
+		requested = (ILInt32)(ready[index].data.u64 >> 32);
+		fired = 0;
+		if((flags & EPOLLIN) != 0)
+		{
+			fired |= IL_POLL_READ;
+		}
+		if((flags & EPOLLOUT) != 0)
+		{
+			fired |= IL_POLL_WRITE;
+		}
+		if((flags & EPOLLPRI) != 0)
+		{
+			fired |= IL_POLL_ERROR;
+		}
+		if((flags & (EPOLLHUP | EPOLLERR)) != 0)
+		{
+			/* Report hangups and errors the same way as "select" does */
+			fired |= (requested & (IL_POLL_READ | IL_POLL_WRITE));
+		}
+		ids[numReady] = (ILInt32)(ILUInt32)(ready[index].data.u64);
+		events[numReady] = (fired & requested);
+		++numReady;
+	}
+	if(ready != stackEvents)
+	{
+		ILFree(ready);
+	}
+	return (result < 0 ? -1 : numReady);
+}
+
+#elif defined(HAVE_POLL_H) && defined(HAVE_POLL) && !defined(IL_WIN32_NATIVE)
+
+/*
+ * Internal structure of a poll-based poll set.  A wait polls a copy of
+ * the descriptors, so that the set can be changed while the wait runs.
+ * The copy has one more entry at the end for the wakeup pipe.
+ */
+struct _tagILSysIOPollSet
+{
+	ILMutex		   *lock;
+	struct pollfd  *fds;
+	ILInt32		   *requested;
+	ILInt32		   *ids;
+	ILInt32			numFds;
+	ILInt32			maxFds;
+	struct pollfd  *waitFds;
+	ILInt32		   *waitRequested;
+	ILInt32		   *waitIds;
+	ILInt32			maxWaitFds;
+	ILInt32			next;
+	int				wakeFds[2];
+
+};
+
+/*
+ * Find the index of a descriptor in a poll set, or -1.
+ */
+static ILInt32 FindDescriptor(ILSysIOPollSet *set, int fd)
+{
+	ILInt32 index;
+	for(index = 0; index < set->numFds; ++index)
+	{
+		if(set->fds[index].fd == fd)
+		{
+			return index;
+		}
+	}
+	return -1;
+}
+
+/*
+ * Resize the arrays of a poll set to hold "size" descriptors.
+ * Returns zero if out of memory.
+ */
+static int ResizeArrays(struct pollfd **fds, ILInt32 **requested,
+						ILInt32 **ids, ILInt32 size)
+{
+	struct pollfd *newFds;
+	ILInt32 *newRequested;
+	ILInt32 *newIds;
+
+	if((newFds = (struct pollfd *)ILRealloc
+			(*fds, sizeof(struct pollfd) * size)) == 0)
+	{
+		return 0;
+	}
+	*fds = newFds;
+	if((newRequested = (ILInt32 *)ILRealloc
+			(*requested, sizeof(ILInt32) * size)) == 0)
+	{
+		return 0;
+	}
+	*requested = newRequested;
+	if((newIds = (ILInt32 *)ILRealloc(*ids, sizeof(ILInt32) * size)) == 0)
+	{
+		return 0;
+	}
+	*ids = newIds;
+	return 1;
+}
+
+ILSysIOPollSet *ILSysIOPollSetCreate(void)
+{
+	ILSysIOPollSet *set;
+
+	if((set = (ILSysIOPollSet *)ILCalloc(1, sizeof(ILSysIOPollSet))) == 0)
+	{
+		errno = ENOMEM;
+		return 0;
+	}
+	if(!CreateWakePipe(set->wakeFds))
+	{
+		ILFree(set);
+		return 0;
+	}
+	if((set->lock = ILMutexCreate()) == 0)
+	{
+		ILSysIOPollSetDestroy(set);
+		errno = ENOMEM;
+		return 0;
+	}
+	return set;
+}
+
+void ILSysIOPollSetDestroy(ILSysIOPollSet *set)
+{
+	if(set->fds)
+	{
+		ILFree(set->fds);
+	}
+	if(set->requested)
+	{
+		ILFree(set->requested);
+	}
+	if(set->ids)
+	{
+		ILFree(set->ids);
+	}
+	if(set->waitFds)
+	{
+		ILFree(set->waitFds);
+	}
+	if(set->waitRequested)
+	{
+		ILFree(set->waitRequested);
+	}
+	if(set->waitIds)
+	{
+		ILFree(set->waitIds);
+	}
+	if(set->lock)
+	{
+		ILMutexDestroy(set->lock);
+	}
+	CloseWakePipe(set->wakeFds);
+	ILFree(set);
+}
+
+void ILSysIOPollSetWakeup(ILSysIOPollSet *set)
+{
+	SignalWakePipe(set->wakeFds);
+}
+
+int ILSysIOPollSetAdd(ILSysIOPollSet *set, ILSysIOHandle handle,
+					  ILInt32 events, ILInt32 id)
+{
+	int fd = (int)(ILNativeInt)handle;
+	ILInt32 index;
+	short pollEvents;
+
+	if(fd < 0)
+	{
+		errno = EBADF;
+		return 0;
+	}
+	pollEvents = 0;
+	if((events & IL_POLL_READ) != 0)
+	{
+		pollEvents |= POLLIN;
+	}
+	if((events & IL_POLL_WRITE) != 0)
+	{
+		pollEvents |= POLLOUT;
+	}
+	if((events & IL_POLL_ERROR) != 0)
+	{
+		pollEvents |= POLLPRI;
+	}
+
+	/* Modify the entry if the descriptor is already in the set */
+	ILMutexLock(set->lock);
+	if((index = FindDescriptor(set, fd)) < 0)
+	{
+		if(set->numFds >= set->maxFds)
+		{
+			index = (set->maxFds ? set->maxFds * 2 : 16);
+			if(!ResizeArrays(&(set->fds), &(set->requested),
+							 &(set->ids), index))
+			{
+				ILMutexUnlock(set->lock);
+				errno = ENOMEM;
+				return 0;
+			}
+			set->maxFds = index;
+		}
+		index = (set->numFds)++;
+		set->fds[index].fd = fd;
+	}
+	set->fds[index].events = pollEvents;
+	set->fds[index].revents = 0;
+	set->requested[index] = events;
+	set->ids[index] = id;
+	ILMutexUnlock(set->lock);
+	return 1;
+}
+
+int ILSysIOPollSetRemove(ILSysIOPollSet *set, ILSysIOHandle handle)
+{
+	ILInt32 index;
+
+	ILMutexLock(set->lock);
+	index = FindDescriptor(set, (int)(ILNativeInt)handle);
+	if(index < 0)
+	{
+		ILMutexUnlock(set->lock);
+		errno = ENOENT;
+		return 0;
+	}
+	--(set->numFds);
+	set->fds[index] = set->fds[set->numFds];
+	set->requested[index] = set->requested[set->numFds];
+	set->ids[index] = set->ids[set->numFds];
+	ILMutexUnlock(set->lock);
+	return 1;
+}
+
+ILInt32 ILSysIOPollSetWait(ILSysIOPollSet *set, ILInt32 *ids,
+						   ILInt32 *events, ILInt32 maxEvents,
+						   ILInt64 timeout)
+{
+	ILCurrTime endtime;
+	ILInt32 numFds, numReady, index, posn;
+	ILInt32 fired;
+	short flags;
+	int result;
+
+	if(maxEvents <= 0)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Copy the descriptors to poll, followed by the wakeup pipe */
+	ILMutexLock(set->lock);
+	numFds = set->numFds;
+	if(numFds + 1 > set->maxWaitFds)
+	{
+		if(!ResizeArrays(&(set->waitFds), &(set->waitRequested),
+						 &(set->waitIds), set->maxFds + 1))
+		{
+			ILMutexUnlock(set->lock);
+			errno = ENOMEM;
+			return -1;
+		}
+		set->maxWaitFds = set->maxFds + 1;
+	}
+	if(numFds > 0)
+	{
+		ILMemCpy(set->waitFds, set->fds, sizeof(struct pollfd) * numFds);
+		ILMemCpy(set->waitRequested, set->requested,
+				 sizeof(ILInt32) * numFds);
+		ILMemCpy(set->waitIds, set->ids, sizeof(ILInt32) * numFds);
+	}
+	ILMutexUnlock(set->lock);
+	set->waitFds[numFds].fd = set->wakeFds[0];
+	set->waitFds[numFds].events = POLLIN;
+	set->waitFds[numFds].revents = 0;
+
+	/* Wait for events, restarting if we are interrupted by signals */
+	if(timeout >= 0)
+	{
+		WaitEndTime(&endtime, timeout);
+	}
+	do
+	{
+		result = poll(set->waitFds, (unsigned long)(numFds + 1),
+					  (timeout >= 0 ? WaitMilliseconds(&endtime) : -1));
+	}
+	while(result < 0 && errno == EINTR);
+	if(result <= 0)
+	{
+		return (ILInt32)result;
+	}
+	if(set->waitFds[numFds].revents != 0)
+	{
+		DrainWakePipe(set->wakeFds);
+	}
+
+	/* Collect the descriptors that fired, starting after the last
+	   one that was reported so that no descriptor is starved */
+	numReady = 0;
+	for(index = 0; index < numFds && numReady < maxEvents; ++index)
+	{
+		posn = (set->next + index) % numFds;
+		flags = set->waitFds[posn].revents;
+		if(!flags)
+		{
+			continue;
+		}
+		fired = 0;
+		if((flags & POLLIN) != 0)
+		{
+			fired |= IL_POLL_READ;
+		}
+		if((flags & POLLOUT) != 0)
+		{
+			fired |= IL_POLL_WRITE;
+		}
+		if((flags & POLLPRI) != 0)
+		{
+			fired |= IL_POLL_ERROR;
+		}
+		if((flags & (POLLHUP | POLLERR | POLLNVAL)) != 0)
+		{
+			fired |= (set->waitRequested[posn] &
+					  (IL_POLL_READ | IL_POLL_WRITE));
+		}
+		ids[numReady] = set->waitIds[posn];
+		events[numReady] = (fired & set->waitRequested[posn]);
+		++numReady;
+		set->next = posn + 1;
+	}
+	return numReady;
+}
+
+#else /* !HAVE_POLL */
+
+ILSysIOPollSet *ILSysIOPollSetCreate(void)
+{
+	/* Poll sets are not supported on this platform */
+	errno = ENOSYS;
+	return 0;
+}
+
+void ILSysIOPollSetDestroy(ILSysIOPollSet *set)
+{
+	/* Nothing to do here */
+}
+
+void ILSysIOPollSetWakeup(ILSysIOPollSet *set)
+{
+	/* Nothing to do here */
+}
+
+int ILSysIOPollSetAdd(ILSysIOPollSet *set, ILSysIOHandle handle,
+					  ILInt32 events, ILInt32 id)
+{
+	errno = ENOSYS;
+	return 0;
+}
+
+int ILSysIOPollSetRemove(ILSysIOPollSet *set, ILSysIOHandle handle)
+{
+	errno = ENOSYS;
+	return 0;
+}
+
+ILInt32 ILSysIOPollSetWait(ILSysIOPollSet *set, ILInt32 *ids,
+						   ILInt32 *events, ILInt32 maxEvents,
+						   ILInt64 timeout)
+{
+	errno = ENOSYS;
+	return -1;
+}
+
+#endif /* !HAVE_POLL */
+
+#ifdef	__cplusplus
+};
+#endif
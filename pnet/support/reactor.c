@@ -0,0 +1,547 @@
+/*
+ * reactor.c - Readiness notification for sockets and pipes.
+ *
+ * Copyright (C) 2026  Free Software Foundation, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+
+Note: the reactor is built on "epoll".  On platforms without it,
+"ILSysIOReactorCreate" returns NULL and the caller is expected to
+perform asynchronous operations on a thread of its own instead.
+
+Every handle has an entry in a table that is indexed by the file
+descriptor.  The entry holds at most one pending cookie per direction.
+Handles are registered with EPOLLONESHOT, so that only one completion
+thread sees an event for a handle.  The thread takes the cookies for
+the directions that became ready, re-arms the handle for the remaining
+directions and then passes the cookies to the callback.
+
+A handle that is about to be closed is unwatched first.  Its pending
+cookies are delivered so that the operations can fail, and the
+generation number of the entry is bumped.  The generation is stored in
+the epoll event data next to the descriptor, so that events which were
+fetched before the close are dropped instead of being delivered to
+watches on a descriptor that has since been reused.
+
+The completion threads are stopped by making the read end of a private
+pipe readable.  It is registered level-triggered, so all threads see it.
+
+The table is allocated with "ILGCAllocPersistent", so that the garbage
+collector sees cookies that are only referenced from the reactor.
+
+*/
+
+#include "thr_defs.h"
+#include "il_sysio.h"
+#include "il_gc.h"
+#ifdef HAVE_UNISTD_H
+	#include <unistd.h>
+#endif
+#ifdef HAVE_FCNTL_H
+	#include <fcntl.h>
+#endif
+#ifdef HAVE_SYS_EPOLL_H
+	#include <sys/epoll.h>
+#endif
+
+#ifdef	__cplusplus
+extern	"C" {
+#endif
+
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_UNISTD_H) && \
+	!defined(IL_NO_THREADS)
+
+/*
+ * Older headers do not know about half-closed stream sockets.
+ */
+#ifndef EPOLLRDHUP
+#define	EPOLLRDHUP					0
+#endif
+
+/*
+ * Maximum number of completion threads.
+ */
+#define	IL_REACTOR_MAX_THREADS		4
+
+/*
+ * Number of processors that share a completion thread by default.
+ */
+#define	IL_REACTOR_CPUS_PER_THREAD	4
+
+/*
+ * Initial size of the handle table.
+ */
+#define	IL_REACTOR_TABLE_SIZE		64
+
+/*
+ * Number of events that a completion thread fetches at once.
+ */
+#define	IL_REACTOR_MAX_EVENTS		32
+
+/*
+ * State of a watched handle.
+ */
+typedef struct _tagILReactorEntry
+{
+	void		   *cookie[2];
+	int				registered;
+	ILUInt32		generation;
+
+} ILReactorEntry;
+
+/*
+ * Pack a descriptor and a generation number into epoll event data.
+ */
+#define	EventData(fd,generation)	\
+			((((ILUInt64)(generation)) << 32) | (ILUInt64)(ILUInt32)(fd))
+#define	EventFd(data)				((int)(ILUInt32)(data))
+#define	EventGeneration(data)		((ILUInt32)((data) >> 32))
+
+/*
+ * Internal structure of a reactor.
+ */
+struct _tagILSysIOReactor
+{
+	ILSysIOReactorFunc	func;
+	void			   *userData;
+	int					epfd;
+	int					wakeFds[2];
+	ILMutex			   *lock;
+	ILReactorEntry	   *table;
+	int					tableSize;
+	int					numThreads;
+	ILThread		   *threads[IL_REACTOR_MAX_THREADS];
+
+};
+
+/*
+ * Get the default number of completion threads.
+ */
+static int DefaultThreads(void)
+{
+	int count = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if(cpus > 0)
+	{
+		count = (int)((cpus + IL_REACTOR_CPUS_PER_THREAD - 1) /
+					  IL_REACTOR_CPUS_PER_THREAD);
+	}
+#endif
+	return (count < IL_REACTOR_MAX_THREADS ? count : IL_REACTOR_MAX_THREADS);
+}
+
+/*
+ * Make sure that the handle table has an entry for "fd".
+ * Must be called with the reactor lock held.
+ */
+static int GrowTable(ILSysIOReactor *reactor, int fd)
+{
+	ILReactorEntry *table;
+	int size = reactor->tableSize;
+
+	if(fd < size)
+	{
+		return 1;
+	}
+	while(size <= fd)
+	{
+		size *= 2;
+	}
+	table = (ILReactorEntry *)ILGCAllocPersistent
+		(size * sizeof(ILReactorEntry));
+	if(!table)
+	{
+		return 0;
+	}
+	ILMemZero(table, size * sizeof(ILReactorEntry));
+	ILMemCpy(table, reactor->table,
+			 reactor->tableSize * sizeof(ILReactorEntry));
+	ILGCFreePersistent(reactor->table);
+	reactor->table = table;
+	reactor->tableSize = size;
+	return 1;
+}
+
+/*
+ * Register or re-arm a handle for the directions that have
+ * pending cookies.  Must be called with the reactor lock held.
+ */
+static int ArmEntry(ILSysIOReactor *reactor, int fd)
+{
+	ILReactorEntry *entry = &(reactor->table[fd]);
+	struct epoll_event event;
+
+	event.events = EPOLLONESHOT;
+	event.data.u64 = EventData(fd, entry->generation);
+	if(entry->cookie[IL_REACTOR_READ])
+	{
+		event.events |= EPOLLIN | EPOLLRDHUP;
+	}
+	if(entry->cookie[IL_REACTOR_WRITE])
+	{
+		event.events |= EPOLLOUT;
+	}
+	if(entry->registered)
+	{
+		if(epoll_ctl(reactor->epfd, EPOLL_CTL_MOD, fd, &event) == 0)
+		{
+			return 1;
+		}
+		if(errno != ENOENT)
+		{
+			return 0;
+		}
+
+		/* The descriptor was closed and reused behind our back */
+		entry->registered = 0;
+		++(entry->generation);
+		event.data.u64 = EventData(fd, entry->generation);
+	}
+	if(epoll_ctl(reactor->epfd, EPOLL_CTL_ADD, fd, &event) != 0)
+	{
+		if(errno != EEXIST ||
+		   epoll_ctl(reactor->epfd, EPOLL_CTL_MOD, fd, &event) != 0)
+		{
+			return 0;
+		}
+	}
+	entry->registered = 1;
+	return 1;
+}
+
+/*
+ * Main loop of a completion thread.
+ */
+static void ReactorMain(void *arg)
+{
+	ILSysIOReactor *reactor = (ILSysIOReactor *)arg;
+	struct epoll_event events[IL_REACTOR_MAX_EVENTS];
+	void *cookies[2 * IL_REACTOR_MAX_EVENTS];
+	ILReactorEntry *entry;
+	int numEvents, numCookies;
+	int index, fd;
+	ILUInt32 flags;
+	int stop = 0;
+
+	while(!stop)
+	{
+		numEvents = epoll_wait(reactor->epfd, events,
+							   IL_REACTOR_MAX_EVENTS, -1);
+		if(numEvents < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			break;
+		}
+
+		/* Collect the cookies of the handles that became ready */
+		numCookies = 0;
+		ILMutexLock(reactor->lock);
+		for(index = 0; index < numEvents; ++index)
+		{
+			fd = EventFd(events[index].data.u64);
+			if(fd == reactor->wakeFds[0])
+			{
+				stop = 1;
+				continue;
+			}
+			if(fd >= reactor->tableSize)
+			{
+				continue;
+			}
+			entry = &(reactor->table[fd]);
+			if(EventGeneration(events[index].data.u64) != entry->generation)
+			{
+				/* The handle was closed after the event was fetched */
+				continue;
+			}
+			flags = events[index].events;
+			if((flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0 &&
+			   entry->cookie[IL_REACTOR_READ])
+			{
+				cookies[numCookies++] = entry->cookie[IL_REACTOR_READ];
+				entry->cookie[IL_REACTOR_READ] = 0;
+			}
+			if((flags & (EPOLLOUT | EPOLLHUP | EPOLLERR)) != 0 &&
+			   entry->cookie[IL_REACTOR_WRITE])
+			{
+				cookies[numCookies++] = entry->cookie[IL_REACTOR_WRITE];
+				entry->cookie[IL_REACTOR_WRITE] = 0;
+			}
+			if(entry->cookie[IL_REACTOR_READ] ||
+			   entry->cookie[IL_REACTOR_WRITE])
+			{
+				if(!ArmEntry(reactor, fd))
+				{
+					/* Deliver the rest now, rather than losing them */
+					if(entry->cookie[IL_REACTOR_READ])
+					{
+						cookies[numCookies++] = entry->cookie[IL_REACTOR_READ];
+						entry->cookie[IL_REACTOR_READ] = 0;
+					}
+					if(entry->cookie[IL_REACTOR_WRITE])
+					{
+						cookies[numCookies++] =
+							entry->cookie[IL_REACTOR_WRITE];
+						entry->cookie[IL_REACTOR_WRITE] = 0;
+					}
+				}
+			}
+		}
+		ILMutexUnlock(reactor->lock);
+
+		/* Hand the cookies to the callback outside the lock */
+		for(index = 0; index < numCookies; ++index)
+		{
+			(*(reactor->func))(reactor->userData, cookies[index]);
+		}
+	}
+}
+
+ILSysIOReactor *ILSysIOReactorCreate(ILSysIOReactorFunc func,
+									 void *userData, int numThreads)
+{
+	ILSysIOReactor *reactor;
+	struct epoll_event event;
+
+	if(!ILHasThreads())
+	{
+		return 0;
+	}
+	if((reactor = (ILSysIOReactor *)ILCalloc
+			(1, sizeof(ILSysIOReactor))) == 0)
+	{
+		return 0;
+	}
+	reactor->func = func;
+	reactor->userData = userData;
+	reactor->epfd = -1;
+	reactor->wakeFds[0] = -1;
+	reactor->wakeFds[1] = -1;
+	if(numThreads <= 0)
+	{
+		numThreads = DefaultThreads();
+	}
+	else if(numThreads > IL_REACTOR_MAX_THREADS)
+	{
+		numThreads = IL_REACTOR_MAX_THREADS;
+	}
+
+	/* Create the epoll instance and the wakeup pipe */
+	if((reactor->epfd = epoll_create(IL_REACTOR_TABLE_SIZE)) < 0 ||
+	   pipe(reactor->wakeFds) != 0)
+	{
+		ILSysIOReactorDestroy(reactor);
+		return 0;
+	}
+#ifdef FD_CLOEXEC
+	fcntl(reactor->epfd, F_SETFD, FD_CLOEXEC);
+	fcntl(reactor->wakeFds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(reactor->wakeFds[1], F_SETFD, FD_CLOEXEC);
+#endif
+	event.events = EPOLLIN;
+	event.data.u64 = EventData(reactor->wakeFds[0], 0);
+	if(epoll_ctl(reactor->epfd, EPOLL_CTL_ADD,
+				 reactor->wakeFds[0], &event) != 0)
+	{
+		ILSysIOReactorDestroy(reactor);
+		return 0;
+	}
+
+	/* Create the lock and the handle table */
+	reactor->tableSize = IL_REACTOR_TABLE_SIZE;
+	if((reactor->lock = ILMutexCreate()) == 0 ||
+	   (reactor->table = (ILReactorEntry *)ILGCAllocPersistent
+	   		(IL_REACTOR_TABLE_SIZE * sizeof(ILReactorEntry))) == 0)
+	{
+		ILSysIOReactorDestroy(reactor);
+		return 0;
+	}
+	ILMemZero(reactor->table, IL_REACTOR_TABLE_SIZE * sizeof(ILReactorEntry));
+
+	/* Start the completion threads */
+	while(reactor->numThreads < numThreads)
+	{
+		ILThread *thread = ILThreadCreate(ReactorMain, reactor);
+		if(!thread)
+		{
+			break;
+		}
+		if(!ILThreadStart(thread))
+		{
+			ILThreadDestroy(thread);
+			break;
+		}
+		reactor->threads[(reactor->numThreads)++] = thread;
+	}
+	if(!(reactor->numThreads))
+	{
+		ILSysIOReactorDestroy(reactor);
+		return 0;
+	}
+	return reactor;
+}
+
+void ILSysIOReactorDestroy(ILSysIOReactor *reactor)
+{
+	int index;
+
+	/* Wake up the completion threads and wait for them to exit */
+	if(reactor->numThreads > 0)
+	{
+		while(write(reactor->wakeFds[1], "x", 1) < 0 && errno == EINTR)
+		{
+			/* Try again */
+		}
+		for(index = 0; index < reactor->numThreads; ++index)
+		{
+			ILThreadJoin(reactor->threads[index], IL_MAX_UINT32);
+			ILThreadDestroy(reactor->threads[index]);
+		}
+	}
+
+	/* Free the remaining resources */
+	if(reactor->epfd >= 0)
+	{
+		close(reactor->epfd);
+	}
+	if(reactor->wakeFds[0] >= 0)
+	{
+		close(reactor->wakeFds[0]);
+	}
+	if(reactor->wakeFds[1] >= 0)
+	{
+		close(reactor->wakeFds[1]);
+	}
+	if(reactor->table)
+	{
+		ILGCFreePersistent(reactor->table);
+	}
+	if(reactor->lock)
+	{
+		ILMutexDestroy(reactor->lock);
+	}
+	ILFree(reactor);
+}
+
+int ILSysIOReactorWatch(ILSysIOReactor *reactor, ILSysIOHandle handle,
+						int direction, void *cookie)
+{
+	int fd = (int)(ILNativeInt)handle;
+	ILReactorEntry *entry;
+	int result = 0;
+
+	if(fd < 0 || !cookie ||
+	   (direction != IL_REACTOR_READ && direction != IL_REACTOR_WRITE))
+	{
+		return 0;
+	}
+	ILMutexLock(reactor->lock);
+	if(GrowTable(reactor, fd))
+	{
+		entry = &(reactor->table[fd]);
+		if(!(entry->cookie[direction]))
+		{
+			entry->cookie[direction] = cookie;
+			if(ArmEntry(reactor, fd))
+			{
+				result = 1;
+			}
+			else
+			{
+				/* Regular files and closed handles end up here */
+				entry->cookie[direction] = 0;
+			}
+		}
+	}
+	ILMutexUnlock(reactor->lock);
+	return result;
+}
+
+void ILSysIOReactorUnwatch(ILSysIOReactor *reactor, ILSysIOHandle handle)
+{
+	int fd = (int)(ILNativeInt)handle;
+	ILReactorEntry *entry;
+	void *cookies[2];
+	struct epoll_event event;
+
+	cookies[0] = 0;
+	cookies[1] = 0;
+	ILMutexLock(reactor->lock);
+	if(fd >= 0 && fd < reactor->tableSize)
+	{
+		entry = &(reactor->table[fd]);
+		if(entry->registered)
+		{
+			/* Older kernels want a non-NULL event for EPOLL_CTL_DEL */
+			ILMemZero(&event, sizeof(event));
+			epoll_ctl(reactor->epfd, EPOLL_CTL_DEL, fd, &event);
+			entry->registered = 0;
+		}
+		++(entry->generation);
+		cookies[0] = entry->cookie[IL_REACTOR_READ];
+		cookies[1] = entry->cookie[IL_REACTOR_WRITE];
+		entry->cookie[IL_REACTOR_READ] = 0;
+		entry->cookie[IL_REACTOR_WRITE] = 0;
+	}
+	ILMutexUnlock(reactor->lock);
+
+	/* Let the pending operations find out that the handle is gone */
+	if(cookies[0])
+	{
+		(*(reactor->func))(reactor->userData, cookies[0]);
+	}
+	if(cookies[1])
+	{
+		(*(reactor->func))(reactor->userData, cookies[1]);
+	}
+}
+
+#else /* !HAVE_SYS_EPOLL_H */
+
+ILSysIOReactor *ILSysIOReactorCreate(ILSysIOReactorFunc func,
+									 void *userData, int numThreads)
+{
+	/* Readiness notification is not supported on this platform */
+	return 0;
+}
+
+void ILSysIOReactorDestroy(ILSysIOReactor *reactor)
+{
+	/* Nothing to do here */
+}
+
+int ILSysIOReactorWatch(ILSysIOReactor *reactor, ILSysIOHandle handle,
+						int direction, void *cookie)
+{
+	return 0;
+}
+
+void ILSysIOReactorUnwatch(ILSysIOReactor *reactor, ILSysIOHandle handle)
+{
+	/* Nothing to do here */
+}
+
+#endif /* !HAVE_SYS_EPOLL_H */
+
+#ifdef	__cplusplus
+};
+#endif
@@ -159,6 +159,231 @@ static void ProcessBlock(ILSHAContext *sha, const unsigned char *block)
 	a = b = c = d = e = temp = 0;
 }
 
+#ifdef IL_CRYPT_X86_HW
+
+#include <immintrin.h>
+
+/*
+ * Compile a function for CPUs with the SHA extensions.
+ */
+#define	IL_SHA_HW	__attribute__((__target__("sha,sse4.1,ssse3")))
+
+/*
+ * Process a run of blocks using the SHA extensions.
+ */
+static IL_SHA_HW void HWProcessBlocks(ILSHAContext *sha,
+									  const unsigned char *data,
+									  unsigned long numBlocks)
+{
+	const __m128i mask = _mm_set_epi64x
+		((ILInt64)0x0001020304050607LL, (ILInt64)0x08090A0B0C0D0E0FLL);
+	__m128i abcd, e0, e1, abcdSave, e0Save;
+	__m128i msg0, msg1, msg2, msg3;
+
+	/* Load the SHA state, with "A" in the highest lane */
+	abcd = _mm_set_epi32((int)(sha->A), (int)(sha->B),
+						 (int)(sha->C), (int)(sha->D));
+	e0 = _mm_set_epi32((int)(sha->E), 0, 0, 0);
+
+	while(numBlocks > 0)
+	{
+		abcdSave = abcd;
+		e0Save = e0;
+
+		/* Rounds 0 to 3 */
+		msg0 = _mm_shuffle_epi8
+			(_mm_loadu_si128((const __m128i *)(data + 0)), mask);
+		e0 = _mm_add_epi32(e0, msg0);
+		e1 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+		/* Rounds 4 to 7 */
+		msg1 = _mm_shuffle_epi8
+			(_mm_loadu_si128((const __m128i *)(data + 16)), mask);
+		e1 = _mm_sha1nexte_epu32(e1, msg1);
+		e0 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+		msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+
+		/* Rounds 8 to 11 */
+		msg2 = _mm_shuffle_epi8
+			(_mm_loadu_si128((const __m128i *)(data + 32)), mask);
+		e0 = _mm_sha1nexte_epu32(e0, msg2);
+		e1 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+		msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+		msg0 = _mm_xor_si128(msg0, msg2);
+
+		/* Rounds 12 to 15 */
+		msg3 = _mm_shuffle_epi8
+			(_mm_loadu_si128((const __m128i *)(data + 48)), mask);
+		e1 = _mm_sha1nexte_epu32(e1, msg3);
+		e0 = abcd;
+		msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+		msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+		msg1 = _mm_xor_si128(msg1, msg3);
+
+		/* Rounds 16 to 19 */
+		e0 = _mm_sha1nexte_epu32(e0, msg0);
+		e1 = abcd;
+		msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+		msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+		msg2 = _mm_xor_si128(msg2, msg0);
+
+		/* Rounds 20 to 23 */
+		e1 = _mm_sha1nexte_epu32(e1, msg1);
+		e0 = abcd;
+		msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+		msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+		msg3 = _mm_xor_si128(msg3, msg1);
+
+		/* Rounds 24 to 27 */
+		e0 = _mm_sha1nexte_epu32(e0, msg2);
+		e1 = abcd;
+		msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 1);
+		msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+		msg0 = _mm_xor_si128(msg0, msg2);
+
+		/* Rounds 28 to 31 */
+		e1 = _mm_sha1nexte_epu32(e1, msg3);
+		e0 = abcd;
+		msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+		msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+		msg1 = _mm_xor_si128(msg1, msg3);
+
+		/* Rounds 32 to 35 */
+		e0 = _mm_sha1nexte_epu32(e0, msg0);
+		e1 = abcd;
+		msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 1);
+		msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+		msg2 = _mm_xor_si128(msg2, msg0);
+
+		/* Rounds 36 to 39 */
+		e1 = _mm_sha1nexte_epu32(e1, msg1);
+		e0 = abcd;
+		msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+		msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+		msg3 = _mm_xor_si128(msg3, msg1);
+
+		/* Rounds 40 to 43 */
+		e0 = _mm_sha1nexte_epu32(e0, msg2);
+		e1 = abcd;
+		msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+		msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+		msg0 = _mm_xor_si128(msg0, msg2);
+
+		/* Rounds 44 to 47 */
+		e1 = _mm_sha1nexte_epu32(e1, msg3);
+		e0 = abcd;
+		msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 2);
+		msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+		msg1 = _mm_xor_si128(msg1, msg3);
+
+		/* Rounds 48 to 51 */
+		e0 = _mm_sha1nexte_epu32(e0, msg0);
+		e1 = abcd;
+		msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+		msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+		msg2 = _mm_xor_si128(msg2, msg0);
+
+		/* Rounds 52 to 55 */
+		e1 = _mm_sha1nexte_epu32(e1, msg1);
+		e0 = abcd;
+		msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 2);
+		msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+		msg3 = _mm_xor_si128(msg3, msg1);
+
+		/* Rounds 56 to 59 */
+		e0 = _mm_sha1nexte_epu32(e0, msg2);
+		e1 = abcd;
+		msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+		msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+		msg0 = _mm_xor_si128(msg0, msg2);
+
+		/* Rounds 60 to 63 */
+		e1 = _mm_sha1nexte_epu32(e1, msg3);
+		e0 = abcd;
+		msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+		msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+		msg1 = _mm_xor_si128(msg1, msg3);
+
+		/* Rounds 64 to 67 */
+		e0 = _mm_sha1nexte_epu32(e0, msg0);
+		e1 = abcd;
+		msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+		msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+		msg2 = _mm_xor_si128(msg2, msg0);
+
+		/* Rounds 68 to 71 */
+		e1 = _mm_sha1nexte_epu32(e1, msg1);
+		e0 = abcd;
+		msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+		msg3 = _mm_xor_si128(msg3, msg1);
+
+		/* Rounds 72 to 75 */
+		e0 = _mm_sha1nexte_epu32(e0, msg2);
+		e1 = abcd;
+		msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+
+		/* Rounds 76 to 79 */
+		e1 = _mm_sha1nexte_epu32(e1, msg3);
+		e0 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+
+		/* Combine the previous SHA state with the new state */
+		e0 = _mm_sha1nexte_epu32(e0, e0Save);
+		abcd = _mm_add_epi32(abcd, abcdSave);
+		data += 64;
+		--numBlocks;
+	}
+
+	/* Save the SHA state */
+	sha->A = (ILUInt32)_mm_extract_epi32(abcd, 3);
+	sha->B = (ILUInt32)_mm_extract_epi32(abcd, 2);
+	sha->C = (ILUInt32)_mm_extract_epi32(abcd, 1);
+	sha->D = (ILUInt32)_mm_extract_epi32(abcd, 0);
+	sha->E = (ILUInt32)_mm_extract_epi32(e0, 3);
+}
+
+#endif /* IL_CRYPT_X86_HW */
+
+/*
+ * Process a run of blocks, in hardware if possible.
+ */
+static void ProcessBlocks(ILSHAContext *sha, const unsigned char *data,
+						  unsigned long numBlocks)
+{
+#ifdef IL_CRYPT_X86_HW
+	if((ILCryptHardware() & IL_CRYPT_HW_SHA) != 0)
+	{
+		HWProcessBlocks(sha, data, numBlocks);
+		return;
+	}
+#endif
+	while(numBlocks > 0)
+	{
+		ProcessBlock(sha, data);
+		data += 64;
+		--numBlocks;
+	}
+}
+
 void ILSHAData(ILSHAContext *sha, const void *buffer, unsigned long len)
 {
 	unsigned long templen;
@@ -172,9 +397,10 @@ void ILSHAData(ILSHAContext *sha, const void *buffer, unsigned long len)
 		if(!(sha->inputLen) && len >= 64)
 		{
 			/* Short cut: no point copying the data twice */
-			ProcessBlock(sha, (const unsigned char *)buffer);
-			buffer = (const void *)(((const unsigned char *)buffer) + 64);
-			len -= 64;
+			templen = (len & ~((unsigned long)63));
+			ProcessBlocks(sha, (const unsigned char *)buffer, templen / 64);
+			buffer = (const void *)(((const unsigned char *)buffer) + templen);
+			len -= templen;
 		}
 		else
 		{
@@ -186,7 +412,7 @@ void ILSHAData(ILSHAContext *sha, const void *buffer, unsigned long len)
 			ILMemCpy(sha->input + sha->inputLen, buffer, templen);
 			if((sha->inputLen += templen) >= 64)
 			{
-				ProcessBlock(sha, sha->input);
+				ProcessBlocks(sha, sha->input, 1);
 				sha->inputLen = 0;
 			}
 			buffer = (const void *)(((const unsigned char *)buffer) + templen);
@@ -222,7 +448,7 @@ void ILSHAFinalize(ILSHAContext *sha, unsigned char hash[IL_SHA_HASH_SIZE])
 			{
 				sha->input[(sha->inputLen)++] = (unsigned char)0x00;
 			}
-			ProcessBlock(sha, sha->input);
+			ProcessBlocks(sha, sha->input, 1);
 			sha->inputLen = 0;
 		}
 		else
@@ -237,7 +463,7 @@ void ILSHAFinalize(ILSHAContext *sha, unsigned char hash[IL_SHA_HASH_SIZE])
 		totalBits = (sha->totalLen << 3);
 		WriteLong(sha->input + 56, (ILUInt32)(totalBits >> 32));
 		WriteLong(sha->input + 60, (ILUInt32)totalBits);
-		ProcessBlock(sha, sha->input);
+		ProcessBlocks(sha, sha->input, 1);
 
 		/* Write the final hash value to the supplied buffer */
 		WriteLong(hash,      sha->A);
@@ -153,6 +153,250 @@ static void ProcessBlock(ILSHA256Context *sha, const unsigned char *block)
 	a = b = c = d = e = f = g = h = temp = temp2 = 0;
 }
 
+#ifdef IL_CRYPT_X86_HW
+
+#include <immintrin.h>
+
+/*
+ * Compile a function for CPUs with the SHA extensions.
+ */
+#define	IL_SHA_HW	__attribute__((__target__("sha,sse4.1,ssse3")))
+
+/*
+ * Process a run of blocks using the SHA extensions.  The instructions
+ * keep the state as the two halves "ABEF" and "CDGH".
+ */
+static IL_SHA_HW void HWProcessBlocks(ILSHA256Context *sha,
+									  const unsigned char *data,
+									  unsigned long numBlocks)
+{
+	const __m128i mask = _mm_set_epi64x
+		((ILInt64)0x0C0D0E0F08090A0BLL, (ILInt64)0x0405060700010203LL);
+	__m128i state0, state1, abefSave, cdghSave;
+	__m128i msg, msg0, msg1, msg2, msg3, temp;
+
+	/* Load the SHA-256 state and rearrange it */
+	temp = _mm_set_epi32((int)(sha->C), (int)(sha->D),
+						 (int)(sha->A), (int)(sha->B));
+	state1 = _mm_set_epi32((int)(sha->E), (int)(sha->F),
+						   (int)(sha->G), (int)(sha->H));
+	state0 = _mm_alignr_epi8(temp, state1, 8);
+	state1 = _mm_blend_epi16(state1, temp, 0xF0);
+
+	while(numBlocks > 0)
+	{
+		abefSave = state0;
+		cdghSave = state1;
+
+		/* Rounds 0 to 3 */
+		msg0 = _mm_shuffle_epi8
+			(_mm_loadu_si128((const __m128i *)(data + 0)), mask);
+		msg = _mm_add_epi32
+			(msg0, _mm_loadu_si128((const __m128i *)(K + 0)));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+		/* Rounds 4 to 7 */
+		msg1 = _mm_shuffle_epi8
+			(_mm_loadu_si128((const __m128i *)(data + 16)), mask);
+		msg = _mm_add_epi32
+			(msg1, _mm_loadu_si128((const __m128i *)(K + 4)));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+		msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+
+		/* Rounds 8 to 11 */
+		msg2 = _mm_shuffle_epi8
+			(_mm_loadu_si128((const __m128i *)(data + 32)), mask);
+		msg = _mm_add_epi32
+			(msg2, _mm_loadu_si128((const __m128i *)(K + 8)));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+		msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+
+		/* Rounds 12 to 15 */
+		msg3 = _mm_shuffle_epi8
+			(_mm_loadu_si128((const __m128i *)(data + 48)), mask);
+		msg = _mm_add_epi32
+			(msg3, _mm_loadu_si128((const __m128i *)(K + 12)));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		temp = _mm_alignr_epi8(msg3, msg2, 4);
+		msg0 = _mm_add_epi32(msg0, temp);
+		msg0 = _mm_sha256msg2_epu32(msg0, msg3);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+		msg2 = _mm_sha256msg1_epu32(msg2, msg3);
+
+		/* Rounds 16 to 19 */
+		msg = _mm_add_epi32
+			(msg0, _mm_loadu_si128((const __m128i *)(K + 16)));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		temp = _mm_alignr_epi8(msg0, msg3, 4);
+		msg1 = _mm_add_epi32(msg1, temp);
+		msg1 = _mm_sha256msg2_epu32(msg1, msg0);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+		msg3 = _mm_sha256msg1_epu32(msg3, msg0);
+
+		/* Rounds 20 to 23 */
+		msg = _mm_add_epi32
+			(msg1, _mm_loadu_si128((const __m128i *)(K + 20)));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		temp = _mm_alignr_epi8(msg1, msg0, 4);
+		msg2 = _mm_add_epi32(msg2, temp);
+		msg2 = _mm_sha256msg2_epu32(msg2, msg1);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+		msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+
+		/* Rounds 24 to 27 */
+		msg = _mm_add_epi32
+			(msg2, _mm_loadu_si128((const __m128i *)(K + 24)));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		temp = _mm_alignr_epi8(msg2, msg1, 4);
+		msg3 = _mm_add_epi32(msg3, temp);
+		msg3 = _mm_sha256msg2_epu32(msg3, msg2);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+		msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+
+		/* Rounds 28 to 31 */
+		msg = _mm_add_epi32
+			(msg3, _mm_loadu_si128((const __m128i *)(K + 28)));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		temp = _mm_alignr_epi8(msg3, msg2, 4);
+		msg0 = _mm_add_epi32(msg0, temp);
+		msg0 = _mm_sha256msg2_epu32(msg0, msg3);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+		msg2 = _mm_sha256msg1_epu32(msg2, msg3);
+
+		/* Rounds 32 to 35 */
+		msg = _mm_add_epi32
+			(msg0, _mm_loadu_si128((const __m128i *)(K + 32)));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		temp = _mm_alignr_epi8(msg0, msg3, 4);
+		msg1 = _mm_add_epi32(msg1, temp);
+		msg1 = _mm_sha256msg2_epu32(msg1, msg0);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+		msg3 = _mm_sha256msg1_epu32(msg3, msg0);
+
+		/* Rounds 36 to 39 */
+		msg = _mm_add_epi32
+			(msg1, _mm_loadu_si128((const __m128i *)(K + 36)));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		temp = _mm_alignr_epi8(msg1, msg0, 4);
+		msg2 = _mm_add_epi32(msg2, temp);
+		msg2 = _mm_sha256msg2_epu32(msg2, msg1);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+		msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+
+		/* Rounds 40 to 43 */
+		msg = _mm_add_epi32
+			(msg2, _mm_loadu_si128((const __m128i *)(K + 40)));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		temp = _mm_alignr_epi8(msg2, msg1, 4);
+		msg3 = _mm_add_epi32(msg3, temp);
+		msg3 = _mm_sha256msg2_epu32(msg3, msg2);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+		msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+
+		/* Rounds 44 to 47 */
+		msg = _mm_add_epi32
+			(msg3, _mm_loadu_si128((const __m128i *)(K + 44)));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		temp = _mm_alignr_epi8(msg3, msg2, 4);
+		msg0 = _mm_add_epi32(msg0, temp);
+		msg0 = _mm_sha256msg2_epu32(msg0, msg3);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+		msg2 = _mm_sha256msg1_epu32(msg2, msg3);
+
+		/* Rounds 48 to 51 */
+		msg = _mm_add_epi32
+			(msg0, _mm_loadu_si128((const __m128i *)(K + 48)));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		temp = _mm_alignr_epi8(msg0, msg3, 4);
+		msg1 = _mm_add_epi32(msg1, temp);
+		msg1 = _mm_sha256msg2_epu32(msg1, msg0);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+		msg3 = _mm_sha256msg1_epu32(msg3, msg0);
+
+		/* Rounds 52 to 55 */
+		msg = _mm_add_epi32
+			(msg1, _mm_loadu_si128((const __m128i *)(K + 52)));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		temp = _mm_alignr_epi8(msg1, msg0, 4);
+		msg2 = _mm_add_epi32(msg2, temp);
+		msg2 = _mm_sha256msg2_epu32(msg2, msg1);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+		/* Rounds 56 to 59 */
+		msg = _mm_add_epi32
+			(msg2, _mm_loadu_si128((const __m128i *)(K + 56)));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		temp = _mm_alignr_epi8(msg2, msg1, 4);
+		msg3 = _mm_add_epi32(msg3, temp);
+		msg3 = _mm_sha256msg2_epu32(msg3, msg2);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+		/* Rounds 60 to 63 */
+		msg = _mm_add_epi32
+			(msg3, _mm_loadu_si128((const __m128i *)(K + 60)));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		msg = _mm_shuffle_epi32(msg, 0x0E);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+		/* Combine the previous SHA-256 state with the new state */
+		state0 = _mm_add_epi32(state0, abefSave);
+		state1 = _mm_add_epi32(state1, cdghSave);
+		data += 64;
+		--numBlocks;
+	}
+
+	/* Save the SHA-256 state */
+	sha->A = (ILUInt32)_mm_extract_epi32(state0, 3);
+	sha->B = (ILUInt32)_mm_extract_epi32(state0, 2);
+	sha->C = (ILUInt32)_mm_extract_epi32(state1, 3);
+	sha->D = (ILUInt32)_mm_extract_epi32(state1, 2);
+	sha->E = (ILUInt32)_mm_extract_epi32(state0, 1);
+	sha->F = (ILUInt32)_mm_extract_epi32(state0, 0);
+	sha->G = (ILUInt32)_mm_extract_epi32(state1, 1);
+	sha->H = (ILUInt32)_mm_extract_epi32(state1, 0);
+}
+
+#endif /* IL_CRYPT_X86_HW */
+
+/*
+ * Process a run of blocks, in hardware if possible.
+ */
+static void ProcessBlocks(ILSHA256Context *sha, const unsigned char *data,
+						  unsigned long numBlocks)
+{
+#ifdef IL_CRYPT_X86_HW
+	if((ILCryptHardware() & IL_CRYPT_HW_SHA) != 0)
+	{
+		HWProcessBlocks(sha, data, numBlocks);
+		return;
+	}
+#endif
+	while(numBlocks > 0)
+	{
+		ProcessBlock(sha, data);
+		data += 64;
+		--numBlocks;
+	}
+}
+
 void ILSHA256Data(ILSHA256Context *sha, const void *buffer, unsigned long len)
 {
 	unsigned long templen;
@@ -166,9 +410,10 @@ void ILSHA256Data(ILSHA256Context *sha, const void *buffer, unsigned long len)
 		if(!(sha->inputLen) && len >= 64)
 		{
 			/* Short cut: no point copying the data twice */
-			ProcessBlock(sha, (const unsigned char *)buffer);
-			buffer = (const void *)(((const unsigned char *)buffer) + 64);
-			len -= 64;
+			templen = (len & ~((unsigned long)63));
+			ProcessBlocks(sha, (const unsigned char *)buffer, templen / 64);
+			buffer = (const void *)(((const unsigned char *)buffer) + templen);
+			len -= templen;
 		}
 		else
 		{
@@ -180,7 +425,7 @@ void ILSHA256Data(ILSHA256Context *sha, const void *buffer, unsigned long len)
 			ILMemCpy(sha->input + sha->inputLen, buffer, templen);
 			if((sha->inputLen += templen) >= 64)
 			{
-				ProcessBlock(sha, sha->input);
+				ProcessBlocks(sha, sha->input, 1);
 				sha->inputLen = 0;
 			}
 			buffer = (const void *)(((const unsigned char *)buffer) + templen);
@@ -217,7 +462,7 @@ void ILSHA256Finalize(ILSHA256Context *sha,
 			{
 				sha->input[(sha->inputLen)++] = (unsigned char)0x00;
 			}
-			ProcessBlock(sha, sha->input);
+			ProcessBlocks(sha, sha->input, 1);
 			sha->inputLen = 0;
 		}
 		else
@@ -232,7 +477,7 @@ void ILSHA256Finalize(ILSHA256Context *sha,
 		totalBits = (sha->totalLen << 3);
 		WriteLong(sha->input + 56, (ILUInt32)(totalBits >> 32));
 		WriteLong(sha->input + 60, (ILUInt32)totalBits);
-		ProcessBlock(sha, sha->input);
+		ProcessBlocks(sha, sha->input, 1);
 
 		/* Write the final hash value to the supplied buffer */
 		WriteLong(hash,      sha->A);
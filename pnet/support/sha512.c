@@ -105,32 +105,104 @@ void ILSHA512Init(ILSHA512Context *sha)
 	sha->totalLen = 0;
 }
 
+#ifdef IL_CRYPT_X86_HW
+
+#include <tmmintrin.h>
+
+/*
+ * Compile a function for CPUs with SSSE3.
+ */
+#define	IL_SHA_HW	__attribute__((__target__("ssse3")))
+
+/*
+ * Vector forms of RHO0 and RHO1, on two 64-bit words at a time.
+ * The rotation by 8 is a byte shuffle.
+ */
+#define	VROTATE(x,n)	\
+			_mm_or_si128(_mm_srli_epi64((x), (n)), \
+						 _mm_slli_epi64((x), 64 - (n)))
+#define	VRHO0(x)	\
+			_mm_xor_si128(_mm_xor_si128(VROTATE((x), 1), \
+										_mm_shuffle_epi8((x), rotate8)), \
+						  _mm_srli_epi64((x), 7))
+#define	VRHO1(x)	\
+			_mm_xor_si128(_mm_xor_si128(VROTATE((x), 19), VROTATE((x), 61)), \
+						  _mm_srli_epi64((x), 6))
+
+/*
+ * Unpack a block and compute the message schedule, two words at a time.
+ * Words "t - 15" and "t - 7" straddle two vectors, and are extracted
+ * with "palignr".  "X" must be aligned on a 16-byte boundary.
+ */
+static IL_SHA_HW void HWExpandBlock(const unsigned char *block, __m128i *X)
+{
+	const __m128i swap = _mm_set_epi64x
+		((ILInt64)0x08090A0B0C0D0E0FLL, (ILInt64)0x0001020304050607LL);
+	const __m128i rotate8 = _mm_set_epi64x
+		((ILInt64)0x080F0E0D0C0B0A09LL, (ILInt64)0x0007060504030201LL);
+	__m128i w15, w7;
+	int t;
+
+	for(t = 0; t < 8; ++t)
+	{
+		X[t] = _mm_shuffle_epi8
+			(_mm_loadu_si128((const __m128i *)(block + t * 16)), swap);
+	}
+	for(t = 8; t < 40; ++t)
+	{
+		w15 = _mm_alignr_epi8(X[t - 7], X[t - 8], 8);
+		w7 = _mm_alignr_epi8(X[t - 3], X[t - 4], 8);
+		X[t] = _mm_add_epi64(_mm_add_epi64(VRHO1(X[t - 1]), w7),
+							 _mm_add_epi64(VRHO0(w15), X[t - 8]));
+	}
+}
+
+/*
+ * The message schedule is accessed as vectors by "HWExpandBlock".
+ */
+#define	IL_SHA_ALIGN	__attribute__((__aligned__(16)))
+
+#else /* !IL_CRYPT_X86_HW */
+
+#define	IL_SHA_ALIGN
+
+#endif /* !IL_CRYPT_X86_HW */
+
 /*
  * Process a single block of input using the hash algorithm.
  */
 static void ProcessBlock(ILSHA512Context *sha, const unsigned char *block)
 {
-	ILUInt64 W[80];
+	ILUInt64 W[80] IL_SHA_ALIGN;
 	ILUInt64 a, b, c, d, e, f, g, h;
 	ILUInt64 temp, temp2;
 	int t;
 
 	/* Unpack the block into 80 64-bit words */
-	for(t = 0; t < 16; ++t)
+#ifdef IL_CRYPT_X86_HW
+	if((ILCryptHardware() & IL_CRYPT_HW_SSSE3) != 0)
 	{
-		W[t] = (((ILUInt64)(block[t * 8 + 0])) << 56) |
-		       (((ILUInt64)(block[t * 8 + 1])) << 48) |
-		       (((ILUInt64)(block[t * 8 + 2])) << 40) |
-		       (((ILUInt64)(block[t * 8 + 3])) << 32) |
-		       (((ILUInt64)(block[t * 8 + 4])) << 24) |
-		       (((ILUInt64)(block[t * 8 + 5])) << 16) |
-		       (((ILUInt64)(block[t * 8 + 6])) <<  8) |
-		        ((ILUInt64)(block[t * 8 + 7]));
+		HWExpandBlock(block, (__m128i *)W);
 	}
-	for(t = 16; t < 80; ++t)
+	else
+#endif
 	{
-		W[t] = RHO1(W[t - 2]) + W[t - 7] +
-			   RHO0(W[t - 15]) + W[t - 16];
+		for(t = 0; t < 16; ++t)
+		{
+			W[t] = (((ILUInt64)(block[t * 8 + 0])) << 56) |
+			       (((ILUInt64)(block[t * 8 + 1])) << 48) |
+			       (((ILUInt64)(block[t * 8 + 2])) << 40) |
+			       (((ILUInt64)(block[t * 8 + 3])) << 32) |
+			       (((ILUInt64)(block[t * 8 + 4])) << 24) |
+			       (((ILUInt64)(block[t * 8 + 5])) << 16) |
+			       (((ILUInt64)(block[t * 8 + 6])) <<  8) |
+			        ((ILUInt64)(block[t * 8 + 7]));
+		}
+		for(t = 16; t < 80; ++t)
+		{
+			W[t] = RHO1(W[t - 2]) + W[t - 7] +
+				   RHO0(W[t - 15]) + W[t - 16];
+		}
 	}
 
 	/* Load the SHA-512 state into local variables */
@@ -55,6 +55,22 @@
 #ifdef HAVE_SYS_SELECT_H
 #include <sys/select.h>
 #endif
+#ifdef HAVE_POLL_H
+#include <poll.h>
+#endif
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+#ifdef HAVE_LIMITS_H
+#include <limits.h>
+#endif
+#if defined(HAVE_PTHREAD_SIGMASK) && defined(HAVE_SIGTIMEDWAIT)
+#include <signal.h>
+#include <pthread.h>
+#endif
 #ifdef HAVE_NETINET_IN_H
 #include <netinet/in.h>
 #endif
@@ -562,6 +578,434 @@ ILInt32 ILSysIOSocketSend(ILSysIOHandle sockfd, const void *msg,
 #endif
 }
 
+/*
+ * Use the kernel's "sendfile" for file to socket transfers if we can
+ * stop it from raising SIGPIPE when the peer has gone away.
+ */
+#if defined(HAVE_SYS_SENDFILE_H) && defined(HAVE_SENDFILE) && \
+	defined(HAVE_PTHREAD_SIGMASK) && defined(HAVE_SIGTIMEDWAIT) && \
+	!defined(IL_WIN32_NATIVE)
+#define	IL_USE_SENDFILE	1
+#endif
+
+/*
+ * Use "pread" when copying through user space, so that the transfer
+ * does not move the file position that is shared with other users.
+ */
+#if defined(HAVE_PREAD) && !defined(IL_WIN32_NATIVE)
+#define	IL_USE_PREAD	1
+#endif
+
+/*
+ * Size of the native buffer to use when copying through user space.
+ */
+#define	IL_SENDFILE_BUFSIZ	65536
+
+/*
+ * Largest number of bytes to hand to the kernel at once.
+ */
+#define	IL_SENDFILE_CHUNK	0x40000000
+
+#ifdef IL_USE_SENDFILE
+
+/*
+ * Transfer file data with "sendfile".  Returns the number of bytes
+ * sent, or -1 if "sendfile" cannot be used on these descriptors and
+ * nothing was sent.
+ */
+static ILInt64 KernelSendFile(int sock, int file, ILInt64 offset,
+							  ILInt64 count, int *fallback)
+{
+	sigset_t pipeSet, oldSet, pending;
+	struct timespec zero;
+	int hadPipe, sawPipe, saveErrno;
+	ILInt64 total = 0;
+	ssize_t sent;
+	size_t chunk;
+	off_t posn;
+
+	/* Block SIGPIPE while we are inside the kernel.  If a SIGPIPE was
+	   already pending, then it isn't ours to discard */
+	sigemptyset(&pipeSet);
+	sigaddset(&pipeSet, SIGPIPE);
+	sigemptyset(&pending);
+	sigpending(&pending);
+	hadPipe = sigismember(&pending, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &pipeSet, &oldSet);
+
+	/* Send chunks until we reach the count or the end of the file */
+	sawPipe = 0;
+	posn = (off_t)offset;
+	*fallback = 0;
+	while(count < 0 || total < count)
+	{
+		chunk = IL_SENDFILE_CHUNK;
+		if(count >= 0 && (count - total) < (ILInt64)chunk)
+		{
+			chunk = (size_t)(count - total);
+		}
+		sent = sendfile(sock, file, &posn, chunk);
+		if(sent > 0)
+		{
+			total += (ILInt64)sent;
+		}
+		else if(sent == 0)
+		{
+			break;
+		}
+		else if(errno == EINTR)
+		{
+			continue;
+		}
+		else
+		{
+			if(total == 0 && (errno == EINVAL || errno == ENOSYS))
+			{
+				/* The file cannot be mapped, so copy it instead */
+				*fallback = 1;
+			}
+			else if(errno == EPIPE)
+			{
+				sawPipe = 1;
+			}
+			if(total == 0)
+			{
+				total = -1;
+			}
+			break;
+		}
+	}
+
+	/* Discard the SIGPIPE that we caused and restore the signal mask */
+	saveErrno = errno;
+	if(sawPipe && !hadPipe)
+	{
+		zero.tv_sec = 0;
+		zero.tv_nsec = 0;
+		while(sigtimedwait(&pipeSet, 0, &zero) < 0 && errno == EINTR)
+		{
+			/* Try again */
+		}
+	}
+	pthread_sigmask(SIG_SETMASK, &oldSet, 0);
+	errno = saveErrno;
+	return total;
+}
+
+#endif /* IL_USE_SENDFILE */
+
+/*
+ * Transfer file data by copying it through a native buffer.
+ */
+static ILInt64 CopySendFile(ILSysIOHandle sockfd, ILSysIOHandle file,
+							ILInt64 offset, ILInt64 count)
+{
+	char *buffer;
+	ILInt64 total = 0;
+#ifndef IL_USE_PREAD
+	ILInt64 oldPosn;
+#endif
+	ILInt32 size, len, posn, sent;
+
+	/* Allocate the copy buffer outside of the garbage collected heap */
+	if((buffer = (char *)ILMalloc(IL_SENDFILE_BUFSIZ)) == 0)
+	{
+		ILSysIOSetErrno(IL_ERRNO_ENOMEM);
+		return -1;
+	}
+
+#ifndef IL_USE_PREAD
+	/* Seek to the starting offset, remembering where the caller was */
+	oldPosn = ILSysIOSeek(file, 0, 1);
+	if(oldPosn < 0 || ILSysIOSeek(file, offset, 0) < 0)
+	{
+		ILFree(buffer);
+		return -1;
+	}
+#endif
+
+	/* Copy the data in buffer-sized chunks */
+	while(count < 0 || total < count)
+	{
+		size = IL_SENDFILE_BUFSIZ;
+		if(count >= 0 && (count - total) < (ILInt64)size)
+		{
+			size = (ILInt32)(count - total);
+		}
+	#ifdef IL_USE_PREAD
+		while((len = (ILInt32)pread((int)(ILNativeInt)file, buffer,
+									(size_t)size,
+									(off_t)(offset + total))) < 0)
+		{
+			/* Retry if the system call was interrupted */
+			if(errno != EINTR)
+			{
+				break;
+			}
+		}
+	#else
+		len = ILSysIORead(file, buffer, size);
+	#endif
+		if(len <= 0)
+		{
+			if(len < 0 && total == 0)
+			{
+				total = -1;
+			}
+			break;
+		}
+		posn = 0;
+		while(posn < len)
+		{
+			sent = ILSysIOSocketSend(sockfd, buffer + posn, len - posn, 0);
+			if(sent <= 0)
+			{
+				break;
+			}
+			posn += sent;
+		}
+		total += (ILInt64)posn;
+		if(posn < len)
+		{
+			if(total == 0)
+			{
+				total = -1;
+			}
+			break;
+		}
+	}
+
+	/* Put the file position back and clean up */
+#ifndef IL_USE_PREAD
+	ILSysIOSeek(file, oldPosn, 0);
+#endif
+	ILFree(buffer);
+	return total;
+}
+
+ILInt64 ILSysIOSocketSendFile(ILSysIOHandle sockfd, ILSysIOHandle file,
+							  ILInt64 offset, ILInt64 count)
+{
+#ifdef IL_USE_SENDFILE
+	ILInt64 result;
+	int fallback;
+#endif
+
+	if(offset < 0)
+	{
+		ILSysIOSetErrno(IL_ERRNO_EINVAL);
+		return -1;
+	}
+#if defined(IL_USE_SENDFILE) || defined(IL_USE_PREAD)
+	if((ILInt64)(off_t)offset != offset)
+	{
+		/* The offset does not fit in this platform's "off_t" */
+		ILSysIOSetErrno(IL_ERRNO_EINVAL);
+		return -1;
+	}
+#endif
+	if(count == 0)
+	{
+		return 0;
+	}
+#ifdef IL_USE_SENDFILE
+	result = KernelSendFile((int)(ILNativeInt)sockfd, (int)(ILNativeInt)file,
+							offset, count, &fallback);
+	if(!fallback)
+	{
+		return result;
+	}
+#endif
+	return CopySendFile(sockfd, file, offset, count);
+}
+
+/*
+ * Use "sendmsg" and "recvmsg" for vectored I/O if we can.
+ */
+#if defined(HAVE_SYS_UIO_H) && defined(HAVE_SENDMSG) && \
+	defined(HAVE_RECVMSG) && !defined(IL_WIN32_NATIVE)
+#define	IL_USE_SENDMSG	1
+#endif
+
+/*
+ * Maximum number of buffers to pass to the kernel at once.  Excess
+ * buffers are left for the caller to send or receive next time.
+ */
+#if defined(IOV_MAX)
+#define	IL_MAX_IOV		IOV_MAX
+#else
+#define	IL_MAX_IOV		16
+#endif
+
+/*
+ * Number of buffers that can be described without allocating memory.
+ */
+#define	IL_STACK_IOV	16
+
+#ifdef IL_USE_SENDMSG
+
+/*
+ * Perform a "sendmsg" or "recvmsg" on a list of buffers.
+ */
+static ILInt32 SocketMessage(ILSysIOHandle sockfd,
+							 const ILSysIOBuffer *buffers,
+							 ILInt32 numBuffers, ILInt32 flags,
+							 int sending)
+{
+	struct iovec stackVec[IL_STACK_IOV];
+	struct iovec *vec;
+	struct msghdr msg;
+	ILInt32 posn;
+	ssize_t result;
+
+	if(numBuffers > IL_MAX_IOV)
+	{
+		numBuffers = IL_MAX_IOV;
+	}
+	if(numBuffers <= IL_STACK_IOV)
+	{
+		vec = stackVec;
+	}
+	else if((vec = (struct iovec *)ILMalloc
+				(sizeof(struct iovec) * numBuffers)) == 0)
+	{
+		ILSysIOSetErrno(IL_ERRNO_ENOMEM);
+		return -1;
+	}
+	for(posn = 0; posn < numBuffers; ++posn)
+	{
+		vec[posn].iov_base = buffers[posn].data;
+		vec[posn].iov_len = (size_t)(buffers[posn].length);
+	}
+	ILMemZero(&msg, sizeof(msg));
+	msg.msg_iov = vec;
+	msg.msg_iovlen = numBuffers;
+	if(sending)
+	{
+	#ifdef MSG_NOSIGNAL
+		result = sendmsg((int)(ILNativeInt)sockfd, &msg,
+						 flags | MSG_NOSIGNAL);
+	#else
+		result = sendmsg((int)(ILNativeInt)sockfd, &msg, flags);
+	#endif
+	}
+	else
+	{
+		result = recvmsg((int)(ILNativeInt)sockfd, &msg, flags);
+	}
+	if(vec != stackVec)
+	{
+		ILFree(vec);
+	}
+	return (ILInt32)result;
+}
+
+#else /* !IL_USE_SENDMSG */
+
+/*
+ * Get the total length of a list of buffers, limited to what
+ * a single send or receive can report.
+ */
+static ILInt32 BufferTotal(const ILSysIOBuffer *buffers, ILInt32 numBuffers)
+{
+	ILInt32 total = 0;
+	ILInt32 posn;
+	for(posn = 0; posn < numBuffers; ++posn)
+	{
+		if(buffers[posn].length > (ILInt32)(IL_MAX_INT32 - total))
+		{
+			return (ILInt32)IL_MAX_INT32;
+		}
+		total += buffers[posn].length;
+	}
+	return total;
+}
+
+#endif /* !IL_USE_SENDMSG */
+
+ILInt32 ILSysIOSocketSendV(ILSysIOHandle sockfd, const ILSysIOBuffer *buffers,
+						   ILInt32 numBuffers, ILInt32 flags)
+{
+#ifdef IL_USE_SENDMSG
+	return SocketMessage(sockfd, buffers, numBuffers, flags, 1);
+#else
+	ILInt32 total, posn, len, result;
+	char *data;
+
+	/* Gather the buffers into one block and send that */
+	total = BufferTotal(buffers, numBuffers);
+	if(numBuffers <= 1 || total == 0)
+	{
+		return ILSysIOSocketSend
+			(sockfd, (numBuffers > 0 ? buffers[0].data : 0), total, flags);
+	}
+	if((data = (char *)ILMalloc(total)) == 0)
+	{
+		ILSysIOSetErrno(IL_ERRNO_ENOMEM);
+		return -1;
+	}
+	len = 0;
+	for(posn = 0; posn < numBuffers && len < total; ++posn)
+	{
+		if(buffers[posn].length > (total - len))
+		{
+			ILMemCpy(data + len, buffers[posn].data, total - len);
+			len = total;
+		}
+		else
+		{
+			ILMemCpy(data + len, buffers[posn].data, buffers[posn].length);
+			len += buffers[posn].length;
+		}
+	}
+	result = ILSysIOSocketSend(sockfd, data, total, flags);
+	ILFree(data);
+	return result;
+#endif
+}
+
+ILInt32 ILSysIOSocketReceiveV(ILSysIOHandle sockfd,
+							  const ILSysIOBuffer *buffers,
+							  ILInt32 numBuffers, ILInt32 flags)
+{
+#ifdef IL_USE_SENDMSG
+	return SocketMessage(sockfd, buffers, numBuffers, flags, 0);
+#else
+	ILInt32 total, posn, len, result;
+	char *data;
+
+	/* Receive into one block and then scatter it into the buffers */
+	total = BufferTotal(buffers, numBuffers);
+	if(numBuffers <= 1 || total == 0)
+	{
+		return ILSysIOSocketReceive
+			(sockfd, (numBuffers > 0 ? buffers[0].data : 0), total, flags);
+	}
+	if((data = (char *)ILMalloc(total)) == 0)
+	{
+		ILSysIOSetErrno(IL_ERRNO_ENOMEM);
+		return -1;
+	}
+	result = ILSysIOSocketReceive(sockfd, data, total, flags);
+	len = 0;
+	for(posn = 0; posn < numBuffers && len < result; ++posn)
+	{
+		if(buffers[posn].length > (result - len))
+		{
+			ILMemCpy(buffers[posn].data, data + len, result - len);
+			len = result;
+		}
+		else
+		{
+			ILMemCpy(buffers[posn].data, data + len, buffers[posn].length);
+			len += buffers[posn].length;
+		}
+	}
+	ILFree(data);
+	return result;
+#endif
+}
+
 ILInt32 ILSysIOSocketSendTo(ILSysIOHandle sockfd, const void *msg,
 					        ILInt32 len, ILInt32 flags,
 							unsigned char *addr, ILInt32 addrLen)
@@ -629,6 +1073,205 @@ int ILSysIOSocketShutdown(ILSysIOHandle sockfd, ILInt32 how)
 	return (shutdown((int)(ILNativeInt)sockfd, how) == 0);
 }
 
+#if defined(HAVE_POLL_H) && defined(HAVE_POLL) && !defined(IL_WIN32_NATIVE)
+
+/*
+ * Number of descriptors that "ILSysIOSocketSelect" can poll
+ * without allocating memory.
+ */
+#define	IL_SELECT_STACK_FDS		64
+
+/*
+ * Events that cause a descriptor to be reported by "ILSysIOSocketSelect".
+ * The read and write events include errors and hangups, because "select"
+ * reports those descriptors as readable and writable as well.
+ */
+#define	IL_SELECT_READ_EVENTS	(POLLIN | POLLHUP | POLLERR)
+#define	IL_SELECT_WRITE_EVENTS	(POLLOUT | POLLHUP | POLLERR)
+#define	IL_SELECT_EXCEPT_EVENTS	(POLLPRI)
+
+/*
+ * Fill in the "pollfd" entries for one of the arrays that were
+ * passed to "ILSysIOSocketSelect".
+ */
+static void SelectToPoll(struct pollfd *fds, ILSysIOHandle **handles,
+						 ILInt32 num, short events)
+{
+	ILInt32 index;
+	for(index = 0; index < num; ++index)
+	{
+		/* "poll" ignores entries with a negative descriptor */
+		fds[index].fd = (int)(ILNativeInt)(handles[index]);
+		fds[index].events = events;
+		fds[index].revents = 0;
+	}
+}
+
+/*
+ * Replace the handles that did not fire with "ILSysIOHandle_Invalid"
+ * and return the number of handles that did.
+ */
+static ILInt32 PollToSelect(struct pollfd *fds, ILSysIOHandle **handles,
+							ILInt32 num, short events)
+{
+	ILInt32 index;
+	ILInt32 fired = 0;
+	for(index = 0; index < num; ++index)
+	{
+		if(fds[index].fd == -1)
+		{
+			continue;
+		}
+		if((fds[index].revents & events) != 0)
+		{
+			++fired;
+		}
+		else
+		{
+			handles[index] = ILSysIOHandle_Invalid;
+		}
+	}
+	return fired;
+}
+
+ILInt32 ILSysIOSocketSelect(ILSysIOHandle **readfds, ILInt32 numRead,
+						    ILSysIOHandle **writefds, ILInt32 numWrite,
+						    ILSysIOHandle **exceptfds, ILInt32 numExcept,
+						    ILInt64 timeout)
+{
+	struct pollfd stackFds[IL_SELECT_STACK_FDS];
+	struct pollfd *fds;
+	ILInt32 numFds, index;
+	ILCurrTime currtime;
+	ILCurrTime endtime;
+	ILInt64 msecs;
+	int result;
+
+	/* Build a single "pollfd" array from the three handle arrays,
+	   so that there is no limit on the descriptor values */
+	if(!readfds)
+	{
+		numRead = 0;
+	}
+	if(!writefds)
+	{
+		numWrite = 0;
+	}
+	if(!exceptfds)
+	{
+		numExcept = 0;
+	}
+	numFds = numRead + numWrite + numExcept;
+	if(numFds <= IL_SELECT_STACK_FDS)
+	{
+		fds = stackFds;
+	}
+	else if((fds = (struct pollfd *)ILMalloc
+					(sizeof(struct pollfd) * numFds)) == 0)
+	{
+		errno = ENOMEM;
+		return -1;
+	}
+	SelectToPoll(fds, readfds, numRead, POLLIN);
+	SelectToPoll(fds + numRead, writefds, numWrite, POLLOUT);
+	SelectToPoll(fds + numRead + numWrite, exceptfds, numExcept, POLLPRI);
+
+	/* Is this a timed poll or an infinite poll? */
+	if(timeout >= 0)
+	{
+		/* Get the current time of day and determine the end time */
+		ILGetCurrTime(&currtime);
+		endtime.secs = currtime.secs + (long)(timeout / (ILInt64)1000000);
+		endtime.nsecs = currtime.nsecs +
+			(long)((timeout % (ILInt64)1000000) * (ILInt64)1000);
+		if(endtime.nsecs >= 1000000000L)
+		{
+			++(endtime.secs);
+			endtime.nsecs -= 1000000000L;
+		}
+
+		/* Loop while we are interrupted by signals */
+		for(;;)
+		{
+			/* How many milliseconds until the timeout?  Round up,
+			   so that we do not wake up just before the end time */
+			msecs = ((ILInt64)(endtime.secs - currtime.secs)) * 1000 +
+					((ILInt64)(endtime.nsecs - currtime.nsecs) + 999999) /
+						1000000;
+			if(msecs < 0)
+			{
+				msecs = 0;
+			}
+			else if(msecs > (ILInt64)IL_MAX_INT32)
+			{
+				msecs = (ILInt64)IL_MAX_INT32;
+			}
+
+			/* Perform a trial poll, which may be interrupted */
+			result = poll(fds, (unsigned long)numFds, (int)msecs);
+			if(result > 0 || (result < 0 && errno != EINTR))
+			{
+				break;
+			}
+
+			/* Timed out or interrupted, so check the end time */
+			ILGetCurrTime(&currtime);
+			if(currtime.secs > endtime.secs ||
+			   (currtime.secs == endtime.secs &&
+			    currtime.nsecs >= endtime.nsecs))
+			{
+				result = 0;
+				break;
+			}
+		}
+	}
+	else
+	{
+		/* Infinite poll */
+		while((result = poll(fds, (unsigned long)numFds, -1)) < 0)
+		{
+			/* Keep looping while we are being interrupted by signals */
+			if(errno != EINTR)
+			{
+				break;
+			}
+		}
+	}
+
+	/* Update the handle arrays if something fired */
+	if(result > 0)
+	{
+		/* "select" fails for closed descriptors, so we do too */
+		for(index = 0; index < numFds; ++index)
+		{
+			if((fds[index].revents & POLLNVAL) != 0)
+			{
+				errno = EBADF;
+				result = -1;
+				break;
+			}
+		}
+		if(result > 0)
+		{
+			result = PollToSelect(fds, readfds, numRead,
+								  IL_SELECT_READ_EVENTS);
+			result += PollToSelect(fds + numRead, writefds, numWrite,
+								   IL_SELECT_WRITE_EVENTS);
+			result += PollToSelect(fds + numRead + numWrite, exceptfds,
+								   numExcept, IL_SELECT_EXCEPT_EVENTS);
+		}
+	}
+
+	/* Clean up and return the result to the caller */
+	if(fds != stackFds)
+	{
+		ILFree(fds);
+	}
+	return (ILInt32)result;
+}
+
+#else /* !HAVE_POLL */
+
 ILInt32 ILSysIOSocketSelect(ILSysIOHandle **readfds, ILInt32 numRead,
 						    ILSysIOHandle **writefds, ILInt32 numWrite,
 						    ILSysIOHandle **exceptfds, ILInt32 numExcept,
@@ -830,6 +1473,8 @@ ILInt32 ILSysIOSocketSelect(ILSysIOHandle **readfds, ILInt32 numRead,
 	return (ILInt32)result;
 }
 
+#endif /* !HAVE_POLL */
+
 int ILSysIOSocketSetBlocking(ILSysIOHandle sockfd, int flag)
 {
 #if defined(FIONBIO) && defined(HAVE_IOCTL)
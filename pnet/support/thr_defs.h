@@ -218,6 +218,8 @@ struct _tagILThread
 	ILWaitHandle					*monitor;
 	ILMonitor						*monitorFreeList;
 	ILUInt32						monitorFreeCount;
+	/* Thread pool worker running on this thread (see "threadpool.c") */
+	void *				volatile	poolWorker;
 	/* 1 if the gc knows the thread and is allowed to execute managed code */
 #if defined(IL_INTERRUPT_SUPPORTS)
 	ILInterruptHandler				interruptHandler;
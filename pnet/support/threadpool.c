@@ -0,0 +1,1091 @@
+/*
+ * threadpool.c - Work-stealing thread pool.
+ *
+ * Copyright (C) 2026  Free Software Foundation, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+
+Note: the code in this module is generic to all platforms.  It builds
+a thread pool on top of the primitives in "thread.c", "wait_event.c"
+and "interlocked.h".
+
+Every worker owns a Chase-Lev deque.  Items that are queued by a worker
+of the pool are pushed onto the bottom of that worker's deque and are
+popped again in LIFO order.  Workers that run out of local work take
+items from the global injection queue, which is used by threads outside
+the pool, and then steal from the top of the other workers' deques.
+
+Workers that find nothing to do park on their own auto-reset event.
+A monitor thread samples the throughput of the pool periodically and
+moves the target number of workers between the minimum and the maximum
+using a simple hill-climbing rule.  If there is a backlog but no item
+completed during the last interval, the monitor injects an extra worker
+so that blocking work items can not deadlock the pool.
+
+The item buffers are allocated with "ILGCAllocPersistent", so that the
+garbage collector sees items that are only referenced from the pool.
+
+*/
+
+#include "thr_defs.h"
+#include "interlocked.h"
+#include "il_gc.h"
+#ifdef HAVE_UNISTD_H
+	#include <unistd.h>
+#endif
+
+#ifdef	__cplusplus
+extern	"C" {
+#endif
+
+/*
+ * Hard limit for the number of workers in a pool.
+ */
+#define	IL_POOL_MAX_WORKERS			256
+
+/*
+ * Default maximum number of workers per processor.
+ */
+#define	IL_POOL_THREADS_PER_CPU		25
+
+/*
+ * Initial sizes of the worker deques and the injection queue.
+ * Both must be powers of 2.
+ */
+#define	IL_POOL_DEQUE_SIZE			64
+#define	IL_POOL_QUEUE_SIZE			64
+
+/*
+ * Number of milliseconds that a worker stays parked before it exits,
+ * if there are more than the minimum number of workers.
+ */
+#define	IL_POOL_IDLE_TIMEOUT		20000
+
+/*
+ * Number of milliseconds between two samples of the monitor.
+ */
+#define	IL_POOL_SAMPLE_INTERVAL		500
+
+/*
+ * Difference of throughput in percent that is treated as a change.
+ */
+#define	IL_POOL_THROUGHPUT_NOISE	5
+
+/*
+ * States of a worker slot.
+ */
+#define	IL_POOL_WORKER_FREE			0
+#define	IL_POOL_WORKER_RUNNING		1
+#define	IL_POOL_WORKER_EXITED		2
+
+/*
+ * Deque indices only ever increase, so compute with wrap-around.
+ */
+#define	IndexAdd(index,n)	((ILInt32)((ILUInt32)(index) + (ILUInt32)(n)))
+#define	IndexDiff(b,t)		((ILInt32)((ILUInt32)(b) - (ILUInt32)(t)))
+
+/*
+ * Circular buffer behind a worker deque.  Buffers that are replaced by
+ * a larger one are kept on the "prev" list, because a thief may still
+ * be reading from them, and are freed when the pool is destroyed.
+ * Their items are cleared when they are replaced, so that the garbage
+ * collector does not see stale items in them.
+ */
+typedef struct _tagILPoolBuffer ILPoolBuffer;
+struct _tagILPoolBuffer
+{
+	ILPoolBuffer		   *prev;
+	ILInt32					mask;
+	void * volatile			items[1];
+};
+
+/*
+ * Information about a worker thread.
+ */
+typedef struct _tagILPoolWorker ILPoolWorker;
+struct _tagILPoolWorker
+{
+	ILThreadPool		   *pool;
+	ILThread			   *thread;
+	ILWaitHandle		   *event;
+	volatile ILInt32		state;
+
+	/* The deque.  The owner pushes and pops at "bottom" and the
+	   thieves take items at "top" */
+	volatile ILInt32		top;
+	volatile ILInt32		bottom;
+	ILPoolBuffer * volatile	buffer;
+	ILInt32					cleared;
+
+	/* Idle list, protected by the pool lock */
+	ILPoolWorker		   *nextIdle;
+	int						idle;
+
+	/* Statistics that are only written by the owner */
+	volatile ILInt32		busy;
+	volatile ILInt32		completed;
+	ILUInt32				random;
+};
+
+/*
+ * Internal structure of a thread pool.
+ */
+struct _tagILThreadPool
+{
+	ILMutex				   *lock;
+	ILThreadPoolStartFunc	startFunc;
+	ILThreadPoolRunFunc		runFunc;
+	void				   *userData;
+	int						shutdown;
+
+	/* Thread counts */
+	ILInt32					minThreads;
+	ILInt32					maxThreads;
+	volatile ILInt32		target;
+	volatile ILInt32		numThreads;
+	volatile ILInt32		numIdle;
+	volatile ILInt32		numSlots;
+	ILPoolWorker		   *firstIdle;
+
+	/* Global injection queue, protected by the pool lock */
+	void				  **queue;
+	ILInt32					queueMask;
+	ILInt32					queueHead;
+	volatile ILInt32		queueCount;
+
+	/* Monitor thread and hill-climbing state */
+	ILThread			   *monitor;
+	ILWaitHandle		   *monitorEvent;
+	int						monitorRunning;
+	ILInt32					lastCompleted;
+	ILInt32					lastThroughput;
+	int						direction;
+
+	ILPoolWorker			workers[IL_POOL_MAX_WORKERS];
+};
+
+/*
+ * Get the number of processors that are online.
+ */
+static ILInt32 ProcessorCount(void)
+{
+#if defined(HAVE_UNISTD_H) && defined(_SC_NPROCESSORS_ONLN)
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	if(count > 0)
+	{
+		return (count < IL_POOL_MAX_WORKERS ? (ILInt32)count
+											: IL_POOL_MAX_WORKERS);
+	}
+#endif
+	return 1;
+}
+
+/*
+ * Allocate a deque buffer with "size" entries.
+ */
+static ILPoolBuffer *BufferCreate(ILInt32 size)
+{
+	ILPoolBuffer *buffer;
+	ILInt32 index;
+
+	buffer = (ILPoolBuffer *)ILGCAllocPersistent
+		(sizeof(ILPoolBuffer) + (size - 1) * sizeof(void *));
+	if(buffer)
+	{
+		buffer->prev = 0;
+		buffer->mask = size - 1;
+		for(index = 0; index < size; ++index)
+		{
+			buffer->items[index] = 0;
+		}
+	}
+	return buffer;
+}
+
+/*
+ * Push an item onto the bottom of the deque of the current worker.
+ */
+static int DequePush(ILPoolWorker *worker, void *item)
+{
+	ILInt32 bottom = worker->bottom;
+	ILInt32 top = ILInterlockedLoadI4_Acquire(&(worker->top));
+	ILPoolBuffer *buffer = worker->buffer;
+	ILPoolBuffer *newBuffer;
+	ILInt32 index;
+
+	if(IndexDiff(bottom, top) > buffer->mask)
+	{
+		/* The deque is full: copy the live items into a larger buffer */
+		newBuffer = BufferCreate((buffer->mask + 1) * 2);
+		if(!newBuffer)
+		{
+			return 0;
+		}
+		for(index = top; index != bottom; index = IndexAdd(index, 1))
+		{
+			newBuffer->items[index & newBuffer->mask] =
+				buffer->items[index & buffer->mask];
+		}
+		newBuffer->prev = buffer;
+		ILInterlockedStoreP_Release((void * volatile *)&(worker->buffer),
+									newBuffer);
+
+		/* Thieves that still read the old buffer will see an empty
+		   slot and retry with the new buffer */
+		for(index = 0; index <= buffer->mask; ++index)
+		{
+			buffer->items[index] = 0;
+		}
+		buffer = newBuffer;
+	}
+	buffer->items[bottom & buffer->mask] = item;
+	ILInterlockedStoreI4_Release(&(worker->bottom), IndexAdd(bottom, 1));
+	return 1;
+}
+
+/*
+ * Pop an item from the bottom of the deque of the current worker.
+ */
+static void *DequePop(ILPoolWorker *worker)
+{
+	ILInt32 bottom = IndexAdd(worker->bottom, -1);
+	ILPoolBuffer *buffer = worker->buffer;
+	ILInt32 top;
+	void *item;
+
+	ILInterlockedStoreI4(&(worker->bottom), bottom);
+	ILInterlockedMemoryBarrier();
+	top = ILInterlockedLoadI4(&(worker->top));
+	if(IndexDiff(bottom, top) < 0)
+	{
+		/* The deque is empty.  The slots below "top" have been taken
+		   by thieves and can be cleared, so that the garbage collector
+		   does not see the stale items any more */
+		ILInterlockedStoreI4(&(worker->bottom), top);
+		if(IndexDiff(top, worker->cleared) > buffer->mask)
+		{
+			worker->cleared = IndexAdd(top, -(buffer->mask + 1));
+		}
+		while(worker->cleared != top)
+		{
+			buffer->items[worker->cleared & buffer->mask] = 0;
+			worker->cleared = IndexAdd(worker->cleared, 1);
+		}
+		return 0;
+	}
+	item = buffer->items[bottom & buffer->mask];
+	if(bottom == top)
+	{
+		/* This is the last item, so we have to race against thieves */
+		if(ILInterlockedCompareAndExchangeI4_Full
+				(&(worker->top), IndexAdd(top, 1), top) != top)
+		{
+			item = 0;
+		}
+		else
+		{
+			buffer->items[bottom & buffer->mask] = 0;
+		}
+		ILInterlockedStoreI4(&(worker->bottom), IndexAdd(top, 1));
+		return item;
+	}
+	buffer->items[bottom & buffer->mask] = 0;
+	return item;
+}
+
+/*
+ * Steal an item from the top of another worker's deque.  Sets "retry"
+ * if the deque was not empty but another thread won the race.
+ */
+static void *DequeSteal(ILPoolWorker *victim, int *retry)
+{
+	ILInt32 top = ILInterlockedLoadI4_Acquire(&(victim->top));
+	ILInt32 bottom;
+	ILPoolBuffer *buffer;
+	void *item;
+
+	ILInterlockedMemoryBarrier();
+	bottom = ILInterlockedLoadI4_Acquire(&(victim->bottom));
+	if(IndexDiff(bottom, top) <= 0)
+	{
+		return 0;
+	}
+	buffer = (ILPoolBuffer *)ILInterlockedLoadP_Acquire
+		((void * const volatile *)&(victim->buffer));
+	item = buffer->items[top & buffer->mask];
+	if(!item)
+	{
+		/* The buffer was replaced after we loaded it, or the
+		   item was taken by someone else */
+		*retry = 1;
+		return 0;
+	}
+	if(ILInterlockedCompareAndExchangeI4_Full
+			(&(victim->top), IndexAdd(top, 1), top) != top)
+	{
+		*retry = 1;
+		return 0;
+	}
+	return item;
+}
+
+/*
+ * Add an item to the global injection queue.  The pool lock must be held.
+ */
+static int QueuePush(ILThreadPool *pool, void *item)
+{
+	void **newQueue;
+	ILInt32 size = pool->queueMask + 1;
+	ILInt32 index;
+
+	if(pool->queueCount == size)
+	{
+		newQueue = (void **)ILGCAllocPersistent(2 * size * sizeof(void *));
+		if(!newQueue)
+		{
+			return 0;
+		}
+		for(index = 0; index < size; ++index)
+		{
+			newQueue[index] =
+				pool->queue[(pool->queueHead + index) & pool->queueMask];
+		}
+		for(; index < 2 * size; ++index)
+		{
+			newQueue[index] = 0;
+		}
+		ILGCFreePersistent(pool->queue);
+		pool->queue = newQueue;
+		pool->queueMask = 2 * size - 1;
+		pool->queueHead = 0;
+	}
+	pool->queue[(pool->queueHead + pool->queueCount) & pool->queueMask] = item;
+	++(pool->queueCount);
+	return 1;
+}
+
+/*
+ * Remove an item from the global injection queue.  The pool lock
+ * must be held.
+ */
+static void *QueuePop(ILThreadPool *pool)
+{
+	void *item;
+
+	if(pool->queueCount == 0)
+	{
+		return 0;
+	}
+	item = pool->queue[pool->queueHead];
+	pool->queue[pool->queueHead] = 0;
+	pool->queueHead = (pool->queueHead + 1) & pool->queueMask;
+	--(pool->queueCount);
+	return item;
+}
+
+/*
+ * Wake up one parked worker.  The pool lock must be held.
+ */
+static int WakeWorker(ILThreadPool *pool)
+{
+	ILPoolWorker *worker = pool->firstIdle;
+
+	if(!worker)
+	{
+		return 0;
+	}
+	pool->firstIdle = worker->nextIdle;
+	worker->nextIdle = 0;
+	worker->idle = 0;
+	--(pool->numIdle);
+	ILWaitEventSet(worker->event);
+	return 1;
+}
+
+/*
+ * Remove a worker from the idle list.  The pool lock must be held.
+ */
+static void UnlinkIdleWorker(ILThreadPool *pool, ILPoolWorker *worker)
+{
+	ILPoolWorker **prev = &(pool->firstIdle);
+
+	while(*prev && *prev != worker)
+	{
+		prev = &((*prev)->nextIdle);
+	}
+	if(*prev)
+	{
+		*prev = worker->nextIdle;
+	}
+	worker->nextIdle = 0;
+	worker->idle = 0;
+	--(pool->numIdle);
+}
+
+/*
+ * Determine if any of the worker deques contains items.
+ */
+static int HaveDequeItems(ILThreadPool *pool)
+{
+	ILInt32 numSlots = ILInterlockedLoadI4_Acquire(&(pool->numSlots));
+	ILPoolWorker *worker;
+	ILInt32 index;
+
+	for(index = 0; index < numSlots; ++index)
+	{
+		worker = &(pool->workers[index]);
+		if(worker->state == IL_POOL_WORKER_RUNNING &&
+		   IndexDiff(worker->bottom, worker->top) > 0)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Find the next item for a worker to run.
+ */
+static void *FindWork(ILPoolWorker *worker)
+{
+	ILThreadPool *pool = worker->pool;
+	ILPoolWorker *victim;
+	ILInt32 numSlots;
+	ILInt32 start;
+	ILInt32 index;
+	int retry;
+	void *item;
+
+	/* Try our own deque first */
+	if((item = DequePop(worker)) != 0)
+	{
+		return item;
+	}
+
+	/* Then the global injection queue */
+	if(pool->queueCount > 0)
+	{
+		ILMutexLock(pool->lock);
+		item = QueuePop(pool);
+		ILMutexUnlock(pool->lock);
+		if(item)
+		{
+			return item;
+		}
+	}
+
+	/* Steal from the other workers, starting at a random victim */
+	numSlots = ILInterlockedLoadI4_Acquire(&(pool->numSlots));
+	do
+	{
+		retry = 0;
+		worker->random = worker->random * 1103515245 + 12345;
+		start = (ILInt32)((worker->random >> 16) % (ILUInt32)numSlots);
+		for(index = 0; index < numSlots; ++index)
+		{
+			victim = &(pool->workers[(start + index) % numSlots]);
+			if(victim != worker &&
+			   victim->state == IL_POOL_WORKER_RUNNING &&
+			   (item = DequeSteal(victim, &retry)) != 0)
+			{
+				return item;
+			}
+		}
+	}
+	while(retry);
+	return 0;
+}
+
+static void WorkerMain(void *arg);
+static void MonitorMain(void *arg);
+
+/*
+ * Start a new worker.  The pool lock must be held.
+ */
+static int SpawnWorker(ILThreadPool *pool)
+{
+	ILPoolWorker *worker = 0;
+	ILInt32 index;
+
+	if(pool->shutdown || pool->numThreads >= pool->maxThreads)
+	{
+		return 0;
+	}
+
+	/* Find a free slot, or else the slot of a worker that has exited */
+	for(index = 0; index < IL_POOL_MAX_WORKERS; ++index)
+	{
+		if(pool->workers[index].state == IL_POOL_WORKER_FREE)
+		{
+			worker = &(pool->workers[index]);
+			break;
+		}
+	}
+	if(!worker)
+	{
+		for(index = 0; index < IL_POOL_MAX_WORKERS; ++index)
+		{
+			if(pool->workers[index].state == IL_POOL_WORKER_EXITED)
+			{
+				worker = &(pool->workers[index]);
+				break;
+			}
+		}
+		if(!worker)
+		{
+			return 0;
+		}
+	}
+
+	/* Reclaim the thread of the previous owner of the slot */
+	if(worker->thread)
+	{
+		ILThreadJoin(worker->thread, IL_MAX_UINT32);
+		ILThreadDestroy(worker->thread);
+		worker->thread = 0;
+	}
+
+	/* The event and the deque buffer are kept when a slot is reused */
+	if(!(worker->event))
+	{
+		if((worker->event = ILWaitEventCreate(0, 0)) == 0)
+		{
+			return 0;
+		}
+	}
+	if(!(worker->buffer))
+	{
+		if((worker->buffer = BufferCreate(IL_POOL_DEQUE_SIZE)) == 0)
+		{
+			return 0;
+		}
+	}
+	worker->pool = pool;
+	worker->random = (ILUInt32)index * 2654435761U + 1;
+	if((worker->thread = ILThreadCreate(WorkerMain, worker)) == 0)
+	{
+		return 0;
+	}
+	ILThreadSetBackground(worker->thread, 1);
+
+	/* Publish the slot before the thread can start stealing */
+	ILInterlockedStoreI4_Release(&(worker->state), IL_POOL_WORKER_RUNNING);
+	if(index >= pool->numSlots)
+	{
+		ILInterlockedStoreI4_Release(&(pool->numSlots), index + 1);
+	}
+	++(pool->numThreads);
+	if(!ILThreadStart(worker->thread))
+	{
+		--(pool->numThreads);
+		ILThreadDestroy(worker->thread);
+		worker->thread = 0;
+		worker->state = IL_POOL_WORKER_FREE;
+		return 0;
+	}
+
+	/* Make sure that the monitor is running */
+	if(!(pool->monitorRunning))
+	{
+		if(pool->monitor)
+		{
+			ILThreadJoin(pool->monitor, IL_MAX_UINT32);
+			ILThreadDestroy(pool->monitor);
+		}
+		if((pool->monitor = ILThreadCreate(MonitorMain, pool)) != 0)
+		{
+			ILThreadSetBackground(pool->monitor, 1);
+			pool->monitorRunning = 1;
+			if(!ILThreadStart(pool->monitor))
+			{
+				ILThreadDestroy(pool->monitor);
+				pool->monitor = 0;
+				pool->monitorRunning = 0;
+			}
+		}
+	}
+	return 1;
+}
+
+/*
+ * Park the current worker until there is work to do.  Returns zero
+ * if the worker should exit.
+ */
+static int ParkWorker(ILPoolWorker *worker)
+{
+	ILThreadPool *pool = worker->pool;
+	int result;
+
+	ILMutexLock(pool->lock);
+	if(pool->shutdown || pool->numThreads > pool->target)
+	{
+		/* The pool is shutting down or has too many threads */
+		ILMutexUnlock(pool->lock);
+		return 0;
+	}
+	if(pool->queueCount > 0)
+	{
+		ILMutexUnlock(pool->lock);
+		return 1;
+	}
+	worker->idle = 1;
+	worker->nextIdle = pool->firstIdle;
+	pool->firstIdle = worker;
+	++(pool->numIdle);
+	ILMutexUnlock(pool->lock);
+
+	/* A worker may have pushed onto its deque before it saw us on the
+	   idle list, so check the deques again before going to sleep */
+	ILInterlockedMemoryBarrier();
+	if(HaveDequeItems(pool))
+	{
+		ILMutexLock(pool->lock);
+		if(worker->idle)
+		{
+			UnlinkIdleWorker(pool, worker);
+		}
+		else
+		{
+			/* Consume the wakeup that we did not wait for */
+			ILWaitOne(worker->event, 0);
+		}
+		ILMutexUnlock(pool->lock);
+		return 1;
+	}
+
+	result = ILWaitOne(worker->event, IL_POOL_IDLE_TIMEOUT);
+	if(result == 0)
+	{
+		/* Woken up by "WakeWorker", which unlinked us */
+		return 1;
+	}
+
+	ILMutexLock(pool->lock);
+	if(worker->idle)
+	{
+		UnlinkIdleWorker(pool, worker);
+	}
+	else if(result == IL_WAIT_TIMEOUT)
+	{
+		/* Someone woke us up just as the timeout expired */
+		ILWaitOne(worker->event, 0);
+		ILMutexUnlock(pool->lock);
+		return 1;
+	}
+	if(result == IL_WAIT_TIMEOUT && pool->numThreads <= pool->minThreads)
+	{
+		ILMutexUnlock(pool->lock);
+		return 1;
+	}
+	ILMutexUnlock(pool->lock);
+	return 0;
+}
+
+/*
+ * Main loop of a worker thread.
+ */
+static void WorkerMain(void *arg)
+{
+	ILPoolWorker *worker = (ILPoolWorker *)arg;
+	ILThreadPool *pool = worker->pool;
+	ILThread *thread = ILThreadSelf();
+	int restart = 1;
+	void *item;
+
+	thread->poolWorker = worker;
+	if(pool->startFunc && !(*(pool->startFunc))(pool->userData))
+	{
+		/* The worker can not run items, so don't replace it either */
+		restart = 0;
+	}
+	else
+	{
+		for(;;)
+		{
+			if((item = FindWork(worker)) != 0)
+			{
+				worker->busy = 1;
+				if((*(pool->runFunc))(pool->userData, item))
+				{
+					worker->busy = 0;
+					worker->completed = IndexAdd(worker->completed, 1);
+					break;
+				}
+				worker->busy = 0;
+				worker->completed = IndexAdd(worker->completed, 1);
+			}
+			else if(!ParkWorker(worker))
+			{
+				break;
+			}
+		}
+	}
+
+	/* Hand our remaining items over to the other workers */
+	ILMutexLock(pool->lock);
+	while((item = DequePop(worker)) != 0)
+	{
+		QueuePush(pool, item);
+	}
+	thread->poolWorker = 0;
+	--(pool->numThreads);
+	if(restart && pool->queueCount > 0 && !WakeWorker(pool))
+	{
+		SpawnWorker(pool);
+	}
+
+	/* The slot can be reused once we have left the lock */
+	ILInterlockedStoreI4_Release(&(worker->state), IL_POOL_WORKER_EXITED);
+	ILMutexUnlock(pool->lock);
+}
+
+/*
+ * Adjust the target number of workers.  The pool lock must be held.
+ */
+static void AdjustPool(ILThreadPool *pool)
+{
+	ILPoolWorker *worker;
+	ILInt32 completed = 0;
+	ILInt32 backlog = pool->queueCount;
+	ILInt32 busy = 0;
+	ILInt32 throughput;
+	ILInt32 index;
+
+	for(index = 0; index < pool->numSlots; ++index)
+	{
+		worker = &(pool->workers[index]);
+		completed = IndexAdd(completed, worker->completed);
+		if(worker->state == IL_POOL_WORKER_RUNNING)
+		{
+			busy += worker->busy;
+			if(IndexDiff(worker->bottom, worker->top) > 0)
+			{
+				backlog += IndexDiff(worker->bottom, worker->top);
+			}
+		}
+	}
+	throughput = IndexDiff(completed, pool->lastCompleted);
+
+	if(backlog > 0)
+	{
+		if(throughput == 0 && busy >= pool->numThreads)
+		{
+			/* Every worker is blocked: inject another one */
+			if(pool->target < pool->numThreads + 1)
+			{
+				pool->target = pool->numThreads + 1;
+			}
+		}
+		else if(throughput * 100 >
+					pool->lastThroughput * (100 + IL_POOL_THROUGHPUT_NOISE))
+		{
+			/* The last move helped, so keep going */
+			pool->target += pool->direction;
+		}
+		else if(throughput * 100 <
+					pool->lastThroughput * (100 - IL_POOL_THROUGHPUT_NOISE))
+		{
+			/* The last move hurt, so turn around */
+			pool->direction = -(pool->direction);
+			pool->target += pool->direction;
+		}
+		if(pool->target < pool->minThreads)
+		{
+			pool->target = pool->minThreads;
+		}
+		else if(pool->target > pool->maxThreads)
+		{
+			pool->target = pool->maxThreads;
+		}
+
+		/* Put the idle workers to work and start new ones if needed */
+		while(backlog > 0 && WakeWorker(pool))
+		{
+			--backlog;
+		}
+		while(backlog > 0 && pool->numThreads < pool->target &&
+			  SpawnWorker(pool))
+		{
+			--backlog;
+		}
+	}
+	else
+	{
+		pool->direction = 1;
+	}
+	pool->lastCompleted = completed;
+	pool->lastThroughput = throughput;
+}
+
+/*
+ * Main loop of the monitor thread.
+ */
+static void MonitorMain(void *arg)
+{
+	ILThreadPool *pool = (ILThreadPool *)arg;
+	int result;
+
+	for(;;)
+	{
+		result = ILWaitOne(pool->monitorEvent, IL_POOL_SAMPLE_INTERVAL);
+		ILMutexLock(pool->lock);
+		if(pool->shutdown ||
+		   (result != 0 && result != IL_WAIT_TIMEOUT) ||
+		   (pool->numThreads == 0 && pool->queueCount == 0))
+		{
+			/* "SpawnWorker" restarts us when it is needed again */
+			pool->monitorRunning = 0;
+			ILMutexUnlock(pool->lock);
+			break;
+		}
+		AdjustPool(pool);
+		ILMutexUnlock(pool->lock);
+	}
+}
+
+ILThreadPool *ILThreadPoolCreate(ILThreadPoolStartFunc startFunc,
+								 ILThreadPoolRunFunc runFunc,
+								 void *userData)
+{
+	ILThreadPool *pool;
+
+	if(!ILHasThreads() || !runFunc)
+	{
+		return 0;
+	}
+	if((pool = (ILThreadPool *)ILCalloc(1, sizeof(ILThreadPool))) == 0)
+	{
+		return 0;
+	}
+	pool->startFunc = startFunc;
+	pool->runFunc = runFunc;
+	pool->userData = userData;
+	pool->minThreads = ProcessorCount();
+	pool->maxThreads = pool->minThreads * IL_POOL_THREADS_PER_CPU;
+	if(pool->maxThreads > IL_POOL_MAX_WORKERS)
+	{
+		pool->maxThreads = IL_POOL_MAX_WORKERS;
+	}
+	pool->target = pool->minThreads;
+	pool->direction = 1;
+	pool->queueMask = IL_POOL_QUEUE_SIZE - 1;
+	if((pool->lock = ILMutexCreate()) == 0 ||
+	   (pool->monitorEvent = ILWaitEventCreate(0, 0)) == 0 ||
+	   (pool->queue = (void **)ILGCAllocPersistent
+	   			(IL_POOL_QUEUE_SIZE * sizeof(void *))) == 0)
+	{
+		ILThreadPoolDestroy(pool);
+		return 0;
+	}
+	ILMemZero(pool->queue, IL_POOL_QUEUE_SIZE * sizeof(void *));
+	return pool;
+}
+
+void ILThreadPoolDestroy(ILThreadPool *pool)
+{
+	ILPoolWorker *worker;
+	ILPoolBuffer *buffer;
+	ILInt32 index;
+
+	/* Tell the workers and the monitor to exit */
+	if(pool->lock)
+	{
+		ILMutexLock(pool->lock);
+		pool->shutdown = 1;
+		while(WakeWorker(pool))
+		{
+			/* Nothing to do here */
+		}
+		if(pool->monitorEvent)
+		{
+			ILWaitEventSet(pool->monitorEvent);
+		}
+		ILMutexUnlock(pool->lock);
+	}
+
+	/* Wait for them and free the per-worker state */
+	for(index = 0; index < IL_POOL_MAX_WORKERS; ++index)
+	{
+		worker = &(pool->workers[index]);
+		if(worker->thread)
+		{
+			ILThreadJoin(worker->thread, IL_MAX_UINT32);
+			ILThreadDestroy(worker->thread);
+		}
+		if(worker->event)
+		{
+			ILWaitHandleClose(worker->event);
+		}
+		while((buffer = worker->buffer) != 0)
+		{
+			worker->buffer = buffer->prev;
+			ILGCFreePersistent(buffer);
+		}
+	}
+	if(pool->monitor)
+	{
+		ILThreadJoin(pool->monitor, IL_MAX_UINT32);
+		ILThreadDestroy(pool->monitor);
+	}
+	if(pool->monitorEvent)
+	{
+		ILWaitHandleClose(pool->monitorEvent);
+	}
+	if(pool->queue)
+	{
+		ILGCFreePersistent(pool->queue);
+	}
+	if(pool->lock)
+	{
+		ILMutexDestroy(pool->lock);
+	}
+	ILFree(pool);
+}
+
+int ILThreadPoolQueue(ILThreadPool *pool, void *item)
+{
+	ILThread *thread = ILThreadSelf();
+	ILPoolWorker *worker;
+
+	if(!item || pool->shutdown)
+	{
+		return 0;
+	}
+
+	/* Workers of this pool push onto their own deque */
+	worker = (thread ? (ILPoolWorker *)(thread->poolWorker) : 0);
+	if(worker && worker->pool == pool)
+	{
+		if(!DequePush(worker, item))
+		{
+			return 0;
+		}
+		ILInterlockedMemoryBarrier();
+		if(pool->numIdle > 0 || pool->numThreads < pool->target)
+		{
+			ILMutexLock(pool->lock);
+			if(!WakeWorker(pool) && pool->numThreads < pool->target)
+			{
+				SpawnWorker(pool);
+			}
+			ILMutexUnlock(pool->lock);
+		}
+		return 1;
+	}
+
+	/* Everyone else uses the injection queue */
+	ILMutexLock(pool->lock);
+	if(!QueuePush(pool, item))
+	{
+		ILMutexUnlock(pool->lock);
+		return 0;
+	}
+	if(!WakeWorker(pool) && pool->numThreads < pool->target)
+	{
+		SpawnWorker(pool);
+	}
+	ILMutexUnlock(pool->lock);
+	return 1;
+}
+
+int ILThreadPoolGetMinThreads(ILThreadPool *pool)
+{
+	return pool->minThreads;
+}
+
+int ILThreadPoolGetMaxThreads(ILThreadPool *pool)
+{
+	return pool->maxThreads;
+}
+
+int ILThreadPoolSetMinThreads(ILThreadPool *pool, int count)
+{
+	int result = 0;
+
+	ILMutexLock(pool->lock);
+	if(count > 0 && count <= pool->maxThreads)
+	{
+		pool->minThreads = count;
+		if(pool->target < count)
+		{
+			pool->target = count;
+		}
+		result = 1;
+	}
+	ILMutexUnlock(pool->lock);
+	return result;
+}
+
+int ILThreadPoolSetMaxThreads(ILThreadPool *pool, int count)
+{
+	int result = 0;
+
+	ILMutexLock(pool->lock);
+	if(count >= pool->minThreads && count <= IL_POOL_MAX_WORKERS)
+	{
+		pool->maxThreads = count;
+		if(pool->target > count)
+		{
+			pool->target = count;
+		}
+		result = 1;
+	}
+	ILMutexUnlock(pool->lock);
+	return result;
+}
+
+void ILThreadPoolGetCounts(ILThreadPool *pool, int *numThreads,
+						   int *numBusy, int *numQueued)
+{
+	ILPoolWorker *worker;
+	ILInt32 index;
+	int busy = 0;
+	int queued;
+
+	ILMutexLock(pool->lock);
+	queued = pool->queueCount;
+	for(index = 0; index < pool->numSlots; ++index)
+	{
+		worker = &(pool->workers[index]);
+		if(worker->state == IL_POOL_WORKER_RUNNING)
+		{
+			busy += worker->busy;
+			if(IndexDiff(worker->bottom, worker->top) > 0)
+			{
+				queued += IndexDiff(worker->bottom, worker->top);
+			}
+		}
+	}
+	if(numThreads)
+	{
+		*numThreads = pool->numThreads;
+	}
+	if(numBusy)
+	{
+		*numBusy = busy;
+	}
+	if(numQueued)
+	{
+		*numQueued = queued;
+	}
+	ILMutexUnlock(pool->lock);
+}
+
+#ifdef	__cplusplus
+};
+#endif
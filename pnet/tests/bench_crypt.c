@@ -0,0 +1,345 @@
+/*
+ * bench_crypt.c - Measure the speed of the cryptographic primitives.
+ *
+ * Copyright (C) 2026  Free Software Foundation, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * This program is not run by "make check".  Run "./bench_crypt" by hand
+ * to print the time taken by each benchmark.  The inputs are generated
+ * from a fixed seed, so that runs on different builds are comparable.
+ */
+
+#include <stdio.h>
+#include "il_system.h"
+#include "il_crypt.h"
+#include "il_bignum.h"
+
+#ifdef	__cplusplus
+extern	"C" {
+#endif
+
+/*
+ * Simple pseudo-random generator for the benchmark inputs.
+ */
+static ILUInt32 randomState = 0x12345678;
+static void RandomBytes(unsigned char *buf, int len)
+{
+	while(len > 0)
+	{
+		randomState ^= randomState << 13;
+		randomState ^= randomState >> 17;
+		randomState ^= randomState << 5;
+		*buf++ = (unsigned char)randomState;
+		--len;
+	}
+}
+
+/*
+ * Get the current time in milliseconds.
+ */
+static double CurrentTime(void)
+{
+	ILCurrTime timeValue;
+	if(!ILGetSinceRebootTime(&timeValue))
+	{
+		ILGetCurrTime(&timeValue);
+	}
+	return ((double)(timeValue.secs)) * 1000.0 +
+		   ((double)(timeValue.nsecs)) / 1000000.0;
+}
+
+/*
+ * Size of the buffer that is used to measure throughput.
+ */
+#define	BENCH_BUFFER_SIZE	(64 * 1024)
+
+/*
+ * Report the throughput of a benchmark that processed "bytes" bytes.
+ */
+static void ReportRate(const char *name, const char *variant,
+					   double bytes, double elapsed)
+{
+	printf("%-20s %-9s %10.1f MB/s\n", name, variant,
+		   (bytes / (1024.0 * 1024.0)) / (elapsed / 1000.0));
+}
+
+/*
+ * Measure the throughput of the AES modes with a "keyBits" key.
+ */
+static void BenchAES(int keyBits, const char *variant, int iterations)
+{
+	static unsigned char buf[BENCH_BUFFER_SIZE];
+	unsigned char key[32];
+	unsigned char iv[16];
+	ILAESContext aes;
+	char name[64];
+	double start;
+	int count;
+
+	RandomBytes(key, sizeof(key));
+	RandomBytes(iv, sizeof(iv));
+	RandomBytes(buf, sizeof(buf));
+	ILAESInit(&aes, key, keyBits);
+
+	start = CurrentTime();
+	for(count = 0; count < iterations; ++count)
+	{
+		ILAESEncryptECB(&aes, buf, buf, BENCH_BUFFER_SIZE / 16);
+	}
+	sprintf(name, "aes-%d-ecb encrypt", keyBits);
+	ReportRate(name, variant, (double)BENCH_BUFFER_SIZE * iterations,
+			   CurrentTime() - start);
+
+	start = CurrentTime();
+	for(count = 0; count < iterations; ++count)
+	{
+		ILAESEncryptCBC(&aes, iv, buf, buf, BENCH_BUFFER_SIZE / 16);
+	}
+	sprintf(name, "aes-%d-cbc encrypt", keyBits);
+	ReportRate(name, variant, (double)BENCH_BUFFER_SIZE * iterations,
+			   CurrentTime() - start);
+
+	start = CurrentTime();
+	for(count = 0; count < iterations; ++count)
+	{
+		ILAESDecryptCBC(&aes, iv, buf, buf, BENCH_BUFFER_SIZE / 16);
+	}
+	sprintf(name, "aes-%d-cbc decrypt", keyBits);
+	ReportRate(name, variant, (double)BENCH_BUFFER_SIZE * iterations,
+			   CurrentTime() - start);
+
+	ILAESFinalize(&aes);
+}
+
+/*
+ * Measure the throughput of the SHA hash algorithms.
+ */
+static void BenchSHA(const char *variant, int iterations)
+{
+	static unsigned char buf[BENCH_BUFFER_SIZE];
+	unsigned char hash[IL_SHA512_HASH_SIZE];
+	ILSHAContext sha1;
+	ILSHA256Context sha256;
+	ILSHA512Context sha512;
+	double start;
+	int count;
+
+	RandomBytes(buf, sizeof(buf));
+
+	start = CurrentTime();
+	ILSHAInit(&sha1);
+	for(count = 0; count < iterations; ++count)
+	{
+		ILSHAData(&sha1, buf, BENCH_BUFFER_SIZE);
+	}
+	ILSHAFinalize(&sha1, hash);
+	ReportRate("sha1", variant, (double)BENCH_BUFFER_SIZE * iterations,
+			   CurrentTime() - start);
+
+	start = CurrentTime();
+	ILSHA256Init(&sha256);
+	for(count = 0; count < iterations; ++count)
+	{
+		ILSHA256Data(&sha256, buf, BENCH_BUFFER_SIZE);
+	}
+	ILSHA256Finalize(&sha256, hash);
+	ReportRate("sha256", variant, (double)BENCH_BUFFER_SIZE * iterations,
+			   CurrentTime() - start);
+
+	start = CurrentTime();
+	ILSHA512Init(&sha512);
+	for(count = 0; count < iterations; ++count)
+	{
+		ILSHA512Data(&sha512, buf, BENCH_BUFFER_SIZE);
+	}
+	ILSHA512Finalize(&sha512, hash);
+	ReportRate("sha512", variant, (double)BENCH_BUFFER_SIZE * iterations,
+			   CurrentTime() - start);
+}
+
+/*
+ * Compare AES-128 CBC encryption one block per call, which is how the
+ * managed transforms used to drive the engine, against a single call
+ * for the whole buffer.
+ */
+static void BenchBlockCalls(const char *variant, int iterations)
+{
+	static unsigned char buf[BENCH_BUFFER_SIZE];
+	unsigned char key[16];
+	unsigned char iv[16];
+	ILAESContext aes;
+	double start;
+	int count, offset, posn;
+
+	RandomBytes(key, sizeof(key));
+	RandomBytes(iv, sizeof(iv));
+	RandomBytes(buf, sizeof(buf));
+	ILAESInit(&aes, key, 128);
+
+	start = CurrentTime();
+	for(count = 0; count < iterations; ++count)
+	{
+		for(offset = 0; offset < BENCH_BUFFER_SIZE; offset += 16)
+		{
+			for(posn = 0; posn < 16; ++posn)
+			{
+				iv[posn] ^= buf[offset + posn];
+			}
+			ILAESEncrypt(&aes, iv, iv);
+			ILMemCpy(buf + offset, iv, 16);
+		}
+	}
+	ReportRate("aes-128-cbc 1-block", variant,
+			   (double)BENCH_BUFFER_SIZE * iterations, CurrentTime() - start);
+
+	start = CurrentTime();
+	for(count = 0; count < iterations; ++count)
+	{
+		ILAESEncryptCBC(&aes, iv, buf, buf, BENCH_BUFFER_SIZE / 16);
+	}
+	ReportRate("aes-128-cbc bulk", variant,
+			   (double)BENCH_BUFFER_SIZE * iterations, CurrentTime() - start);
+
+	ILAESFinalize(&aes);
+}
+
+/*
+ * Measure the symmetric primitives with and without the hardware.
+ */
+static void BenchSymmetric(void)
+{
+	int saved = ILCryptSetHardware(0);
+	BenchAES(128, "portable", 50);
+	BenchAES(256, "portable", 50);
+	BenchSHA("portable", 200);
+	BenchBlockCalls("portable", 50);
+	ILCryptSetHardware(saved);
+	if(ILCryptHardware() != 0)
+	{
+		BenchAES(128, "hardware", 2000);
+		BenchAES(256, "hardware", 2000);
+		BenchSHA("hardware", 1000);
+		BenchBlockCalls("hardware", 2000);
+	}
+}
+
+/*
+ * Measure modular exponentiation with an odd modulus of "bits" bits
+ * and an exponent of the same size, as used by RSA private keys.
+ */
+static void BenchModExp(int bits, int iterations)
+{
+	unsigned char buf[1024];
+	ILBigNum *base;
+	ILBigNum *exponent;
+	ILBigNum *modulus;
+	ILBigNum *result;
+	double start, elapsed;
+	int bytes = bits / 8;
+	int count;
+
+	RandomBytes(buf, bytes);
+	base = ILBigNumFromBytes(buf, bytes - 1);
+	RandomBytes(buf, bytes);
+	exponent = ILBigNumFromBytes(buf, bytes);
+	RandomBytes(buf, bytes);
+	buf[0] |= 0x80;
+	buf[bytes - 1] |= 0x01;
+	modulus = ILBigNumFromBytes(buf, bytes);
+	if(!base || !exponent || !modulus)
+	{
+		fprintf(stderr, "out of memory\n");
+		return;
+	}
+
+	start = CurrentTime();
+	for(count = 0; count < iterations; ++count)
+	{
+		result = ILBigNumPow(base, exponent, modulus);
+		if(!result)
+		{
+			fprintf(stderr, "out of memory\n");
+			break;
+		}
+		ILBigNumFree(result);
+	}
+	elapsed = CurrentTime() - start;
+	printf("modexp %4d bits     %10.2f ms/op\n",
+		   bits, elapsed / (double)iterations);
+
+	ILBigNumFree(base);
+	ILBigNumFree(exponent);
+	ILBigNumFree(modulus);
+}
+
+/*
+ * Measure multiplication of two values of "bits" bits.
+ */
+static void BenchMul(int bits, int iterations)
+{
+	unsigned char buf[1024];
+	ILBigNum *x;
+	ILBigNum *y;
+	ILBigNum *result;
+	double start, elapsed;
+	int bytes = bits / 8;
+	int count;
+
+	RandomBytes(buf, bytes);
+	x = ILBigNumFromBytes(buf, bytes);
+	RandomBytes(buf, bytes);
+	y = ILBigNumFromBytes(buf, bytes);
+	if(!x || !y)
+	{
+		fprintf(stderr, "out of memory\n");
+		return;
+	}
+
+	start = CurrentTime();
+	for(count = 0; count < iterations; ++count)
+	{
+		result = ILBigNumMul(x, y, (ILBigNum *)0);
+		if(!result)
+		{
+			fprintf(stderr, "out of memory\n");
+			break;
+		}
+		ILBigNumFree(result);
+	}
+	elapsed = CurrentTime() - start;
+	printf("multiply %4d bits   %10.4f ms/op\n",
+		   bits, elapsed / (double)iterations);
+
+	ILBigNumFree(x);
+	ILBigNumFree(y);
+}
+
+int main(int argc, char *argv[])
+{
+	BenchSymmetric();
+	BenchMul(2048, 20000);
+	BenchMul(4096, 5000);
+	BenchModExp(1024, 200);
+	BenchModExp(2048, 40);
+	BenchModExp(4096, 8);
+	return 0;
+}
+
+#ifdef	__cplusplus
+};
+#endif
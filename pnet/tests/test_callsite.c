@@ -0,0 +1,210 @@
+/*
+ * test_callsite.c - Test the call site routines in "engine".
+ *
+ * Copyright (C) 2026  Free Software Foundation, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ilunit.h"
+#include "il_engine.h"
+
+#ifdef	__cplusplus
+extern	"C" {
+#endif
+
+/*
+ * The process that the tests run in.
+ */
+static ILExecProcess *process;
+static ILExecThread *thread;
+
+/*
+ * Add a static method to a class.
+ */
+static ILMethod *addMethod(ILClass *classInfo, const char *name,
+						   ILType *returnType, ILType *paramType)
+{
+	ILContext *context = ILClassToContext(classInfo);
+	ILMethod *method;
+	ILType *signature;
+
+	method = ILMethodCreate(classInfo, 0, name,
+							IL_META_METHODDEF_PUBLIC |
+							IL_META_METHODDEF_STATIC);
+	signature = ILTypeCreateMethod(context, returnType);
+	if(!method || !signature)
+	{
+		ILUnitOutOfMemory();
+	}
+	if(paramType != ILType_Invalid &&
+	   !ILTypeAddParam(context, signature, paramType))
+	{
+		ILUnitOutOfMemory();
+	}
+	ILMemberSetSignature((ILMember *)method, signature);
+	return method;
+}
+
+/*
+ * Create a process that contains the class "CallSiteTest"
+ * with a few methods to look up by name.
+ */
+static void createProcess(void)
+{
+	ILImage *image;
+	ILClass *classInfo;
+
+	if(ILExecInit(0) != IL_EXEC_INIT_OK)
+	{
+		ILUnitOutOfMemory();
+	}
+	process = ILExecProcessCreate(0, 0);
+	if(!process)
+	{
+		ILUnitOutOfMemory();
+	}
+	thread = ILExecProcessGetMain(process);
+	image = ILImageCreate(ILExecProcessGetContext(process));
+	if(!image || !ILModuleCreate(image, 0, "callsite.dll", 0) ||
+	   !ILAssemblyCreate(image, 0, "callsite", 0))
+	{
+		ILUnitOutOfMemory();
+	}
+	classInfo = ILClassCreate(ILClassGlobalScope(image), 0,
+							  "CallSiteTest", "Test", 0);
+	if(!classInfo)
+	{
+		ILUnitOutOfMemory();
+	}
+	ILClassSetAttrs(classInfo, ~((ILUInt32)0),
+					IL_META_TYPEDEF_PUBLIC | IL_META_TYPEDEF_ABSTRACT |
+					IL_META_TYPEDEF_SEALED);
+	addMethod(classInfo, "Run", ILType_Void, ILType_Int32);
+	addMethod(classInfo, "Run", ILType_Int32, ILType_Float64);
+	addMethod(classInfo, "Run", ILType_Void, ILType_Invalid);
+}
+
+/*
+ * Test that resolving a method returns a call site for it.
+ */
+static void callsite_resolve(void *arg)
+{
+	ILExecCallSite *site;
+	ILMethod *method;
+
+	site = ILExecThreadResolveMethod(thread, "Test.CallSiteTest",
+									 "Run", "(i)V");
+	ILUnitAssert(site != 0);
+	method = ILExecCallSiteGetMethod(site);
+	ILUnitAssert(method != 0);
+	ILUnitAssert(!strcmp(ILMethod_Name(method), "Run"));
+	ILUnitAssert(ILTypeNumParams(ILMethod_Signature(method)) == 1);
+	ILUnitAssert(ILTypeGetParam(ILMethod_Signature(method), 1) ==
+					ILType_Int32);
+}
+
+/*
+ * Test that resolving the same names again returns the same call site.
+ */
+static void callsite_same(void *arg)
+{
+	ILExecCallSite *site1;
+	ILExecCallSite *site2;
+	ILExecCallSite *site3;
+
+	site1 = ILExecThreadResolveMethod(thread, "Test.CallSiteTest",
+									  "Run", "(d)i");
+	site2 = ILExecThreadResolveMethod(thread, "Test.CallSiteTest",
+									  "Run", "(d)i");
+	site3 = ILExecThreadResolveMethod(thread, "Test.CallSiteTest",
+									  "Run", "()V");
+	ILUnitAssert(site1 != 0);
+	ILUnitAssert(site1 == site2);
+	ILUnitAssert(site3 != 0);
+	ILUnitAssert(site3 != site1);
+	ILUnitAssert(ILExecCallSiteGetMethod(site1) !=
+				 ILExecCallSiteGetMethod(site3));
+}
+
+/*
+ * Test that looking up a method by name agrees with its call site.
+ */
+static void callsite_lookup(void *arg)
+{
+	ILExecCallSite *site;
+	ILMethod *method;
+
+	/* The method is found whether or not it has a call site */
+	method = ILExecThreadLookupMethod(thread, "Test.CallSiteTest",
+									  "Run", "()V");
+	ILUnitAssert(method != 0);
+	site = ILExecThreadResolveMethod(thread, "Test.CallSiteTest",
+									 "Run", "()V");
+	ILUnitAssert(site != 0);
+	ILUnitAssert(ILExecCallSiteGetMethod(site) == method);
+	ILUnitAssert(ILExecThreadLookupMethod(thread, "Test.CallSiteTest",
+										  "Run", "()V") == method);
+}
+
+/*
+ * Test that names that cannot be resolved don't produce a call site.
+ */
+static void callsite_missing(void *arg)
+{
+	ILUnitAssert(ILExecThreadResolveMethod
+					(thread, "Test.CallSiteTest", "Run", "(l)V") == 0);
+	ILUnitAssert(ILExecThreadResolveMethod
+					(thread, "Test.CallSiteTest", "Walk", "()V") == 0);
+	ILUnitAssert(ILExecThreadResolveMethod
+					(thread, "Test.NoSuchClass", "Run", "()V") == 0);
+	ILUnitAssert(ILExecThreadResolveMethod
+					(thread, "Test.CallSiteTest", "Run", 0) == 0);
+	ILUnitAssert(ILExecThreadLookupMethod
+					(thread, "Test.CallSiteTest", "Walk", "()V") == 0);
+	ILUnitAssert(ILExecCallSiteGetMethod(0) == 0);
+}
+
+/*
+ * Simple test registration macro.
+ */
+#define	RegisterSimple(name)	(ILUnitRegister(#name, name, 0))
+
+/*
+ * Register all unit tests.
+ */
+void ILUnitRegisterTests(void)
+{
+	createProcess();
+
+	/*
+	 * Test call sites.
+	 */
+	ILUnitRegisterSuite("Call Sites");
+	RegisterSimple(callsite_resolve);
+	RegisterSimple(callsite_same);
+	RegisterSimple(callsite_lookup);
+	RegisterSimple(callsite_missing);
+}
+
+void ILUnitCleanupTests(void)
+{
+	/* This also destroys the process */
+	ILExecDeinit();
+}
+
+#ifdef	__cplusplus
+};
+#endif
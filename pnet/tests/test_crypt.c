@@ -345,6 +345,157 @@ static void test_aes_block(BlockTestInfo *arg)
 	}
 }
 
+/*
+ * Fill a buffer with a test pattern.
+ */
+static void FillPattern(unsigned char *buf, int len)
+{
+	int posn;
+	for(posn = 0; posn < len; ++posn)
+	{
+		buf[posn] = (unsigned char)(posn * 7 + (posn >> 8) + 1);
+	}
+}
+
+/*
+ * Encrypt a run of blocks with AES in ECB and CBC modes.
+ */
+static void AESEncryptModes(BlockTestInfo *arg, unsigned char *plaintext,
+							unsigned char *ecb, unsigned char *cbc,
+							int numBlocks)
+{
+	ILAESContext aes;
+	unsigned char iv[16];
+	ILMemCpy(iv, arg->plaintext, 16);
+	ILAESInit(&aes, arg->key, arg->keyBits);
+	ILAESEncryptECB(&aes, plaintext, ecb, numBlocks);
+	ILAESEncryptCBC(&aes, iv, plaintext, cbc, numBlocks);
+	ILAESFinalize(&aes);
+}
+
+/*
+ * Test the multi-block AES modes, and check that the hardware
+ * and portable versions agree.  The odd number of blocks tests
+ * the tail after the blocks that are processed together.
+ */
+static void test_aes_modes(BlockTestInfo *arg)
+{
+	ILAESContext aes;
+	unsigned char plaintext[16 * 11];
+	unsigned char ecb[16 * 11];
+	unsigned char cbc[16 * 11];
+	unsigned char ecb2[16 * 11];
+	unsigned char cbc2[16 * 11];
+	unsigned char iv[16];
+	int saved;
+
+	/* Encrypt with and without the hardware, and compare */
+	FillPattern(plaintext, sizeof(plaintext));
+	AESEncryptModes(arg, plaintext, ecb, cbc, 11);
+	saved = ILCryptSetHardware(0);
+	AESEncryptModes(arg, plaintext, ecb2, cbc2, 11);
+	ILCryptSetHardware(saved);
+	if(ILMemCmp(ecb, ecb2, sizeof(ecb)) != 0)
+	{
+		ILUnitFailed("ECB ciphertexts don't match");
+	}
+	if(ILMemCmp(cbc, cbc2, sizeof(cbc)) != 0)
+	{
+		ILUnitFailed("CBC ciphertexts don't match");
+	}
+
+	/* The first block of ECB must match the single block cipher */
+	ILAESInit(&aes, arg->key, arg->keyBits);
+	ILAESEncrypt(&aes, plaintext, ecb2);
+	if(ILMemCmp(ecb, ecb2, 16) != 0)
+	{
+		ILUnitFailed("ECB doesn't match the block cipher");
+	}
+
+	/* Decrypt in place, in two pieces for CBC */
+	ILAESDecryptECB(&aes, ecb, ecb, 11);
+	ILMemCpy(iv, arg->plaintext, 16);
+	ILAESDecryptCBC(&aes, iv, cbc, cbc, 5);
+	ILAESDecryptCBC(&aes, iv, cbc + 16 * 5, cbc + 16 * 5, 6);
+	ILAESFinalize(&aes);
+	if(ILMemCmp(ecb, plaintext, sizeof(plaintext)) != 0)
+	{
+		ILUnitFailed("ECB plaintexts don't match");
+	}
+	if(ILMemCmp(cbc, plaintext, sizeof(plaintext)) != 0)
+	{
+		ILUnitFailed("CBC plaintexts don't match");
+	}
+	if(ILMemCmp(iv, cbc2 + 16 * 10, 16) != 0)
+	{
+		ILUnitFailed("CBC chaining values don't match");
+	}
+}
+
+/*
+ * Hash a buffer with each of the SHA algorithms, in uneven pieces.
+ */
+static void SHAHashAll(const unsigned char *buf, int len,
+					   unsigned char *hash)
+{
+	ILSHAContext sha1;
+	ILSHA256Context sha256;
+	ILSHA512Context sha512;
+	int posn, size;
+
+	ILSHAInit(&sha1);
+	ILSHA256Init(&sha256);
+	ILSHA512Init(&sha512);
+	for(posn = 0; posn < len; posn += size)
+	{
+		size = (posn % 301) + 1;
+		if(size > (len - posn))
+		{
+			size = len - posn;
+		}
+		ILSHAData(&sha1, buf + posn, size);
+		ILSHA256Data(&sha256, buf + posn, size);
+		ILSHA512Data(&sha512, buf + posn, size);
+	}
+	ILSHAFinalize(&sha1, hash);
+	ILSHA256Finalize(&sha256, hash + IL_SHA_HASH_SIZE);
+	ILSHA512Finalize(&sha512, hash + IL_SHA_HASH_SIZE + IL_SHA256_HASH_SIZE);
+}
+
+/*
+ * Check that the hardware and portable versions of SHA agree.
+ */
+static void sha_hardware(void *arg)
+{
+	unsigned char buf[3000];
+	unsigned char hash1[IL_SHA_HASH_SIZE + IL_SHA256_HASH_SIZE +
+						IL_SHA512_HASH_SIZE];
+	unsigned char hash2[IL_SHA_HASH_SIZE + IL_SHA256_HASH_SIZE +
+						IL_SHA512_HASH_SIZE];
+	int saved;
+
+	FillPattern(buf, sizeof(buf));
+	SHAHashAll(buf, sizeof(buf), hash1);
+	saved = ILCryptSetHardware(0);
+	SHAHashAll(buf, sizeof(buf), hash2);
+	ILCryptSetHardware(saved);
+	if(ILMemCmp(hash1, hash2, IL_SHA_HASH_SIZE) != 0)
+	{
+		ILUnitFailed("SHA-1 hashes don't match");
+	}
+	if(ILMemCmp(hash1 + IL_SHA_HASH_SIZE, hash2 + IL_SHA_HASH_SIZE,
+				IL_SHA256_HASH_SIZE) != 0)
+	{
+		ILUnitFailed("SHA-256 hashes don't match");
+	}
+	if(ILMemCmp(hash1 + IL_SHA_HASH_SIZE + IL_SHA256_HASH_SIZE,
+				hash2 + IL_SHA_HASH_SIZE + IL_SHA256_HASH_SIZE,
+				IL_SHA512_HASH_SIZE) != 0)
+	{
+		ILUnitFailed("SHA-512 hashes don't match");
+	}
+}
+
 /*
  * Define test vectors for the DES algorithm.
  */
@@ -978,6 +1129,38 @@ static BigNumTestInfo bignum_mul_7 = {		/* multiply double-word values */
 	ILBigNumMul,
 	"8589934595", "8589934599", 0, "73786976380737552405"
 };
+static BigNumTestInfo bignum_mul_8 = {		/* Karatsuba multiplication */
+	ILBigNumMul,
+		"18546179043176043036691509935708073625042841771146402024"
+		"08533127723397144263909993198706746628379974032610361608"
+		"26969172516581632069016869650291823646691965297491784287"
+		"14435311817079068080067894745921962486289319123606571866"
+		"87948042063528927543086861473639246548272461264053383023"
+		"33369728885568739167866849265818987471221462028571679271"
+		"54701305381084850841193593202496715142553506063385",
+		"16301646606920893840230245706232819638689820498545211289"
+		"20656743186758963192915880368042375443935422912107946444"
+		"15280156565275608493530613640878344199650855381617371101"
+		"44231273021631918702218053992732685198799059869401920416"
+		"87199120886830541588228521152118743510546094743167252135"
+		"47660375469244918995080688922083084720938319253808733814"
+		"11642515335604982185050177980010487862369",
+	0,
+		"30233325667053813147026017657223128931174850699587270178"
+		"60143109010357744610552539543525215186009662144280420614"
+		"98889249385188242967047556915160595472610878040929338114"
+		"61348973213262831999314567053219365228854539043786645351"
+		"61559891784147968928220671860766250005828786967486653945"
+		"22103077003783995062105929186036186161446263530751107232"
+		"71175972853099209849469275771964890529624466485609653931"
+		"07977267263103900836561946344592379004970311292394899079"
+		"10986259896110244435821427415446273807503904944704961620"
+		"97847988058642507143155936931488225822130193124225707808"
+		"37394435174315124852351577793421964698753072211175738068"
+		"91039195104583273957914981725494187700267512248650908937"
+		"62977259299242553169934522597215309835575504792961629949"
+		"0293512267993110649111188870259065"
+};
 
 /*
  * Test vectors for "ILBigNumMod".
@@ -1054,6 +1237,32 @@ static BigNumTestInfo bignum_pow_4 = {
 	ILBigNumPow,
 	"34", "1", 0, "34"
 };
+static BigNumTestInfo bignum_pow_5 = {		/* multi-word odd modulus */
+	ILBigNumPow,
+		"81088107633041584075157552652509853201830427090514118769"
+		"4234909910498276681497553316841548",
+		"10451144320034958861954637043110229257014057146572173110"
+		"91627229419263189375794824327753371",
+		"10041782727034897921171728718288553863089006159175632067"
+		"2041513049245680562729",
+		"52561722191460246265591580360395116059684008717256310887"
+		"762377076912123135885"
+};
+static BigNumTestInfo bignum_pow_6 = {		/* multi-word even modulus */
+	ILBigNumPow,
+		"81088107633041584075157552652509853201830427090514118769"
+		"4234909910498276681497553316841548",
+		"10451144320034958861954637043110229257014057146572173110"
+		"91627229419263189375794824327753371",
+		"10041782727034897921171728718288553863089006159175632067"
+		"2041513049245680562730",
+		"24951509132073999511372043854583457259248681882323444105"
+		"959256971278076214622"
+};
+static BigNumTestInfo bignum_pow_7 = {		/* zero exponent, odd modulus */
+	ILBigNumPow,
+	"34", "0", "67", "1"
+};
 
 /*
  * Test big number operations.
@@ -1175,6 +1384,7 @@ void ILUnitRegisterTests(void)
 	ILUnitRegisterSuite("SHA-512");
 	RegisterCrypt(test_sha512_hash, sha512_hash_1);
 	RegisterCrypt(test_sha512_hash, sha512_hash_2);
+	RegisterSimple(sha_hardware);
 
 	/*
 	 * Test the properties of the AES algorithm.
@@ -1183,6 +1393,12 @@ void ILUnitRegisterTests(void)
 	RegisterCrypt(test_aes_block, aes_block_1);
 	RegisterCrypt(test_aes_block, aes_block_2);
 	RegisterCrypt(test_aes_block, aes_block_3);
+	ILUnitRegister("aes_modes_1", (ILUnitTestFunc)test_aes_modes,
+				   &aes_block_1);
+	ILUnitRegister("aes_modes_2", (ILUnitTestFunc)test_aes_modes,
+				   &aes_block_2);
+	ILUnitRegister("aes_modes_3", (ILUnitTestFunc)test_aes_modes,
+				   &aes_block_3);
 
 	/*
 	 * Test the properties of the DES algorithm.
@@ -1249,6 +1465,7 @@ void ILUnitRegisterTests(void)
 	RegisterCrypt(test_bignum_oper, bignum_mul_5);
 	RegisterCrypt(test_bignum_oper, bignum_mul_6);
 	RegisterCrypt(test_bignum_oper, bignum_mul_7);
+	RegisterCrypt(test_bignum_oper, bignum_mul_8);
 
 	RegisterCrypt(test_bignum_oper, bignum_mod_1);
 	RegisterCrypt(test_bignum_oper, bignum_mod_2);
@@ -1267,6 +1484,9 @@ void ILUnitRegisterTests(void)
 	RegisterCrypt(test_bignum_oper, bignum_pow_2);
 	RegisterCrypt(test_bignum_oper, bignum_pow_3);
 	RegisterCrypt(test_bignum_oper, bignum_pow_4);
+	RegisterCrypt(test_bignum_oper, bignum_pow_5);
+	RegisterCrypt(test_bignum_oper, bignum_pow_6);
+	RegisterCrypt(test_bignum_oper, bignum_pow_7);
 }
 
 void ILUnitCleanupTests(void)
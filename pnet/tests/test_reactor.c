@@ -0,0 +1,307 @@
+/*
+ * test_reactor.c - Test the readiness notification routines in "support".
+ *
+ * Copyright (C) 2026  Free Software Foundation, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ilunit.h"
+#include "../support/interlocked.h"
+#include "il_thread.h"
+#include "il_gc.h"
+#include "il_sysio.h"
+#if HAVE_UNISTD_H
+	#include <unistd.h>
+#endif
+
+#ifdef	__cplusplus
+extern	"C" {
+#endif
+
+/*
+ * Put the current thread to sleep for a number of 100ms "time steps".
+ */
+static void sleepFor(int steps)
+{
+	ILThreadSleep(steps * 100);
+}
+
+/*
+ * State of the current test.  Anything that a failed test leaves
+ * behind is cleaned up by the next test, or when the tests finish.
+ */
+static ILSysIOReactor *reactor;
+static int fds[2] = {-1, -1};
+static ILWaitHandle *firedEvent;
+static volatile ILInt32 fired;
+static volatile ILInt32 expected;
+static void * volatile lastCookie;
+
+/*
+ * Receive a cookie from the reactor.
+ */
+static void reactorReady(void *userData, void *cookie)
+{
+	lastCookie = cookie;
+	if(ILInterlockedIncrementI4_Full(&fired) == expected)
+	{
+		ILWaitEventSet(firedEvent);
+	}
+}
+
+/*
+ * Close the pipe of the current test.
+ */
+static void closePipe(void)
+{
+	if(fds[0] >= 0)
+	{
+		close(fds[0]);
+		fds[0] = -1;
+	}
+	if(fds[1] >= 0)
+	{
+		close(fds[1]);
+		fds[1] = -1;
+	}
+}
+
+/*
+ * Release everything that the current test allocated.
+ */
+static void cleanup(void)
+{
+	/* Stop the completion threads before the event goes away */
+	if(reactor)
+	{
+		ILSysIOReactorDestroy(reactor);
+		reactor = 0;
+	}
+	if(firedEvent)
+	{
+		ILWaitHandleClose(firedEvent);
+		firedEvent = 0;
+	}
+	closePipe();
+}
+
+/*
+ * Create a reactor and a pipe for a test.  Returns zero if the
+ * platform has no readiness notification support.
+ */
+static int setup(void)
+{
+	cleanup();
+	fired = 0;
+	expected = 0;
+	lastCookie = 0;
+	if(!(firedEvent = ILWaitEventCreate(1, 0)))
+	{
+		ILUnitOutOfMemory();
+	}
+	if(!(reactor = ILSysIOReactorCreate(reactorReady, 0, 1)))
+	{
+		return 0;
+	}
+	if(pipe(fds) != 0)
+	{
+		ILUnitOutOfMemory();
+	}
+	return 1;
+}
+
+/*
+ * Wait until a total of "count" cookies have been delivered.
+ */
+static int waitFired(ILInt32 count)
+{
+	ILWaitEventReset(firedEvent);
+	expected = count;
+	if(ILInterlockedLoadI4(&fired) >= count)
+	{
+		return 1;
+	}
+	return (ILWaitOne(firedEvent, 5000) == 0);
+}
+
+/*
+ * Get the read end of the pipe as a handle.
+ */
+#define	ReadHandle()	((ILSysIOHandle)(ILNativeInt)(fds[0]))
+
+/*
+ * Test that a read watch fires once data arrives on a pipe,
+ * but not before.
+ */
+static void reactor_read(void *arg)
+{
+	if(!setup())
+	{
+		return;
+	}
+	ILUnitAssert(ILSysIOReactorWatch(reactor, ReadHandle(), IL_REACTOR_READ,
+									 (void *)fds));
+	sleepFor(2);
+	if(fired != 0)
+	{
+		ILUnitFailed("the watch fired before the pipe was readable");
+	}
+	ILUnitAssert(write(fds[1], "x", 1) == 1);
+	ILUnitAssert(waitFired(1));
+	sleepFor(1);
+	if(fired != 1 || lastCookie != (void *)fds)
+	{
+		ILUnitFailed("the watch fired %d times", (int)fired);
+	}
+	cleanup();
+}
+
+/*
+ * Test that only one watch per direction can be pending, and that
+ * a handle can be watched again after the first watch fired.
+ */
+static void reactor_rearm(void *arg)
+{
+	if(!setup())
+	{
+		return;
+	}
+	ILUnitAssert(ILSysIOReactorWatch(reactor, ReadHandle(), IL_REACTOR_READ,
+									 (void *)fds));
+	ILUnitAssert(!ILSysIOReactorWatch(reactor, ReadHandle(), IL_REACTOR_READ,
+									  (void *)fds));
+	ILUnitAssert(write(fds[1], "x", 1) == 1);
+	ILUnitAssert(waitFired(1));
+	ILUnitAssert(ILSysIOReactorWatch(reactor, ReadHandle(), IL_REACTOR_READ,
+									 (void *)fds));
+	if(!waitFired(2))
+	{
+		ILUnitFailed("the watch fired %d times", (int)fired);
+	}
+	cleanup();
+}
+
+/*
+ * Test that unwatching a handle delivers its pending cookies.
+ */
+static void reactor_unwatch(void *arg)
+{
+	if(!setup())
+	{
+		return;
+	}
+	ILUnitAssert(ILSysIOReactorWatch(reactor, ReadHandle(), IL_REACTOR_READ,
+									 (void *)fds));
+	ILSysIOReactorUnwatch(reactor, ReadHandle());
+	ILUnitAssert(fired == 1);
+	ILUnitAssert(write(fds[1], "x", 1) == 1);
+	sleepFor(1);
+	ILUnitAssert(fired == 1);
+	cleanup();
+}
+
+/*
+ * Test that a handle which is closed and then reused for another
+ * pipe only fires for the watches on the new pipe.
+ */
+static void reactor_reuse(void *arg)
+{
+	int oldFd;
+
+	if(!setup())
+	{
+		return;
+	}
+	ILUnitAssert(ILSysIOReactorWatch(reactor, ReadHandle(), IL_REACTOR_READ,
+									 (void *)fds));
+	ILUnitAssert(write(fds[1], "x", 1) == 1);
+	ILUnitAssert(waitFired(1));
+	ILUnitAssert(ILSysIOReactorWatch(reactor, ReadHandle(), IL_REACTOR_WRITE,
+									 (void *)reactor));
+
+	/* Close the pipe, which cancels the pending write watch */
+	oldFd = fds[0];
+	ILSysIOReactorUnwatch(reactor, ReadHandle());
+	ILUnitAssert(fired == 2 && lastCookie == (void *)reactor);
+	closePipe();
+
+	/* The new pipe normally gets the same descriptors */
+	ILUnitAssert(pipe(fds) == 0);
+	ILUnitAssert(ILSysIOReactorWatch(reactor, ReadHandle(), IL_REACTOR_READ,
+									 (void *)&oldFd));
+	sleepFor(2);
+	if(fired != 2)
+	{
+		ILUnitFailed("a watch fired for the closed pipe");
+	}
+	ILUnitAssert(write(fds[1], "x", 1) == 1);
+	ILUnitAssert(waitFired(3));
+	ILUnitAssert(lastCookie == (void *)&oldFd);
+	cleanup();
+}
+
+/*
+ * Simple test registration macro.
+ */
+#define	RegisterSimple(name)	(ILUnitRegister(#name, name, 0))
+
+/*
+ * Register all unit tests.
+ */
+void ILUnitRegisterTests(void)
+{
+	/*
+	 * Bail out if no thread support at all in the system.
+	 */
+	if(!ILHasThreads())
+	{
+		fputs("System does not support threads - skipping all tests\n", stdout);
+		return;
+	}
+
+	/*
+	 * Initialize the thread subsystem and the GC, which
+	 * allocates the reactor's handle table.
+	 */
+	ILThreadInit();
+	ILGCInit(0);
+
+	/*
+	 * Tests for the I/O readiness reactor.
+	 */
+	ILUnitRegisterSuite("I/O Readiness Tests");
+	RegisterSimple(reactor_read);
+	RegisterSimple(reactor_rearm);
+	RegisterSimple(reactor_unwatch);
+	RegisterSimple(reactor_reuse);
+}
+
+void ILUnitCleanupTests(void)
+{
+	/*
+	 * Clean up after a test that failed, and then
+	 * deinitialize the threading subsystem.
+	 */
+	if(ILHasThreads())
+	{
+		cleanup();
+		ILThreadDeinit();
+	}
+}
+
+#ifdef	__cplusplus
+};
+#endif
@@ -0,0 +1,237 @@
+/*
+ * test_stack.c - Test the operand stacks of threads in "engine".
+ *
+ * Copyright (C) 2026  Free Software Foundation, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ilunit.h"
+#include "../engine/engine.h"
+
+#ifdef	__cplusplus
+extern	"C" {
+#endif
+
+#if defined(IL_USE_CVM) && defined(IL_CONFIG_GROW_STACK)
+
+/*
+ * Number of threads to create in "stack_many".  This is more than
+ * the number of root sets in the garbage collector.
+ */
+#define	NUM_THREADS		1100
+
+/*
+ * The process that the tests run in.
+ */
+static ILExecProcess *process;
+static ILExecThread *threads[NUM_THREADS];
+
+/*
+ * Hidden pointer to an object that is only referenced from a stack.
+ * The collector clears it when the object is collected.
+ */
+static ILNativeUInt hiddenObject;
+
+/*
+ * Create an object, store it in a stack slot, and watch it.  This is
+ * a separate function so that the pointer does not stay in a register
+ * or on the C stack of the test.
+ */
+static void storeObject(CVMWord *slot)
+{
+	void *object = ILGCAlloc(64);
+	if(!object)
+	{
+		ILUnitOutOfMemory();
+	}
+	slot->ptrValue = object;
+	hiddenObject = ~((ILNativeUInt)object);
+	ILGCRegisterGeneralWeak(&hiddenObject, object);
+}
+
+/*
+ * Destroy the threads that a test created.
+ */
+static void destroyThreads(void)
+{
+	int posn;
+	for(posn = 0; posn < NUM_THREADS; ++posn)
+	{
+		if(threads[posn])
+		{
+			_ILExecThreadDestroy(threads[posn]);
+			threads[posn] = 0;
+		}
+	}
+}
+
+/*
+ * Test that a stack grows on demand, and that the collector scans
+ * the part of the stack that was added by growing it.
+ */
+static void stack_grow(void *arg)
+{
+	ILExecThread *thread;
+	ILUInt32 initial;
+	ILUInt32 words;
+
+	destroyThreads();
+	thread = threads[0] = _ILExecThreadCreate(process, 0);
+	ILUnitAssert(thread != 0);
+	ILUnitAssert(thread->stackReserved);
+	initial = (ILUInt32)(thread->stackLimit - thread->stackBase);
+	ILUnitAssert(thread->stackMax > thread->stackLimit);
+
+	/* Grow the stack to twice its initial size */
+	words = initial + 16;
+	ILUnitAssert(_ILGrowStack(thread, thread->stackBase, words));
+	ILUnitAssert((ILUInt32)(thread->stackLimit - thread->stackBase) > words);
+
+	/* An object that is only referenced from the new part survives */
+	storeObject(&(thread->stackBase[initial + 8]));
+	ILGCCollect();
+	ILGCCollect();
+	ILUnitAssert(hiddenObject != 0);
+	ILUnitAssert(thread->stackBase[initial + 8].ptrValue ==
+				 (void *)(~hiddenObject));
+	ILGCUnregisterWeak(&hiddenObject);
+	hiddenObject = 0;
+
+	/* The stack cannot grow beyond the reserved space */
+	ILUnitAssert(!_ILGrowStack
+		(thread, thread->stackBase,
+		 (ILUInt32)(thread->stackMax - thread->stackBase)));
+	destroyThreads();
+}
+
+/*
+ * Test that a stack that has shrunk can grow again.
+ */
+static void stack_shrink(void *arg)
+{
+	ILExecThread *thread;
+	ILUInt32 initial;
+	ILUInt32 grown;
+
+	destroyThreads();
+	thread = threads[0] = _ILExecThreadCreate(process, 0);
+	ILUnitAssert(thread != 0);
+	initial = (ILUInt32)(thread->stackLimit - thread->stackBase);
+	ILUnitAssert(_ILGrowStack(thread, thread->stackBase, initial * 4));
+	grown = (ILUInt32)(thread->stackLimit - thread->stackBase);
+	ILUnitAssert(grown > initial * 4);
+
+	/* Shrink the stack while it is empty */
+	thread->stackTop = thread->stackBase;
+	_ILExecThreadShrinkStack(thread);
+	ILUnitAssert((ILUInt32)(thread->stackLimit - thread->stackBase) < grown);
+	ILUnitAssert(thread->stackLimit >= thread->stackBase + initial);
+
+	/* The collector still works after the stack has shrunk */
+	ILGCCollect();
+
+	/* Grow it again, which reuses the committed pages */
+	ILUnitAssert(_ILGrowStack(thread, thread->stackBase, initial * 4));
+	ILUnitAssert((ILUInt32)(thread->stackLimit - thread->stackBase) >
+					initial * 4);
+	thread->stackBase[initial * 4].intValue = 42;
+	ILGCCollect();
+	ILUnitAssert(thread->stackBase[initial * 4].intValue == 42);
+	destroyThreads();
+}
+
+/*
+ * Test that there is no limit on the number of stacks that can grow.
+ */
+static void stack_many(void *arg)
+{
+	ILExecThread *thread;
+	ILUInt32 initial;
+	int posn;
+
+	destroyThreads();
+	for(posn = 0; posn < NUM_THREADS; ++posn)
+	{
+		thread = threads[posn] = _ILExecThreadCreate(process, 0);
+		ILUnitAssert(thread != 0);
+		if(!(thread->stackReserved))
+		{
+			ILUnitFailed("thread %d has a fixed-size stack", posn);
+		}
+	}
+
+	/* Grow the last stack and check that the collector scans it */
+	thread = threads[NUM_THREADS - 1];
+	initial = (ILUInt32)(thread->stackLimit - thread->stackBase);
+	ILUnitAssert(_ILGrowStack(thread, thread->stackBase, initial * 2));
+	storeObject(&(thread->stackBase[initial * 2]));
+	ILGCCollect();
+	ILUnitAssert(hiddenObject != 0);
+	ILGCUnregisterWeak(&hiddenObject);
+	hiddenObject = 0;
+	destroyThreads();
+}
+
+#endif /* IL_USE_CVM && IL_CONFIG_GROW_STACK */
+
+/*
+ * Simple test registration macro.
+ */
+#define	RegisterSimple(name)	(ILUnitRegister(#name, name, 0))
+
+/*
+ * Register all unit tests.
+ */
+void ILUnitRegisterTests(void)
+{
+#if defined(IL_USE_CVM) && defined(IL_CONFIG_GROW_STACK)
+	if(ILExecInit(0) != IL_EXEC_INIT_OK)
+	{
+		ILUnitOutOfMemory();
+	}
+	process = ILExecProcessCreate(0, 0);
+	if(!process)
+	{
+		ILUnitOutOfMemory();
+	}
+
+	/*
+	 * Test growable operand stacks.
+	 */
+	ILUnitRegisterSuite("Operand Stacks");
+	RegisterSimple(stack_grow);
+	RegisterSimple(stack_shrink);
+	RegisterSimple(stack_many);
+#else
+	fputs("Operand stacks cannot grow - skipping all tests\n", stdout);
+#endif
+}
+
+void ILUnitCleanupTests(void)
+{
+#if defined(IL_USE_CVM) && defined(IL_CONFIG_GROW_STACK)
+	/* Destroying the engine also destroys the process */
+	if(process)
+	{
+		destroyThreads();
+		ILExecDeinit();
+	}
+#endif
+}
+
+#ifdef	__cplusplus
+};
+#endif
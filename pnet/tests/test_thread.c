@@ -24,9 +24,13 @@
 #include "../support/interlocked_slist.h"
 #include "il_thread.h"
 #include "il_gc.h"
+#include "il_sysio.h"
 #if HAVE_UNISTD_H
 	#include <unistd.h>
 #endif
+#if HAVE_SYS_SOCKET_H
+	#include <sys/socket.h>
+#endif
 #ifdef IL_WIN32_NATIVE
 	#include <windows.h>
 #endif
@@ -3488,6 +3492,536 @@ static void monitor_abort_during_wait(void *arg)
 	}
 }
 
+/*
+ * State shared by the thread pool tests.
+ */
+static ILThreadPool * volatile _pool;
+static volatile ILInt32 _poolItems;
+static volatile ILInt32 _poolStarted;
+static ILInt32 _poolTarget;
+static ILWaitHandle *_poolDone;
+
+/*
+ * Prepare to wait until "count" pool items have run.
+ */
+static void _pool_begin(ILInt32 count)
+{
+	_poolItems = 0;
+	_poolStarted = 0;
+	_poolTarget = count;
+	if(!(_poolDone = ILWaitEventCreate(1, 0)))
+	{
+		ILUnitOutOfMemory();
+	}
+}
+
+/*
+ * Record that a pool item has run, and wake up the
+ * test once all of the expected items have run.
+ */
+static void _pool_ran(void)
+{
+	if(ILInterlockedIncrementI4_Full(&_poolItems) == _poolTarget)
+	{
+		ILWaitEventSet(_poolDone);
+	}
+}
+
+/*
+ * Wait until all of the expected pool items have run.
+ */
+static int _pool_wait(void)
+{
+	return (ILWaitOne(_poolDone, 30000) == 0);
+}
+
+/*
+ * Clean up after waiting for pool items.
+ */
+static void _pool_end(void)
+{
+	ILWaitHandleClose(_poolDone);
+	_poolDone = 0;
+}
+
+/*
+ * Thread pool callbacks.
+ */
+static int _pool_start(void *userData)
+{
+	ILInterlockedIncrementI4_Full(&_poolStarted);
+	return 1;
+}
+static int _pool_count(void *userData, void *item)
+{
+	_pool_ran();
+	return 0;
+}
+static int _pool_split(void *userData, void *item)
+{
+	ILNativeInt depth = (ILNativeInt)item;
+
+	/* Queue two children from the worker, which uses the worker deque */
+	if(depth > 1)
+	{
+		ILThreadPoolQueue(_pool, (void *)(depth - 1));
+		ILThreadPoolQueue(_pool, (void *)(depth - 1));
+	}
+	_pool_ran();
+	return 0;
+}
+static int _pool_block(void *userData, void *item)
+{
+	/* Block until all items have been started */
+	_pool_ran();
+	ILWaitOne(_poolDone, 30000);
+	return 0;
+}
+
+/*
+ * Test that a thread pool can be created and destroyed.
+ */
+static void threadpool_create(void *arg)
+{
+	ILThreadPool *pool;
+
+	if(!(pool = ILThreadPoolCreate(_pool_start, _pool_count, 0)))
+	{
+		ILUnitOutOfMemory();
+	}
+	ILUnitAssert(ILThreadPoolGetMinThreads(pool) >= 1);
+	ILUnitAssert(ILThreadPoolGetMaxThreads(pool) >=
+				 ILThreadPoolGetMinThreads(pool));
+	ILThreadPoolDestroy(pool);
+}
+
+/*
+ * Test that items queued from outside the pool are all run.
+ */
+static void threadpool_queue(void *arg)
+{
+	ILThreadPool *pool;
+	ILNativeInt i;
+	int ok;
+
+	_pool_begin(10000);
+	if(!(pool = ILThreadPoolCreate(_pool_start, _pool_count, 0)))
+	{
+		ILUnitOutOfMemory();
+	}
+	for(i = 1; i <= 10000; ++i)
+	{
+		if(!ILThreadPoolQueue(pool, (void *)i))
+		{
+			ILThreadPoolDestroy(pool);
+			ILUnitOutOfMemory();
+		}
+	}
+	ok = _pool_wait();
+	ILThreadPoolDestroy(pool);
+	_pool_end();
+	if(!ok)
+	{
+		ILUnitFailed("only %d of 10000 items were run", (int)_poolItems);
+	}
+	if(_poolItems != 10000 || _poolStarted < 1)
+	{
+		ILUnitFailed("%d items were run on %d workers",
+					 (int)_poolItems, (int)_poolStarted);
+	}
+}
+
+/*
+ * Test that items queued by workers are run, which pushes them
+ * onto the worker deques and lets the other workers steal them.
+ */
+static void threadpool_nested(void *arg)
+{
+	ILThreadPool *pool;
+	int ok;
+
+	_pool_begin((1 << 14) - 1);
+	if(!(pool = ILThreadPoolCreate(0, _pool_split, 0)))
+	{
+		ILUnitOutOfMemory();
+	}
+	_pool = pool;
+	ILThreadPoolQueue(pool, (void *)(ILNativeInt)14);
+	ok = _pool_wait();
+	ILThreadPoolDestroy(pool);
+	_pool_end();
+	_pool = 0;
+	if(!ok || _poolItems != (1 << 14) - 1)
+	{
+		ILUnitFailed("%d of %d items were run", (int)_poolItems,
+					 (1 << 14) - 1);
+	}
+}
+
+/*
+ * Test that the pool grows beyond the minimum when all workers block.
+ */
+static void threadpool_starvation(void *arg)
+{
+	ILThreadPool *pool;
+	int numThreads;
+	int ok;
+
+	_pool_begin(3);
+	if(!(pool = ILThreadPoolCreate(0, _pool_block, 0)))
+	{
+		ILUnitOutOfMemory();
+	}
+	ILThreadPoolSetMinThreads(pool, 1);
+	ILThreadPoolQueue(pool, (void *)(ILNativeInt)3);
+	ILThreadPoolQueue(pool, (void *)(ILNativeInt)3);
+	ILThreadPoolQueue(pool, (void *)(ILNativeInt)3);
+	ok = _pool_wait();
+	ILThreadPoolGetCounts(pool, &numThreads, 0, 0);
+	ILThreadPoolDestroy(pool);
+	_pool_end();
+	if(!ok)
+	{
+		ILUnitFailed("the pool did not inject workers for blocked items");
+	}
+	ILUnitAssert(numThreads >= 3);
+}
+
+/*
+ * Test the minimum and maximum thread limits.
+ */
+static void threadpool_limits(void *arg)
+{
+	ILThreadPool *pool;
+
+	if(!(pool = ILThreadPoolCreate(0, _pool_count, 0)))
+	{
+		ILUnitOutOfMemory();
+	}
+
+	/* The default minimum is the number of CPUs, which may be more
+	   than the maximum that we want to set */
+	ILUnitAssert(ILThreadPoolSetMinThreads(pool, 1));
+	ILUnitAssert(ILThreadPoolSetMaxThreads(pool, 8));
+	ILUnitAssert(ILThreadPoolSetMinThreads(pool, 2));
+	ILUnitAssert(!ILThreadPoolSetMinThreads(pool, 9));
+	ILUnitAssert(!ILThreadPoolSetMaxThreads(pool, 1));
+	ILUnitAssert(!ILThreadPoolSetMinThreads(pool, 0));
+	ILUnitAssert(ILThreadPoolGetMinThreads(pool) == 2);
+	ILUnitAssert(ILThreadPoolGetMaxThreads(pool) == 8);
+	ILThreadPoolDestroy(pool);
+}
+
+/*
+ * Test that a poll set reports handles that are ready, and only those.
+ */
+static void pollset_wait(void *arg)
+{
+	ILSysIOPollSet *set;
+	ILInt32 ids[4];
+	ILInt32 events[4];
+	ILInt32 result;
+	int fds[2];
+
+	if(!(set = ILSysIOPollSetCreate()))
+	{
+		return;
+	}
+	if(pipe(fds) != 0)
+	{
+		ILSysIOPollSetDestroy(set);
+		ILUnitOutOfMemory();
+	}
+	ILUnitAssert(ILSysIOPollSetAdd(set, (ILSysIOHandle)(ILNativeInt)fds[0],
+								   IL_POLL_READ, 42));
+	ILUnitAssert(ILSysIOPollSetWait(set, ids, events, 4, 0) == 0);
+	ILUnitAssert(write(fds[1], "x", 1) == 1);
+	result = ILSysIOPollSetWait(set, ids, events, 4, 1000000);
+	ILUnitAssert(result == 1);
+	ILUnitAssert(ids[0] == 42);
+	ILUnitAssert(events[0] == IL_POLL_READ);
+
+	/* The handle stays in the set until it is removed */
+	ILUnitAssert(ILSysIOPollSetWait(set, ids, events, 4, 0) == 1);
+	ILUnitAssert(ILSysIOPollSetRemove(set,
+									  (ILSysIOHandle)(ILNativeInt)fds[0]));
+	ILUnitAssert(ILSysIOPollSetWait(set, ids, events, 4, 0) == 0);
+	ILSysIOPollSetDestroy(set);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+/*
+ * Poll set that "pollset_wakeup" waits on.
+ */
+static ILSysIOPollSet *wakeupSet;
+
+/*
+ * Wake up a poll set after a short delay.
+ */
+static void pollsetWakeup(void *arg)
+{
+	sleepFor(1);
+	ILSysIOPollSetWakeup(wakeupSet);
+}
+
+/*
+ * Test that a wait on an empty poll set with no timeout can be woken up.
+ */
+static void pollset_wakeup(void *arg)
+{
+	ILThread *thread;
+	ILInt32 ids[4];
+	ILInt32 events[4];
+	ILInt32 woken, again;
+
+	if(!(wakeupSet = ILSysIOPollSetCreate()))
+	{
+		return;
+	}
+	thread = ILThreadCreate(pollsetWakeup, 0);
+	if(!thread)
+	{
+		ILSysIOPollSetDestroy(wakeupSet);
+		ILUnitOutOfMemory();
+	}
+	ILThreadStart(thread);
+	woken = ILSysIOPollSetWait(wakeupSet, ids, events, 4, -1);
+	ILThreadJoin(thread, IL_MAX_UINT32);
+	ILThreadDestroy(thread);
+
+	/* The wakeup has been consumed */
+	again = ILSysIOPollSetWait(wakeupSet, ids, events, 4, 0);
+	ILSysIOPollSetDestroy(wakeupSet);
+	ILUnitAssert(woken == 0);
+	ILUnitAssert(again == 0);
+}
+
+/*
+ * Test that select works on descriptors above FD_SETSIZE.
+ */
+static void select_high_fd(void *arg)
+{
+	ILSysIOHandle readArray[1];
+	ILSysIOHandle writeArray[1];
+	int fds[2];
+	int highFd;
+
+	if(pipe(fds) != 0)
+	{
+		ILUnitOutOfMemory();
+	}
+	highFd = dup2(fds[0], 4000);
+	close(fds[0]);
+	if(highFd < 0)
+	{
+		/* The descriptor limit is too low to test this */
+		close(fds[1]);
+		return;
+	}
+	ILUnitAssert(write(fds[1], "x", 1) == 1);
+	readArray[0] = (ILSysIOHandle)(ILNativeInt)highFd;
+	writeArray[0] = (ILSysIOHandle)(ILNativeInt)fds[1];
+	ILUnitAssert(ILSysIOSocketSelect((ILSysIOHandle **)readArray, 1,
+									 (ILSysIOHandle **)writeArray, 1,
+									 0, 0, 1000000) == 2);
+	ILUnitAssert(readArray[0] == (ILSysIOHandle)(ILNativeInt)highFd);
+	ILUnitAssert(writeArray[0] == (ILSysIOHandle)(ILNativeInt)fds[1]);
+	close(highFd);
+	close(fds[1]);
+}
+
+/*
+ * Test sending part of a file on a socket.
+ */
+static void sendfile_socket(void *arg)
+{
+	char path[] = "/tmp/pnetsfXXXXXX";
+	unsigned char data[20000];
+	unsigned char buf[20000];
+	ILSysIOHandle file;
+	ILSysIOHandle sock;
+	int fd, fds[2];
+	int posn, len;
+
+	/* Create a file with a known pattern in it */
+	if((fd = mkstemp(path)) < 0)
+	{
+		ILUnitOutOfMemory();
+	}
+	unlink(path);
+	for(posn = 0; posn < (int)sizeof(data); ++posn)
+	{
+		data[posn] = (unsigned char)(posn * 7);
+	}
+	ILUnitAssert(write(fd, data, sizeof(data)) == (int)sizeof(data));
+	ILUnitAssert(lseek(fd, 123, SEEK_SET) == 123);
+	if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+	{
+		close(fd);
+		ILUnitOutOfMemory();
+	}
+	file = (ILSysIOHandle)(ILNativeInt)fd;
+	sock = (ILSysIOHandle)(ILNativeInt)(fds[0]);
+
+	/* Send everything after the first few bytes */
+	ILUnitAssert(ILSysIOSocketSendFile(sock, file, 5, -1) ==
+				 (ILInt64)(sizeof(data) - 5));
+	posn = 0;
+	while(posn < (int)(sizeof(data) - 5))
+	{
+		len = read(fds[1], buf + posn, sizeof(data) - 5 - posn);
+		ILUnitAssert(len > 0);
+		posn += len;
+	}
+	ILUnitAssert(!ILMemCmp(buf, data + 5, sizeof(data) - 5));
+
+	/* The file position must not have moved */
+	ILUnitAssert(lseek(fd, 0, SEEK_CUR) == 123);
+
+	/* A count past the end of the file stops at EOF */
+	ILUnitAssert(ILSysIOSocketSendFile(sock, file, sizeof(data) - 10, 100)
+					== 10);
+	ILUnitAssert(read(fds[1], buf, sizeof(buf)) == 10);
+	ILUnitAssert(!ILMemCmp(buf, data + sizeof(data) - 10, 10));
+
+	/* Negative offsets are rejected */
+	ILUnitAssert(ILSysIOSocketSendFile(sock, file, -1, 10) == -1);
+
+	/* Offsets past the end of the file send nothing, even if they
+	   do not fit in the platform's "off_t" */
+	ILUnitAssert(ILSysIOSocketSendFile(sock, file, ((ILInt64)1) << 40, 10)
+					<= 0);
+	close(fd);
+	close(fds[0]);
+	close(fds[1]);
+}
+
+/*
+ * Test vectored send and receive on a socket.
+ */
+static void socket_vector(void *arg)
+{
+	ILSysIOBuffer buffers[3];
+	char first[4];
+	char second[8];
+	int fds[2];
+
+	if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+	{
+		ILUnitOutOfMemory();
+	}
+
+	/* Send a header and payload in one message */
+	buffers[0].data = "HDR:";
+	buffers[0].length = 4;
+	buffers[1].data = "";
+	buffers[1].length = 0;
+	buffers[2].data = "payload";
+	buffers[2].length = 7;
+	ILUnitAssert(ILSysIOSocketSendV((ILSysIOHandle)(ILNativeInt)(fds[0]),
+									buffers, 3, 0) == 11);
+
+	/* Receive it into buffers that split it differently */
+	buffers[0].data = first;
+	buffers[0].length = 3;
+	buffers[1].data = second;
+	buffers[1].length = 8;
+	ILUnitAssert(ILSysIOSocketReceiveV((ILSysIOHandle)(ILNativeInt)(fds[1]),
+									   buffers, 2, 0) == 11);
+	ILUnitAssert(!ILMemCmp(first, "HDR", 3));
+	ILUnitAssert(!ILMemCmp(second, ":payload", 8));
+	close(fds[0]);
+	close(fds[1]);
+}
+
+/*
+ * Test that collections are recorded in the pause statistics.
+ */
+static void gc_pause_stats(void *arg)
+{
+	ILGCPauseStats before;
+	ILGCPauseStats after;
+	int count;
+
+	count = ILGCCollectionCount();
+	ILGCGetPauseStats(&before);
+	ILGCCollect();
+	ILGCGetPauseStats(&after);
+	if(ILGCCollectionCount() != count)
+	{
+		ILUnitAssert(after.numPauses > before.numPauses);
+	}
+	ILUnitAssert(after.numPauses >= before.numPauses);
+	ILUnitAssert(after.maxTime >= after.lastTime);
+	ILUnitAssert(after.totalTime >= after.maxTime);
+}
+
+/*
+ * Count the objects that have been finalized.
+ */
+static ILInt32 volatile gcFinalized;
+static void gc_finalizer_count(void *block, void *data)
+{
+	ILInterlockedIncrementI4(&gcFinalized);
+}
+
+/*
+ * Keep a second thread alive until an event is set.
+ */
+static void waitForEvent(void *arg)
+{
+	ILWaitOne((ILWaitHandle *)arg, 10000);
+}
+
+/*
+ * Test that a finalization storm is drained and counted.
+ */
+static void gc_finalizer_storm(void *arg)
+{
+	ILGCFinalizerStats before;
+	ILGCFinalizerStats after;
+	ILWaitHandle *event;
+	ILThread *thread;
+	void *block;
+	int posn;
+
+	/* Finalizers are run synchronously if there is only one thread,
+	   so start another one to force the use of the finalizer threads */
+	event = ILWaitEventCreate(1, 0);
+	thread = ILThreadCreate(waitForEvent, event);
+	if(!event || !thread)
+	{
+		ILUnitOutOfMemory();
+	}
+	ILThreadStart(thread);
+
+	ILGCGetFinalizerStats(&before);
+	gcFinalized = 0;
+	for(posn = 0; posn < 4096; ++posn)
+	{
+		if((block = ILGCAlloc(32)) == 0)
+		{
+			ILUnitOutOfMemory();
+		}
+		ILGCRegisterFinalizer(block, gc_finalizer_count, 0);
+	}
+	block = 0;
+	ILGCFullCollection(-1);
+	ILGCGetFinalizerStats(&after);
+	ILWaitEventSet(event);
+	ILThreadJoin(thread, 10000);
+	ILThreadDestroy(thread);
+	ILWaitHandleClose(event);
+
+	/* A few blocks may be kept alive by stray pointers on the stack */
+	ILUnitAssert(ILInterlockedLoadI4(&gcFinalized) >= 4000);
+	ILUnitAssert(after.numFinalized - before.numFinalized >=
+				 (ILUInt64)ILInterlockedLoadI4(&gcFinalized));
+	ILUnitAssert(after.numThreads == 4);
+	ILUnitAssert(after.maxPending > 0);
+}
+
 /*
  * Simple test registration macro.
  */
@@ -3498,6 +4032,8 @@ static void monitor_abort_during_wait(void *arg)
  */
 void ILUnitRegisterTests(void)
 {
+	ILGCOptions gcOptions;
+
 	/*
 	 * Bail out if no thread support at all in the system.
 	 */
@@ -3514,7 +4050,14 @@ void ILUnitRegisterTests(void)
 
 	/*
 	 * Initialize the GC system (the GC is used to create threads).
+	 * Use several finalizer threads, so that they are tested too.
 	 */
+	gcOptions.markers = 0;
+	gcOptions.incremental = 0;
+	gcOptions.pauseTarget = 0;
+	gcOptions.reportPauses = 0;
+	gcOptions.finalizers = 4;
+	ILGCSetOptions(&gcOptions);
 	ILGCInit(0);	
 
 	/*
@@ -3646,6 +4189,33 @@ void ILUnitRegisterTests(void)
 	RegisterSimple(monitor_abort_during_enter);
 	RegisterSimple(monitor_interrupt_during_wait);
 	RegisterSimple(monitor_abort_during_wait);
+
+	/*
+	 * Tests for the work-stealing thread pool.
+	 */
+	ILUnitRegisterSuite("Thread Pool Tests");
+	RegisterSimple(threadpool_create);
+	RegisterSimple(threadpool_queue);
+	RegisterSimple(threadpool_nested);
+	RegisterSimple(threadpool_starvation);
+	RegisterSimple(threadpool_limits);
+
+	/*
+	 * Tests for poll sets and select.
+	 */
+	ILUnitRegisterSuite("I/O Readiness Tests");
+	RegisterSimple(pollset_wait);
+	RegisterSimple(pollset_wakeup);
+	RegisterSimple(select_high_fd);
+	RegisterSimple(sendfile_socket);
+	RegisterSimple(socket_vector);
+
+	/*
+	 * Garbage collector tests.
+	 */
+	ILUnitRegisterSuite("Garbage Collector Tests");
+	RegisterSimple(gc_pause_stats);
+	RegisterSimple(gc_finalizer_storm);
 }
 
 void ILUnitCleanupTests(void)
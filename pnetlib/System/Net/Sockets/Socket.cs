@@ -26,6 +26,10 @@ using DotGNU.Platform;
 using System;
 using System.Private;
 using System.Collections;
+#if CONFIG_FRAMEWORK_2_0 && CONFIG_GENERICS
+using System.Collections.Generic;
+#endif
+using System.IO;
 using System.Security;
 using System.Threading;
 
@@ -42,6 +46,8 @@ public class Socket : IDisposable
 	private EndPoint remoteEP;
 	private Object readLock;
 	private BlockingOperations blockingOps;
+	private int transfers;
+	private IntPtr closeHandle;
 
 	// Invalid socket handle.
 	private static readonly IntPtr InvalidHandle =
@@ -124,6 +130,8 @@ public class Socket : IDisposable
 				this.remoteEP = null;
 				this.readLock = new Object();
 				this.blockingOps = new BlockingOperations();
+				this.transfers = 0;
+				this.closeHandle = InvalidHandle;
 
 				// Attempt to create the socket.  This may bail out for
 				// some address families, even if "AddressFamilySupported"
@@ -152,6 +160,8 @@ public class Socket : IDisposable
 				this.remoteEP = remoteEP;
 				this.readLock = new Object();
 				this.blockingOps = new BlockingOperations();
+				this.transfers = 0;
+				this.closeHandle = InvalidHandle;
 			}
 
 	// Destructor.
@@ -364,12 +374,40 @@ public class Socket : IDisposable
 				}
 
 		// Start the async thread, or perform the operation synchronously.
+		// Everything but "Connect" waits for the socket to become ready,
+		// so that pending operations do not tie up a pool thread each.
 		public void Start()
 				{
 					if(SocketMethods.CanStartThreads())
 					{
-						SocketMethods.QueueCompletionItem
-							(new AsyncCallback(Run), this);
+						switch(operation)
+						{
+							case AsyncOperation.Accept:
+							case AsyncOperation.Receive:
+							case AsyncOperation.ReceiveFrom:
+							{
+								SocketMethods.QueueCompletionOnReady
+									(socket.handle, false,
+									 new AsyncCallback(Run), this);
+							}
+							break;
+
+							case AsyncOperation.Send:
+							case AsyncOperation.SendTo:
+							{
+								SocketMethods.QueueCompletionOnReady
+									(socket.handle, true,
+									 new AsyncCallback(Run), this);
+							}
+							break;
+
+							default:
+							{
+								SocketMethods.QueueCompletionItem
+									(new AsyncCallback(Run), this);
+							}
+							break;
+						}
 					}
 					else
 					{
@@ -770,8 +808,24 @@ public class Socket : IDisposable
 				{
 					if(handle != InvalidHandle)
 					{
-						SocketMethods.Close(handle);
+						// Closing the handle completes the pending
+						// asynchronous operations, which must already
+						// see a disposed socket when they run.
+						IntPtr h = handle;
 						handle = InvalidHandle;
+						if(transfers > 0)
+						{
+							// "SendFile" is still using the handle outside
+							// the lock, so stop the transfer and let the
+							// last one close the handle once it has finished.
+							SocketMethods.Shutdown
+								(h, (int)(SocketShutdown.Both));
+							closeHandle = h;
+						}
+						else
+						{
+							SocketMethods.Close(h);
+						}
 						blockingOps.Abort();
 					}
 				}
@@ -1113,6 +1167,22 @@ public class Socket : IDisposable
 				return Receive(buffer, 0, buffer.Length, SocketFlags.None);
 			}
 
+#if CONFIG_FRAMEWORK_2_0 && CONFIG_GENERICS
+
+	// Receive data on this socket into a list of buffer segments,
+	// filling them in order with a single system call.
+	public int Receive(IList<ArraySegment<byte>> buffers,
+					   SocketFlags socketFlags)
+			{
+				return SegmentIO(buffers, socketFlags, false);
+			}
+	public int Receive(IList<ArraySegment<byte>> buffers)
+			{
+				return SegmentIO(buffers, SocketFlags.None, false);
+			}
+
+#endif // CONFIG_FRAMEWORK_2_0 && CONFIG_GENERICS
+
 	// Receive data on this socket and record where it came from.
 	public int ReceiveFrom(byte[] buffer, int offset, int size,
 					       SocketFlags socketFlags, ref EndPoint remoteEP)
@@ -1441,6 +1511,141 @@ public class Socket : IDisposable
 				return Send(buffer, 0, buffer.Length, SocketFlags.None);
 			}
 
+#if CONFIG_FRAMEWORK_2_0 && CONFIG_GENERICS
+
+	// Send the data in a list of buffer segments on this socket as a
+	// single message, without first copying it into one array.
+	public int Send(IList<ArraySegment<byte>> buffers,
+					SocketFlags socketFlags)
+			{
+				return SegmentIO(buffers, socketFlags, true);
+			}
+	public int Send(IList<ArraySegment<byte>> buffers)
+			{
+				return SegmentIO(buffers, SocketFlags.None, true);
+			}
+
+#endif // CONFIG_FRAMEWORK_2_0 && CONFIG_GENERICS
+
+#if !ECMA_COMPAT
+
+	// Send the contents of a file on this socket.  The engine moves the
+	// data from the file to the socket directly, so large files are never
+	// copied through managed memory.  The socket is only locked while its
+	// state is checked, so that other threads can use it during a long
+	// transfer.  "Dispose" defers closing the handle until we are done.
+	public void SendFile(String fileName)
+			{
+				long offset, length, result;
+				IntPtr sock;
+
+				if(fileName == null)
+				{
+					throw new ArgumentNullException("fileName");
+				}
+				FileStream stream = new FileStream
+					(fileName, FileMode.Open, FileAccess.Read, FileShare.Read);
+				try
+				{
+					IntPtr file = stream.Handle;
+					length = stream.Length;
+					offset = 0;
+					lock(this)
+					{
+						if(handle == InvalidHandle)
+						{
+							throw new ObjectDisposedException
+								(S._("Exception_Disposed"));
+						}
+						sock = handle;
+						++transfers;
+					}
+					try
+					{
+						while(offset < length)
+						{
+							using(BlockingOperation op = blockingOps.NewOp())
+							{
+								result = SocketMethods.SendFile
+									(sock, file, offset, length - offset);
+							}
+							if(result < 0)
+							{
+								Errno errno = this.GetErrno();
+								lock(this)
+								{
+									if(handle == InvalidHandle)
+									{
+										throw new ObjectDisposedException
+											(S._("Exception_Disposed"));
+									}
+								}
+								throw new SocketException(errno);
+							}
+							else if(result == 0)
+							{
+								// The file was truncated while we sent it.
+								break;
+							}
+							offset += result;
+						}
+					}
+					finally
+					{
+						lock(this)
+						{
+							--transfers;
+							if(transfers == 0 && closeHandle != InvalidHandle)
+							{
+								SocketMethods.Close(closeHandle);
+								closeHandle = InvalidHandle;
+							}
+						}
+					}
+				}
+				finally
+				{
+					stream.Close();
+				}
+			}
+
+#if CONFIG_FRAMEWORK_2_0 && !CONFIG_COMPACT_FRAMEWORK
+
+	// Send the whole contents of a buffer, even if the socket
+	// accepts it in several pieces.
+	private void SendAll(byte[] buffer)
+			{
+				int offset = 0;
+				while(offset < buffer.Length)
+				{
+					offset += Send(buffer, offset, buffer.Length - offset,
+								   SocketFlags.None);
+				}
+			}
+
+	// Send a file on this socket, surrounded by extra data.
+	public void SendFile(String fileName, byte[] preBuffer,
+						 byte[] postBuffer, TransmitFileOptions flags)
+			{
+				if(preBuffer != null)
+				{
+					SendAll(preBuffer);
+				}
+				SendFile(fileName);
+				if(postBuffer != null)
+				{
+					SendAll(postBuffer);
+				}
+				if((flags & TransmitFileOptions.Disconnect) != 0)
+				{
+					Shutdown(SocketShutdown.Both);
+				}
+			}
+
+#endif // CONFIG_FRAMEWORK_2_0 && !CONFIG_COMPACT_FRAMEWORK
+
+#endif // !ECMA_COMPAT
+
 	// Send data on this socket to a specific location.
 	public int SendTo(byte[] buffer, int offset, int size,
 					  SocketFlags socketFlags, EndPoint remoteEP)
@@ -1801,7 +2006,7 @@ public class Socket : IDisposable
 
 	// Get the operating system handle for a socket object,
 	// bailing out if the object is not a valid socket.
-	private static IntPtr GetHandle(Object obj)
+	internal static IntPtr GetHandle(Object obj)
 			{
 				Socket socket = (obj as Socket);
 				if(socket == null)
@@ -1936,6 +2141,74 @@ public class Socket : IDisposable
 				}
 			}
 
+#if CONFIG_FRAMEWORK_2_0 && CONFIG_GENERICS
+
+	// Send or receive on a list of buffer segments.
+	private int SegmentIO(IList<ArraySegment<byte>> buffers,
+						  SocketFlags socketFlags, bool sending)
+			{
+				int num, posn, result;
+				byte[][] arrays;
+				int[] offsets;
+				int[] counts;
+				ArraySegment<byte> segment;
+
+				// Split the segments into the form used by the engine.
+				if(buffers == null)
+				{
+					throw new ArgumentNullException("buffers");
+				}
+				num = buffers.Count;
+				if(num == 0)
+				{
+					throw new ArgumentException(S._("Arg_EmptyArray"));
+				}
+				arrays = new byte [num][];
+				offsets = new int [num];
+				counts = new int [num];
+				for(posn = 0; posn < num; ++posn)
+				{
+					segment = buffers[posn];
+					ValidateBuffer(segment.Array, segment.Offset,
+								   segment.Count);
+					arrays[posn] = segment.Array;
+					offsets[posn] = segment.Offset;
+					counts[posn] = segment.Count;
+				}
+
+				// Perform the operation.
+				lock(this)
+				{
+					if(handle == InvalidHandle)
+					{
+						throw new ObjectDisposedException
+							(S._("Exception_Disposed"));
+					}
+					using(BlockingOperation op = blockingOps.NewOp())
+					{
+						if(sending)
+						{
+							result = SocketMethods.SendV
+								(handle, arrays, offsets, counts,
+								 (int)socketFlags);
+						}
+						else
+						{
+							result = SocketMethods.ReceiveV
+								(handle, arrays, offsets, counts,
+								 (int)socketFlags);
+						}
+					}
+					if(result < 0)
+					{
+						throw new SocketException(this.GetErrno());
+					}
+					return result;
+				}
+			}
+
+#endif // CONFIG_FRAMEWORK_2_0 && CONFIG_GENERICS
+
 }; // class Socket
 
 }; // namespace System.Net.Sockets
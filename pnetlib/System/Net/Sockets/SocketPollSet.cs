@@ -0,0 +1,435 @@
+/*
+ * SocketPollSet.cs - Implementation of the
+ *			"System.Net.Sockets.SocketPollSet" class.
+ *
+ * Copyright (C) 2026  Free Software Foundation, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+namespace System.Net.Sockets
+{
+
+using Platform;
+using System;
+using System.Collections;
+
+// A persistent set of sockets to poll for events.  This is a DotGNU
+// extension for event loops: unlike "Socket.Select", the sockets stay
+// registered with the kernel between calls to "Poll", so the cost of
+// an iteration does not grow with the number of idle sockets.
+public sealed class SocketPollSet : IDisposable
+{
+	// Event flags that are shared with the engine.
+	private const int PollRead  = 1;
+	private const int PollWrite = 2;
+	private const int PollError = 4;
+
+	// Maximum number of sockets that are reported by one "Poll" call.
+	private const int MaxReady = 1024;
+
+	// Registration information for a socket.  The identifier is what
+	// the engine reports when the socket fires.  It is not reused while
+	// the entry exists, so an event for a socket that was closed during
+	// a poll cannot be mistaken for a new socket with the same handle.
+	private sealed class Entry
+	{
+		public Socket socket;
+		public IntPtr handle;
+		public int events;
+		public int id;
+
+	}; // class Entry
+
+	// Internal state.
+	private IntPtr pollSet;
+	private IntPtr closeSet;
+	private bool polling;
+	private Hashtable sockets;
+	private Hashtable handles;
+	private Hashtable ids;
+	private int nextId;
+	private Object pollLock;
+	private int[] readyIds;
+	private int[] readyEvents;
+
+	// Constructor.
+	public SocketPollSet()
+			{
+				pollSet = SocketMethods.PollSetCreate();
+				if(pollSet == IntPtr.Zero)
+				{
+					throw new SocketException(SocketMethods.GetErrno());
+				}
+				sockets = new Hashtable();
+				handles = new Hashtable();
+				ids = new Hashtable();
+				pollLock = new Object();
+			}
+
+	// Destructor.
+	~SocketPollSet()
+			{
+				Dispose(false);
+			}
+
+	// Get the number of sockets in this set.
+	public int Count
+			{
+				get
+				{
+					lock(this)
+					{
+						return sockets.Count;
+					}
+				}
+			}
+
+	// Convert a select mode into an event flag.
+	private static int ModeToEvent(SelectMode mode)
+			{
+				switch(mode)
+				{
+					case SelectMode.SelectRead:		return PollRead;
+					case SelectMode.SelectWrite:	return PollWrite;
+					case SelectMode.SelectError:	return PollError;
+				}
+				throw new NotSupportedException(S._("NotSupp_SelectMode"));
+			}
+
+	// Make sure that the poll set has not been disposed.
+	private void CheckDisposed()
+			{
+				if(pollSet == IntPtr.Zero)
+				{
+					throw new ObjectDisposedException
+						(S._("Exception_Disposed"));
+				}
+			}
+
+	// Allocate an identifier for a new entry.
+	private int NewId()
+			{
+				int id;
+				do
+				{
+					id = nextId;
+					nextId = (nextId + 1) & 0x7FFFFFFF;
+				}
+				while(ids.Contains(id));
+				return id;
+			}
+
+	// Start watching a socket for a particular kind of event.  A socket
+	// can be watched for several kinds of events by calling this again.
+	public void Add(Socket socket, SelectMode mode)
+			{
+				if(socket == null)
+				{
+					throw new ArgumentNullException("socket");
+				}
+				int events = ModeToEvent(mode);
+				lock(this)
+				{
+					CheckDisposed();
+					Entry entry = (Entry)(sockets[socket]);
+					if(entry == null)
+					{
+						entry = new Entry();
+						entry.socket = socket;
+						entry.handle = Socket.GetHandle(socket);
+						entry.events = 0;
+						entry.id = NewId();
+
+						// Another entry for the same handle belongs to a
+						// socket that was closed without being removed,
+						// and whose handle has now been reused.
+						Entry stale = (Entry)(handles[entry.handle]);
+						if(stale != null)
+						{
+							ForgetEntry(stale);
+						}
+					}
+					else if((entry.events & events) != 0)
+					{
+						return;
+					}
+					if(!SocketMethods.PollSetAdd
+							(pollSet, entry.handle,
+							 entry.events | events, entry.id))
+					{
+						throw new SocketException(SocketMethods.GetErrno());
+					}
+					entry.events |= events;
+					sockets[socket] = entry;
+					handles[entry.handle] = entry;
+					ids[entry.id] = entry;
+				}
+			}
+
+	// Stop watching a socket for a particular kind of event.
+	public void Remove(Socket socket, SelectMode mode)
+			{
+				if(socket == null)
+				{
+					throw new ArgumentNullException("socket");
+				}
+				int events = ModeToEvent(mode);
+				lock(this)
+				{
+					CheckDisposed();
+					Entry entry = (Entry)(sockets[socket]);
+					if(entry == null || (entry.events & events) == 0)
+					{
+						return;
+					}
+					if((entry.events & ~events) == 0)
+					{
+						RemoveEntry(entry);
+					}
+					else if(SocketMethods.PollSetAdd
+								(pollSet, entry.handle,
+								 entry.events & ~events, entry.id))
+					{
+						entry.events &= ~events;
+					}
+					else
+					{
+						throw new SocketException(SocketMethods.GetErrno());
+					}
+				}
+			}
+
+	// Stop watching a socket altogether.
+	public void Remove(Socket socket)
+			{
+				if(socket == null)
+				{
+					throw new ArgumentNullException("socket");
+				}
+				lock(this)
+				{
+					CheckDisposed();
+					Entry entry = (Entry)(sockets[socket]);
+					if(entry != null)
+					{
+						RemoveEntry(entry);
+					}
+				}
+			}
+
+	// Remove a socket entry.  The engine may have dropped the handle
+	// already if the socket was closed, so failures are ignored.
+	private void RemoveEntry(Entry entry)
+			{
+				SocketMethods.PollSetRemove(pollSet, entry.handle);
+				ForgetEntry(entry);
+			}
+
+	// Forget about a socket entry without touching the engine's set,
+	// which may be watching a newer socket with the same handle.
+	private void ForgetEntry(Entry entry)
+			{
+				sockets.Remove(entry.socket);
+				ids.Remove(entry.id);
+				if(handles[entry.handle] == entry)
+				{
+					handles.Remove(entry.handle);
+				}
+			}
+
+	// Determine if a socket is being watched for a particular event.
+	public bool Contains(Socket socket, SelectMode mode)
+			{
+				if(socket == null)
+				{
+					return false;
+				}
+				int events = ModeToEvent(mode);
+				lock(this)
+				{
+					Entry entry = (Entry)(sockets[socket]);
+					return (entry != null && (entry.events & events) != 0);
+				}
+			}
+
+	// Wait for events on the sockets in this set.  The lists are cleared
+	// and then filled with the sockets that are ready.  Returns the number
+	// of sockets that were added to the lists, or zero on timeout.  A
+	// negative timeout waits forever.  Sockets can be added and removed
+	// while a poll is running, and closing the set interrupts the poll.
+	public int Poll(IList checkRead, IList checkWrite,
+					IList checkError, int microSeconds)
+			{
+				int result, posn, events, count;
+				IntPtr set;
+				Errno errno;
+				Entry entry;
+				bool reported;
+
+				// Only one thread can wait on the engine's set at a time.
+				lock(pollLock)
+				{
+					lock(this)
+					{
+						CheckDisposed();
+
+						// Size the result buffers for the current set.
+						int size = sockets.Count;
+						if(size < 16)
+						{
+							size = 16;
+						}
+						else if(size > MaxReady)
+						{
+							size = MaxReady;
+						}
+						if(readyIds == null || readyIds.Length < size)
+						{
+							readyIds = new int [size];
+							readyEvents = new int [size];
+						}
+						set = pollSet;
+						polling = true;
+					}
+
+					// Wait for the events without holding the lock, so
+					// that the set can be changed or closed meanwhile.
+					errno = Errno.Success;
+					try
+					{
+						result = SocketMethods.PollSetWait
+							(set, readyIds, readyEvents,
+							 (microSeconds < 0 ? -1L : (long)microSeconds));
+						if(result < 0)
+						{
+							errno = SocketMethods.GetErrno();
+						}
+					}
+					finally
+					{
+						lock(this)
+						{
+							polling = false;
+							if(closeSet != IntPtr.Zero)
+							{
+								SocketMethods.PollSetDestroy(closeSet);
+								closeSet = IntPtr.Zero;
+							}
+						}
+					}
+
+					lock(this)
+					{
+						CheckDisposed();
+						if(result < 0)
+						{
+							throw new SocketException(errno);
+						}
+
+						// Report the sockets that are ready.
+						if(checkRead != null)
+						{
+							checkRead.Clear();
+						}
+						if(checkWrite != null)
+						{
+							checkWrite.Clear();
+						}
+						if(checkError != null)
+						{
+							checkError.Clear();
+						}
+						count = 0;
+						for(posn = 0; posn < result; ++posn)
+						{
+							// Skip sockets that were removed during the wait.
+							entry = (Entry)(ids[readyIds[posn]]);
+							if(entry == null)
+							{
+								continue;
+							}
+							events = (readyEvents[posn] & entry.events);
+							reported = false;
+							if((events & PollRead) != 0 && checkRead != null)
+							{
+								checkRead.Add(entry.socket);
+								reported = true;
+							}
+							if((events & PollWrite) != 0 && checkWrite != null)
+							{
+								checkWrite.Add(entry.socket);
+								reported = true;
+							}
+							if((events & PollError) != 0 && checkError != null)
+							{
+								checkError.Add(entry.socket);
+								reported = true;
+							}
+							if(reported)
+							{
+								++count;
+							}
+						}
+						return count;
+					}
+				}
+			}
+
+	// Close this poll set.  The sockets in it are not closed.
+	public void Close()
+			{
+				Dispose(true);
+				GC.SuppressFinalize(this);
+			}
+
+	// Implement the IDisposable interface.
+	void IDisposable.Dispose()
+			{
+				Close();
+			}
+
+	// Dispose of this poll set.
+	private void Dispose(bool disposing)
+			{
+				lock(this)
+				{
+					if(pollSet != IntPtr.Zero)
+					{
+						if(polling)
+						{
+							// Interrupt the wait, and let "Poll" destroy
+							// the set once the wait has returned.
+							SocketMethods.PollSetWakeup(pollSet);
+							closeSet = pollSet;
+						}
+						else
+						{
+							SocketMethods.PollSetDestroy(pollSet);
+						}
+						pollSet = IntPtr.Zero;
+					}
+					if(disposing)
+					{
+						sockets.Clear();
+						handles.Clear();
+						ids.Clear();
+					}
+				}
+			}
+
+}; // class SocketPollSet
+
+}; // namespace System.Net.Sockets
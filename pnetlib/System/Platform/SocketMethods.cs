@@ -85,6 +85,26 @@ internal class SocketMethods
 		(IntPtr handle, byte[] buffer, int offset, int size,
 		 int flags, byte[] addr);
 
+	// Send data from a list of buffer segments as a single message.
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern public static int SendV
+		(IntPtr handle, byte[][] buffers, int[] offsets,
+		 int[] counts, int flags);
+
+	// Receive data into a list of buffer segments, filling them in order.
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern public static int ReceiveV
+		(IntPtr handle, byte[][] buffers, int[] offsets,
+		 int[] counts, int flags);
+
+	// Send "count" bytes from a file handle to a connected socket,
+	// starting at "offset", without copying through managed memory.
+	// A negative count sends to the end of the file.  Returns the number
+	// of bytes sent, or -1 on error.
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern public static long SendFile
+		(IntPtr handle, IntPtr file, long offset, long count);
+
 	// Close a socket (regardless of pending in/output).
 	[MethodImpl(MethodImplOptions.InternalCall)]
 	extern public static bool Close(IntPtr handle);
@@ -99,6 +119,38 @@ internal class SocketMethods
 		(IntPtr[] readarray, IntPtr[] writearray,
 		 IntPtr[] errorarray, long timeout);
 
+	// Create a persistent set of socket handles to poll for events.
+	// Returns IntPtr.Zero on error.
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern public static IntPtr PollSetCreate();
+
+	// Destroy a poll set.
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern public static void PollSetDestroy(IntPtr pollSet);
+
+	// Wake up the thread that is waiting on a poll set.
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern public static void PollSetWakeup(IntPtr pollSet);
+
+	// Add a handle to a poll set, or change its events.  The events
+	// are a combination of 1 (read), 2 (write) and 4 (error).  The
+	// identifier is reported by "PollSetWait" when the handle fires.
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern public static bool PollSetAdd
+		(IntPtr pollSet, IntPtr handle, int events, int id);
+
+	// Remove a handle from a poll set.
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern public static bool PollSetRemove(IntPtr pollSet, IntPtr handle);
+
+	// Wait for handles in a poll set to become ready.  The identifiers
+	// of the handles that fired and their events are stored in the
+	// arrays.  Returns the number of handles that fired, 0 on timeout
+	// or wakeup, or -1 on error.  The timeout is in microseconds.
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern public static int PollSetWait
+		(IntPtr pollSet, int[] ids, int[] events, long timeout);
+
 	// Change the blocking mode on a socket.
 	[MethodImpl(MethodImplOptions.InternalCall)]
 	extern public static bool SetBlocking(IntPtr handle, bool blocking);
@@ -166,6 +218,13 @@ internal class SocketMethods
 	extern public static bool QueueCompletionItem
 			(AsyncCallback callback, IAsyncResult state);
 
+	// Make a backdoor call to "ThreadPool.QueueCompletionOnReady", which
+	// runs the callback once the socket is ready for reading or writing.
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern public static bool QueueCompletionOnReady
+			(IntPtr handle, bool write, AsyncCallback callback,
+			 IAsyncResult state);
+
 	// Create a "ManualResetEvent" instance.  Backdoor access.
 	[MethodImpl(MethodImplOptions.InternalCall)]
 	extern public static WaitHandle CreateManualResetEvent();
@@ -108,6 +108,24 @@ internal sealed class CryptoMethods
 									  int inOffset, byte[] outBuffer,
 									  int outOffset);
 
+	// Encrypt "count" bytes of whole blocks.  If "iv" is null, then
+	// use ECB mode.  Otherwise use CBC mode, and leave the last
+	// ciphertext block in "iv" ready for the next call.
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern public static void EncryptBlocks(IntPtr state, byte[] iv,
+											byte[] inBuffer, int inOffset,
+											byte[] outBuffer, int outOffset,
+											int count);
+
+	// Decrypt "count" bytes of whole blocks.  If "iv" is null, then
+	// use ECB mode.  Otherwise use CBC mode, and leave the last
+	// ciphertext block in "iv" ready for the next call.
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern public static void DecryptBlocks(IntPtr state, byte[] iv,
+											byte[] inBuffer, int inOffset,
+											byte[] outBuffer, int outOffset,
+											int count);
+
 	// Free a symmetric block context.
 	[MethodImpl(MethodImplOptions.InternalCall)]
 	extern public static void SymmetricFree(IntPtr state);
@@ -0,0 +1,129 @@
+/*
+ * ArraySegment_1.cs - Implementation of the
+ *		"System.ArraySegment<T>" class.
+ *
+ * Copyright (C) 2026  Free Software Foundation, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+namespace System
+{
+
+#if CONFIG_FRAMEWORK_2_0 && CONFIG_GENERICS
+
+#if !ECMA_COMPAT && CONFIG_SERIALIZATION
+[Serializable]
+#endif
+public struct ArraySegment<T>
+{
+	private T[] array;
+	private int offset;
+	private int count;
+
+	public ArraySegment(T[] array)
+			{
+				if(array == null)
+				{
+					throw new ArgumentNullException("array");
+				}
+				this.array = array;
+				this.offset = 0;
+				this.count = array.Length;
+			}
+
+	public ArraySegment(T[] array, int offset, int count)
+			{
+				if(array == null)
+				{
+					throw new ArgumentNullException("array");
+				}
+				if(offset < 0)
+				{
+					throw new ArgumentOutOfRangeException
+						("offset", _("ArgRange_Array"));
+				}
+				if(count < 0)
+				{
+					throw new ArgumentOutOfRangeException
+						("count", _("ArgRange_Array"));
+				}
+				if((array.Length - offset) < count)
+				{
+					throw new ArgumentException(_("Arg_InvalidArrayRange"));
+				}
+				this.array = array;
+				this.offset = offset;
+				this.count = count;
+			}
+
+	public T[] Array
+			{
+				get
+				{
+					return array;
+				}
+			}
+
+	public int Offset
+			{
+				get
+				{
+					return offset;
+				}
+			}
+
+	public int Count
+			{
+				get
+				{
+					return count;
+				}
+			}
+
+	public override bool Equals(Object obj)
+			{
+				if(obj is ArraySegment<T>)
+				{
+					return (this == (ArraySegment<T>)obj);
+				}
+				return false;
+			}
+
+	public override int GetHashCode()
+			{
+				if(array == null)
+				{
+					return 0;
+				}
+				return array.GetHashCode() ^ offset ^ count;
+			}
+
+	public static bool operator==(ArraySegment<T> a, ArraySegment<T> b)
+			{
+				return (a.array == b.array && a.offset == b.offset &&
+						a.count == b.count);
+			}
+
+	public static bool operator!=(ArraySegment<T> a, ArraySegment<T> b)
+			{
+				return !(a == b);
+			}
+
+}; // struct ArraySegment<T>
+
+#endif // CONFIG_FRAMEWORK_2_0 && CONFIG_GENERICS
+
+}; // namespace System
@@ -264,6 +264,27 @@ public class FileStream : Stream
 				base.EndWrite(asyncResult);
 			}
 
+	// Asynchronous operations on pipes and terminals wait until the
+	// handle is ready, instead of blocking a pool thread each.
+	internal override bool GetAsyncHandle(bool reading, out IntPtr handle)
+			{
+				lock(this)
+				{
+					handle = this.handle;
+					if(canSeek || handle == invalidHandle)
+					{
+						return false;
+					}
+
+					// Data that is already buffered can be read right away.
+					if(reading && !bufferOwnedByWrite && bufferPosn < bufferLen)
+					{
+						return false;
+					}
+					return true;
+				}
+			}
+
 	// Flush read data from the buffer.
 	private void FlushReadBuffer()
 			{
@@ -350,11 +371,15 @@ public class FileStream : Stream
 						{
 							FlushWriteBuffer();
 						}
+						// Closing the handle completes the pending
+						// asynchronous operations, which must already
+						// see a closed stream when they run.
+						IntPtr h = handle;
+						handle = invalidHandle;
 						if(ownsHandle)
 						{
-							FileMethods.Close(handle);
+							FileMethods.Close(h);
 						}
-						handle = invalidHandle;
 					}
 				}
 			}
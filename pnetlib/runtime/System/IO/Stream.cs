@@ -98,10 +98,20 @@ public abstract class Stream : MarshalByRefObject, IDisposable
 		// Start the async thread, or perform the operation synchronously.
 		public void Start()
 				{
+					IntPtr handle;
 					if(Thread.CanStartThreads())
 					{
-						ThreadPool.QueueCompletionItem
-							(new WaitCallback(Run), null);
+						if(stream.GetAsyncHandle(reading, out handle))
+						{
+							ThreadPool.QueueCompletionOnReady
+								(handle, !reading,
+								 new WaitCallback(Run), null);
+						}
+						else
+						{
+							ThreadPool.QueueCompletionItem
+								(new WaitCallback(Run), null);
+						}
 					}
 					else
 					{
@@ -192,6 +202,15 @@ public abstract class Stream : MarshalByRefObject, IDisposable
 
 	}; // class AsyncControl
 
+	// Get the operating system handle that an asynchronous read or write
+	// should wait on before it runs.  Returns false if the operation
+	// should be started on a pool thread straight away.
+	internal virtual bool GetAsyncHandle(bool reading, out IntPtr handle)
+			{
+				handle = IntPtr.Zero;
+				return false;
+			}
+
 	// Begin an asynchronous read operation.
 	public virtual IAsyncResult BeginRead
 				(byte[] buffer, int offset, int count,
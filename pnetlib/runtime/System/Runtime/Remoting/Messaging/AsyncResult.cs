@@ -68,11 +68,10 @@ public class AsyncResult : IAsyncResult
 				this.endInvokeCalled = false;
 
 				// If we have threads, then queue the delegate to run
-				// on the thread pool's completion worker thread.
+				// on one of the thread pool's worker threads.
 				if(Thread.CanStartThreads())
 				{
-					ThreadPool.QueueCompletionItem
-						(new WaitCallback(Run), null);
+					ThreadPool.QueueUserWorkItem(new WaitCallback(Run), null);
 					return;
 				}
 
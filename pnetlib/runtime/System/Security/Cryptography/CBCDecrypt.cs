@@ -49,7 +49,7 @@ internal sealed class CBCDecrypt
 				IntPtr state = transform.state;
 				byte[] tempBuffer = transform.tempBuffer;
 				int offset = outputOffset;
-				int index;
+				int index, count;
 
 				// Process a left-over block from last time.
 				if(transform.tempSize > 0 && inputCount > 0)
@@ -78,28 +78,27 @@ internal sealed class CBCDecrypt
 					}
 				}
 
-				// Process all of the blocks in the input, minus one.
-				while(inputCount > blockSize)
+				// Process all of the blocks in the input, minus one,
+				// with one call.  The engine does the chaining, and
+				// copies the last ciphertext block to the IV.
+				if(inputCount > 0)
 				{
-					// Decrypt the ciphertext to get the plaintext
-					// xor'ed with the IV.
-					CryptoMethods.Decrypt(state, inputBuffer, inputOffset,
-										  tempBuffer, 0);
-
-					// XOR the IV with the temporary buffer to get plaintext.
-					for(index = blockSize - 1; index >= 0; --index)
+					count = ((inputCount - 1) / blockSize) * blockSize;
+					if(count > 0)
 					{
-						outputBuffer[offset + index] =
-							(byte)(iv[index] ^ tempBuffer[index]);
+						if(count > (outputBuffer.Length - offset))
+						{
+							throw new ArgumentException
+								(_("Arg_InvalidArrayRange"));
+						}
+						CryptoMethods.DecryptBlocks(state, iv,
+													inputBuffer, inputOffset,
+													outputBuffer, offset,
+													count);
+						inputOffset += count;
+						inputCount -= count;
+						offset += count;
 					}
-
-					// Copy the original ciphertext to the IV.
-					Array.Copy(inputBuffer, inputOffset, iv, 0, blockSize);
-
-					// Advance to the next block.
-					inputOffset += blockSize;
-					inputCount -= blockSize;
-					offset += blockSize;
 				}
 
 				// Save the last block for next time.
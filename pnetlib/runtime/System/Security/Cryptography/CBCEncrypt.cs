@@ -37,33 +37,25 @@ internal sealed class CBCEncrypt
 							         int inputCount, byte[] outputBuffer,
 							         int outputOffset)
 			{
-				int blockSize = transform.blockSize;
-				byte[] iv = transform.iv;
-				IntPtr state = transform.state;
-				int offset = outputOffset;
-				int index;
+				int count = inputCount - (inputCount % transform.blockSize);
 
-				// Process all of the blocks in the input.
-				while(inputCount >= blockSize)
+				// Process all of the blocks in the input with one call.
+				// The engine does the chaining, and updates the IV.
+				if(count > 0)
 				{
-					// XOR the plaintext with the IV.
-					for(index = blockSize - 1; index >= 0; --index)
+					if(count > (outputBuffer.Length - outputOffset))
 					{
-						iv[index] ^= inputBuffer[inputOffset + index];
+						throw new ArgumentException
+							(_("Arg_InvalidArrayRange"));
 					}
-
-					// Encrypt the IV to get the ciphertext and the next IV.
-					CryptoMethods.Encrypt(state, iv, 0, iv, 0);
-					Array.Copy(iv, 0, outputBuffer, offset, blockSize);
-
-					// Advance to the next block.
-					inputOffset += blockSize;
-					inputCount -= blockSize;
-					offset += blockSize;
+					CryptoMethods.EncryptBlocks(transform.state, transform.iv,
+												inputBuffer, inputOffset,
+												outputBuffer, outputOffset,
+												count);
 				}
 
 				// Finished.
-				return offset - outputOffset;
+				return count;
 			}
 
 	// Transform the final input block.
@@ -95,22 +87,14 @@ internal sealed class CBCEncrypt
 				outputBuffer = new byte [size];
 
 				// Process full blocks in the input.
-				while(inputCount >= blockSize)
+				offset = inputCount - (inputCount % blockSize);
+				if(offset > 0)
 				{
-					// XOR the plaintext with the IV.
-					for(index = blockSize - 1; index >= 0; --index)
-					{
-						iv[index] ^= inputBuffer[inputOffset + index];
-					}
-
-					// Encrypt the IV to get the ciphertext and the next IV.
-					CryptoMethods.Encrypt(state, iv, 0, iv, 0);
-					Array.Copy(iv, 0, outputBuffer, offset, blockSize);
-
-					// Advance to the next block.
-					inputOffset += blockSize;
-					inputCount -= blockSize;
-					offset += blockSize;
+					CryptoMethods.EncryptBlocks(state, iv,
+												inputBuffer, inputOffset,
+												outputBuffer, 0, offset);
+					inputOffset += offset;
+					inputCount -= offset;
 				}
 
 				// Format and encrypt the final partial block.
@@ -49,7 +49,7 @@ internal sealed class ECBDecrypt
 				IntPtr state = transform.state;
 				byte[] tempBuffer = transform.tempBuffer;
 				int offset = outputOffset;
-				int index;
+				int index, count;
 				bool needPadding = (transform.padding != PaddingMode.None);
 
 				// Process a left-over block from last time.
@@ -70,17 +70,30 @@ internal sealed class ECBDecrypt
 
 				// Process all of the blocks in the input, minus one.
 				// If we don't need padding, then process all of the blocks.
-				while((needPadding && inputCount > blockSize) ||
-				      (!needPadding && inputCount >= blockSize))
+				if(needPadding && inputCount > 0)
+				{
+					count = ((inputCount - 1) / blockSize) * blockSize;
+				}
+				else
+				{
+					count = inputCount - (inputCount % blockSize);
+				}
+				if(count > 0)
 				{
 					// Decrypt the ciphertext to get the plaintext.
-					CryptoMethods.Decrypt(state, inputBuffer, inputOffset,
-										  outputBuffer, offset);
-
-					// Advance to the next block.
-					inputOffset += blockSize;
-					inputCount -= blockSize;
-					offset += blockSize;
+					if(count > (outputBuffer.Length - offset))
+					{
+						throw new ArgumentException
+							(_("Arg_InvalidArrayRange"));
+					}
+					CryptoMethods.DecryptBlocks(state, null,
+												inputBuffer, inputOffset,
+												outputBuffer, offset, count);
+
+					// Advance past the blocks.
+					inputOffset += count;
+					inputCount -= count;
+					offset += count;
 				}
 
 				// Save the last block for next time.
@@ -37,22 +37,24 @@ internal sealed class ECBEncrypt
 							         int inputCount, byte[] outputBuffer,
 							         int outputOffset)
 			{
-				int blockSize = transform.blockSize;
-				IntPtr state = transform.state;
-				int offset = outputOffset;
+				int count = inputCount - (inputCount % transform.blockSize);
 
-				// Process all of the blocks in the input.
-				while(inputCount >= blockSize)
+				// Process all of the blocks in the input with one call.
+				if(count > 0)
 				{
-					CryptoMethods.Encrypt(state, inputBuffer, inputOffset,
-										  outputBuffer, offset);
-					inputOffset += blockSize;
-					inputCount -= blockSize;
-					offset += blockSize;
+					if(count > (outputBuffer.Length - outputOffset))
+					{
+						throw new ArgumentException
+							(_("Arg_InvalidArrayRange"));
+					}
+					CryptoMethods.EncryptBlocks(transform.state, null,
+												inputBuffer, inputOffset,
+												outputBuffer, outputOffset,
+												count);
 				}
 
 				// Finished.
-				return offset - outputOffset;
+				return count;
 			}
 
 	// Transform the final input block.
@@ -83,13 +85,14 @@ internal sealed class ECBEncrypt
 				outputBuffer = new byte [size];
 
 				// Process full blocks in the input.
-				while(inputCount >= blockSize)
+				offset = inputCount - (inputCount % blockSize);
+				if(offset > 0)
 				{
-					CryptoMethods.Encrypt(state, inputBuffer, inputOffset,
-										  outputBuffer, offset);
-					inputOffset += blockSize;
-					inputCount -= blockSize;
-					offset += blockSize;
+					CryptoMethods.EncryptBlocks(state, null,
+												inputBuffer, inputOffset,
+												outputBuffer, 0, offset);
+					inputOffset += offset;
+					inputCount -= offset;
 				}
 
 				// Format and encrypt the final partial block.
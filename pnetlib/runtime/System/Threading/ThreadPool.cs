@@ -21,6 +21,7 @@
 namespace System.Threading
 {
 
+using System.Runtime.CompilerServices;
 using System.Security;
 using System.Security.Permissions;
 
@@ -31,25 +32,12 @@ public
 #endif
 sealed class ThreadPool
 {
-	// Maximum number of threads in the pool.
-	private const int MaxWorkerThreads = 16;
-	private const int MaxCompletionThreads = 16;
-
-	// Minimum number of threads in the pool.
-	private const int MinWorkerThreads = 0;
-	private const int MinCompletionThreads = 0;
-
-	// Internal state.
-	private static int usedWorkerThreads;
-	private static int usedCompletionThreads;
-	private static int queuedCompletionItems;
+	// Kinds of native thread pools in the runtime engine.
+	private const int WorkerPool = 0;
+	private const int CompletionPool = 1;
+
+	// Work items that are run synchronously if we don't have threads.
 	private static WorkItem workItems, lastWorkItem;
-	private static WorkItem completionItems, lastCompletionItem;
-	private static Thread[] workerThreads;
-	private static Thread[] completionThreads;
-	private static int numWorkerThreads;
-	private static int numCompletionThreads;
-	private static Object completionWait;
 
 	// Constructor.
 	private ThreadPool() {}
@@ -65,43 +53,63 @@ sealed class ThreadPool
 	public static void GetAvailableThreads(out int workerThreads,
 										   out int completionPortThreads)
 			{
-				lock(typeof(ThreadPool))
-				{
-					workerThreads = MaxWorkerThreads - usedWorkerThreads;
-					completionPortThreads =
-						MaxCompletionThreads - usedCompletionThreads;
-				}
+				workerThreads = InternalGetAvailableThreads(WorkerPool);
+				completionPortThreads =
+					InternalGetAvailableThreads(CompletionPool);
 			}
 
 	// Get the maximum number of threads in the thread pool.
 	public static void GetMaxThreads(out int workerThreads,
 									 out int completionPortThreads)
 			{
-				workerThreads = MaxWorkerThreads;
-				completionPortThreads = MaxCompletionThreads;
+				workerThreads = InternalGetMaxThreads(WorkerPool);
+				completionPortThreads = InternalGetMaxThreads(CompletionPool);
 			}
 
 	// Get the minimum number of threads that should exist in the thread pool.
 	public static void GetMinThreads(out int workerThreads,
 									 out int completionPortThreads)
 			{
-				workerThreads = MinWorkerThreads;
-				completionPortThreads = MinCompletionThreads;
+				workerThreads = InternalGetMinThreads(WorkerPool);
+				completionPortThreads = InternalGetMinThreads(CompletionPool);
 			}
 
 	// Set the minimum number of threads that should exist in the thread pool.
 	public static bool SetMinThreads(int workerThreads,
 									 int completionPortThreads)
 			{
-				// Ignored - we let the pool decide how big it should be.
-				return false;
+				if(workerThreads < 1 || completionPortThreads < 1 ||
+				   workerThreads > InternalGetMaxThreads(WorkerPool) ||
+				   completionPortThreads >
+				   		InternalGetMaxThreads(CompletionPool))
+				{
+					return false;
+				}
+				return InternalSetMinThreads(WorkerPool, workerThreads) &&
+					   InternalSetMinThreads
+					   		(CompletionPool, completionPortThreads);
+			}
+
+	// Set the maximum number of threads in the thread pool.
+	public static bool SetMaxThreads(int workerThreads,
+									 int completionPortThreads)
+			{
+				if(workerThreads < InternalGetMinThreads(WorkerPool) ||
+				   completionPortThreads <
+				   		InternalGetMinThreads(CompletionPool))
+				{
+					return false;
+				}
+				return InternalSetMaxThreads(WorkerPool, workerThreads) &&
+					   InternalSetMaxThreads
+					   		(CompletionPool, completionPortThreads);
 			}
 
 	// Queue a new work item within the thread pool.
 	public static bool QueueUserWorkItem(WaitCallback callBack, Object state)
 			{
 				AddWorkItem(new WorkItem(ClrSecurity.GetPermissionsFrom(1),
-										 callBack, state));
+										 callBack, state), WorkerPool);
 				return true;
 			}
 	public static bool QueueUserWorkItem(WaitCallback callBack)
@@ -113,16 +121,9 @@ sealed class ThreadPool
 	internal static bool QueueCompletionItem
 				(WaitCallback callBack, Object state)
 			{
-				lock(typeof(ThreadPool))
-				{
-					if(completionWait == null)
-					{
-						completionWait = new Object();
-					}
-				}
-				AddCompletionItem
+				AddWorkItem
 					(new WorkItem(ClrSecurity.GetPermissionsFrom(1),
-					 callBack, state));
+					 callBack, state), CompletionPool);
 				return true;
 			}
 
@@ -132,16 +133,35 @@ sealed class ThreadPool
 	internal static bool QueueCompletionItem
 				(AsyncCallback callBack, IAsyncResult state)
 			{
-				lock(typeof(ThreadPool))
-				{
-					if(completionWait == null)
-					{
-						completionWait = new Object();
-					}
-				}
-				AddCompletionItem
+				AddWorkItem
 					(new WorkItem(ClrSecurity.GetPermissionsFrom(1),
-					 callBack, state));
+					 callBack, state), CompletionPool);
+				return true;
+			}
+
+	// Queue a new I/O completion item that runs once a socket or pipe
+	// handle is ready for reading or writing.  The item is queued right
+	// away if the engine cannot watch the handle.
+	internal static bool QueueCompletionOnReady
+				(IntPtr handle, bool write, WaitCallback callBack, Object state)
+			{
+				AddWorkItemOnReady
+					(handle, write,
+					 new WorkItem(ClrSecurity.GetPermissionsFrom(1),
+					 			  callBack, state));
+				return true;
+			}
+
+	// Queue a new I/O completion item that runs once a socket or pipe
+	// handle is ready.  This version is used by the "System" assembly.
+	internal static bool QueueCompletionOnReady
+				(IntPtr handle, bool write, AsyncCallback callBack,
+				 IAsyncResult state)
+			{
+				AddWorkItemOnReady
+					(handle, write,
+					 new WorkItem(ClrSecurity.GetPermissionsFrom(1),
+					 			  callBack, state));
 				return true;
 			}
 
@@ -175,7 +195,7 @@ sealed class ThreadPool
 											 waitObject, callBack, state,
 											 millisecondsTimeOutInterval,
 											 executeOnlyOnce);
-				AddWorkItem(item);
+				AddWorkItem(item, WorkerPool);
 				return new RegisteredWaitHandle(item);
 			}
 	public static RegisteredWaitHandle RegisterWaitForSingleObject
@@ -253,7 +273,7 @@ sealed class ThreadPool
 					 executeOnlyOnce);
 			}
 
-	// Get the next work item to be dispatched.
+	// Get the next work item to be dispatched synchronously.
 	private static WorkItem ItemToDispatch()
 			{
 				lock(typeof(ThreadPool))
@@ -271,129 +291,31 @@ sealed class ThreadPool
 				}
 			}
 
-	// Get the next completion item to be dispatched.
-	private static WorkItem CompletionItemToDispatch()
-			{
-				lock(completionWait)
-				{
-					WorkItem item = completionItems;
-					if(item != null)
-					{
-						completionItems = item.next;
-						if(item.next == null)
-						{
-							lastCompletionItem = null;
-						}
-					}
-					return item;
-				}
-			}
-
-	// Run a worker thread.
-	private static void Work()
+	// Prepare a native pool thread to run work items.  This is
+	// called by the runtime engine when the thread starts.
+	private static void InitializeWorker()
 			{
-				// Assert unrestricted permissions for this thread.
-				// The permissions will be modified for each work item
-				// to reflect the context that created the work item.
-				ClrSecurity.SetPermissions(null, 0);
-
-				// Wait for and dispatch work items.
-				WorkItem item = null;
-				for(;;)
-				{
-					lock(typeof(ThreadPool))
-					{
-						do
-						{
-							item = ItemToDispatch();
-							if(item == null)
-							{
-								Monitor.Wait(typeof(ThreadPool));
-							}
-						}
-						while(item == null);
-					}
-									
-					try
-					{
-						Interlocked.Increment(ref usedWorkerThreads);
-						item.Execute();
-					}
-					finally
-					{
-						item = null;
-						Interlocked.Decrement(ref usedWorkerThreads);
-					}
-				}
+			#if !ECMA_COMPAT
+				Thread.CurrentThread.inThreadPool = true;
+			#endif
 			}
 
-	// Run a completion thread.
-	private static void Complete()
+	// Add a work item to one of the native thread pools.
+	private static void AddWorkItem(WorkItem item, int pool)
 			{
-				// Assert unrestricted permissions for this thread.
-				// The permissions will be modified for each work item
-				// to reflect the context that created the work item.
-				ClrSecurity.SetPermissions(null, 0);
-
-				// Wait for and dispatch completion items.
-				WorkItem item;
-				
-				for(;;)
+				if(Thread.CanStartThreads())
 				{
-					lock(completionWait)
-					{
-						do
-						{
-							item = CompletionItemToDispatch();
-							if(item == null)
-							{
-								Monitor.Wait(completionWait);
-							}
-						}
-						while (item == null);
-						usedCompletionThreads++;
-						queuedCompletionItems--;
-					}
-					
-					try
-					{
-						item.Execute();
-					}
-					finally
+					if(InternalQueueWorkItem(item, pool))
 					{
-						item = null;
-						lock(completionWait)
-							usedCompletionThreads--;
+						return;
 					}
-				}
-			}
 
-	// Add a work item to the worker queue.
-	private static void AddWorkItem(WorkItem item)
-			{
-				if (!Thread.CanStartThreads())
-				{
-					// Add the item to the end of the worker queue.
-					if(lastWorkItem != null)
-					{
-						lastWorkItem.next = item;
-					}
-					else
-					{
-						workItems = item;
-					}
-					lastWorkItem = item;
-			
-					// We don't have threads, so execute the items now.
-					WorkItem next = ItemToDispatch();
-					while(next != null)
-					{
-						next.Execute();
-						next = ItemToDispatch();
-					}
+					// The engine could not queue the item, so run it now.
+					item.Execute();
 				}
 				else
 				{
+					// Add the item to the end of the queue.
 					lock(typeof(ThreadPool))
 					{
 						if(lastWorkItem != null)
@@ -405,111 +327,56 @@ sealed class ThreadPool
 							workItems = item;
 						}
 						lastWorkItem = item;
-					
-						// Determine if we need to spawn a new worker thread.
-
-						if(workItems != null &&
-							numWorkerThreads < MaxWorkerThreads)
-						{
-							if(workerThreads == null)
-							{
-								workerThreads = new Thread [MaxWorkerThreads];
-							}
-							Thread thread = new Thread(new ThreadStart(Work));
-							#if !ECMA_COMPAT
-							thread.inThreadPool = true;
-							#endif
-							workerThreads[numWorkerThreads++] = thread;
-							thread.IsBackground = true;
-							thread.Start();
-						}
-						Monitor.Pulse(typeof(ThreadPool));
 					}
-				}
-			}
-
-	// Add a work item to the completion queue.
-	private static void AddCompletionItem(WorkItem item)
-			{				
-				if (!Thread.CanStartThreads())
-				{
-					// Add the item to the end of the worker queue.
-					if(lastCompletionItem != null)
-					{
-						lastCompletionItem.next = item;
-					}
-					else
-					{
-						completionItems = item;
-					}
-					lastCompletionItem = item;
 
 					// We don't have threads, so execute the items now.
-					WorkItem next = CompletionItemToDispatch();
+					WorkItem next = ItemToDispatch();
 					while(next != null)
 					{
 						next.Execute();
-						next = CompletionItemToDispatch();
+						next = ItemToDispatch();
 					}
 				}
-				else
+			}
+
+	// Add a work item to the completion pool once a handle is ready.
+	private static void AddWorkItemOnReady
+				(IntPtr handle, bool write, WorkItem item)
+			{
+				if(!Thread.CanStartThreads() ||
+				   !InternalWatchHandle(handle, write, item))
 				{
-					lock(completionWait)
-					{
-						if(lastCompletionItem != null)
-						{
-							lastCompletionItem.next = item;
-						}
-						else
-						{
-							completionItems = item;
-						}
-						lastCompletionItem = item;
-						queuedCompletionItems++;
-
-						if( completionThreads == null )
-								completionThreads =
-									new Thread [MaxCompletionThreads];
-
-						//
-						// We need to make sure that there are enough threads to
-						// handle the entire queue.
-						//
-						// There is a small possibility here that there is a thread
-						// about to end that could take this work unit, but we have no
-						// way of knowing that.
-						//
-						int needThreads = usedCompletionThreads + queuedCompletionItems;
-
-						// Determine if we need to spawn a new completion thread.
-						if( needThreads > numCompletionThreads )
-						{
-							if( needThreads > MaxCompletionThreads )
-//								throw new SystemException("Number of completion threads required exceeds maximum");
-							{
-								// Don't throw. Leave on the queue and pulse the lock if there are any waiting threads
-								if( usedCompletionThreads < numCompletionThreads )
-									Monitor.Pulse(completionWait);
-								return;
-							}
-							Thread thread =
-								new Thread(new ThreadStart(Complete));
-						#if !ECMA_COMPAT
-							thread.inThreadPool = true;
-						#endif
-							completionThreads[numCompletionThreads++] = thread;
-							thread.IsBackground = true;
-							thread.Start();
-						}
-						else
-						{
-							// Signal one of our waiting threads
-							Monitor.Pulse(completionWait);
-						}
-					}
+					AddWorkItem(item, CompletionPool);
 				}
 			}
 
+	// Queue a work item on a native thread pool.  Returns false if
+	// the item could not be queued.  The engine calls "item.Execute()"
+	// on a pool thread.
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern private static bool InternalQueueWorkItem(Object item, int pool);
+
+	// Get the limits and the number of available threads of a native pool.
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern private static int InternalGetMinThreads(int pool);
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern private static int InternalGetMaxThreads(int pool);
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern private static int InternalGetAvailableThreads(int pool);
+
+	// Queue a work item on the completion pool once a handle becomes
+	// ready for reading or writing.  Returns false if the handle cannot
+	// be watched, or if there already is a pending watch in that direction.
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern private static bool InternalWatchHandle
+			(IntPtr handle, bool write, Object item);
+
+	// Set the limits of a native pool.
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern private static bool InternalSetMinThreads(int pool, int count);
+	[MethodImpl(MethodImplOptions.InternalCall)]
+	extern private static bool InternalSetMaxThreads(int pool, int count);
+
 	// Structure of a work item.
 	internal sealed class WorkItem
 	{
@@ -345,9 +345,18 @@ namespace System.Threading
 
 		//
 		// Called by the Alarm object when a time expires.  Fire the
-		// real Timer's callback.
+		// real Timer's callback on the thread pool, so that a slow
+		// callback does not hold up the other timers.
 		//
 		private void fireTimer()
+		{
+			ThreadPool.QueueUserWorkItem(new WaitCallback(runCallback));
+		}
+
+		//
+		// Run the real Timer's callback.
+		//
+		private void runCallback(Object unused)
 		{
 			TimerCallback	callback;
 			Object			state;
@@ -48,6 +48,7 @@ public class SuiteSystem
 				suite.AddTests(typeof(TestMath));
 				suite.AddTests(typeof(TestSByte));
 				suite.AddTests(typeof(TestSingle));
+				suite.AddTests(typeof(TestStackAllocation));
 				suite.AddTests(typeof(TestString));
 			#if !ECMA_COMPAT
 				suite.AddTests(typeof(TestGuid));
@@ -0,0 +1,224 @@
+/*
+ * TestStackAllocation.cs - Tests for objects that the JIT allocates
+ *                          in the stack frame.
+ *
+ * Copyright (C) 2026  Free Software Foundation, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+using CSUnit;
+using System;
+using System.IO;
+using System.Reflection;
+using System.Reflection.Emit;
+
+// The engine allocates an object in the stack frame of the method that
+// creates it if the object cannot be seen once the method returns.  Each
+// test lets an object leave its method in a different way, overwrites
+// the dead stack frame, and then checks that the object is still intact.
+
+public class TestStackAllocation : TestCase
+{
+	// Object that is small enough to be allocated in the stack frame.
+	public class Node
+	{
+		public int a;
+		public int b;
+		public int c;
+
+		public Node()
+		{
+			a = 11;
+			b = 22;
+			c = 33;
+		}
+
+		// Sum the fields after reusing the stack.
+		public int Sum()
+		{
+			Scribble(8);
+			return a + b + c;
+		}
+	}
+
+	// Object that holds a reference to another object.
+	private class Holder
+	{
+		public Node node;
+	}
+
+	private static Node saved;
+
+	// Constructor.
+	public TestStackAllocation(String name)
+		: base(name)
+	{
+		// Nothing to do here.
+	}
+
+	// Set up for the tests.
+	protected override void Setup()
+	{
+		saved = null;
+	}
+
+	// Clean up after the tests.
+	protected override void Cleanup()
+	{
+		saved = null;
+#if CONFIG_REFLECTION_EMIT
+		File.Delete("TailCall.dll");
+#endif
+	}
+
+	// Overwrite the stack below the caller with other values.
+	public static int Scribble(int depth)
+	{
+		int w = depth * 7;
+		int x = w + 101;
+		int y = x + 202;
+		int z = y + 303;
+		if(depth > 0)
+		{
+			return Scribble(depth - 1) + w + x + y + z;
+		}
+		return w + x + y + z;
+	}
+
+	// Check that an object still has the values set by its constructor.
+	private static void CheckNode(String msg, Node node)
+	{
+		Scribble(8);
+		AssertNotNull(msg, node);
+		AssertEquals(msg + " a", 11, node.a);
+		AssertEquals(msg + " b", 22, node.b);
+		AssertEquals(msg + " c", 33, node.c);
+	}
+
+	private static int LocalOnly()
+	{
+		Node node = new Node();
+		return node.Sum();
+	}
+
+	private static Holder StoreToField()
+	{
+		Holder holder = new Holder();
+		Node node = new Node();
+		holder.node = node;
+		return holder;
+	}
+
+	private static void StoreToStatic()
+	{
+		Node node = new Node();
+		saved = node;
+	}
+
+	private static void Capture(ref Node node)
+	{
+		saved = node;
+	}
+
+	private static void PassByRef()
+	{
+		Node node = new Node();
+		Capture(ref node);
+	}
+
+	private static Node Return()
+	{
+		Node node = new Node();
+		return node;
+	}
+
+	// Test an object that never leaves its method.
+	public void TestStackAllocationLocal()
+	{
+		AssertEquals("Local", 66, LocalOnly());
+	}
+
+	// Test an object that is stored to a field of another object.
+	public void TestStackAllocationField()
+	{
+		Holder holder = StoreToField();
+		CheckNode("Field", holder.node);
+	}
+
+	// Test an object that is stored to a static field.
+	public void TestStackAllocationStatic()
+	{
+		StoreToStatic();
+		CheckNode("Static", saved);
+	}
+
+	// Test an object whose local is passed by reference.
+	public void TestStackAllocationByRef()
+	{
+		PassByRef();
+		CheckNode("ByRef", saved);
+	}
+
+	// Test an object that is returned.
+	public void TestStackAllocationReturn()
+	{
+		CheckNode("Return", Return());
+	}
+
+#if CONFIG_REFLECTION_EMIT
+
+	// Test an object that is "this" of a tail call.  C# cannot express
+	// the "tail." prefix, so the method is built with Reflection.Emit:
+	//
+	//		newobj    instance void Node::.ctor()
+	//		stloc.0
+	//		ldloc.0
+	//		tail. call instance int32 Node::Sum()
+	//		ret
+	public void TestStackAllocationTailCall()
+	{
+		AssemblyName name = new AssemblyName();
+		name.Name = "TailCall";
+		AssemblyBuilder assembly;
+		assembly = AppDomain.CurrentDomain.DefineDynamicAssembly
+			(name, AssemblyBuilderAccess.Save);
+		ModuleBuilder module = assembly.DefineDynamicModule("TailCall.dll");
+		TypeBuilder type = module.DefineType("TailCall", TypeAttributes.Public);
+		MethodBuilder method = type.DefineMethod
+			("Run", MethodAttributes.Static | MethodAttributes.Public,
+			 typeof(int), new Type[0]);
+		ILGenerator il = method.GetILGenerator();
+		il.DeclareLocal(typeof(Node));
+		il.Emit(OpCodes.Newobj, typeof(Node).GetConstructor(new Type[0]));
+		il.Emit(OpCodes.Stloc_0);
+		il.Emit(OpCodes.Ldloc_0);
+		il.Emit(OpCodes.Tailcall);
+		il.Emit(OpCodes.Call, typeof(Node).GetMethod("Sum"));
+		il.Emit(OpCodes.Ret);
+		type.CreateType();
+		assembly.Save("TailCall.dll");
+
+		Type tailCall = Assembly.LoadFrom("TailCall.dll").GetType("TailCall");
+		Object result = tailCall.InvokeMember
+			("Run",
+			 BindingFlags.InvokeMethod | BindingFlags.Public |
+			 BindingFlags.Static, null, null, null);
+		AssertEquals("TailCall", 66, (int)result);
+	}
+
+#endif // CONFIG_REFLECTION_EMIT
+
+}; // class TestStackAllocation